@@ -0,0 +1,36 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference_uvec2 : require
+#extension GL_GOOGLE_include_directive : require
+
+#include "gltf_pbr_input.glsl"
+#include "vertex_formats.glsl"
+
+// Depth pre-pass of the glTF PBR material. The position needs to match gltf_pbr.vert bit for bit so the
+// colour pass can test against it with EQUAL.
+invariant gl_Position;
+
+// needs to match gltf_pbr.vert, the pipelines share the layout
+layout(push_constant) uniform constants
+{
+    mat4 render_matrix;
+    uvec2 vertex_buffer; // device address
+    float opacity;
+    uint vertex_format;
+    vec4 position_offset;
+    vec4 position_scale;
+}
+push_constants;
+
+void main()
+{
+    DecodedVertex v = FetchVertex(
+        push_constants.vertex_buffer,
+        push_constants.vertex_format,
+        uint(gl_VertexIndex),
+        push_constants.position_offset.xyz,
+        push_constants.position_scale.xyz
+    );
+
+    gl_Position = scene_data.view_projection * push_constants.render_matrix * vec4(v.position, 1.0f);
+}
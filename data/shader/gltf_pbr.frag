@@ -1,8 +1,14 @@
 #version 450
 
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference_uvec2 : require
 #extension GL_GOOGLE_include_directive : require
 
 #include "gltf_pbr_input.glsl"
+#include "virtual_texture.glsl"
+
+// the virtual texture feedback writes would otherwise turn off early depth testing.
+layout(early_fragment_tests) in;
 
 // shader input
 layout(location = 0) in vec3 inNormal;
@@ -15,7 +21,23 @@ void main()
 {
     float light_intensity = max(dot(scene_data.light_direction.xyz, inNormal), 0.1f); // minimum 0.1f intensity
 
-    vec3 base_colour = inColour * texture(colour_texture, inUV).xyz;
+    vec4 colour_sample;
+    if (pbr_params.virtual_texture.w != 0u)
+    {
+        colour_sample = SampleVirtualTexture(
+            pbr_params.virtual_texture,
+            inUV,
+            scene_data.virtual_texturing.xy,
+            scene_data.virtual_texturing.zw,
+            virtual_texture_cache
+        );
+    }
+    else
+    {
+        colour_sample = texture(colour_texture, inUV);
+    }
+
+    vec3 base_colour = inColour * colour_sample.xyz;
     vec3 ambient_colour = base_colour * scene_data.ambient_colour.xyz;
     vec3 colour_with_light = base_colour * light_intensity * scene_data.light_colour.xyz;
 
@@ -6,13 +6,17 @@ layout(set = 0, binding = 0) uniform SceneData
     vec4 ambient_colour;
     vec4 light_direction;
     vec4 light_colour;
+    uvec4 virtual_texturing; // xy: page table address, zw: feedback address of the frame
 }
 scene_data;
 
+layout(set = 0, binding = 1) uniform sampler2D virtual_texture_cache;
+
 layout(set = 1, binding = 0) uniform MaterialParams
 {
     vec4 colour;
     vec4 metal_roughness;
+    uvec4 virtual_texture; // sampled instead of colour_texture if w isn't 0, see virtual_texture.glsl
 }
 pbr_params;
 
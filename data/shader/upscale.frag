@@ -0,0 +1,61 @@
+#version 450
+
+// Scales the draw extent of a viewport to the whole target with a Catmull-Rom filter, which stays sharper
+// than a bilinear blit when the viewport renders at a lower resolution.
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out vec4 outColour;
+
+layout(set = 0, binding = 0) uniform sampler2D source_image;
+
+// needs to match Renderer::GPUUpscalePushConstants
+layout(push_constant) uniform constants
+{
+    vec2 source_size; // size of the whole source image in texels
+    vec2 draw_extent; // part of the source image that was drawn, in texels
+}
+push_constants;
+
+// Catmull-Rom with 9 bilinear taps instead of 16 point taps. Tap positions are clamped to the draw extent so
+// nothing outside of it bleeds in.
+vec4 SampleCatmullRom(vec2 uv)
+{
+    vec2 sample_position = uv * push_constants.draw_extent;
+    vec2 centre = floor(sample_position - 0.5f) + 0.5f;
+    vec2 f = sample_position - centre;
+
+    vec2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+    vec2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+    vec2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+    vec2 w3 = f * f * (-0.5f + 0.5f * f);
+
+    // the middle two taps are merged into one bilinear tap.
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 min_position = vec2(0.5f);
+    vec2 max_position = push_constants.draw_extent - 0.5f;
+    vec2 position0 = clamp(centre - 1.0f, min_position, max_position) / push_constants.source_size;
+    vec2 position12 = clamp(centre + offset12, min_position, max_position) / push_constants.source_size;
+    vec2 position3 = clamp(centre + 2.0f, min_position, max_position) / push_constants.source_size;
+
+    vec4 result = vec4(0.0f);
+    result += textureLod(source_image, vec2(position0.x, position0.y), 0.0f) * w0.x * w0.y;
+    result += textureLod(source_image, vec2(position12.x, position0.y), 0.0f) * w12.x * w0.y;
+    result += textureLod(source_image, vec2(position3.x, position0.y), 0.0f) * w3.x * w0.y;
+
+    result += textureLod(source_image, vec2(position0.x, position12.y), 0.0f) * w0.x * w12.y;
+    result += textureLod(source_image, vec2(position12.x, position12.y), 0.0f) * w12.x * w12.y;
+    result += textureLod(source_image, vec2(position3.x, position12.y), 0.0f) * w3.x * w12.y;
+
+    result += textureLod(source_image, vec2(position0.x, position3.y), 0.0f) * w0.x * w3.y;
+    result += textureLod(source_image, vec2(position12.x, position3.y), 0.0f) * w12.x * w3.y;
+    result += textureLod(source_image, vec2(position3.x, position3.y), 0.0f) * w3.x * w3.y;
+
+    // the negative lobes can ring below zero around sharp edges.
+    return max(result, vec4(0.0f));
+}
+
+void main()
+{
+    outColour = SampleCatmullRom(inUV);
+}
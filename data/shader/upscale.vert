@@ -0,0 +1,10 @@
+#version 450
+
+// Fullscreen triangle for the upscale pass, uv covers the target.
+layout(location = 0) out vec2 outUV;
+
+void main()
+{
+    outUV = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(outUV * 2.0f - 1.0f, 0.0f, 1.0f);
+}
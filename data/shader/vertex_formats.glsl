@@ -0,0 +1,103 @@
+// Vertex layouts that can be stored in a mesh vertex buffer. Needs to match Renderer::VertexFormat and the
+// vertex structures in VkTypes.h.
+// Requires GL_EXT_buffer_reference and GL_EXT_buffer_reference_uvec2.
+
+#define VERTEX_FORMAT_STANDARD 0
+#define VERTEX_FORMAT_COMPACT 1
+#define VERTEX_FORMAT_COMPACT_QUANTISED 2
+
+struct StandardVertex
+{
+    vec3 position;
+    float uv_x;
+    vec3 normal;
+    float uv_y;
+    vec4 color;
+};
+
+// vec3 would be aligned to 16 bytes, so the position is stored as separate floats.
+struct CompactVertex
+{
+    float position_x;
+    float position_y;
+    float position_z;
+    uint normal; // octahedral snorm16x2
+    uint uv;     // half2
+    uint colour; // unorm8x4
+};
+
+struct QuantisedVertex
+{
+    uint position_xy; // unorm16x2
+    uint position_z;  // unorm16, upper half unused
+    uint normal;
+    uint uv;
+    uint colour;
+};
+
+layout(buffer_reference, std430) readonly buffer StandardVertexBuffer
+{
+    StandardVertex vertices[];
+};
+
+layout(buffer_reference, std430) readonly buffer CompactVertexBuffer
+{
+    CompactVertex vertices[];
+};
+
+layout(buffer_reference, std430) readonly buffer QuantisedVertexBuffer
+{
+    QuantisedVertex vertices[];
+};
+
+struct DecodedVertex
+{
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+    vec4 colour;
+};
+
+vec3 OctahedralDecode(vec2 encoded)
+{
+    vec3 normal = vec3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0f)
+    {
+        vec2 sign_not_zero = vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+        normal.xy = (1.0f - abs(normal.yx)) * sign_not_zero;
+    }
+    return normalize(normal);
+}
+
+// position_offset and position_scale are the bounds used to dequantise QuantisedVertex positions.
+DecodedVertex FetchVertex(uvec2 vertex_buffer, uint vertex_format, uint index, vec3 position_offset, vec3 position_scale)
+{
+    DecodedVertex decoded;
+    if (vertex_format == VERTEX_FORMAT_COMPACT)
+    {
+        CompactVertex v = CompactVertexBuffer(vertex_buffer).vertices[index];
+        decoded.position = vec3(v.position_x, v.position_y, v.position_z);
+        decoded.normal = OctahedralDecode(unpackSnorm2x16(v.normal));
+        decoded.uv = unpackHalf2x16(v.uv);
+        decoded.colour = unpackUnorm4x8(v.colour);
+    }
+    else if (vertex_format == VERTEX_FORMAT_COMPACT_QUANTISED)
+    {
+        QuantisedVertex v = QuantisedVertexBuffer(vertex_buffer).vertices[index];
+        vec3 normalised_position = vec3(unpackUnorm2x16(v.position_xy), unpackUnorm2x16(v.position_z).x);
+        decoded.position = position_offset + normalised_position * position_scale;
+        decoded.normal = OctahedralDecode(unpackSnorm2x16(v.normal));
+        decoded.uv = unpackHalf2x16(v.uv);
+        decoded.colour = unpackUnorm4x8(v.colour);
+    }
+    else
+    {
+        StandardVertex v = StandardVertexBuffer(vertex_buffer).vertices[index];
+        decoded.position = v.position;
+        decoded.normal = v.normal;
+        decoded.uv = vec2(v.uv_x, v.uv_y);
+        decoded.colour = v.color;
+    }
+
+    return decoded;
+}
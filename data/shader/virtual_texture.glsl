@@ -0,0 +1,67 @@
+// Sampling of virtual textures through their page table. Needs to match Renderer::VirtualTexturing.
+// Requires GL_EXT_buffer_reference and GL_EXT_buffer_reference_uvec2.
+
+#define VIRTUAL_TEXTURE_TILE_SIZE 128u
+#define VIRTUAL_TEXTURE_CACHE_TILES 32u
+
+layout(buffer_reference, std430) readonly buffer VirtualPageTable
+{
+    uint entries[];
+};
+
+layout(buffer_reference, std430) writeonly buffer VirtualFeedback
+{
+    uint requested[];
+};
+
+// first page of a mip relative to the first page of the texture, mips are square power of two page grids
+// stored finest first.
+uint VirtualMipOffset(uint mip_count, uint mip)
+{
+    uint offset = 0u;
+    for (uint finer_mip = 0u; finer_mip < mip; ++finer_mip)
+    {
+        uint side = 1u << (mip_count - 1u - finer_mip);
+        offset += side * side;
+    }
+    return offset;
+}
+
+// texture_info is MaterialParameters::virtual_texture: first page, width, height and page mip count.
+// Writes the page the sample wanted into the feedback and samples the closest resident page instead.
+vec4 SampleVirtualTexture(
+    uvec4 texture_info, vec2 uv, uvec2 page_table_address, uvec2 feedback_address, sampler2D cache
+)
+{
+    uint mip_count = texture_info.w;
+    vec2 size = vec2(texture_info.yz);
+
+    // derivatives of the unwrapped coordinates, so repeating doesn't pick a tiny mip at the seam.
+    vec2 texel_dx = dFdx(uv * size);
+    vec2 texel_dy = dFdy(uv * size);
+    float lod = 0.5f * log2(max(dot(texel_dx, texel_dx), dot(texel_dy, texel_dy)));
+    uint mip = uint(clamp(floor(lod), 0.0f, float(mip_count - 1u)));
+
+    vec2 texel = fract(uv) * size;
+    uint side = 1u << (mip_count - 1u - mip);
+    uvec2 page = min(uvec2(texel) / (VIRTUAL_TEXTURE_TILE_SIZE << mip), uvec2(side - 1u));
+    uint page_index = texture_info.x + VirtualMipOffset(mip_count, mip) + page.y * side + page.x;
+
+    VirtualFeedback(feedback_address).requested[page_index] = 1u;
+    uint entry = VirtualPageTable(page_table_address).entries[page_index];
+    if ((entry & 0x80000000u) == 0u)
+    {
+        return vec4(1.0f); // not even the coarsest page is loaded yet
+    }
+
+    uvec2 cache_tile = uvec2(entry & 0xFFu, (entry >> 8u) & 0xFFu);
+    uint resident_mip = (entry >> 16u) & 0xFFu;
+    vec2 resident_texel = texel / float(1u << resident_mip);
+    vec2 tile_texel = mod(resident_texel, float(VIRTUAL_TEXTURE_TILE_SIZE));
+
+    // tiles have no filtering border, so the cache is read without filtering. A linear sampler would blend
+    // in the neighbouring tiles of the atlas at the tile edges.
+    uvec2 cache_texel = cache_tile * VIRTUAL_TEXTURE_TILE_SIZE +
+                        min(uvec2(tile_texel), uvec2(VIRTUAL_TEXTURE_TILE_SIZE - 1u));
+    return texelFetch(cache, ivec2(cache_texel), 0);
+}
@@ -8,9 +8,15 @@
 
 #include <chrono>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 EngineCore::EngineCore(CVars cvars)
 {
+    m_job_system = std::make_unique<Jobs::JobSystem>(cvars.job_workers);
+    m_pipeline_frames = cvars.pipeline_frames;
+
     // We initialize SDL and create a window with it.
     SDL_Init(SDL_INIT_VIDEO);
 
@@ -31,8 +37,12 @@ EngineCore::EngineCore(CVars cvars)
         m_window,
         cvars.backbuffer_scale,
         cvars.use_validation_layers,
-        cvars.force_immediate_uploads
+        cvars.force_immediate_uploads,
+        cvars.compress_vertices,
+        static_cast<Renderer::PresentMode>(cvars.present_mode),
+        cvars.frames_in_flight
     );
+    m_renderer->SetMaxFrameRate(cvars.max_fps);
     if (m_renderer->Init() == false)
     {
         m_initialisation_failure = true;
@@ -42,17 +52,119 @@ EngineCore::EngineCore(CVars cvars)
     constexpr const char* font_path = "../data/fonts/roboto.ttf";
     ImGui::GetIO().Fonts->AddFontFromFileTTF(font_path, 14);
 
+    // extra windows mirror the main viewport, e.g. for additional displays.
+    for (uint32_t i = 0; i < cvars.present_windows; ++i)
+    {
+        const std::string title = "Vulkan Engine " + std::to_string(i + 2);
+        SDL_Window* window = SDL_CreateWindow(
+            title.data(),
+            SDL_WINDOWPOS_UNDEFINED,
+            SDL_WINDOWPOS_UNDEFINED,
+            cvars.width,
+            cvars.height,
+            window_flags
+        );
+        if (m_renderer->AddPresentWindow(window, m_renderer->main_viewport) == false)
+        {
+            SDL_DestroyWindow(window);
+            continue;
+        }
+        m_present_windows.push_back(window);
+    }
+
     m_game = std::make_unique<Game::GameMain>(*m_renderer, cvars);
+
+    BuildFrameTaskGraph();
 }
 
 EngineCore::~EngineCore()
 {
     m_renderer->Cleanup();
+    for (SDL_Window* window : m_present_windows)
+    {
+        SDL_DestroyWindow(window);
+    }
     SDL_DestroyWindow(m_window);
 }
 
 void EngineCore::Update() {}
 
+void EngineCore::BuildFrameTaskGraph()
+{
+    m_frame_graph.Clear();
+
+    // events and ImGui widgets run on the main thread before the graph, so the jobs see their changes.
+    const Jobs::JobId game_tick = m_frame_graph.AddJob(
+        "game tick",
+        [this]()
+        {
+            m_game->Tick(m_last_delta_ms / 1000.0, *m_job_system);
+        }
+    );
+    const Jobs::JobId scene_extraction = m_frame_graph.AddJob(
+        "scene extraction",
+        [this]()
+        {
+            m_game->Draw(*m_job_system);
+        },
+        { game_tick }
+    );
+    const auto add_frame_publish = [this](std::vector<Jobs::JobId> dependencies)
+    {
+        return m_frame_graph.AddJob(
+            "frame publish",
+            [this]()
+            {
+                m_renderer->PublishFrameContexts();
+            },
+            std::move(dependencies)
+        );
+    };
+
+    // when pipelined, the game extracts the next frame while the renderer records the snapshot the game
+    // extracted during the last run. The snapshot is swapped once both are done, which costs a frame of
+    // latency. Otherwise the frame is extracted and published before it is culled and recorded.
+    std::vector<Jobs::JobId> culling_dependencies{};
+    if (m_pipeline_frames == false)
+    {
+        culling_dependencies.push_back(add_frame_publish({ scene_extraction }));
+    }
+
+    const Jobs::JobId culling = m_frame_graph.AddJob(
+        "culling",
+        [this]()
+        {
+            m_renderer->PrepareFrame(*m_job_system);
+        },
+        std::move(culling_dependencies)
+    );
+    const Jobs::JobId upload_preparation = m_frame_graph.AddJob(
+        "upload preparation",
+        [this]()
+        {
+            m_renderer->PrepareUploads();
+        }
+    );
+
+    // recording touches SDL and ImGui, which aren't thread safe.
+    const Jobs::JobId command_recording = m_frame_graph.AddJob(
+        "command recording",
+        [this]()
+        {
+            // renderer draw should be after any other kind of draw because things "queue" render objects for
+            // the renderer to render during its draw.
+            m_renderer->Update();
+        },
+        { culling, upload_preparation },
+        Jobs::JobAffinity::MainThread
+    );
+
+    if (m_pipeline_frames)
+    {
+        add_frame_publish({ scene_extraction, command_recording });
+    }
+}
+
 void EngineCore::RunMainLoop()
 {
     SDL_Event e;
@@ -60,14 +172,31 @@ void EngineCore::RunMainLoop()
 
     while (quit == false)
     {
+        // wait for the frame limit before polling so the frame uses the latest input.
+        m_renderer->LimitFrameRate();
+
         while (SDL_PollEvent(&e) != 0)
         {
+            switch (e.type)
+            {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+            case SDL_MOUSEMOTION:
+            case SDL_MOUSEWHEEL:
+                m_renderer->RecordInput();
+                break;
+            default:
+                break;
+            }
+
             if (e.type == SDL_QUIT)
             {
                 quit = true;
             }
 
-            if (e.type == SDL_WINDOWEVENT)
+            if (e.type == SDL_WINDOWEVENT && SDL_GetWindowFromID(e.window.windowID) == m_window)
             {
                 if (e.window.event == SDL_WINDOWEVENT_MINIMIZED)
                 {
@@ -77,6 +206,20 @@ void EngineCore::RunMainLoop()
                 {
                     m_renderer->stop_rendering = false;
                 }
+                if (e.window.event == SDL_WINDOWEVENT_CLOSE)
+                {
+                    quit = true;
+                }
+            }
+            else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_CLOSE)
+            {
+                // the other windows only stop being presented to.
+                SDL_Window* window = SDL_GetWindowFromID(e.window.windowID);
+                if (std::erase(m_present_windows, window) > 0)
+                {
+                    m_renderer->RemovePresentWindow(window);
+                    SDL_DestroyWindow(window);
+                }
             }
 
             ImGui_ImplSDL2_ProcessEvent(&e);
@@ -97,11 +240,7 @@ void EngineCore::RunMainLoop()
 
         OnImgui();
 
-        m_game->Draw(m_last_delta_ms / 1000.0);
-
-        // renderer draw should be after any other kind of draw because things "queue" render objects for the
-        // renderer to render during its draw.
-        m_renderer->Update();
+        m_frame_graph.Run(*m_job_system);
 
         // any logical updates
         Update();
@@ -117,6 +256,7 @@ void EngineCore::OnImgui()
         {
             ImGui::Checkbox("Show Demo", &m_show_imgui_demo);
             ImGui::Checkbox("Frame Stats", &m_show_fps);
+            ImGui::Checkbox("Frame Task Graph", &m_show_frame_graph);
             ImGui::EndMenu();
         }
 
@@ -146,6 +286,21 @@ void EngineCore::OnImgui()
         );
     }
 
+    if (m_show_frame_graph)
+    {
+        if (ImGui::Begin("Frame Task Graph", &m_show_frame_graph))
+        {
+            ImGui::Text("Workers: %u", m_job_system->WorkerCount());
+            // the graph isn't running while ImGui is drawn, so it can be rebuilt here.
+            if (ImGui::Checkbox("Pipeline Frames", &m_pipeline_frames))
+            {
+                BuildFrameTaskGraph();
+            }
+            m_frame_graph.DrawImGui();
+        }
+        ImGui::End();
+    }
+
     m_game->OnImGui();
 }
 
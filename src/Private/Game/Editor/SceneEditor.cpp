@@ -113,7 +113,7 @@ namespace Game::Editor
                 m_selected_node = node.Id();
             }
 
-            for (const std::unique_ptr<Node>& child : node.Children())
+            for (const NodePtr& child : node.Children())
             {
                 DrawNodeEntry(*child);
             }
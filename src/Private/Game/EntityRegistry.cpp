@@ -0,0 +1,44 @@
+#include "Game/EntityRegistry.h"
+
+namespace Game
+{
+    Entity EntityRegistry::Create()
+    {
+        ++m_alive_count;
+        if (m_free_indices.empty() == false)
+        {
+            const uint32_t index = m_free_indices.back();
+            m_free_indices.pop_back();
+            return Entity{ index, m_generations[index] };
+        }
+
+        m_generations.push_back(0);
+        return Entity{ uint32_t(m_generations.size() - 1), 0 };
+    }
+
+    void EntityRegistry::Destroy(Entity entity)
+    {
+        if (IsAlive(entity) == false)
+        {
+            return;
+        }
+
+        for (const std::unique_ptr<ComponentStorageBase>& storage : m_storages)
+        {
+            if (storage != nullptr)
+            {
+                storage->Remove(entity.index);
+            }
+        }
+
+        // handles to the entity stop resolving once the index is reused.
+        ++m_generations[entity.index];
+        m_free_indices.push_back(entity.index);
+        --m_alive_count;
+    }
+
+    bool EntityRegistry::IsAlive(Entity entity) const
+    {
+        return entity.index < m_generations.size() && m_generations[entity.index] == entity.generation;
+    }
+} // namespace Game
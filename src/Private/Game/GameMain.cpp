@@ -1,4 +1,5 @@
 #include "Game/GameMain.h"
+#include "Game/Components.h"
 #include "Game/Editor/SceneEditor.h"
 #include "Game/GameScene.h"
 #include "Game/GameTime.h"
@@ -13,6 +14,7 @@
 #include <glm/fwd.hpp>
 #include <glm/trigonometric.hpp>
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,22 +28,48 @@ namespace Game
     {
         m_main_scene = std::make_unique<GameScene>();
         m_main_editor = std::make_unique<Editor::SceneEditor>(*m_main_scene);
+        m_tick_scheduler.tick_rate = m_cvars.tick_rate;
+        m_tick_scheduler.max_catch_up_steps = m_cvars.max_catch_up_steps;
 
         MainSceneSetup();
     }
 
     void GameMain::MainSceneSetup()
     {
-        Utils::LoadGltfIntoGameScene(*m_renderer, m_main_scene->Root(), m_cvars.default_scene_path);
+        Renderer::MeshImportSettings import_settings{};
+        import_settings.optimise = m_cvars.optimise_meshes;
+        import_settings.generate_lods = m_cvars.generate_lods;
+        import_settings.use_cache = m_cvars.use_mesh_cache;
+        import_settings.build_meshlets = m_cvars.build_meshlets;
+
+        Utils::LoadGltfIntoGameScene(
+            *m_renderer, m_main_scene->Root(), m_cvars.default_scene_path, import_settings
+        );
     }
 
-    void GameMain::Draw(double delta_time_seconds)
+    void GameMain::Tick(double delta_time_seconds, Jobs::JobSystem& job_system)
     {
-        m_game_time.delta_time_seconds = (float)delta_time_seconds;
-        m_game_time.game_time_seconds += m_game_time.delta_time_seconds;
+        const uint32_t steps = m_tick_scheduler.Advance(delta_time_seconds);
+        for (uint32_t step = 0; step < steps; ++step)
+        {
+            const auto tick_start = std::chrono::steady_clock::now();
+
+            m_game_time.delta_time_seconds = (float)m_tick_scheduler.TickSeconds();
+            m_game_time.game_time_seconds += m_game_time.delta_time_seconds;
+            m_main_scene->TickUpdate(m_game_time, job_system);
+
+            const std::chrono::duration<double, std::milli> tick_duration =
+                std::chrono::steady_clock::now() - tick_start;
+            m_tick_scheduler.RecordTick(tick_duration.count());
+        }
 
-        // draw on the main viewport.
-        m_main_scene->Draw(m_main_viewport->frame_context);
+        m_main_scene->SetTickInterpolation(m_tick_scheduler.Interpolation());
+    }
+
+    void GameMain::Draw(Jobs::JobSystem& job_system)
+    {
+        // draw on the main viewport. The renderer only reads it once it is published.
+        m_main_scene->Draw(m_main_viewport->frame_context, job_system);
     }
 
     void GameMain::OnImGui()
@@ -53,6 +81,11 @@ namespace Game
                 ImGui::Checkbox("Enable", &m_editor_enabled);
                 ImGui::EndMenu();
             }
+            if (ImGui::BeginMenu("Simulation"))
+            {
+                ImGui::Checkbox("Tick Stats", &m_show_simulation);
+                ImGui::EndMenu();
+            }
             ImGui::EndMainMenuBar();
         }
 
@@ -60,5 +93,73 @@ namespace Game
         {
             m_main_editor->DrawImGui();
         }
+
+        if (m_show_simulation)
+        {
+            DrawSimulationImGui();
+        }
+    }
+
+    void GameMain::DrawSimulationImGui()
+    {
+        if (ImGui::Begin("Simulation", &m_show_simulation))
+        {
+            TickScheduler& scheduler = m_tick_scheduler;
+            ImGui::SliderFloat("Tick Rate", &scheduler.tick_rate, 1.0f, 240.0f, "%.0f Hz");
+            int max_catch_up_steps = int(scheduler.max_catch_up_steps);
+            if (ImGui::SliderInt("Max Catch-up Steps", &max_catch_up_steps, 1, 16))
+            {
+                scheduler.max_catch_up_steps = uint32_t(max_catch_up_steps);
+            }
+
+            ImGui::SeparatorText("Steps");
+            ImGui::Text("Last frame: %u", scheduler.last_steps);
+            ImGui::Text("Max per frame: %u", scheduler.max_steps);
+            ImGui::Text("Total: %llu", (unsigned long long)scheduler.total_ticks);
+            ImGui::Text("Dropped time: %.3f s", scheduler.dropped_seconds);
+            ImGui::Text("Interpolation: %.2f", scheduler.Interpolation());
+
+            ImGui::SeparatorText("Ticking Nodes");
+            constexpr const char* group_names[TICK_GROUP_COUNT] = { "Early", "Default", "Late" };
+            for (size_t group = 0; group < TICK_GROUP_COUNT; ++group)
+            {
+                ImGui::Text(
+                    "%s: %zu serial, %zu parallel",
+                    group_names[group],
+                    m_main_scene->TickingNodeCount(TickGroup(group), false),
+                    m_main_scene->TickingNodeCount(TickGroup(group), true)
+                );
+            }
+
+            ImGui::SeparatorText("Entities");
+            EntityRegistry& registry = m_main_scene->Registry();
+            ImGui::Text("Alive: %zu", registry.AliveCount());
+            ImGui::Text("Transforms: %zu", registry.Storage<TransformComponent>().Size());
+            ImGui::Text("Mesh Renderers: %zu", registry.Storage<MeshRendererComponent>().Size());
+            ImGui::Text("Node Links: %zu", registry.Storage<NodeLinkComponent>().Size());
+
+            ImGui::SeparatorText("Node Pools");
+            for (const NodePool* pool : m_main_scene->Allocator().Pools())
+            {
+                ImGui::Text(
+                    "%s: %zu / %zu (%zu bytes)",
+                    pool->TypeName().c_str(),
+                    pool->LiveCount(),
+                    pool->Capacity(),
+                    pool->BlockSize()
+                );
+            }
+
+            ImGui::SeparatorText("Tick Cost");
+            ImGui::Text("Last: %.3f ms", scheduler.last_tick_milliseconds);
+            ImGui::Text("Average: %.3f ms", scheduler.average_tick_milliseconds);
+            ImGui::Text("Max: %.3f ms", scheduler.max_tick_milliseconds);
+
+            if (ImGui::Button("Reset Stats"))
+            {
+                scheduler.ResetStats();
+            }
+        }
+        ImGui::End();
     }
 } // namespace Game
\ No newline at end of file
@@ -1,41 +1,46 @@
 #include "Game/GameScene.h"
+#include "Game/Components.h"
 #include "Game/Node.h"
+#include "Game/Nodes/MeshNode.h"
+#include "Jobs/JobSystem.h"
+#include "Renderer/FrameDrawContext.h"
 
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <span>
 
 namespace
 {
-    void UpdateUpkeepList(std::vector<Game::Node*>& vec, Game::Node& target_node, bool enable)
+    // parallel work is handed to the workers in chunks of this size.
+    constexpr size_t nodes_per_tick_chunk = 64;
+    constexpr size_t nodes_per_draw_chunk = 64;
+    constexpr size_t entities_per_draw_chunk = 256;
+
+    size_t ChunkCount(size_t count, size_t per_chunk) { return (count + per_chunk - 1) / per_chunk; }
+
+    // the node keeps its index in the list, so it can be removed in constant time by moving the last node of
+    // the list into its place. The list order isn't kept.
+    void UpdateUpkeepList(
+        std::vector<Game::Node*>& vec, Game::Node& target_node, bool enable, size_t Game::Node::* list_index
+    )
     {
         if (enable == false)
         {
-            const auto r_it = std::find_if(
-                vec.rbegin(),
-                vec.rend(),
-                [&target_node](const Game::Node* update_node)
-                {
-                    return target_node.Id() == update_node->Id();
-                }
-            );
-
-            if (r_it == vec.rend())
+            const size_t index = target_node.*list_index;
+            if (index >= vec.size() || vec[index] != &target_node)
             {
                 return;
             }
 
-            // reverse iterator is offset by one turns out. Learned the hard way. Thanks C++
-            auto it = --r_it.base();
-
-            // we don't do an erase, we simply swap the element we're removing with the last element
-            // effectively "shrinking" the list without moving everything.
-            // If the update order needs to be predictible, this won't do but let's see how it goes.
-            *it = std::move(vec.back());
+            vec[index] = vec.back();
+            vec[index]->*list_index = index;
             vec.pop_back();
+            target_node.*list_index = SIZE_MAX;
         }
         else
         {
+            target_node.*list_index = vec.size();
             vec.emplace_back(&target_node);
         }
     }
@@ -45,6 +50,7 @@ namespace Game
 {
     GameScene::GameScene()
     {
+        m_node_allocator = std::make_unique<NodeAllocator>();
         m_root = std::make_unique<RootNode>();
         RegisterNode(*m_root.get());
     }
@@ -56,6 +62,7 @@ namespace Game
         m_active_nodes[node.m_id] = &node;
         node.OnAdded();
         node.RefreshTransform();
+        node.m_previous_world_transform = node.m_world_transform;
         if (node.m_tick_updating)
         {
             SetNodeTickUpdate(node, true);
@@ -90,12 +97,44 @@ namespace Game
 
     void GameScene::SetNodeTickUpdate(Node& node, bool update)
     {
-        UpdateUpkeepList(m_updating_nodes, node, update);
+        UpdateUpkeepList(TickList(node), node, update, &Node::m_tick_list_index);
+    }
+
+    std::vector<Node*>& GameScene::TickList(const Node& node)
+    {
+        TickGroupNodes& group = m_tick_groups[size_t(node.m_tick_group)];
+        return node.m_parallel_tick ? group.parallel : group.serial;
+    }
+
+    size_t GameScene::TickingNodeCount(TickGroup group, bool parallel) const
+    {
+        const TickGroupNodes& group_nodes = m_tick_groups[size_t(group)];
+        return parallel ? group_nodes.parallel.size() : group_nodes.serial.size();
+    }
+
+    void GameScene::DeferChange(std::function<void()> change)
+    {
+        if (m_ticking == false)
+        {
+            change();
+            return;
+        }
+
+        m_deferred_changes.push(std::move(change));
+    }
+
+    void GameScene::ApplyDeferredChanges()
+    {
+        std::function<void()> change;
+        while (m_deferred_changes.try_pop(change))
+        {
+            change();
+        }
     }
 
     void GameScene::SetNodeRenderable(Node& node, bool is_renderable)
     {
-        UpdateUpkeepList(m_renderable_nodes, node, is_renderable);
+        UpdateUpkeepList(m_renderable_nodes, node, is_renderable, &Node::m_renderable_list_index);
     }
 
     void GameScene::SetPaused(bool paused) { m_paused = paused; }
@@ -111,6 +150,125 @@ namespace Game
     }
 
     void GameScene::Draw(Renderer::FrameDrawContext& ctx, const CameraNode* camera_node)
+    {
+        SetupDrawCamera(ctx, camera_node);
+
+        for (Node* renderable : m_renderable_nodes)
+        {
+            renderable->Draw(ctx);
+        }
+
+        DrawEntities(ctx, nullptr);
+    }
+
+    void GameScene::Draw(
+        Renderer::FrameDrawContext& ctx, Jobs::JobSystem& job_system, const CameraNode* camera_node
+    )
+    {
+        SetupDrawCamera(ctx, camera_node);
+
+        // nodes only write into the context and their own state, so the chunks can draw in parallel.
+        DrawChunks(
+            ctx,
+            &job_system,
+            ChunkCount(m_renderable_nodes.size(), nodes_per_draw_chunk),
+            [&](size_t chunk, Renderer::FrameDrawContext& chunk_ctx)
+            {
+                const size_t first_node = chunk * nodes_per_draw_chunk;
+                const size_t last_node =
+                    std::min(first_node + nodes_per_draw_chunk, m_renderable_nodes.size());
+                for (size_t node = first_node; node < last_node; ++node)
+                {
+                    m_renderable_nodes[node]->Draw(chunk_ctx);
+                }
+            }
+        );
+
+        DrawEntities(ctx, &job_system);
+    }
+
+    void GameScene::DrawEntities(Renderer::FrameDrawContext& ctx, Jobs::JobSystem* job_system)
+    {
+        ComponentStorage<MeshRendererComponent>& mesh_renderers = m_registry.Storage<MeshRendererComponent>();
+        ComponentStorage<TransformComponent>& transforms = m_registry.Storage<TransformComponent>();
+        std::span<MeshRendererComponent> components = mesh_renderers.Components();
+        std::span<const uint32_t> entity_indices = mesh_renderers.EntityIndices();
+
+        DrawChunks(
+            ctx,
+            job_system,
+            ChunkCount(components.size(), entities_per_draw_chunk),
+            [&](size_t chunk, Renderer::FrameDrawContext& chunk_ctx)
+            {
+                const size_t first = chunk * entities_per_draw_chunk;
+                const size_t last = std::min(first + entities_per_draw_chunk, components.size());
+                for (size_t component = first; component < last; ++component)
+                {
+                    const TransformComponent* transform = transforms.Find(entity_indices[component]);
+                    if (transform == nullptr)
+                    {
+                        continue;
+                    }
+
+                    const Transform world_transform = Transform::Interpolated(
+                        transform->previous_transform, transform->transform, m_tick_interpolation
+                    );
+                    AppendMeshRenderObjects(
+                        chunk_ctx,
+                        components[component].mesh,
+                        world_transform.ToMatrix(),
+                        components[component].surface_lods
+                    );
+                }
+            }
+        );
+    }
+
+    void GameScene::DrawChunks(
+        Renderer::FrameDrawContext& ctx,
+        Jobs::JobSystem* job_system,
+        size_t chunk_count,
+        const std::function<void(size_t chunk, Renderer::FrameDrawContext& chunk_ctx)>& draw_chunk
+    ) const
+    {
+        if (job_system == nullptr || chunk_count <= 1)
+        {
+            for (size_t chunk = 0; chunk < chunk_count; ++chunk)
+            {
+                draw_chunk(chunk, ctx);
+            }
+            return;
+        }
+
+        // the copies start without the objects already in the context.
+        std::vector<Renderer::RenderObject> render_objects = std::move(ctx.render_objects);
+        ctx.render_objects.clear();
+        std::vector<Renderer::FrameDrawContext> chunk_contexts(chunk_count, ctx);
+        ctx.render_objects = std::move(render_objects);
+
+        job_system->ParallelFor(
+            chunk_count,
+            1,
+            [&](size_t first_chunk, size_t last_chunk)
+            {
+                for (size_t chunk = first_chunk; chunk < last_chunk; ++chunk)
+                {
+                    draw_chunk(chunk, chunk_contexts[chunk]);
+                }
+            }
+        );
+
+        for (Renderer::FrameDrawContext& chunk_context : chunk_contexts)
+        {
+            ctx.render_objects.insert(
+                ctx.render_objects.end(),
+                std::make_move_iterator(chunk_context.render_objects.begin()),
+                std::make_move_iterator(chunk_context.render_objects.end())
+            );
+        }
+    }
+
+    void GameScene::SetupDrawCamera(Renderer::FrameDrawContext& ctx, const CameraNode* camera_node) const
     {
         const CameraNode* used_camera = camera_node;
         if (used_camera == nullptr)
@@ -119,29 +277,108 @@ namespace Game
         }
         if (used_camera != nullptr)
         {
-            ctx.camera_position = m_active_camera->m_world_transform.position;
-            ctx.camera_rotation = glm::mat4(m_active_camera->m_world_transform.rotation);
+            const Transform camera_transform = m_active_camera->InterpolatedWorldTransform();
+            ctx.camera_position = camera_transform.position;
+            ctx.camera_rotation = glm::mat4(camera_transform.rotation);
             ctx.camera_vertical_fov = m_active_camera->vertical_fov;
         }
+        ctx.UpdateCamera();
+    }
 
-        for (Node* renderable : m_renderable_nodes)
+    void GameScene::TickUpdate(const GameTime& time)
+    {
+        KeepPreviousTransforms();
+        UpdateAllNodes(time, nullptr);
+    }
+
+    void GameScene::TickUpdate(const GameTime& time, Jobs::JobSystem& job_system)
+    {
+        KeepPreviousTransforms();
+        UpdateAllNodes(time, &job_system);
+    }
+
+    void GameScene::AddSystem(std::string name, TickGroup group, EntitySystemUpdate update)
+    {
+        m_systems.push_back(EntitySystem{ std::move(name), group, std::move(update) });
+    }
+
+    void GameScene::KeepPreviousTransforms()
+    {
+        for (TransformComponent& transform : m_registry.Storage<TransformComponent>().Components())
         {
-            renderable->Draw(ctx);
+            transform.previous_transform = transform.transform;
         }
-    }
 
-    void GameScene::TickUpdate(const GameTime& time) { UpdateAllNodes(time); }
+        // only what is drawn gets interpolated.
+        for (Node* node : m_renderable_nodes)
+        {
+            node->m_previous_world_transform = node->m_world_transform;
+        }
+        if (m_active_camera != nullptr)
+        {
+            m_active_camera->m_previous_world_transform = m_active_camera->m_world_transform;
+        }
+    }
 
-    void GameScene::UpdateAllNodes(const GameTime& time)
+    void GameScene::UpdateAllNodes(const GameTime& time, Jobs::JobSystem* job_system)
     {
         if (m_paused)
         {
             return;
         }
 
-        for (Node* node : m_updating_nodes)
+        for (size_t group_index = 0; group_index < m_tick_groups.size(); ++group_index)
         {
-            node->OnTickUpdate(time);
+            TickGroupNodes& group = m_tick_groups[group_index];
+            m_ticking = true;
+
+            for (EntitySystem& system : m_systems)
+            {
+                if (size_t(system.group) == group_index)
+                {
+                    system.update(m_registry, time, job_system);
+                }
+            }
+
+            const auto tick_parallel_nodes = [&](size_t first_node, size_t last_node)
+            {
+                for (size_t node = first_node; node < last_node; ++node)
+                {
+                    group.parallel[node]->OnTickUpdate(time);
+                }
+            };
+            if (job_system != nullptr)
+            {
+                job_system->ParallelFor(group.parallel.size(), nodes_per_tick_chunk, tick_parallel_nodes);
+            }
+            else
+            {
+                tick_parallel_nodes(0, group.parallel.size());
+            }
+
+            for (Node* node : group.serial)
+            {
+                node->OnTickUpdate(time);
+            }
+
+            // sync point, nothing ticks until the next group so the structure can change.
+            m_ticking = false;
+            ApplyDeferredChanges();
         }
+
+        UpdateNodeLinks();
+    }
+
+    void GameScene::UpdateNodeLinks()
+    {
+        m_registry.Each<NodeLinkComponent, TransformComponent>(
+            [this](Entity, NodeLinkComponent& link, TransformComponent& transform)
+            {
+                if (const Node* node = NodeFromId(link.node))
+                {
+                    transform.transform = link.offset.Transformed(node->WorldTransform());
+                }
+            }
+        );
     }
 } // namespace Game
\ No newline at end of file
@@ -3,7 +3,6 @@
 #include "Game/GameScene.h"
 
 #include "ThirdParty/ImGUI.h"
-#include <algorithm>
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/matrix.hpp>
 #include <memory>
@@ -39,6 +38,16 @@ namespace Game
         return FromMatrix(result);
     }
 
+    Transform Transform::Interpolated(const Transform& from, const Transform& to, float alpha)
+    {
+        Transform xform{};
+        xform.position = glm::mix(from.position, to.position, alpha);
+        xform.scale = glm::mix(from.scale, to.scale, alpha);
+        xform.rotation = glm::slerp(from.rotation, to.rotation, alpha);
+
+        return xform;
+    }
+
     Node::Node(std::string_view name, bool tick_update, bool is_renderable) :
         m_name(name),
         m_tick_updating(tick_update),
@@ -46,6 +55,13 @@ namespace Game
     {
     }
 
+    Transform Node::InterpolatedWorldTransform() const
+    {
+        return Transform::Interpolated(
+            m_previous_world_transform, m_world_transform, m_owning_scene->TickInterpolation()
+        );
+    }
+
     RootNode& Node::SceneRoot() { return const_cast<RootNode&>(std::as_const(*this).SceneRoot()); }
 
     const RootNode& Node::SceneRoot() const
@@ -62,7 +78,49 @@ namespace Game
     /// Set whether this node should be updated every tick through OnTickUpdate.
     void Node::SetTickUpdate(bool tick_update_enabled)
     {
-        Scene().SetNodeTickUpdate(*this, tick_update_enabled);
+        const bool deferred = DeferWhileTicking(
+            [tick_update_enabled](Node& node)
+            {
+                node.SetTickUpdate(tick_update_enabled);
+            }
+        );
+        if (deferred || m_tick_updating == tick_update_enabled)
+        {
+            return;
+        }
+
+        m_tick_updating = tick_update_enabled;
+        if (m_owning_scene != nullptr)
+        {
+            m_owning_scene->SetNodeTickUpdate(*this, tick_update_enabled);
+        }
+    }
+
+    void Node::SetTickGroup(TickGroup group, bool parallel)
+    {
+        const bool deferred = DeferWhileTicking(
+            [group, parallel](Node& node)
+            {
+                node.SetTickGroup(group, parallel);
+            }
+        );
+        if (deferred)
+        {
+            return;
+        }
+
+        // the scene keeps a list per group, so the node moves between them.
+        const bool registered = m_owning_scene != nullptr && m_tick_updating;
+        if (registered)
+        {
+            m_owning_scene->SetNodeTickUpdate(*this, false);
+        }
+        m_tick_group = group;
+        m_parallel_tick = parallel;
+        if (registered)
+        {
+            m_owning_scene->SetNodeTickUpdate(*this, true);
+        }
     }
 
     void Node::Destroy()
@@ -84,16 +142,19 @@ namespace Game
     /// Destroy the given child node. All destruction has to go through this for proper release of resources.
     void Node::DestroyChild(NodeId_t child_node_id)
     {
-        auto found = std::find_if(
-            m_children.begin(),
-            m_children.end(),
-            [child_node_id](const std::unique_ptr<Node>& node)
+        const bool deferred = DeferWhileTicking(
+            [child_node_id](Node& node)
             {
-                return node->Id() == child_node_id;
+                node.DestroyChild(child_node_id);
             }
         );
+        if (deferred)
+        {
+            return;
+        }
 
-        if (found == m_children.end())
+        Node* child = m_owning_scene->NodeFromId(child_node_id);
+        if (child == nullptr || child->m_parent != this)
         {
             LogError(
                 "Trying to destroy a child(Id %u) that does not belong to this node(%s)",
@@ -103,36 +164,31 @@ namespace Game
             return;
         }
 
-        // destroy the children of the child recursively
-        std::vector<NodeId_t> children_nodes{};
-        children_nodes.reserve(found->get()->m_children.size());
-        for (const std::unique_ptr<Node>& child : found->get()->m_children)
-        {
-            children_nodes.emplace_back(child->m_id);
-        }
-
-        for (const NodeId_t child_id : children_nodes)
-        {
-            found->get()->DestroyChild(child_id);
-        }
-
-        m_owning_scene->ReleaseNode(*found->get());
-        m_children.erase(found);
+        // the whole subtree leaves the scene, then goes back to the pools when the child is dropped.
+        child->ReleaseChildren();
+        m_owning_scene->ReleaseNode(*child);
+        TakeChild(*child);
     }
 
     /// Move the given child from this node and attach them to another node instead.
     void Node::MoveChild(NodeId_t child_node_id, Node& new_parent)
     {
-        auto child_it = std::find_if(
-            m_children.begin(),
-            m_children.end(),
-            [child_node_id](const std::unique_ptr<Node>& node)
+        const bool deferred = DeferWhileTicking(
+            [child_node_id, new_parent_id = new_parent.Id()](Node& node)
             {
-                return node->Id() == child_node_id;
+                if (Node* parent = node.Scene().NodeFromId(new_parent_id))
+                {
+                    node.MoveChild(child_node_id, *parent);
+                }
             }
         );
+        if (deferred)
+        {
+            return;
+        }
 
-        if (child_it == m_children.end())
+        Node* child = m_owning_scene->NodeFromId(child_node_id);
+        if (child == nullptr || child->m_parent != this)
         {
             LogWarning(
                 "Trying to move a child(Id %u) that does not belong to this node(%s).",
@@ -142,8 +198,7 @@ namespace Game
             return;
         }
 
-        new_parent.AddChild(std::move(*child_it));
-        m_children.erase(child_it);
+        new_parent.AddChild(TakeChild(*child));
     }
 
     /// Attach this node to given node, detaching from the current parent.
@@ -194,16 +249,83 @@ namespace Game
         }
     }
 
-    void Node::PostCreateChild(Node& node) { m_owning_scene->RegisterNode(node); }
+    void Node::PostCreateChild(Node& node)
+    {
+        // registering changes the tick lists, which can't happen while they are ticked.
+        Node* created_node = &node;
+        const bool deferred = DeferWhileTicking(
+            [created_node](Node& parent)
+            {
+                parent.m_owning_scene->RegisterNode(*created_node);
+            }
+        );
+        if (deferred == false)
+        {
+            m_owning_scene->RegisterNode(node);
+        }
+    }
 
-    Node* Node::AddChild(std::unique_ptr<Node>&& node)
+    NodePool& Node::PoolFor(std::type_index type, size_t size, size_t alignment)
     {
-        std::unique_ptr<Node>& new_child = m_children.emplace_back(std::move(node));
+        return m_owning_scene->Allocator().PoolFor(type, size, alignment);
+    }
+
+    Node* Node::AddChild(NodePtr&& node)
+    {
+        NodePtr& new_child = m_children.emplace_back(std::move(node));
         new_child->m_parent = this;
+        new_child->m_child_index = m_children.size() - 1;
+        // set before registration, which waits for the sync point during a tick.
+        new_child->m_owning_scene = m_owning_scene;
         new_child->RefreshTransform();
         return new_child.get();
     }
 
+    NodePtr Node::TakeChild(Node& child)
+    {
+        const size_t index = child.m_child_index;
+        NodePtr taken = std::move(m_children[index]);
+        if (index + 1 < m_children.size())
+        {
+            m_children[index] = std::move(m_children.back());
+            m_children[index]->m_child_index = index;
+        }
+        m_children.pop_back();
+
+        taken->m_parent = nullptr;
+        taken->m_child_index = INVALID_INDEX;
+        return taken;
+    }
+
+    void Node::ReleaseChildren()
+    {
+        for (const NodePtr& child : m_children)
+        {
+            child->ReleaseChildren();
+            m_owning_scene->ReleaseNode(*child);
+        }
+    }
+
+    bool Node::DeferWhileTicking(std::function<void(Node&)> change)
+    {
+        if (m_owning_scene == nullptr || m_owning_scene->IsTicking() == false)
+        {
+            return false;
+        }
+
+        GameScene* scene = m_owning_scene;
+        m_owning_scene->DeferChange(
+            [scene, node_id = m_id, change = std::move(change)]()
+            {
+                if (Node* node = scene->NodeFromId(node_id))
+                {
+                    change(*node);
+                }
+            }
+        );
+        return true;
+    }
+
     void Node::RefreshTransform()
     {
         if (m_parent != nullptr)
@@ -215,7 +337,7 @@ namespace Game
             m_world_transform = m_local_transform;
         }
 
-        for (std::unique_ptr<Node>& node : m_children)
+        for (NodePtr& node : m_children)
         {
             node->RefreshTransform();
         }
@@ -0,0 +1,103 @@
+#include "Game/NodePool.h"
+#include "Game/Node.h"
+
+#include <new>
+#include <utility>
+
+namespace Game
+{
+    NodePool::NodePool(std::string type_name, size_t block_size, size_t block_alignment) :
+        m_type_name(std::move(type_name)),
+        m_block_size(block_size),
+        m_block_alignment(block_alignment)
+    {
+    }
+
+    NodePool::~NodePool()
+    {
+        for (std::byte* chunk : m_chunks)
+        {
+            ::operator delete(chunk, std::align_val_t(m_block_alignment));
+        }
+    }
+
+    void* NodePool::Allocate()
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_free_blocks.empty())
+        {
+            AddChunk();
+        }
+
+        void* block = m_free_blocks.back();
+        m_free_blocks.pop_back();
+        ++m_live_count;
+        return block;
+    }
+
+    void NodePool::Free(void* block)
+    {
+        std::lock_guard lock(m_mutex);
+        m_free_blocks.push_back(block);
+        --m_live_count;
+    }
+
+    size_t NodePool::LiveCount() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_live_count;
+    }
+
+    size_t NodePool::Capacity() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_chunks.size() * BLOCKS_PER_CHUNK;
+    }
+
+    void NodePool::AddChunk()
+    {
+        // sizeof is always a multiple of alignof, so consecutive blocks stay aligned.
+        std::byte* chunk = static_cast<std::byte*>(
+            ::operator new(m_block_size * BLOCKS_PER_CHUNK, std::align_val_t(m_block_alignment))
+        );
+        m_chunks.push_back(chunk);
+
+        // in reverse so the blocks are handed out in address order.
+        m_free_blocks.reserve(m_free_blocks.size() + BLOCKS_PER_CHUNK);
+        for (size_t block = BLOCKS_PER_CHUNK; block > 0; --block)
+        {
+            m_free_blocks.push_back(chunk + (block - 1) * m_block_size);
+        }
+    }
+
+    void NodeDeleter::operator()(Node* node) const
+    {
+        node->~Node();
+        pool->Free(node);
+    }
+
+    NodePool& NodeAllocator::PoolFor(std::type_index type, size_t size, size_t alignment)
+    {
+        std::lock_guard lock(m_mutex);
+        std::unique_ptr<NodePool>& pool = m_pools[type];
+        if (pool == nullptr)
+        {
+            pool = std::make_unique<NodePool>(type.name(), size, alignment);
+        }
+
+        return *pool;
+    }
+
+    std::vector<const NodePool*> NodeAllocator::Pools() const
+    {
+        std::lock_guard lock(m_mutex);
+        std::vector<const NodePool*> pools{};
+        pools.reserve(m_pools.size());
+        for (const auto& [type, pool] : m_pools)
+        {
+            pools.push_back(pool.get());
+        }
+
+        return pools;
+    }
+} // namespace Game
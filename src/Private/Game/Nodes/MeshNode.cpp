@@ -6,34 +6,137 @@
 #include "Renderer/FrameDrawContext.h"
 #include "Renderer/Utility/VkLoader.h"
 
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 
-namespace Game
+namespace
 {
-    MeshNode::MeshNode(std::string_view name, const Renderer::MeshHandle& mesh) :
-        Node(name, false, true),
-        m_mesh_asset(mesh)
+    // a coarser LOD is only picked once its error is this far under the limit, so objects sitting right at
+    // the threshold don't flicker between LODs.
+    constexpr float lod_hysteresis = 0.75f;
+
+    /// Conversion from object space error to pixels on screen for the closest point of the mesh bounds.
+    /// Infinite when the camera is inside the bounds.
+    float ObjectErrorToPixels(
+        const Renderer::FrameDrawContext& ctx, const glm::mat4& world, const Renderer::MeshBounds& bounds
+    )
     {
+        if (ctx.draw_extent.height == 0)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+
+        const float world_scale = std::max(
+            { glm::length(glm::vec3(world[0])),
+              glm::length(glm::vec3(world[1])),
+              glm::length(glm::vec3(world[2])) }
+        );
+        const glm::vec3 world_centre = glm::vec3(world * glm::vec4(bounds.Centre(), 1.0f));
+        const float world_radius = glm::length(bounds.Extent()) * 0.5f * world_scale;
+
+        const float distance = glm::distance(world_centre, ctx.CameraWorldPosition()) - world_radius;
+        if (distance <= 0.0f)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+
+        const float half_fov_tan = std::tan(glm::radians(ctx.camera_vertical_fov) * 0.5f);
+        const float pixels_per_unit_at_one = float(ctx.draw_extent.height) / (2.0f * half_fov_tan);
+        return world_scale * pixels_per_unit_at_one / distance;
     }
 
-    void MeshNode::OnAdded() {}
+    uint32_t SelectSurfaceLod(
+        const Renderer::GeoSurface& surface,
+        uint32_t current_lod,
+        float error_to_pixels,
+        float max_pixel_error
+    )
+    {
+        if (max_pixel_error <= 0.0f)
+        {
+            return 0;
+        }
 
-    void MeshNode::OnRemoved() {}
+        const auto pixel_error = [&](uint32_t lod)
+        {
+            return lod == 0 ? 0.0f : surface.Lod(lod).error * error_to_pixels;
+        };
 
-    void MeshNode::Draw(Renderer::FrameDrawContext& ctx)
+        uint32_t lod = std::min(current_lod, surface.LodCount() - 1);
+        while (lod > 0 && pixel_error(lod) > max_pixel_error)
+        {
+            --lod;
+        }
+        while (lod + 1 < surface.LodCount() && pixel_error(lod + 1) <= max_pixel_error * lod_hysteresis)
+        {
+            ++lod;
+        }
+
+        return lod;
+    }
+} // namespace
+
+namespace Game
+{
+    void AppendMeshRenderObjects(
+        Renderer::FrameDrawContext& ctx,
+        const Renderer::MeshHandle& mesh,
+        const glm::mat4& world_matrix,
+        std::vector<uint32_t>& surface_lods
+    )
     {
-        for (const Renderer::GeoSurface& surface : m_mesh_asset->surfaces)
+        const float error_to_pixels = ObjectErrorToPixels(ctx, world_matrix, mesh->buffers.bounds);
+
+        surface_lods.resize(mesh->surfaces.size(), 0);
+        for (size_t surface_idx = 0; surface_idx < mesh->surfaces.size(); ++surface_idx)
         {
+            const Renderer::GeoSurface& surface = mesh->surfaces[surface_idx];
+            const uint32_t lod =
+                SelectSurfaceLod(surface, surface_lods[surface_idx], error_to_pixels, ctx.lod_pixel_error);
+            surface_lods[surface_idx] = lod;
+            const Renderer::GeoSurfaceLod lod_range = surface.Lod(lod);
+
             Renderer::RenderObject obj{};
-            obj.index_buffer = m_mesh_asset->buffers.index_buffer->buffer;
-            obj.vertex_buffer_address = m_mesh_asset->buffers.vertex_buffer_address;
+            obj.index_buffer = mesh->buffers.index_buffer->buffer;
+            obj.vertex_buffer_address = mesh->buffers.vertex_buffer_address;
+            obj.vertex_format = mesh->buffers.vertex_format;
+            obj.bounds = mesh->buffers.bounds;
 
-            obj.first_index = surface.first_index;
-            obj.index_count = surface.index_count;
+            obj.first_index = mesh->buffers.first_index + lod_range.first_index;
+            obj.index_count = lod_range.index_count;
             obj.material = &surface.material->material;
-            obj.transform = WorldTransform().ToMatrix();
+            obj.transform = world_matrix;
+
+            // meshlets only exist for the full detail surface.
+            if (lod == 0 && mesh->buffers.meshlet_count > 0)
+            {
+                obj.index_buffer_address = mesh->buffers.index_buffer_address;
+                obj.meshlet_buffer_address = mesh->buffers.meshlet_buffer_address;
+                obj.first_meshlet = surface.first_meshlet;
+                obj.meshlet_count = surface.meshlet_count;
+            }
 
             ctx.render_objects.emplace_back(obj);
         }
     }
+
+    MeshNode::MeshNode(std::string_view name, const Renderer::MeshHandle& mesh) :
+        Node(name, false, true),
+        m_mesh_asset(mesh)
+    {
+    }
+
+    void MeshNode::OnAdded() {}
+
+    void MeshNode::OnRemoved() {}
+
+    void MeshNode::Draw(Renderer::FrameDrawContext& ctx)
+    {
+        AppendMeshRenderObjects(ctx, m_mesh_asset, InterpolatedWorldTransform().ToMatrix(), m_surface_lods);
+    }
 } // namespace Game
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "Game/TickScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // weight of the newest tick in the average tick cost.
+    constexpr double tick_cost_smoothing = 0.05;
+    constexpr float min_tick_rate = 1.0f;
+    constexpr uint32_t min_catch_up_steps = 1; // zero would never tick and keep accumulating time
+} // namespace
+
+namespace Game
+{
+    uint32_t TickScheduler::Advance(double delta_time_seconds)
+    {
+        accumulated_seconds += std::max(delta_time_seconds, 0.0);
+
+        const double tick_seconds = TickSeconds();
+        const uint32_t max_steps_per_frame = std::max(max_catch_up_steps, min_catch_up_steps);
+        uint32_t steps = uint32_t(accumulated_seconds / tick_seconds);
+        if (steps > max_steps_per_frame)
+        {
+            // catching up on every missed tick would make the next frame even longer, the game slows down.
+            const uint32_t dropped_steps = steps - max_steps_per_frame;
+            dropped_seconds += double(dropped_steps) * tick_seconds;
+            accumulated_seconds -= double(dropped_steps) * tick_seconds;
+            steps = max_steps_per_frame;
+        }
+        accumulated_seconds = std::max(accumulated_seconds - double(steps) * tick_seconds, 0.0);
+
+        last_steps = steps;
+        max_steps = std::max(max_steps, steps);
+        total_ticks += steps;
+        return steps;
+    }
+
+    double TickScheduler::TickSeconds() const { return 1.0 / double(std::max(tick_rate, min_tick_rate)); }
+
+    float TickScheduler::Interpolation() const
+    {
+        return float(std::clamp(accumulated_seconds / TickSeconds(), 0.0, 1.0));
+    }
+
+    void TickScheduler::RecordTick(double milliseconds)
+    {
+        last_tick_milliseconds = milliseconds;
+        average_tick_milliseconds =
+            average_tick_milliseconds == 0.0
+                ? milliseconds
+                : std::lerp(average_tick_milliseconds, milliseconds, tick_cost_smoothing);
+        max_tick_milliseconds = std::max(max_tick_milliseconds, milliseconds);
+    }
+
+    void TickScheduler::ResetStats()
+    {
+        max_steps = 0;
+        total_ticks = 0;
+        dropped_seconds = 0.0;
+        max_tick_milliseconds = 0.0;
+    }
+} // namespace Game
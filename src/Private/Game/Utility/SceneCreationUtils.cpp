@@ -40,9 +40,15 @@ namespace
 
 namespace Game::Utils
 {
-    void LoadGltfIntoGameScene(Renderer::VulkanEngine& engine, Node& node, std::filesystem::path file_path)
+    void LoadGltfIntoGameScene(
+        Renderer::VulkanEngine& engine,
+        Node& node,
+        std::filesystem::path file_path,
+        const Renderer::MeshImportSettings& import_settings
+    )
     {
-        const std::optional<Renderer::GLTFScene> scene = Renderer::Utils::LoadGltfScene(engine, file_path);
+        const std::optional<Renderer::GLTFScene> scene =
+            Renderer::Utils::LoadGltfScene(engine, file_path, import_settings);
 
         if (scene.has_value() == false)
         {
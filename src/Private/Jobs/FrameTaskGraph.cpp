@@ -0,0 +1,297 @@
+#include "Jobs/FrameTaskGraph.h"
+#include "Jobs/JobSystem.h"
+
+#include "ThirdParty/ImGUI.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+    int64_t NowMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count();
+    }
+} // namespace
+
+namespace Jobs
+{
+    JobId FrameTaskGraph::AddJob(
+        std::string name, std::function<void()> work, std::vector<JobId> dependencies, JobAffinity affinity
+    )
+    {
+        const JobId id = JobId(m_jobs.size());
+        for (JobId dependency : dependencies)
+        {
+            assert(dependency < id && "Dependencies need to be added before the jobs depending on them.");
+            m_jobs[dependency].dependents.push_back(id);
+        }
+
+        m_jobs.push_back(Job{ std::move(name), std::move(work), std::move(dependencies), {}, affinity, {} });
+        return id;
+    }
+
+    void FrameTaskGraph::Clear()
+    {
+        m_jobs.clear();
+        m_last_run_us = 0;
+    }
+
+    void FrameTaskGraph::Run(JobSystem& job_system)
+    {
+        if (m_jobs.empty())
+        {
+            return;
+        }
+
+        m_job_system = &job_system;
+        m_run_start_us = NowMicroseconds();
+
+        // atomics can't be copied, so the counters are only rebuilt when the graph changed.
+        if (m_remaining_dependencies.size() != m_jobs.size())
+        {
+            m_remaining_dependencies = std::vector<std::atomic<uint32_t>>(m_jobs.size());
+        }
+        for (size_t i = 0; i < m_jobs.size(); ++i)
+        {
+            m_remaining_dependencies[i].store(uint32_t(m_jobs[i].dependencies.size()));
+        }
+        m_unfinished_jobs.store(uint32_t(m_jobs.size()));
+
+        for (JobId job = 0; job < JobId(m_jobs.size()); ++job)
+        {
+            if (m_jobs[job].dependencies.empty())
+            {
+                Schedule(job);
+            }
+        }
+
+        // the main thread runs its jobs as soon as they become ready instead of waiting for the workers, so
+        // a main thread job never sits behind unrelated worker jobs. Every job either finishes on a worker or
+        // ends up in the queue, so this can't get stuck.
+        while (true)
+        {
+            JobId job;
+            {
+                std::unique_lock lock{ m_main_thread_mutex };
+                m_main_thread_condition.wait(
+                    lock,
+                    [this]()
+                    {
+                        return !m_main_thread_jobs.empty() || m_unfinished_jobs.load() == 0;
+                    }
+                );
+                if (m_main_thread_jobs.empty())
+                {
+                    break;
+                }
+                job = m_main_thread_jobs.front();
+                m_main_thread_jobs.pop_front();
+            }
+
+            Execute(job);
+        }
+
+        // every job is done, this only waits for the worker tasks to return.
+        job_system.Arena().execute(
+            [this]()
+            {
+                m_tasks.wait();
+            }
+        );
+
+        m_last_run_us = NowMicroseconds() - m_run_start_us;
+        m_job_system = nullptr;
+    }
+
+    void FrameTaskGraph::Schedule(JobId job)
+    {
+        if (m_jobs[job].affinity == JobAffinity::MainThread)
+        {
+            {
+                std::lock_guard lock{ m_main_thread_mutex };
+                m_main_thread_jobs.push_back(job);
+            }
+            m_main_thread_condition.notify_one();
+            return;
+        }
+
+        // the only arena slot is reserved for the main thread, nothing else would pick the job up.
+        if (m_job_system->WorkerCount() <= 1)
+        {
+            Execute(job);
+            return;
+        }
+
+        m_job_system->Arena().execute(
+            [this, job]()
+            {
+                m_tasks.run(
+                    [this, job]()
+                    {
+                        Execute(job);
+                    }
+                );
+            }
+        );
+    }
+
+    void FrameTaskGraph::Execute(JobId job)
+    {
+        Job& executed = m_jobs[job];
+        executed.timing.thread_slot = JobSystem::CurrentThreadSlot();
+        executed.timing.start_us = NowMicroseconds() - m_run_start_us;
+
+        executed.work();
+
+        executed.timing.end_us = NowMicroseconds() - m_run_start_us;
+
+        for (JobId dependent : executed.dependents)
+        {
+            if (m_remaining_dependencies[dependent].fetch_sub(1) == 1)
+            {
+                Schedule(dependent);
+            }
+        }
+
+        if (m_unfinished_jobs.fetch_sub(1) == 1)
+        {
+            // taking the lock makes sure the main thread is either waiting or will see the count.
+            {
+                std::lock_guard lock{ m_main_thread_mutex };
+            }
+            m_main_thread_condition.notify_one();
+        }
+    }
+
+    void FrameTaskGraph::DrawImGui() const
+    {
+        ImGui::Text("Last run: %.3f ms", double(m_last_run_us) / 1000.0);
+
+        if (ImGui::BeginTable("frame_task_graph_jobs", 5, ImGuiTableFlags_Borders))
+        {
+            ImGui::TableSetupColumn("Job");
+            ImGui::TableSetupColumn("Depends On");
+            ImGui::TableSetupColumn("Thread");
+            ImGui::TableSetupColumn("Start (ms)");
+            ImGui::TableSetupColumn("Duration (ms)");
+            ImGui::TableHeadersRow();
+
+            for (const Job& job : m_jobs)
+            {
+                std::string dependencies{};
+                for (JobId dependency : job.dependencies)
+                {
+                    dependencies += dependencies.empty() ? "" : ", ";
+                    dependencies += m_jobs[dependency].name;
+                }
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", job.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", dependencies.c_str());
+                ImGui::TableNextColumn();
+                if (job.timing.thread_slot < 0)
+                {
+                    ImGui::Text("main");
+                }
+                else
+                {
+                    ImGui::Text("worker %d", job.timing.thread_slot);
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", double(job.timing.start_us) / 1000.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", double(job.timing.end_us - job.timing.start_us) / 1000.0);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::Button("Copy Graphviz"))
+        {
+            ImGui::SetClipboardText(ToGraphviz().c_str());
+        }
+
+        // timeline with a lane for the main thread and each worker that ran a job.
+        if (m_last_run_us <= 0)
+        {
+            return;
+        }
+
+        int32_t max_slot = -1;
+        for (const Job& job : m_jobs)
+        {
+            max_slot = std::max(max_slot, job.timing.thread_slot);
+        }
+
+        const float lane_height = ImGui::GetTextLineHeightWithSpacing();
+        const float label_width = ImGui::CalcTextSize("worker 00").x + ImGui::GetStyle().ItemSpacing.x;
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float width = std::max(ImGui::GetContentRegionAvail().x - label_width, 1.0f);
+        const float us_to_pixels = width / float(m_last_run_us);
+        ImDrawList* draw_list = ImGui::GetWindowDrawList();
+
+        for (int32_t slot = -1; slot <= max_slot; ++slot)
+        {
+            const float lane_y = origin.y + float(slot + 1) * lane_height;
+            const std::string label = slot < 0 ? "main" : "worker " + std::to_string(slot);
+            draw_list->AddText(ImVec2(origin.x, lane_y), ImGui::GetColorU32(ImGuiCol_Text), label.c_str());
+
+            for (const Job& job : m_jobs)
+            {
+                if (job.timing.thread_slot != slot)
+                {
+                    continue;
+                }
+
+                const float start_x = origin.x + label_width + float(job.timing.start_us) * us_to_pixels;
+                const float end_x = origin.x + label_width + float(job.timing.end_us) * us_to_pixels;
+                const ImVec2 min{ start_x, lane_y };
+                const ImVec2 max{ std::max(end_x, start_x + 2.0f), lane_y + lane_height - 2.0f };
+                draw_list->AddRectFilled(min, max, ImGui::GetColorU32(ImGuiCol_PlotHistogram));
+                draw_list->PushClipRect(min, max, true);
+                draw_list->AddText(min, ImGui::GetColorU32(ImGuiCol_Text), job.name.c_str());
+                draw_list->PopClipRect();
+                if (ImGui::IsMouseHoveringRect(min, max))
+                {
+                    const double duration_ms = double(job.timing.end_us - job.timing.start_us) / 1000.0;
+                    ImGui::SetTooltip("%s: %.3f ms", job.name.c_str(), duration_ms);
+                }
+            }
+        }
+
+        ImGui::Dummy(ImVec2(width + label_width, float(max_slot + 2) * lane_height));
+    }
+
+    std::string FrameTaskGraph::ToGraphviz() const
+    {
+        std::ostringstream stream;
+        stream << "digraph frame {\n";
+        for (JobId job = 0; job < JobId(m_jobs.size()); ++job)
+        {
+            const JobTiming& timing = m_jobs[job].timing;
+            const double duration_ms = double(timing.end_us - timing.start_us) / 1000.0;
+            stream << "    job" << job << " [label=\"" << m_jobs[job].name << "\\n" << duration_ms << " ms\"";
+            if (m_jobs[job].affinity == JobAffinity::MainThread)
+            {
+                stream << " shape=box";
+            }
+            stream << "];\n";
+
+            for (JobId dependency : m_jobs[job].dependencies)
+            {
+                stream << "    job" << dependency << " -> job" << job << ";\n";
+            }
+        }
+        stream << "}\n";
+
+        return stream.str();
+    }
+} // namespace Jobs
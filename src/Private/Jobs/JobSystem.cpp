@@ -0,0 +1,52 @@
+#include "Jobs/JobSystem.h"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace Jobs
+{
+    JobSystem::JobSystem(uint32_t worker_count) :
+        m_arena(int(worker_count > 0 ? worker_count : std::max(std::thread::hardware_concurrency(), 1u)))
+    {
+        m_arena.initialize();
+    }
+
+    void JobSystem::ParallelFor(
+        size_t count, size_t grain_size, const std::function<void(size_t, size_t)>& body
+    )
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // not worth waking up the workers.
+        if (count <= grain_size)
+        {
+            body(0, count);
+            return;
+        }
+
+        m_arena.execute(
+            [&]()
+            {
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, count, std::max(grain_size, size_t(1))),
+                    [&body](const tbb::blocked_range<size_t>& range)
+                    {
+                        body(range.begin(), range.end());
+                    }
+                );
+            }
+        );
+    }
+
+    int32_t JobSystem::CurrentThreadSlot()
+    {
+        const int slot = tbb::this_task_arena::current_thread_index();
+        return slot >= 0 ? int32_t(slot) : -1;
+    }
+} // namespace Jobs
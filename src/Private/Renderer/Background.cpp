@@ -0,0 +1,87 @@
+#include "Renderer/Background.h"
+#include "Renderer/Utility/VkDescriptors.h"
+#include "Renderer/Utility/VkPipelines.h"
+
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <iostream>
+
+namespace Renderer
+{
+    bool BackgroundPass::BuildPipelines(vkb::DispatchTable& device_dispatch)
+    {
+        Utils::DescriptorLayoutBuilder layout_builder;
+        layout_builder.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE); // draw image
+        descriptor_layout = layout_builder.Build(device_dispatch, VK_SHADER_STAGE_COMPUTE_BIT);
+
+        VkPushConstantRange range{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(BackgroundPushConstants) };
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.pSetLayouts = &descriptor_layout;
+        pipeline_layout_info.setLayoutCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &range;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+
+        VkResult result = device_dispatch.createPipelineLayout(&pipeline_layout_info, nullptr, &layout);
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "[!] Failed to create pipeline layout for backgrounds. Vulkan Error: "
+                      << string_VkResult(result) << std::endl;
+            return false;
+        }
+
+        ComputeEffect gradient{};
+        gradient.name = "gradient";
+        gradient.path = "../data/shader/gradient_color.comp.spv";
+        gradient.push_constants.data1 = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f); // top colour
+        gradient.push_constants.data2 = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // bottom colour
+
+        ComputeEffect sky{};
+        sky.name = "sky";
+        sky.path = "../data/shader/sky.comp.spv";
+        sky.push_constants.data1 = glm::vec4(0.1f, 0.2f, 0.4f, 0.97f); // colour and star threshold
+
+        // effects whose shader doesn't load are left out, the pass works as long as one of them does.
+        for (ComputeEffect effect : { sky, gradient })
+        {
+            VkShaderModule shader;
+            if (Utils::LoadShaderModule(device_dispatch, effect.path, &shader) == false)
+            {
+                std::cerr << "[!] Failed to load background shader " << effect.path << "." << std::endl;
+                continue;
+            }
+
+            effect.layout = layout;
+            effect.pipeline = Utils::BuildComputePipeline(device_dispatch, layout, shader);
+            device_dispatch.destroyShaderModule(shader, nullptr);
+            if (effect.pipeline != VK_NULL_HANDLE)
+            {
+                effects.push_back(effect);
+            }
+        }
+
+        loaded = effects.empty() == false;
+        return loaded;
+    }
+
+    void BackgroundPass::DestroyResources(vkb::DispatchTable& device_dispatch)
+    {
+        for (ComputeEffect& effect : effects)
+        {
+            device_dispatch.destroyPipeline(effect.pipeline, nullptr);
+        }
+        effects.clear();
+        if (layout != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyPipelineLayout(layout, nullptr);
+            layout = VK_NULL_HANDLE;
+        }
+        if (descriptor_layout != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyDescriptorSetLayout(descriptor_layout, nullptr);
+            descriptor_layout = VK_NULL_HANDLE;
+        }
+        loaded = false;
+    }
+} // namespace Renderer
@@ -0,0 +1,61 @@
+#include "Renderer/DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // timings are a few frames old, wait for them to reflect a new scale before changing it again.
+    constexpr uint32_t SETTLE_FRAMES = 4;
+    constexpr double SMOOTHING = 0.1;
+
+    // scale down quickly to avoid dropping frames, scale up slowly to avoid oscillating.
+    constexpr float MAX_SCALE_DECREASE = 0.1f;
+    constexpr float MAX_SCALE_INCREASE = 0.02f;
+} // namespace
+
+namespace Renderer
+{
+    float DynamicResolution::Update(float render_scale, double gpu_milliseconds)
+    {
+        const float lowest_scale = std::min(min_scale, max_scale);
+        const float clamped_scale = std::clamp(render_scale, lowest_scale, max_scale);
+        if (gpu_milliseconds <= 0.0 || target_milliseconds <= 0.0f)
+        {
+            return clamped_scale;
+        }
+
+        // timings of the frames in flight were measured with the old scale, skip them.
+        if (frames_until_change > 0)
+        {
+            --frames_until_change;
+            return clamped_scale;
+        }
+
+        smoothed_milliseconds = smoothed_milliseconds == 0.0
+                                    ? gpu_milliseconds
+                                    : std::lerp(smoothed_milliseconds, gpu_milliseconds, SMOOTHING);
+
+        const double ratio = double(target_milliseconds) / smoothed_milliseconds;
+        if (ratio > 1.0 - tolerance && ratio < 1.0 + tolerance)
+        {
+            return clamped_scale;
+        }
+
+        // GPU time is roughly proportional to the pixel count, which is the square of the scale.
+        float new_scale = clamped_scale * float(std::sqrt(ratio));
+        new_scale = std::clamp(
+            new_scale, clamped_scale - MAX_SCALE_DECREASE, clamped_scale + MAX_SCALE_INCREASE
+        );
+        new_scale = std::clamp(new_scale, lowest_scale, max_scale);
+
+        if (std::abs(new_scale - clamped_scale) > 0.001f)
+        {
+            // start smoothing over once the new scale shows up in the timings.
+            frames_until_change = SETTLE_FRAMES;
+            smoothed_milliseconds = 0.0;
+        }
+
+        return new_scale;
+    }
+} // namespace Renderer
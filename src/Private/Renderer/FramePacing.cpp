@@ -0,0 +1,191 @@
+#include "Renderer/FramePacing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    // sleeps aren't precise, the last bit of the wait spins instead.
+    constexpr int64_t SPIN_MICROSECONDS = 1'000;
+    constexpr double LATENCY_SMOOTHING = 0.05;
+} // namespace
+
+namespace Renderer
+{
+    VkPresentModeKHR ToVkPresentMode(PresentMode mode)
+    {
+        switch (mode)
+        {
+        case PresentMode::Fifo:
+            return VK_PRESENT_MODE_FIFO_KHR;
+        case PresentMode::Mailbox:
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        case PresentMode::Immediate:
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        case PresentMode::FifoRelaxed:
+            return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        }
+
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    const char* PresentModeName(PresentMode mode) { return PresentModeName(ToVkPresentMode(mode)); }
+
+    const char* PresentModeName(VkPresentModeKHR mode)
+    {
+        switch (mode)
+        {
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "FIFO";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "MAILBOX";
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "IMMEDIATE";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "FIFO_RELAXED";
+        default:
+            return "UNKNOWN";
+        }
+    }
+
+    void FrameLimiter::Wait()
+    {
+        if (max_fps <= 0.0f)
+        {
+            next_frame_us = 0;
+            return;
+        }
+
+        const int64_t frame_us = int64_t(1'000'000.0 / double(max_fps));
+        int64_t now_us = FramePacingTimeMicroseconds();
+
+        // start over if this is the first limited frame or we fell more than a frame behind, otherwise the
+        // limiter would let frames through unlimited to catch up.
+        if (next_frame_us == 0 || now_us - next_frame_us > frame_us)
+        {
+            next_frame_us = now_us + frame_us;
+            return;
+        }
+
+        if (next_frame_us - now_us > SPIN_MICROSECONDS)
+        {
+            const int64_t sleep_us = next_frame_us - now_us - SPIN_MICROSECONDS;
+            std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+        }
+        while (FramePacingTimeMicroseconds() < next_frame_us)
+        {
+            std::this_thread::yield();
+        }
+
+        // stepping from the deadline rather than from now keeps the average rate exact.
+        next_frame_us += frame_us;
+    }
+
+    void InputLatency::RecordInput()
+    {
+        if (pending_input_us == 0)
+        {
+            pending_input_us = FramePacingTimeMicroseconds();
+        }
+    }
+
+    int64_t InputLatency::TakeInput()
+    {
+        const int64_t input_us = pending_input_us;
+        pending_input_us = 0;
+        return input_us;
+    }
+
+    void InputLatency::RecordPresent(int64_t input_us)
+    {
+        if (input_us == 0)
+        {
+            return;
+        }
+
+        last_milliseconds = double(FramePacingTimeMicroseconds() - input_us) / 1000.0;
+        average_milliseconds = average_milliseconds == 0.0
+                                   ? last_milliseconds
+                                   : std::lerp(average_milliseconds, last_milliseconds, LATENCY_SMOOTHING);
+        max_milliseconds = std::max(max_milliseconds, last_milliseconds);
+    }
+
+    uint32_t FramesInFlightBenchmark::Start(uint32_t current_frames_in_flight)
+    {
+        running = true;
+        restore_frames_in_flight = current_frames_in_flight;
+        stage_frames = 0;
+
+        results.clear();
+        results.push_back(FramesInFlightResult{ .frames_in_flight = 1 });
+        return 1;
+    }
+
+    uint32_t FramesInFlightBenchmark::Update(
+        uint32_t frames_in_flight,
+        double frame_milliseconds,
+        double fence_wait_milliseconds,
+        double gpu_milliseconds
+    )
+    {
+        if (running == false)
+        {
+            return frames_in_flight;
+        }
+
+        // the frames in flight were changed from somewhere else, whatever we measure now is meaningless.
+        FramesInFlightResult& result = results.back();
+        if (result.frames_in_flight != frames_in_flight)
+        {
+            running = false;
+            return frames_in_flight;
+        }
+
+        ++stage_frames;
+        if (stage_frames <= WARMUP_FRAMES)
+        {
+            return frames_in_flight;
+        }
+
+        // running sums, turned into averages once the stage is done.
+        ++result.measured_frames;
+        result.frame_milliseconds += frame_milliseconds;
+        result.fence_wait_milliseconds += fence_wait_milliseconds;
+        if (gpu_milliseconds >= 0.0)
+        {
+            ++result.gpu_measured_frames;
+            result.gpu_milliseconds += gpu_milliseconds;
+        }
+
+        if (result.measured_frames < MEASURED_FRAMES)
+        {
+            return frames_in_flight;
+        }
+
+        result.frame_milliseconds /= double(result.measured_frames);
+        result.fence_wait_milliseconds /= double(result.measured_frames);
+        result.gpu_milliseconds = result.gpu_measured_frames > 0
+                                      ? result.gpu_milliseconds / double(result.gpu_measured_frames)
+                                      : -1.0;
+
+        if (frames_in_flight >= MAX_FRAME_OVERLAP)
+        {
+            running = false;
+            return restore_frames_in_flight;
+        }
+
+        stage_frames = 0;
+        results.push_back(FramesInFlightResult{ .frames_in_flight = frames_in_flight + 1 });
+        return frames_in_flight + 1;
+    }
+
+    int64_t FramePacingTimeMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count();
+    }
+} // namespace Renderer
@@ -0,0 +1,194 @@
+#include "Renderer/GeometryPool.h"
+
+#include "Renderer/ResourceStorage.h"
+#include "Renderer/VkEngine.h"
+#include "Renderer/VkTypes.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+
+namespace Renderer
+{
+    void RangeAllocator::Init(VkDeviceSize capacity)
+    {
+        m_free_ranges.clear();
+        m_free_ranges.emplace(0, capacity);
+        m_capacity = capacity;
+        m_used_bytes = 0;
+    }
+
+    std::optional<GeometryRange> RangeAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        if (size == 0)
+        {
+            return std::nullopt;
+        }
+
+        for (auto it = m_free_ranges.begin(); it != m_free_ranges.end(); ++it)
+        {
+            const VkDeviceSize free_offset = it->first;
+            const VkDeviceSize free_size = it->second;
+            const VkDeviceSize offset = (free_offset + alignment - 1) / alignment * alignment;
+            const VkDeviceSize padding = offset - free_offset;
+            if (padding + size > free_size)
+            {
+                continue;
+            }
+
+            // the alignment padding in front stays free, so does whatever is left behind the range.
+            m_free_ranges.erase(it);
+            if (padding > 0)
+            {
+                m_free_ranges.emplace(free_offset, padding);
+            }
+            if (padding + size < free_size)
+            {
+                m_free_ranges.emplace(offset + size, free_size - padding - size);
+            }
+
+            m_used_bytes += size;
+            return GeometryRange{ offset, size };
+        }
+
+        return std::nullopt;
+    }
+
+    void RangeAllocator::Free(GeometryRange range)
+    {
+        if (range.size == 0)
+        {
+            return;
+        }
+
+        m_used_bytes -= range.size;
+        auto [it, inserted] = m_free_ranges.emplace(range.offset, range.size);
+
+        // merge with the free range behind and then the one in front.
+        auto next = std::next(it);
+        if (next != m_free_ranges.end() && it->first + it->second == next->first)
+        {
+            it->second += next->second;
+            m_free_ranges.erase(next);
+        }
+        if (it != m_free_ranges.begin())
+        {
+            auto previous = std::prev(it);
+            if (previous->first + previous->second == it->first)
+            {
+                previous->second += it->second;
+                m_free_ranges.erase(it);
+            }
+        }
+    }
+
+    VkDeviceSize RangeAllocator::LargestFreeRange() const
+    {
+        VkDeviceSize largest = 0;
+        for (const auto& [offset, size] : m_free_ranges)
+        {
+            largest = std::max(largest, size);
+        }
+        return largest;
+    }
+
+    void GeometryPool::Init(VulkanEngine& engine)
+    {
+        // same usages as the buffers of a single mesh, see VulkanEngine::UploadMesh.
+        m_vertex_buffer = engine.CreateBuffer(
+            VERTEX_POOL_BYTES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            0,
+            "geometry_pool_vertices"
+        );
+        m_index_buffer = engine.CreateBuffer(
+            INDEX_POOL_BYTES,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            0,
+            "geometry_pool_indices"
+        );
+
+        std::lock_guard lock{ m_mutex };
+        m_vertex_buffer_address = engine.BufferDeviceAddress(m_vertex_buffer);
+        m_index_buffer_address = engine.BufferDeviceAddress(m_index_buffer);
+        m_vertex_ranges.Init(VERTEX_POOL_BYTES);
+        m_index_ranges.Init(INDEX_POOL_BYTES);
+        m_fallback_meshes = 0;
+    }
+
+    void GeometryPool::Destroy()
+    {
+        m_vertex_buffer = BufferHandle{};
+        m_index_buffer = BufferHandle{};
+    }
+
+    bool GeometryPool::Allocate(GPUMeshBuffers& buffers, VkDeviceSize vertex_bytes, VkDeviceSize index_bytes)
+    {
+        std::lock_guard lock{ m_mutex };
+        if (m_vertex_buffer.IsValid() == false)
+        {
+            return false;
+        }
+
+        // an empty mesh or one without indices gets an empty range, which Free skips.
+        std::optional<GeometryRange> vertex_range =
+            vertex_bytes == 0 ? GeometryRange{} : m_vertex_ranges.Allocate(vertex_bytes, VERTEX_ALIGNMENT);
+        std::optional<GeometryRange> index_range =
+            index_bytes == 0 ? GeometryRange{} : m_index_ranges.Allocate(index_bytes, sizeof(uint32_t));
+        if (vertex_range.has_value() == false || index_range.has_value() == false)
+        {
+            if (vertex_range.has_value())
+            {
+                m_vertex_ranges.Free(*vertex_range);
+            }
+            if (index_range.has_value())
+            {
+                m_index_ranges.Free(*index_range);
+            }
+
+            if (m_fallback_meshes++ == 0)
+            {
+                std::cerr << "[!] Geometry pool is full, meshes get buffers of their own from now on."
+                          << std::endl;
+            }
+            return false;
+        }
+
+        buffers.vertex_buffer = m_vertex_buffer;
+        buffers.index_buffer = m_index_buffer;
+        buffers.vertex_range = *vertex_range;
+        buffers.index_range = *index_range;
+        buffers.first_index = static_cast<uint32_t>(index_range->offset / sizeof(uint32_t));
+        buffers.vertex_buffer_address = m_vertex_buffer_address + vertex_range->offset;
+        buffers.index_buffer_address = m_index_buffer_address + index_range->offset;
+        return true;
+    }
+
+    void GeometryPool::Free(VulkanEngine& engine, const GPUMeshBuffers& buffers)
+    {
+        if (buffers.vertex_range.size == 0 && buffers.index_range.size == 0)
+        {
+            return;
+        }
+
+        // frames in flight can still draw the mesh, its ranges are reused once this frame comes around again.
+        engine.GetCurrentFrame().deletion_queue.PushFunction(
+            "geometry pool ranges",
+            [this, vertex_range = buffers.vertex_range, index_range = buffers.index_range]()
+            {
+                std::lock_guard lock{ m_mutex };
+                m_vertex_ranges.Free(vertex_range);
+                m_index_ranges.Free(index_range);
+            }
+        );
+    }
+} // namespace Renderer
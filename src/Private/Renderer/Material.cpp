@@ -6,6 +6,7 @@
 #include "Renderer/VkTypes.h"
 
 #include <array>
+#include <utility>
 #include <vulkan/vk_enum_string_helper.h>
 #include <vulkan/vulkan_core.h>
 
@@ -14,11 +15,11 @@ namespace Renderer
     bool Material_GLTF_PBR::BuildPipelines(MaterialEngineInterface& interface)
     {
         Utils::DescriptorLayoutBuilder descriptor_layout_builder;
-        descriptor_layout_builder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);         // parameters
-        descriptor_layout_builder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER); // colour sampler
+        descriptor_layout_builder.AddBinding(PARAMETERS_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        descriptor_layout_builder.AddBinding(COLOUR_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
         descriptor_layout_builder.AddBinding(
-            2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
-        ); // metal_roughness sampler
+            METAL_ROUGHNESS_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        );
 
         descriptor_layout = descriptor_layout_builder.Build(
             *interface.device_dispatch_table, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT
@@ -92,6 +93,9 @@ namespace Renderer
 
         opaque_pipeline.pipeline = pipeline_builder.BuildPipeline(*interface.device_dispatch_table);
 
+        BuildDepthPrepassPipelines(interface, pipeline_builder);
+
+        pipeline_builder.EnableDepthTest(VK_COMPARE_OP_GREATER_OR_EQUAL);
         pipeline_builder.EnableBlendingAlpha(); // alpha blending for transparent
         transparent_pipeline.pipeline = pipeline_builder.BuildPipeline(*interface.device_dispatch_table);
 
@@ -105,11 +109,57 @@ namespace Renderer
         return true;
     }
 
+    void Material_GLTF_PBR::BuildDepthPrepassPipelines(
+        MaterialEngineInterface& interface, Utils::PipelineBuilder& opaque_builder
+    )
+    {
+        // the pre-pass is optional, viewports draw without it if the pipelines aren't there.
+        VkShaderModule depth_vert_shader;
+        if (Utils::LoadShaderModule(
+                *interface.device_dispatch_table, "../data/shader/depth_only.vert.spv", &depth_vert_shader
+            ) == false)
+        {
+            std::cerr << "[!] Failed to load depth only vertex shader, depth pre-pass is unavailable."
+                      << std::endl;
+            return;
+        }
+
+        // no fragment shader or colour attachment, only depth is written.
+        opaque_pipeline.depth_prepass_pipeline =
+            Utils::PipelineBuilder{}
+                .SetLayout(opaque_pipeline.layout)
+                .AddVertexShader(depth_vert_shader)
+                .SetCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+                .SetInputTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+                .SetPolygonMode(VK_POLYGON_MODE_FILL)
+                .SetDepthFormat(interface.depth_image_format)
+                .EnableDepthTest(VK_COMPARE_OP_GREATER_OR_EQUAL)
+                .SetMultisamplingNone()
+                .DisableBlending()
+                .BuildPipeline(*interface.device_dispatch_table);
+
+        interface.device_dispatch_table->destroyShaderModule(depth_vert_shader, nullptr);
+
+        // depth is already final, only shade the closest surface.
+        opaque_builder.EnableDepthTest(VK_COMPARE_OP_EQUAL, false);
+        opaque_pipeline.depth_equal_pipeline = opaque_builder.BuildPipeline(*interface.device_dispatch_table);
+    }
+
     void Material_GLTF_PBR::DestroyResources(vkb::DispatchTable& device_dispatch)
     {
         // nuke any living descriptors
         descriptor_allocator.DestroyPools(device_dispatch);
 
+        for (VkPipeline* pipeline :
+             { &opaque_pipeline.depth_prepass_pipeline, &opaque_pipeline.depth_equal_pipeline })
+        {
+            if (*pipeline != VK_NULL_HANDLE)
+            {
+                device_dispatch.destroyPipeline(*pipeline, nullptr);
+                *pipeline = VK_NULL_HANDLE;
+            }
+        }
+
         if (opaque_pipeline.pipeline != VK_NULL_HANDLE)
         {
             device_dispatch.destroyPipeline(opaque_pipeline.pipeline, nullptr);
@@ -148,7 +198,7 @@ namespace Renderer
 
         // 0 is uniform buffer which is MaterialParameters
         descriptor_writer.WriteBuffer(
-            0,
+            PARAMETERS_BINDING,
             resources.uniform_buffer->buffer,
             sizeof(MaterialParameters),
             resources.buffer_offset,
@@ -157,14 +207,14 @@ namespace Renderer
 
         // 1 is colour image and 2 is metal_roughness image
         descriptor_writer.WriteImage(
-            1,
+            COLOUR_BINDING,
             resources.colour_image->image_view,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
             resources.colour_sampler,
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
         );
         descriptor_writer.WriteImage(
-            2,
+            METAL_ROUGHNESS_BINDING,
             resources.metal_roughness_image->image_view,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
             resources.metal_roughness_sampler,
@@ -192,4 +242,56 @@ namespace Renderer
                                  { resources.colour_image, resources.metal_roughness_image },
                                  { resources.uniform_buffer } };
     }
+
+    VkDescriptorSet Material_GLTF_PBR::ReplaceImage(
+        vkb::DispatchTable& device_dispatch,
+        MaterialInstance& instance,
+        uint32_t binding,
+        VkImageView image_view,
+        VkSampler sampler
+    )
+    {
+        VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+        if (recycled_sets.empty() == false)
+        {
+            descriptor_set = recycled_sets.back();
+            recycled_sets.pop_back();
+        }
+        else
+        {
+            descriptor_set = descriptor_allocator.Allocate(device_dispatch, descriptor_layout);
+        }
+
+        // everything but the replaced binding stays the same.
+        std::array<VkCopyDescriptorSet, 2> copies{};
+        uint32_t copy_count = 0;
+        for (uint32_t copied_binding : { PARAMETERS_BINDING, COLOUR_BINDING, METAL_ROUGHNESS_BINDING })
+        {
+            if (copied_binding == binding)
+            {
+                continue;
+            }
+
+            VkCopyDescriptorSet& copy = copies[copy_count++];
+            copy.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+            copy.srcSet = instance.material_set;
+            copy.srcBinding = copied_binding;
+            copy.dstSet = descriptor_set;
+            copy.dstBinding = copied_binding;
+            copy.descriptorCount = 1;
+        }
+        device_dispatch.updateDescriptorSets(0, nullptr, copy_count, copies.data());
+
+        Utils::DescriptorWriter descriptor_writer{};
+        descriptor_writer.WriteImage(
+            binding,
+            image_view,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            sampler,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        );
+        descriptor_writer.UpdateSet(device_dispatch, descriptor_set);
+
+        return std::exchange(instance.material_set, descriptor_set);
+    }
 } // namespace Renderer
\ No newline at end of file
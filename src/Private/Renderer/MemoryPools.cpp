@@ -0,0 +1,635 @@
+#include "Renderer/MemoryPools.h"
+#include "Renderer/TextureResidency.h"
+#include "Renderer/Utility/VkImages.h"
+#include "Renderer/Utility/VkInitialisers.h"
+#include "Renderer/VkEngine.h"
+#include "Renderer/VkTypes.h"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace Renderer
+{
+    namespace
+    {
+        // the lowest bit of the user data tells images from buffers, the rest is the storage id.
+        void* MoveUserData(StorageId_t id, bool is_image)
+        {
+            return reinterpret_cast<void*>((uintptr_t(id) << 1) | uintptr_t(is_image));
+        }
+
+        // memory type of the pool, picked for a resource representative of the class.
+        std::optional<uint32_t> PoolMemoryType(VmaAllocator allocator, AllocationClass allocation_class)
+        {
+            constexpr VmaAllocationCreateFlags upload_flags =
+                VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
+            constexpr VkBufferUsageFlags move_usage =
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+            VkBufferCreateInfo buffer_info{};
+            buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_info.size = 64 * 1024;
+
+            VmaAllocationCreateInfo allocation_info{};
+            uint32_t memory_type = 0;
+            VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+            switch (allocation_class)
+            {
+            case AllocationClass::Mesh:
+                buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | move_usage;
+                allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+                result = vmaFindMemoryTypeIndexForBufferInfo(
+                    allocator, &buffer_info, &allocation_info, &memory_type
+                );
+                break;
+            case AllocationClass::Material:
+                buffer_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+                allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+                allocation_info.flags = upload_flags;
+                result = vmaFindMemoryTypeIndexForBufferInfo(
+                    allocator, &buffer_info, &allocation_info, &memory_type
+                );
+                break;
+            case AllocationClass::Texture:
+            {
+                VkImageCreateInfo image_info = Utils::ImageCreateInfo(
+                    VK_FORMAT_R8G8B8A8_UNORM,
+                    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                    VkExtent3D{ 1024, 1024, 1 }
+                );
+                allocation_info.usage = VMA_MEMORY_USAGE_AUTO;
+                allocation_info.flags = upload_flags;
+                result = vmaFindMemoryTypeIndexForImageInfo(
+                    allocator, &image_info, &allocation_info, &memory_type
+                );
+                break;
+            }
+            case AllocationClass::Transient:
+                buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+                allocation_info.usage = VMA_MEMORY_USAGE_AUTO;
+                allocation_info.flags =
+                    VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+                result = vmaFindMemoryTypeIndexForBufferInfo(
+                    allocator, &buffer_info, &allocation_info, &memory_type
+                );
+                break;
+            case AllocationClass::General:
+            case AllocationClass::Count:
+                break;
+            }
+
+            if (result != VK_SUCCESS)
+            {
+                return std::nullopt;
+            }
+            return memory_type;
+        }
+    } // namespace
+
+    const char* AllocationClassName(AllocationClass allocation_class)
+    {
+        switch (allocation_class)
+        {
+        case AllocationClass::General:
+            return "General";
+        case AllocationClass::Mesh:
+            return "Mesh";
+        case AllocationClass::Material:
+            return "Material";
+        case AllocationClass::Texture:
+            return "Texture";
+        case AllocationClass::Transient:
+            return "Transient";
+        case AllocationClass::Count:
+            break;
+        }
+        return "Unknown";
+    }
+
+    void MemoryPools::Init(VmaAllocator allocator)
+    {
+        // General stays in the default pools.
+        for (size_t pool_index = 1; pool_index < m_pools.size(); ++pool_index)
+        {
+            const AllocationClass allocation_class = static_cast<AllocationClass>(pool_index);
+            std::optional<uint32_t> memory_type = PoolMemoryType(allocator, allocation_class);
+            if (memory_type.has_value() == false)
+            {
+                std::cerr << "[!] No memory type for the " << AllocationClassName(allocation_class)
+                          << " pool, its resources use the default pools." << std::endl;
+                continue;
+            }
+
+            VmaPoolCreateInfo pool_info{};
+            pool_info.memoryTypeIndex = *memory_type;
+            if (vmaCreatePool(allocator, &pool_info, &m_pools[pool_index]) != VK_SUCCESS)
+            {
+                std::cerr << "[!] Failed to create the " << AllocationClassName(allocation_class)
+                          << " pool, its resources use the default pools." << std::endl;
+                m_pools[pool_index] = VK_NULL_HANDLE;
+                continue;
+            }
+            vmaSetPoolName(allocator, m_pools[pool_index], AllocationClassName(allocation_class));
+        }
+    }
+
+    void MemoryPools::Destroy(VmaAllocator allocator)
+    {
+        for (VmaPool& pool : m_pools)
+        {
+            if (pool != VK_NULL_HANDLE)
+            {
+                vmaDestroyPool(allocator, pool);
+                pool = VK_NULL_HANDLE;
+            }
+        }
+    }
+
+    void MemoryPools::EndDefragmentation(VulkanEngine& engine)
+    {
+        if (m_pass_active)
+        {
+            EndPass(engine);
+        }
+
+        if (m_context != VK_NULL_HANDLE)
+        {
+            FinishDefragmentation(engine.Allocator());
+        }
+    }
+
+    void MemoryPools::TrackBuffer(VmaAllocator allocator, VmaAllocation allocation, StorageId_t id)
+    {
+        vmaSetAllocationUserData(allocator, allocation, MoveUserData(id, false));
+    }
+
+    void MemoryPools::TrackImage(VmaAllocator allocator, VmaAllocation allocation, StorageId_t id)
+    {
+        vmaSetAllocationUserData(allocator, allocation, MoveUserData(id, true));
+    }
+
+    bool MemoryPools::AbandonMove(VmaAllocation allocation)
+    {
+        if (m_pass_active == false)
+        {
+            return false;
+        }
+
+        for (uint32_t move_index = 0; move_index < m_pass.moveCount; ++move_index)
+        {
+            VmaDefragmentationMove& move = m_pass.pMoves[move_index];
+            if (move.srcAllocation == allocation)
+            {
+                // VMA frees both the old and the new place when the pass ends.
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void MemoryPools::Update(VulkanEngine& engine, VkCommandBuffer cmd, bool idle_frame)
+    {
+        if (m_pass_active)
+        {
+            // the scene extracted while the copies were recorded still draws the old places during the next
+            // frame, see PublishMovedAddresses. That frame is done once its frame slot comes around again.
+            if (engine.frame_number < m_pass_frame + int(engine.FramesInFlight()) + 1)
+            {
+                return;
+            }
+            EndPass(engine);
+        }
+
+        if (defragmentation_enabled == false)
+        {
+            if (m_context != VK_NULL_HANDLE)
+            {
+                FinishDefragmentation(engine.Allocator());
+            }
+            return;
+        }
+
+        if (idle_frame == false)
+        {
+            return;
+        }
+
+        if (m_context == VK_NULL_HANDLE)
+        {
+            const bool requested = std::any_of(
+                m_requested.begin(),
+                m_requested.end(),
+                [](bool pool_requested)
+                {
+                    return pool_requested;
+                }
+            );
+            if (requested == false && engine.frame_number % CHECK_INTERVAL_FRAMES != 0)
+            {
+                return;
+            }
+
+            CheckFragmentation(engine.Allocator());
+            if (m_context == VK_NULL_HANDLE)
+            {
+                return;
+            }
+        }
+
+        BeginPass(engine, cmd);
+    }
+
+    void MemoryPools::PublishMovedAddresses(VulkanEngine& engine)
+    {
+        // the storages are patched, the meshes copied the addresses of their buffers.
+        for (const auto& [buffer_id, address] : m_moved_addresses)
+        {
+            UpdateMeshAddresses(engine, buffer_id, address);
+        }
+        m_moved_addresses.clear();
+    }
+
+    void MemoryPools::RequestDefragmentation(AllocationClass allocation_class)
+    {
+        if (IsMovableClass(allocation_class))
+        {
+            m_requested[static_cast<size_t>(allocation_class)] = true;
+        }
+    }
+
+    VmaStatistics MemoryPools::PoolStatistics(VmaAllocator allocator, AllocationClass allocation_class) const
+    {
+        VmaStatistics stats{};
+        VmaPool pool = Pool(allocation_class);
+        if (pool != VK_NULL_HANDLE)
+        {
+            vmaGetPoolStatistics(allocator, pool, &stats);
+        }
+        return stats;
+    }
+
+    void MemoryPools::BeginDefragmentation(VmaAllocator allocator, AllocationClass allocation_class)
+    {
+        VmaDefragmentationInfo defragmentation_info{};
+        defragmentation_info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        defragmentation_info.pool = Pool(allocation_class);
+        defragmentation_info.maxBytesPerPass = MAX_BYTES_PER_PASS;
+        defragmentation_info.maxAllocationsPerPass = MAX_MOVES_PER_PASS;
+        if (vmaBeginDefragmentation(allocator, &defragmentation_info, &m_context) != VK_SUCCESS)
+        {
+            m_context = VK_NULL_HANDLE;
+            return;
+        }
+
+        m_defragmented_class = allocation_class;
+    }
+
+    void MemoryPools::FinishDefragmentation(VmaAllocator allocator)
+    {
+        VmaDefragmentationStats stats{};
+        vmaEndDefragmentation(allocator, m_context, &stats);
+        m_context = VK_NULL_HANDLE;
+
+        m_moved_bytes += stats.bytesMoved;
+        m_moved_allocations += stats.allocationsMoved;
+        if (stats.allocationsMoved > 0)
+        {
+            std::cout << "[*] Defragmented the " << AllocationClassName(m_defragmented_class)
+                      << " pool: moved " << stats.allocationsMoved << " allocations ("
+                      << stats.bytesMoved / 1024 << " KiB), freed " << stats.deviceMemoryBlocksFreed
+                      << " blocks." << std::endl;
+        }
+    }
+
+    void MemoryPools::CheckFragmentation(VmaAllocator allocator)
+    {
+        for (size_t pool_index = 0; pool_index < m_pools.size(); ++pool_index)
+        {
+            const AllocationClass allocation_class = static_cast<AllocationClass>(pool_index);
+            if (m_pools[pool_index] == VK_NULL_HANDLE || IsMovableClass(allocation_class) == false)
+            {
+                continue;
+            }
+
+            const bool requested = std::exchange(m_requested[pool_index], false);
+            VmaStatistics stats{};
+            vmaGetPoolStatistics(allocator, m_pools[pool_index], &stats);
+            const VkDeviceSize unused_bytes = stats.blockBytes - stats.allocationBytes;
+            const bool fragmented =
+                unused_bytes >= DEFRAGMENT_UNUSED_BYTES &&
+                float(unused_bytes) >= float(stats.blockBytes) * DEFRAGMENT_UNUSED_FRACTION;
+            if (requested || fragmented)
+            {
+                BeginDefragmentation(allocator, allocation_class);
+                return;
+            }
+        }
+    }
+
+    void MemoryPools::BeginPass(VulkanEngine& engine, VkCommandBuffer cmd)
+    {
+        VmaAllocator allocator = engine.Allocator();
+        if (vmaBeginDefragmentationPass(allocator, m_context, &m_pass) == VK_SUCCESS)
+        {
+            // nothing left to move.
+            FinishDefragmentation(allocator);
+            return;
+        }
+
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        Utils::GlobalMemoryBarrier(
+            &device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            VK_ACCESS_2_MEMORY_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT
+        );
+
+        uint32_t moved_count = 0;
+        for (uint32_t move_index = 0; move_index < m_pass.moveCount; ++move_index)
+        {
+            VmaDefragmentationMove& move = m_pass.pMoves[move_index];
+            VmaAllocationInfo allocation_info{};
+            vmaGetAllocationInfo(allocator, move.srcAllocation, &allocation_info);
+
+            // untracked allocations belong to resources the storages can't patch.
+            const uintptr_t user_data = reinterpret_cast<uintptr_t>(allocation_info.pUserData);
+            const StorageId_t id = StorageId_t(user_data >> 1);
+            bool moved = false;
+            if (user_data != 0 && (user_data & 1) != 0)
+            {
+                moved = MoveImage(engine, cmd, move, id);
+            }
+            else if (user_data != 0)
+            {
+                std::optional<VkDeviceAddress> address = MoveBuffer(engine, cmd, move, id);
+                moved = address.has_value();
+                if (address.has_value() && *address != 0)
+                {
+                    m_moved_addresses.emplace_back(id, *address);
+                }
+            }
+
+            if (moved == false)
+            {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+            ++moved_count;
+        }
+
+        Utils::GlobalMemoryBarrier(
+            &device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT
+        );
+
+        m_pass_active = true;
+        m_pass_frame = engine.frame_number;
+        m_pass_moved_count = moved_count;
+    }
+
+    void MemoryPools::EndPass(VulkanEngine& engine)
+    {
+        VmaAllocator allocator = engine.Allocator();
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        for (VkBuffer buffer : m_moved.buffers)
+        {
+            device_dispatch.destroyBuffer(buffer, nullptr);
+        }
+        for (VkImageView image_view : m_moved.image_views)
+        {
+            device_dispatch.destroyImageView(image_view, nullptr);
+        }
+        for (VkImage image : m_moved.images)
+        {
+            device_dispatch.destroyImage(image, nullptr);
+        }
+
+        const VkResult result = vmaEndDefragmentationPass(allocator, m_context, &m_pass);
+        m_pass_active = false;
+        m_pass = VmaDefragmentationPassMoveInfo{};
+
+        // the allocations of moved buffers point at their new place now, so do their mapped pointers.
+        {
+            ResourceStorage<AllocatedBuffer>& storage = engine.m_buffer_storage;
+            std::lock_guard lock{ storage.resource_lock };
+            for (StorageId_t id : m_moved.buffer_ids)
+            {
+                auto buffer = storage.resource_map.find(id);
+                if (buffer != storage.resource_map.end())
+                {
+                    AllocatedBuffer& moved = buffer->second;
+                    vmaGetAllocationInfo(allocator, moved.allocation, &moved.allocation_info);
+                }
+            }
+        }
+        m_moved = MovedResources{};
+
+        // passes that can't move anything would keep proposing the same moves.
+        if (result == VK_SUCCESS || m_pass_moved_count == 0)
+        {
+            FinishDefragmentation(allocator);
+        }
+    }
+
+    std::optional<VkDeviceAddress> MemoryPools::MoveBuffer(
+        VulkanEngine& engine, VkCommandBuffer cmd, VmaDefragmentationMove& move, StorageId_t id
+    )
+    {
+        if (IsRegisteredMeshBuffer(engine, id) == false)
+        {
+            return std::nullopt;
+        }
+
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        ResourceStorage<AllocatedBuffer>& storage = engine.m_buffer_storage;
+        std::lock_guard lock{ storage.resource_lock };
+
+        // released buffers are destroyed with the next frame, AbandonMove hands them to VMA then.
+        auto entry = storage.resource_map.find(id);
+        if (entry == storage.resource_map.end() || entry->second.allocation != move.srcAllocation)
+        {
+            return std::nullopt;
+        }
+        AllocatedBuffer& buffer = entry->second;
+
+        VkBufferCreateInfo buffer_info{};
+        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_info.size = buffer.size;
+        buffer_info.usage = buffer.usage;
+        VkBuffer moved_buffer = VK_NULL_HANDLE;
+        VK_CHECK(device_dispatch.createBuffer(&buffer_info, nullptr, &moved_buffer));
+        VK_CHECK(vmaBindBufferMemory(engine.Allocator(), move.dstTmpAllocation, moved_buffer));
+
+        VkBufferCopy copy{};
+        copy.size = buffer.size;
+        device_dispatch.cmdCopyBuffer(cmd, buffer.buffer, moved_buffer, 1, &copy);
+
+        // every handle sees the new buffer, frames in flight keep reading the old one until the pass ends.
+        m_moved.buffers.push_back(std::exchange(buffer.buffer, moved_buffer));
+        m_moved.buffer_ids.push_back(id);
+
+        if ((buffer.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) == 0)
+        {
+            return VkDeviceAddress(0);
+        }
+
+        VkBufferDeviceAddressInfo address_info{};
+        address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        address_info.buffer = moved_buffer;
+        return device_dispatch.getBufferDeviceAddress(&address_info);
+    }
+
+    bool MemoryPools::MoveImage(
+        VulkanEngine& engine, VkCommandBuffer cmd, VmaDefragmentationMove& move, StorageId_t id
+    )
+    {
+        // only textures whose materials can be pointed at the new image are moved.
+        TextureResidency& residency = engine.Residency();
+        if (residency.CanMove(id) == false)
+        {
+            return false;
+        }
+
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        {
+            ResourceStorage<AllocatedImage>& storage = engine.m_image_storage;
+            std::lock_guard lock{ storage.resource_lock };
+
+            auto entry = storage.resource_map.find(id);
+            if (entry == storage.resource_map.end() || entry->second.allocation != move.srcAllocation)
+            {
+                return false;
+            }
+            AllocatedImage& image = entry->second;
+
+            VkImageCreateInfo image_info =
+                Utils::ImageCreateInfo(image.image_format, image.image_usage, image.image_extent);
+            image_info.mipLevels = image.mip_levels;
+            VkImage moved_image = VK_NULL_HANDLE;
+            VK_CHECK(device_dispatch.createImage(&image_info, nullptr, &moved_image));
+            VK_CHECK(vmaBindImageMemory(engine.Allocator(), move.dstTmpAllocation, moved_image));
+
+            VkImageViewCreateInfo view_info =
+                Utils::ImageViewCreateInfo(image.image_format, moved_image, VK_IMAGE_ASPECT_COLOR_BIT);
+            view_info.subresourceRange.levelCount = image.mip_levels;
+            VkImageView moved_view = VK_NULL_HANDLE;
+            VK_CHECK(device_dispatch.createImageView(&view_info, nullptr, &moved_view));
+
+            Utils::TransitionImage(
+                &device_dispatch,
+                cmd,
+                image.image,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+            );
+            Utils::TransitionImage(
+                &device_dispatch,
+                cmd,
+                moved_image,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+            );
+
+            std::vector<VkImageCopy2> copies(image.mip_levels);
+            for (uint32_t mip = 0; mip < image.mip_levels; ++mip)
+            {
+                VkImageCopy2& copy = copies[mip];
+                copy.sType = VK_STRUCTURE_TYPE_IMAGE_COPY_2;
+                copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1 };
+                copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1 };
+                copy.extent = VkExtent3D{ std::max(image.image_extent.width >> mip, 1u),
+                                          std::max(image.image_extent.height >> mip, 1u),
+                                          1 };
+            }
+
+            VkCopyImageInfo2 copy_info{};
+            copy_info.sType = VK_STRUCTURE_TYPE_COPY_IMAGE_INFO_2;
+            copy_info.srcImage = image.image;
+            copy_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            copy_info.dstImage = moved_image;
+            copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            copy_info.regionCount = uint32_t(copies.size());
+            copy_info.pRegions = copies.data();
+            device_dispatch.cmdCopyImage2(cmd, &copy_info);
+
+            // the old image can still be shown by the debug panels this frame.
+            Utils::TransitionImage(
+                &device_dispatch,
+                cmd,
+                image.image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            );
+            Utils::TransitionImage(
+                &device_dispatch,
+                cmd,
+                moved_image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            );
+
+            // the debug textures are looked up by image, the moved one gets a new texture once displayed.
+            engine.m_debug_textures.Forget(image.image, uint64_t(engine.frame_number));
+
+            m_moved.images.push_back(std::exchange(image.image, moved_image));
+            m_moved.image_views.push_back(std::exchange(image.image_view, moved_view));
+        }
+
+        residency.ImageMoved(engine, id);
+        return true;
+    }
+
+    bool MemoryPools::IsRegisteredMeshBuffer(VulkanEngine& engine, StorageId_t buffer_id)
+    {
+        ResourceStorage<MeshAsset>& storage = engine.m_mesh_storage;
+        std::lock_guard lock{ storage.resource_lock };
+        return std::any_of(
+            storage.resource_map.begin(),
+            storage.resource_map.end(),
+            [buffer_id](const auto& entry)
+            {
+                const GPUMeshBuffers& buffers = entry.second.buffers;
+                return buffers.vertex_buffer.id == buffer_id || buffers.index_buffer.id == buffer_id ||
+                       buffers.meshlet_buffer.id == buffer_id;
+            }
+        );
+    }
+
+    void MemoryPools::UpdateMeshAddresses(
+        VulkanEngine& engine, StorageId_t buffer_id, VkDeviceAddress address
+    )
+    {
+        ResourceStorage<MeshAsset>& storage = engine.m_mesh_storage;
+        std::lock_guard lock{ storage.resource_lock };
+        for (auto& [mesh_id, mesh] : storage.resource_map)
+        {
+            GPUMeshBuffers& buffers = mesh.buffers;
+            if (buffers.vertex_buffer.id == buffer_id)
+            {
+                buffers.vertex_buffer_address = address;
+            }
+            if (buffers.index_buffer.id == buffer_id)
+            {
+                buffers.index_buffer_address = address;
+            }
+            if (buffers.meshlet_buffer.id == buffer_id)
+            {
+                buffers.meshlet_buffer_address = address;
+            }
+        }
+    }
+} // namespace Renderer
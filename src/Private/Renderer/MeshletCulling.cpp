@@ -0,0 +1,94 @@
+#include "Renderer/MeshletCulling.h"
+#include "Renderer/Utility/VkPipelines.h"
+
+#include <glm/geometric.hpp>
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace Renderer
+{
+    bool MeshletCullingPass::BuildPipelines(vkb::DispatchTable& device_dispatch)
+    {
+        VkPushConstantRange range{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GPUMeshletCullPushConstants) };
+
+        // everything is accessed through device addresses, no descriptors needed.
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.pPushConstantRanges = &range;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+
+        VkResult result = device_dispatch.createPipelineLayout(&pipeline_layout_info, nullptr, &layout);
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "[!] Failed to create pipeline layout for meshlet culling. Vulkan Error: "
+                      << string_VkResult(result) << std::endl;
+            return false;
+        }
+
+        VkShaderModule cull_shader;
+        if (Utils::LoadShaderModule(device_dispatch, "../data/shader/meshlet_cull.comp.spv", &cull_shader) ==
+            false)
+        {
+            std::cerr << "[!] Failed to load meshlet culling compute shader." << std::endl;
+            return false;
+        }
+
+        pipeline = Utils::BuildComputePipeline(device_dispatch, layout, cull_shader);
+        device_dispatch.destroyShaderModule(cull_shader, nullptr);
+
+        loaded = pipeline != VK_NULL_HANDLE;
+        return loaded;
+    }
+
+    void MeshletCullingPass::DestroyResources(vkb::DispatchTable& device_dispatch)
+    {
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyPipeline(pipeline, nullptr);
+            pipeline = VK_NULL_HANDLE;
+        }
+        if (layout != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyPipelineLayout(layout, nullptr);
+            layout = VK_NULL_HANDLE;
+        }
+        loaded = false;
+    }
+
+    GPUMeshletCullData MeshletCullingPass::CullData(
+        const glm::mat4& view_projection, const glm::vec3& camera_position
+    )
+    {
+        // Gribb & Hartmann plane extraction for [0, 1] depth.
+        const auto row = [&](int i)
+        {
+            return glm::vec4(
+                view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]
+            );
+        };
+
+        GPUMeshletCullData cull_data{};
+        cull_data.frustum_planes[0] = row(3) + row(0); // left
+        cull_data.frustum_planes[1] = row(3) - row(0); // right
+        cull_data.frustum_planes[2] = row(3) + row(1); // bottom
+        cull_data.frustum_planes[3] = row(3) - row(1); // top
+        cull_data.frustum_planes[4] = row(2);          // depth >= 0, far plane with reversed depth
+        cull_data.frustum_planes[5] = row(3) - row(2); // depth <= 1, near plane with reversed depth
+
+        for (glm::vec4& plane : cull_data.frustum_planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        cull_data.camera_position = glm::vec4(camera_position, 1.0f);
+
+        return cull_data;
+    }
+
+    VkExtent2D MeshletCullingPass::DispatchSize(uint32_t meshlet_count)
+    {
+        const uint32_t row_size = std::clamp(meshlet_count, 1u, MAX_GROUPS_PER_ROW);
+        return VkExtent2D{ row_size, (meshlet_count + row_size - 1) / row_size };
+    }
+} // namespace Renderer
@@ -0,0 +1,142 @@
+#include "Renderer/OcclusionCulling.h"
+#include "Renderer/Utility/VkDescriptors.h"
+#include "Renderer/Utility/VkPipelines.h"
+
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    uint32_t PreviousPowerOfTwo(uint32_t value)
+    {
+        uint32_t result = 1;
+        while (result * 2 <= value)
+        {
+            result *= 2;
+        }
+        return result;
+    }
+
+    bool BuildPassPipeline(
+        vkb::DispatchTable& device_dispatch,
+        VkDescriptorSetLayout descriptor_layout,
+        uint32_t push_constant_size,
+        const char* shader_path,
+        VkPipelineLayout& out_layout,
+        VkPipeline& out_pipeline
+    )
+    {
+        VkPushConstantRange range{ VK_SHADER_STAGE_COMPUTE_BIT, 0, push_constant_size };
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.pSetLayouts = &descriptor_layout;
+        pipeline_layout_info.setLayoutCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &range;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+
+        VkResult result = device_dispatch.createPipelineLayout(&pipeline_layout_info, nullptr, &out_layout);
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "[!] Failed to create pipeline layout for " << shader_path
+                      << ". Vulkan Error: " << string_VkResult(result) << std::endl;
+            return false;
+        }
+
+        VkShaderModule shader;
+        if (Renderer::Utils::LoadShaderModule(device_dispatch, shader_path, &shader) == false)
+        {
+            std::cerr << "[!] Failed to load compute shader " << shader_path << std::endl;
+            return false;
+        }
+
+        out_pipeline = Renderer::Utils::BuildComputePipeline(device_dispatch, out_layout, shader);
+        device_dispatch.destroyShaderModule(shader, nullptr);
+
+        return out_pipeline != VK_NULL_HANDLE;
+    }
+} // namespace
+
+namespace Renderer
+{
+    bool OcclusionCullingPass::BuildPipelines(vkb::DispatchTable& device_dispatch)
+    {
+        Utils::DescriptorLayoutBuilder pyramid_layout_builder;
+        pyramid_layout_builder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER); // source depth
+        pyramid_layout_builder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);          // destination mip
+        pyramid_descriptor_layout =
+            pyramid_layout_builder.Build(device_dispatch, VK_SHADER_STAGE_COMPUTE_BIT);
+
+        Utils::DescriptorLayoutBuilder cull_layout_builder;
+        cull_layout_builder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER); // depth pyramid
+        cull_descriptor_layout = cull_layout_builder.Build(device_dispatch, VK_SHADER_STAGE_COMPUTE_BIT);
+
+        loaded = BuildPassPipeline(
+                     device_dispatch,
+                     pyramid_descriptor_layout,
+                     sizeof(GPUDepthPyramidPushConstants),
+                     "../data/shader/depth_pyramid.comp.spv",
+                     pyramid_layout,
+                     pyramid_pipeline
+                 ) &&
+                 BuildPassPipeline(
+                     device_dispatch,
+                     cull_descriptor_layout,
+                     sizeof(GPUOcclusionCullPushConstants),
+                     "../data/shader/occlusion_cull.comp.spv",
+                     cull_layout,
+                     cull_pipeline
+                 );
+
+        return loaded;
+    }
+
+    void OcclusionCullingPass::DestroyResources(vkb::DispatchTable& device_dispatch)
+    {
+        for (VkPipeline* pipeline : { &pyramid_pipeline, &cull_pipeline })
+        {
+            if (*pipeline != VK_NULL_HANDLE)
+            {
+                device_dispatch.destroyPipeline(*pipeline, nullptr);
+                *pipeline = VK_NULL_HANDLE;
+            }
+        }
+        for (VkPipelineLayout* layout : { &pyramid_layout, &cull_layout })
+        {
+            if (*layout != VK_NULL_HANDLE)
+            {
+                device_dispatch.destroyPipelineLayout(*layout, nullptr);
+                *layout = VK_NULL_HANDLE;
+            }
+        }
+        for (VkDescriptorSetLayout* layout : { &pyramid_descriptor_layout, &cull_descriptor_layout })
+        {
+            if (*layout != VK_NULL_HANDLE)
+            {
+                device_dispatch.destroyDescriptorSetLayout(*layout, nullptr);
+                *layout = VK_NULL_HANDLE;
+            }
+        }
+        loaded = false;
+    }
+
+    VkExtent2D OcclusionCullingPass::PyramidExtent(VkExtent2D draw_extent)
+    {
+        // rounding down keeps every mip exactly half of the previous one, mip 0 reduces up to 3x3 texels.
+        return VkExtent2D{ PreviousPowerOfTwo(draw_extent.width), PreviousPowerOfTwo(draw_extent.height) };
+    }
+
+    uint32_t OcclusionCullingPass::PyramidMipCount(VkExtent2D pyramid_extent)
+    {
+        uint32_t mip_count = 1;
+        uint32_t size = std::max(pyramid_extent.width, pyramid_extent.height);
+        while (size > 1)
+        {
+            size /= 2;
+            ++mip_count;
+        }
+        return mip_count;
+    }
+} // namespace Renderer
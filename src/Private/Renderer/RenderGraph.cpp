@@ -0,0 +1,529 @@
+#include "Renderer/RenderGraph.h"
+#include "Renderer/Utility/GpuProfiler.h"
+#include "Renderer/Utility/VkImages.h"
+#include "Renderer/Utility/VkInitialisers.h"
+#include "Renderer/VkTypes.h"
+
+#include <VkBootstrapDispatch.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace Renderer
+{
+    namespace
+    {
+        constexpr VkAccessFlags2 WRITE_ACCESS =
+            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+        bool SameDesc(const TransientImageDesc& a, const TransientImageDesc& b)
+        {
+            return a.extent.width == b.extent.width && a.extent.height == b.extent.height &&
+                   a.format == b.format && a.usage == b.usage && a.aspect == b.aspect;
+        }
+    } // namespace
+
+    ImageState ImageUsageState(ImageUsage usage)
+    {
+        switch (usage)
+        {
+        case ImageUsage::ColorAttachment:
+            return ImageState{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                               VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                               VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+                                   VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT };
+        case ImageUsage::DepthAttachment:
+            return ImageState{ VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+                               VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                                   VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                               VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+        case ImageUsage::StorageWrite:
+            return ImageState{ VK_IMAGE_LAYOUT_GENERAL,
+                               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                               VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT };
+        case ImageUsage::ComputeSampled:
+            return ImageState{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                               VK_ACCESS_2_SHADER_SAMPLED_READ_BIT };
+        case ImageUsage::FragmentSampled:
+            return ImageState{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                               VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                               VK_ACCESS_2_SHADER_SAMPLED_READ_BIT };
+        case ImageUsage::TransferSrc:
+            return ImageState{ VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                               VK_ACCESS_2_TRANSFER_READ_BIT };
+        case ImageUsage::TransferDst:
+            return ImageState{ VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                               VK_ACCESS_2_TRANSFER_WRITE_BIT };
+        case ImageUsage::None:
+            break;
+        }
+        return ImageState{};
+    }
+
+    RenderGraphPass& RenderGraphPass::Read(RenderGraphResource resource, ImageUsage usage)
+    {
+        accesses.push_back(Access{ resource, usage, false });
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::Write(RenderGraphResource resource, ImageUsage usage)
+    {
+        accesses.push_back(Access{ resource, usage, true });
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::HasSideEffects()
+    {
+        side_effects = true;
+        return *this;
+    }
+
+    void RenderGraph::Init(vkb::DispatchTable* device_dispatch, VmaAllocator allocator, uint32_t frame_count)
+    {
+        m_device_dispatch = device_dispatch;
+        m_allocator = allocator;
+        m_heaps.resize(frame_count);
+    }
+
+    void RenderGraph::Destroy()
+    {
+        for (TransientHeap& heap : m_heaps)
+        {
+            ReleaseHeap(heap);
+        }
+        m_heaps.clear();
+        m_images.clear();
+        m_passes.clear();
+    }
+
+    void RenderGraph::SetFrameCount(uint32_t frame_count)
+    {
+        for (TransientHeap& heap : m_heaps)
+        {
+            ReleaseHeap(heap);
+        }
+        m_heaps = std::vector<TransientHeap>(frame_count);
+    }
+
+    void RenderGraph::BeginFrame(uint32_t frame_index)
+    {
+        m_frame_index = frame_index % uint32_t(m_heaps.size());
+        m_images.clear();
+        m_passes.clear();
+    }
+
+    RenderGraphResource RenderGraph::ImportImage(
+        std::string name,
+        VkImage image,
+        VkImageView view,
+        ImageState initial_state,
+        VkImageLayout final_layout
+    )
+    {
+        GraphImage& graph_image = m_images.emplace_back();
+        graph_image.name = std::move(name);
+        graph_image.image = image;
+        graph_image.view = view;
+        graph_image.state = initial_state;
+        graph_image.final_layout = final_layout;
+        return RenderGraphResource(m_images.size() - 1);
+    }
+
+    RenderGraphResource RenderGraph::CreateImage(const TransientImageDesc& desc)
+    {
+        GraphImage& graph_image = m_images.emplace_back();
+        graph_image.name = desc.name;
+        graph_image.transient = true;
+        graph_image.desc = desc;
+        return RenderGraphResource(m_images.size() - 1);
+    }
+
+    RenderGraphResource RenderGraph::CreateVirtualResource(std::string name)
+    {
+        GraphImage& graph_image = m_images.emplace_back();
+        graph_image.name = std::move(name);
+        graph_image.is_virtual = true;
+        return RenderGraphResource(m_images.size() - 1);
+    }
+
+    RenderGraphPass& RenderGraph::AddPass(
+        std::string name, std::string group, std::function<void(VkCommandBuffer cmd)> execute
+    )
+    {
+        RenderGraphPass& pass = m_passes.emplace_back();
+        pass.name = std::move(name);
+        pass.group = std::move(group);
+        pass.execute = std::move(execute);
+        return pass;
+    }
+
+    void RenderGraph::Execute(VkCommandBuffer cmd, Utils::GpuProfiler& profiler)
+    {
+        m_stats = Stats{};
+        m_stats.pass_count = uint32_t(m_passes.size());
+
+        CullPasses();
+        AllocateTransientImages();
+
+        std::string open_group{};
+        uint32_t group_scope = Utils::GpuProfiler::INVALID_SCOPE;
+        for (uint32_t i = 0; i < m_passes.size(); ++i)
+        {
+            RenderGraphPass& pass = m_passes[i];
+            if (pass.culled)
+            {
+                continue;
+            }
+
+            if (pass.group != open_group)
+            {
+                profiler.EndScope(*m_device_dispatch, cmd, group_scope);
+                group_scope = Utils::GpuProfiler::INVALID_SCOPE;
+                open_group = pass.group;
+                if (open_group.empty() == false)
+                {
+                    group_scope = profiler.BeginScope(*m_device_dispatch, cmd, open_group);
+                }
+            }
+
+            RecordBarriers(cmd, i);
+            pass.execute(cmd);
+            // might hold references to the frame being recorded.
+            pass.execute = nullptr;
+        }
+        profiler.EndScope(*m_device_dispatch, cmd, group_scope);
+
+        RecordFinalBarriers(cmd);
+    }
+
+    void RenderGraph::CullPasses()
+    {
+        // outputs of the frame are needed, so is everything a needed pass uses. Attachments are loaded, so
+        // the passes writing an image before a needed pass are needed as well.
+        std::vector<bool> needed(m_images.size(), false);
+        for (size_t i = 0; i < m_images.size(); ++i)
+        {
+            needed[i] = m_images[i].final_layout != VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+
+        for (size_t i = m_passes.size(); i-- > 0;)
+        {
+            RenderGraphPass& pass = m_passes[i];
+            const bool writes_needed = std::any_of(
+                pass.accesses.begin(),
+                pass.accesses.end(),
+                [&](const RenderGraphPass::Access& access)
+                {
+                    return access.write && needed[access.resource];
+                }
+            );
+
+            pass.culled = pass.side_effects == false && writes_needed == false;
+            if (pass.culled)
+            {
+                ++m_stats.culled_pass_count;
+                continue;
+            }
+
+            for (const RenderGraphPass::Access& access : pass.accesses)
+            {
+                needed[access.resource] = true;
+                GraphImage& image = m_images[access.resource];
+                image.first_pass = std::min(image.first_pass, uint32_t(i));
+                image.last_pass = std::max(image.last_pass, uint32_t(i));
+            }
+        }
+    }
+
+    void RenderGraph::AllocateTransientImages()
+    {
+        struct Placement
+        {
+            RenderGraphResource image;
+            VkMemoryRequirements requirements;
+            VkDeviceSize offset = 0;
+        };
+
+        std::vector<Placement> placements{};
+        for (RenderGraphResource i = 0; i < m_images.size(); ++i)
+        {
+            const GraphImage& image = m_images[i];
+            if (image.transient == false || image.first_pass == UINT32_MAX)
+            {
+                continue; // imported, or only used by culled passes
+            }
+
+            const VkExtent3D extent{ image.desc.extent.width, image.desc.extent.height, 1 };
+            VkImageCreateInfo image_info =
+                Utils::ImageCreateInfo(image.desc.format, image.desc.usage, extent);
+            VkDeviceImageMemoryRequirements requirements_info{};
+            requirements_info.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+            requirements_info.pCreateInfo = &image_info;
+            VkMemoryRequirements2 requirements{};
+            requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+            m_device_dispatch->getDeviceImageMemoryRequirements(&requirements_info, &requirements);
+
+            placements.push_back(Placement{ i, requirements.memoryRequirements });
+            m_stats.unaliased_bytes += requirements.memoryRequirements.size;
+        }
+        if (placements.empty())
+        {
+            return;
+        }
+
+        const auto lifetimes_overlap = [&](const Placement& a, const Placement& b)
+        {
+            const GraphImage& image_a = m_images[a.image];
+            const GraphImage& image_b = m_images[b.image];
+            return image_a.first_pass <= image_b.last_pass && image_b.first_pass <= image_a.last_pass;
+        };
+        const auto memory_overlaps = [](const Placement& a, const Placement& b)
+        {
+            return a.offset < b.offset + b.requirements.size && b.offset < a.offset + a.requirements.size;
+        };
+
+        // biggest first, each at the lowest offset that doesn't overlap an image alive at the same time.
+        std::vector<size_t> order(placements.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(
+            order.begin(),
+            order.end(),
+            [&](size_t a, size_t b)
+            {
+                return placements[a].requirements.size > placements[b].requirements.size;
+            }
+        );
+
+        VkMemoryRequirements heap_requirements{ 0, 1, UINT32_MAX };
+        for (size_t placed_count = 0; placed_count < order.size(); ++placed_count)
+        {
+            Placement& placement = placements[order[placed_count]];
+            const VkDeviceSize alignment = placement.requirements.alignment;
+            bool moved = true;
+            while (moved)
+            {
+                moved = false;
+                for (size_t j = 0; j < placed_count; ++j)
+                {
+                    const Placement& other = placements[order[j]];
+                    if (lifetimes_overlap(placement, other) && memory_overlaps(placement, other))
+                    {
+                        const VkDeviceSize end = other.offset + other.requirements.size;
+                        placement.offset = (end + alignment - 1) / alignment * alignment;
+                        moved = true;
+                    }
+                }
+            }
+
+            heap_requirements.size =
+                std::max(heap_requirements.size, placement.offset + placement.requirements.size);
+            heap_requirements.alignment = std::max(heap_requirements.alignment, alignment);
+            heap_requirements.memoryTypeBits &= placement.requirements.memoryTypeBits;
+        }
+
+        // the first use of an image waits for the images whose memory it takes over.
+        for (const Placement& placement : placements)
+        {
+            GraphImage& image = m_images[placement.image];
+            for (const Placement& other : placements)
+            {
+                const GraphImage& other_image = m_images[other.image];
+                if (other_image.last_pass >= image.first_pass || memory_overlaps(placement, other) == false)
+                {
+                    continue;
+                }
+
+                for (const RenderGraphPass::Access& access : m_passes[other_image.last_pass].accesses)
+                {
+                    if (access.resource == other.image)
+                    {
+                        const ImageState last_state = ImageUsageState(access.usage);
+                        image.state.stages |= last_state.stages;
+                        image.state.access |= last_state.access & WRITE_ACCESS;
+                    }
+                }
+            }
+        }
+
+        std::sort(
+            placements.begin(),
+            placements.end(),
+            [](const Placement& a, const Placement& b)
+            {
+                return a.image < b.image;
+            }
+        );
+
+        // the images of the frame in flight are reused as long as the frame places the same images.
+        TransientHeap& heap = m_heaps[m_frame_index];
+        bool reuse = heap.allocation != VK_NULL_HANDLE && heap.images.size() == placements.size();
+        for (size_t i = 0; reuse && i < placements.size(); ++i)
+        {
+            reuse = SameDesc(heap.images[i].desc, m_images[placements[i].image].desc) &&
+                    heap.images[i].offset == placements[i].offset;
+        }
+
+        if (reuse == false)
+        {
+            ReleaseHeap(heap);
+
+            // every transient image needs a memory type they all support, attachments have one in common.
+            VmaAllocationCreateInfo allocation_info{};
+            allocation_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+            allocation_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            VK_CHECK(vmaAllocateMemory(
+                m_allocator, &heap_requirements, &allocation_info, &heap.allocation, nullptr
+            ));
+            vmaSetAllocationName(m_allocator, heap.allocation, "render graph transients");
+            heap.size = heap_requirements.size;
+
+            for (const Placement& placement : placements)
+            {
+                const TransientImageDesc& desc = m_images[placement.image].desc;
+                TransientImage& transient = heap.images.emplace_back();
+                transient.desc = desc;
+                transient.offset = placement.offset;
+
+                VkImageCreateInfo image_info = Utils::ImageCreateInfo(
+                    desc.format, desc.usage, VkExtent3D{ desc.extent.width, desc.extent.height, 1 }
+                );
+                VK_CHECK(m_device_dispatch->createImage(&image_info, nullptr, &transient.image));
+                VK_CHECK(vmaBindImageMemory2(
+                    m_allocator, heap.allocation, placement.offset, transient.image, nullptr
+                ));
+
+                VkImageViewCreateInfo view_info =
+                    Utils::ImageViewCreateInfo(desc.format, transient.image, desc.aspect);
+                VK_CHECK(m_device_dispatch->createImageView(&view_info, nullptr, &transient.view));
+            }
+        }
+
+        for (size_t i = 0; i < placements.size(); ++i)
+        {
+            GraphImage& image = m_images[placements[i].image];
+            image.image = heap.images[i].image;
+            image.view = heap.images[i].view;
+        }
+        m_stats.transient_bytes = heap.size;
+    }
+
+    void RenderGraph::ReleaseHeap(TransientHeap& heap)
+    {
+        for (TransientImage& transient : heap.images)
+        {
+            m_device_dispatch->destroyImageView(transient.view, nullptr);
+            m_device_dispatch->destroyImage(transient.image, nullptr);
+        }
+        heap.images.clear();
+        if (heap.allocation != VK_NULL_HANDLE)
+        {
+            vmaFreeMemory(m_allocator, heap.allocation);
+            heap.allocation = VK_NULL_HANDLE;
+        }
+        heap.size = 0;
+    }
+
+    void RenderGraph::RecordBarriers(VkCommandBuffer cmd, uint32_t pass_index)
+    {
+        m_barriers.clear();
+        for (const RenderGraphPass::Access& access : m_passes[pass_index].accesses)
+        {
+            if (m_images[access.resource].is_virtual == false)
+            {
+                AddImageBarrier(m_images[access.resource], ImageUsageState(access.usage), access.write);
+            }
+        }
+        if (m_barriers.empty())
+        {
+            return;
+        }
+
+        VkDependencyInfo dependency_info{};
+        dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency_info.imageMemoryBarrierCount = uint32_t(m_barriers.size());
+        dependency_info.pImageMemoryBarriers = m_barriers.data();
+        m_device_dispatch->cmdPipelineBarrier2(cmd, &dependency_info);
+
+        m_stats.barrier_count += uint32_t(m_barriers.size());
+        ++m_stats.barrier_batch_count;
+    }
+
+    void RenderGraph::RecordFinalBarriers(VkCommandBuffer cmd)
+    {
+        m_barriers.clear();
+        for (GraphImage& image : m_images)
+        {
+            if (image.final_layout == VK_IMAGE_LAYOUT_UNDEFINED || image.state.layout == image.final_layout)
+            {
+                continue;
+            }
+
+            // nothing in this command buffer uses it afterwards, presenting waits for the semaphore.
+            ImageState final_state{ image.final_layout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE };
+            AddImageBarrier(image, final_state, false);
+        }
+        if (m_barriers.empty())
+        {
+            return;
+        }
+
+        VkDependencyInfo dependency_info{};
+        dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency_info.imageMemoryBarrierCount = uint32_t(m_barriers.size());
+        dependency_info.pImageMemoryBarriers = m_barriers.data();
+        m_device_dispatch->cmdPipelineBarrier2(cmd, &dependency_info);
+
+        m_stats.barrier_count += uint32_t(m_barriers.size());
+        ++m_stats.barrier_batch_count;
+    }
+
+    void RenderGraph::AddImageBarrier(GraphImage& image, const ImageState& target, bool write)
+    {
+        const auto push_barrier = [&](VkPipelineStageFlags2 src_stages)
+        {
+            const VkImageAspectFlags aspect = image.transient ? image.desc.aspect : VK_IMAGE_ASPECT_COLOR_BIT;
+            VkImageMemoryBarrier2& barrier = m_barriers.emplace_back();
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = src_stages;
+            barrier.srcAccessMask = image.state.access & WRITE_ACCESS;
+            barrier.dstStageMask = target.stages;
+            barrier.dstAccessMask = target.access;
+            barrier.oldLayout = image.state.layout;
+            barrier.newLayout = target.layout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image.image;
+            barrier.subresourceRange = Utils::SubresourceRange(aspect);
+        };
+
+        const bool layout_change = image.state.layout != target.layout;
+        if (layout_change == false && write == false)
+        {
+            // readers in the same layout only wait for the last write once per stage.
+            const bool synchronised = (target.stages & ~image.read_stages) == 0;
+            image.read_stages |= target.stages;
+            if (synchronised == false && image.state.stages != VK_PIPELINE_STAGE_2_NONE)
+            {
+                push_barrier(image.state.stages);
+            }
+            return;
+        }
+
+        // layout transitions and writes wait for the readers as well.
+        const VkPipelineStageFlags2 src_stages = image.state.stages | image.read_stages;
+        if (layout_change || src_stages != VK_PIPELINE_STAGE_2_NONE)
+        {
+            push_barrier(src_stages);
+        }
+
+        // later readers in other stages wait for the transition or the write.
+        image.state = ImageState{ target.layout, target.stages, write ? target.access : VK_ACCESS_2_NONE };
+        image.read_stages = write ? VK_PIPELINE_STAGE_2_NONE : target.stages;
+    }
+} // namespace Renderer
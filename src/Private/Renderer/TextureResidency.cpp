@@ -0,0 +1,627 @@
+#include "Renderer/TextureResidency.h"
+#include "Renderer/Material.h"
+#include "Renderer/Utility/MemoryStats.h"
+#include "Renderer/Utility/VkImages.h"
+#include "Renderer/Utility/VkLoader.h"
+#include "Renderer/VkEngine.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Renderer
+{
+    namespace
+    {
+        constexpr VkDeviceSize BYTES_PER_TEXEL = 4; // only RGBA8 textures are tracked
+
+        // bytes of mips [first_mip, end_mip) of an image with the given mip 0 size.
+        VkDeviceSize MipChainBytes(VkExtent2D extent, uint32_t first_mip, uint32_t end_mip)
+        {
+            VkDeviceSize bytes = 0;
+            for (uint32_t mip = first_mip; mip < end_mip; ++mip)
+            {
+                const VkExtent2D mip_extent = Utils::MipExtent(extent, mip);
+                bytes += VkDeviceSize(mip_extent.width) * mip_extent.height * BYTES_PER_TEXEL;
+            }
+            return bytes;
+        }
+
+        VkExtent2D Extent2D(VkExtent3D extent) { return VkExtent2D{ extent.width, extent.height }; }
+
+        // copies every mip of the source into the destination, starting at destination_first_mip.
+        void CopyMips(
+            vkb::DispatchTable& device_dispatch,
+            VkCommandBuffer cmd,
+            const AllocatedImage& source,
+            uint32_t source_first_mip,
+            const AllocatedImage& destination,
+            uint32_t destination_first_mip
+        )
+        {
+            std::vector<VkImageCopy2> regions{};
+            const VkExtent2D source_extent = Extent2D(source.image_extent);
+            for (uint32_t mip = source_first_mip; mip < source.mip_levels; ++mip)
+            {
+                const uint32_t destination_mip = destination_first_mip + mip - source_first_mip;
+                if (destination_mip >= destination.mip_levels)
+                {
+                    break;
+                }
+
+                const VkExtent2D mip_extent = Utils::MipExtent(source_extent, mip);
+                VkImageCopy2& region = regions.emplace_back();
+                region.sType = VK_STRUCTURE_TYPE_IMAGE_COPY_2;
+                region.srcSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1 };
+                region.dstSubresource =
+                    VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, destination_mip, 0, 1 };
+                region.extent = VkExtent3D{ mip_extent.width, mip_extent.height, 1 };
+            }
+
+            VkCopyImageInfo2 copy_info{};
+            copy_info.sType = VK_STRUCTURE_TYPE_COPY_IMAGE_INFO_2;
+            copy_info.srcImage = source.image;
+            copy_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            copy_info.dstImage = destination.image;
+            copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            copy_info.regionCount = uint32_t(regions.size());
+            copy_info.pRegions = regions.data();
+            device_dispatch.cmdCopyImage2(cmd, &copy_info);
+        }
+
+        VkBufferImageCopy2 Mip0BufferCopy(VkExtent3D extent)
+        {
+            VkBufferImageCopy2 copy{};
+            copy.sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2;
+            copy.bufferOffset = 0;
+            copy.bufferRowLength = 0;
+            copy.bufferImageHeight = 0;
+            copy.imageSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            copy.imageExtent = extent;
+            return copy;
+        }
+    } // namespace
+
+    void TextureResidency::Destroy(vkb::DispatchTable& device_dispatch)
+    {
+        for (VkSampler& sampler : m_clamped_samplers)
+        {
+            if (sampler != VK_NULL_HANDLE)
+            {
+                device_dispatch.destroySampler(sampler, nullptr);
+                sampler = VK_NULL_HANDLE;
+            }
+        }
+
+        std::lock_guard lock{ m_registration_mutex };
+        m_registrations.clear();
+        m_textures.clear();
+    }
+
+    void TextureResidency::Register(
+        const std::shared_ptr<GLTFMaterial>& material, uint32_t binding, const ImageHandle& image
+    )
+    {
+        if (image->mip_levels <= 1 || image->image_format != VK_FORMAT_R8G8B8A8_UNORM)
+        {
+            return;
+        }
+
+        std::lock_guard lock{ m_registration_mutex };
+        m_registrations.push_back(Registration{ material, binding, image });
+    }
+
+    void TextureResidency::Update(
+        VulkanEngine& engine, VkCommandBuffer cmd, const Utils::MemoryTracker& memory_tracker
+    )
+    {
+        m_frame = uint64_t(engine.frame_number);
+
+        AddRegistrations();
+
+        // textures are kept alive by their materials, stop tracking them once every material is gone.
+        std::erase_if(
+            m_textures,
+            [](const ResidentTexture& texture)
+            {
+                return std::all_of(
+                    texture.bindings.begin(),
+                    texture.bindings.end(),
+                    [](const TextureBinding& binding)
+                    {
+                        return binding.material.expired();
+                    }
+                );
+            }
+        );
+        UpdateLastUsedFrames();
+
+        // textures that started streaming in finish regardless, so they don't stay clamped.
+        UploadStreamedMips(engine, cmd);
+
+        if (enabled)
+        {
+            // the heap with the least room decides, textures can end up in any device local heap.
+            VkDeviceSize bytes_over_budget = 0;
+            VkDeviceSize headroom_bytes = VK_WHOLE_SIZE;
+            for (const Utils::HeapBudget& heap : memory_tracker.Heaps())
+            {
+                if (heap.device_local == false || heap.budget == 0)
+                {
+                    continue;
+                }
+
+                const VkDeviceSize budget =
+                    budget_override_mib != 0 ? VkDeviceSize(budget_override_mib) * 1024 * 1024 : heap.budget;
+                const VkDeviceSize evict_limit = VkDeviceSize(double(budget) * EVICT_BUDGET_FRACTION);
+                const VkDeviceSize stream_in_limit = VkDeviceSize(double(budget) * STREAM_IN_BUDGET_FRACTION);
+                if (heap.usage > evict_limit)
+                {
+                    bytes_over_budget = std::max(bytes_over_budget, heap.usage - evict_limit);
+                }
+                headroom_bytes =
+                    std::min(headroom_bytes, heap.usage < stream_in_limit ? stream_in_limit - heap.usage : 0);
+            }
+
+            if (bytes_over_budget > 0)
+            {
+                EvictColdTextures(engine, cmd, bytes_over_budget);
+            }
+            else if (headroom_bytes > 0 && headroom_bytes != VK_WHOLE_SIZE)
+            {
+                StreamInUsedTextures(engine, cmd, headroom_bytes);
+            }
+        }
+
+        m_evicted_count = 0;
+        m_evicted_bytes = 0;
+        for (const ResidentTexture& texture : m_textures)
+        {
+            if (texture.state == TextureResidencyState::Evicted)
+            {
+                const VkExtent2D extent = Extent2D(texture.full_extent);
+                m_evicted_count += 1;
+                m_evicted_bytes += MipChainBytes(extent, 0, texture.dropped_mips);
+            }
+        }
+    }
+
+    void TextureResidency::AddRegistrations()
+    {
+        std::vector<Registration> registrations{};
+        {
+            std::lock_guard lock{ m_registration_mutex };
+            registrations.swap(m_registrations);
+        }
+
+        for (Registration& registration : registrations)
+        {
+            auto texture = std::find_if(
+                m_textures.begin(),
+                m_textures.end(),
+                [&](const ResidentTexture& existing)
+                {
+                    return existing.image.id == registration.image.id;
+                }
+            );
+            if (texture == m_textures.end())
+            {
+                ResidentTexture& added = m_textures.emplace_back();
+                added.image = registration.image;
+                added.full_extent = registration.image->image_extent;
+                added.full_mip_levels = registration.image->mip_levels;
+                added.last_used_frame = m_frame;
+                added.registered_frame = m_frame;
+                texture = m_textures.end() - 1;
+            }
+
+            texture->bindings.push_back(TextureBinding{ registration.material, registration.binding });
+        }
+    }
+
+    bool TextureResidency::CanMove(StorageId_t image_id) const
+    {
+        auto texture = std::find_if(
+            m_textures.begin(),
+            m_textures.end(),
+            [image_id](const ResidentTexture& existing)
+            {
+                return existing.image.id == image_id;
+            }
+        );
+
+        // streaming textures have mips that aren't uploaded yet.
+        return texture != m_textures.end() && texture->state != TextureResidencyState::StreamingIn &&
+               texture->registered_frame < m_frame;
+    }
+
+    void TextureResidency::ImageMoved(VulkanEngine& engine, StorageId_t image_id)
+    {
+        for (ResidentTexture& texture : m_textures)
+        {
+            if (texture.image.id == image_id)
+            {
+                RewriteBindings(engine, texture, engine.Sampler());
+                return;
+            }
+        }
+    }
+
+    void TextureResidency::UpdateLastUsedFrames()
+    {
+        for (ResidentTexture& texture : m_textures)
+        {
+            for (const TextureBinding& binding : texture.bindings)
+            {
+                if (std::shared_ptr<GLTFMaterial> material = binding.material.lock())
+                {
+                    const uint64_t drawn_frame = material->material.last_drawn_frame;
+                    texture.last_used_frame = std::max(texture.last_used_frame, drawn_frame);
+                }
+            }
+        }
+    }
+
+    void TextureResidency::EvictColdTextures(
+        VulkanEngine& engine, VkCommandBuffer cmd, VkDeviceSize bytes_over_budget
+    )
+    {
+        std::vector<ResidentTexture*> candidates{};
+        for (ResidentTexture& texture : m_textures)
+        {
+            const bool cold = m_frame > texture.last_used_frame + COLD_FRAMES;
+            const VkExtent2D next_extent =
+                Utils::MipExtent(Extent2D(texture.full_extent), texture.dropped_mips + 1);
+            const bool can_drop = texture.dropped_mips + 1 < texture.full_mip_levels &&
+                                  std::max(next_extent.width, next_extent.height) >= MIN_RESIDENT_SIZE;
+            if (texture.state != TextureResidencyState::StreamingIn && cold && can_drop)
+            {
+                candidates.push_back(&texture);
+            }
+        }
+
+        // least recently used first, largest first between textures used in the same frame.
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](const ResidentTexture* a, const ResidentTexture* b)
+            {
+                if (a->last_used_frame != b->last_used_frame)
+                {
+                    return a->last_used_frame < b->last_used_frame;
+                }
+                return a->dropped_mips < b->dropped_mips;
+            }
+        );
+
+        // the budget is only sampled once a frame, count what was freed so far to not evict too much.
+        VkDeviceSize freed_bytes = 0;
+        for (size_t i = 0; i < candidates.size() && i < MAX_CHANGES_PER_FRAME; ++i)
+        {
+            if (freed_bytes >= bytes_over_budget)
+            {
+                break;
+            }
+
+            ResidentTexture& texture = *candidates[i];
+            const VkExtent2D extent = Extent2D(texture.full_extent);
+            freed_bytes += MipChainBytes(extent, texture.dropped_mips, texture.dropped_mips + 1);
+            DropTopMip(engine, cmd, texture);
+        }
+    }
+
+    void TextureResidency::StreamInUsedTextures(
+        VulkanEngine& engine, VkCommandBuffer cmd, VkDeviceSize headroom_bytes
+    )
+    {
+        // textures drawn last frame are needed again, the last draws are recorded before this update.
+        std::vector<ResidentTexture*> candidates{};
+        for (ResidentTexture& texture : m_textures)
+        {
+            if (texture.state == TextureResidencyState::Evicted && texture.last_used_frame + 2 >= m_frame)
+            {
+                candidates.push_back(&texture);
+            }
+        }
+
+        // smallest first so more textures fit in the headroom.
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](const ResidentTexture* a, const ResidentTexture* b)
+            {
+                return MipChainBytes(Extent2D(a->full_extent), 0, a->dropped_mips) <
+                       MipChainBytes(Extent2D(b->full_extent), 0, b->dropped_mips);
+            }
+        );
+
+        for (size_t i = 0; i < candidates.size() && i < MAX_CHANGES_PER_FRAME; ++i)
+        {
+            ResidentTexture& texture = *candidates[i];
+            const VkDeviceSize needed_bytes =
+                MipChainBytes(Extent2D(texture.full_extent), 0, texture.dropped_mips);
+            if (needed_bytes > headroom_bytes)
+            {
+                break;
+            }
+
+            headroom_bytes -= needed_bytes;
+            StreamIn(engine, cmd, texture);
+        }
+    }
+
+    void TextureResidency::UploadStreamedMips(VulkanEngine& engine, VkCommandBuffer cmd)
+    {
+        // spread large uploads over frames, the clamped textures can be drawn while they wait.
+        VkDeviceSize uploaded_bytes = 0;
+        for (ResidentTexture& texture : m_textures)
+        {
+            if (texture.state != TextureResidencyState::StreamingIn)
+            {
+                continue;
+            }
+            if (uploaded_bytes >= MAX_UPLOAD_BYTES_PER_FRAME)
+            {
+                break;
+            }
+
+            uploaded_bytes += MipChainBytes(Extent2D(texture.full_extent), 0, texture.dropped_mips);
+            UploadTopMips(engine, cmd, texture);
+        }
+    }
+
+    void TextureResidency::DropTopMip(VulkanEngine& engine, VkCommandBuffer cmd, ResidentTexture& texture)
+    {
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        const AllocatedImage& current = *texture.image;
+
+        Utils::TransitionImage(
+            &device_dispatch,
+            cmd,
+            current.image,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+        );
+
+        // mip 0 is kept in host memory so the dropped mips can be rebuilt without reloading the scene.
+        if (texture.dropped_mips == 0)
+        {
+            const VkDeviceSize size = MipChainBytes(Extent2D(texture.full_extent), 0, 1);
+            texture.evicted_pixels = engine.CreateBuffer(
+                size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                0,
+                "texture_evicted_pixels"
+            );
+
+            VkBufferImageCopy2 copy = Mip0BufferCopy(texture.full_extent);
+            VkCopyImageToBufferInfo2 copy_info{};
+            copy_info.sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_BUFFER_INFO_2;
+            copy_info.srcImage = current.image;
+            copy_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            copy_info.dstBuffer = texture.evicted_pixels->buffer;
+            copy_info.regionCount = 1;
+            copy_info.pRegions = &copy;
+            device_dispatch.cmdCopyImageToBuffer2(cmd, &copy_info);
+        }
+
+        ImageHandle smaller = AllocateMips(engine, texture, texture.dropped_mips + 1);
+        Utils::TransitionImage(
+            &device_dispatch,
+            cmd,
+            smaller->image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        );
+        CopyMips(device_dispatch, cmd, current, 1, *smaller, 0);
+        Utils::TransitionImage(
+            &device_dispatch,
+            cmd,
+            smaller->image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+
+        // the old image can still be shown by the resource debugger until it is destroyed.
+        Utils::TransitionImage(
+            &device_dispatch,
+            cmd,
+            current.image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+
+        texture.dropped_mips += 1;
+        texture.state = TextureResidencyState::Evicted;
+        ReplaceImage(engine, texture, std::move(smaller));
+        RewriteBindings(engine, texture, engine.Sampler());
+    }
+
+    void TextureResidency::StreamIn(VulkanEngine& engine, VkCommandBuffer cmd, ResidentTexture& texture)
+    {
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        const AllocatedImage& current = *texture.image;
+
+        // the mips still in memory are copied now, the dropped ones are uploaded by a later frame. The top
+        // mips are put in the sampled layout too since descriptors cover every mip of the view.
+        ImageHandle full = AllocateMips(engine, texture, 0);
+        Utils::TransitionImage(
+            &device_dispatch,
+            cmd,
+            current.image,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+        );
+        Utils::TransitionImageMips(
+            &device_dispatch,
+            cmd,
+            full->image,
+            0,
+            texture.dropped_mips,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+        Utils::TransitionImageMips(
+            &device_dispatch,
+            cmd,
+            full->image,
+            texture.dropped_mips,
+            VK_REMAINING_MIP_LEVELS,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        );
+        CopyMips(device_dispatch, cmd, current, 0, *full, texture.dropped_mips);
+        Utils::TransitionImageMips(
+            &device_dispatch,
+            cmd,
+            full->image,
+            texture.dropped_mips,
+            VK_REMAINING_MIP_LEVELS,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+        Utils::TransitionImage(
+            &device_dispatch,
+            cmd,
+            current.image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+
+        // the sampler starts at the first mip that was already in memory, so the top mips stay hidden and the
+        // texture keeps the resolution it was evicted to until they are uploaded.
+        texture.state = TextureResidencyState::StreamingIn;
+        ReplaceImage(engine, texture, std::move(full));
+        RewriteBindings(engine, texture, ClampedSampler(engine, texture.dropped_mips));
+    }
+
+    void TextureResidency::UploadTopMips(VulkanEngine& engine, VkCommandBuffer cmd, ResidentTexture& texture)
+    {
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        const AllocatedImage& image = *texture.image;
+
+        // the top mips don't hold anything yet, their contents can be discarded.
+        Utils::TransitionImageMips(
+            &device_dispatch,
+            cmd,
+            image.image,
+            0,
+            texture.dropped_mips,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        );
+
+        VkBufferImageCopy2 copy = Mip0BufferCopy(texture.full_extent);
+        VkCopyBufferToImageInfo2 copy_info{};
+        copy_info.sType = VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2;
+        copy_info.srcBuffer = texture.evicted_pixels->buffer;
+        copy_info.dstImage = image.image;
+        copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copy_info.regionCount = 1;
+        copy_info.pRegions = &copy;
+        device_dispatch.cmdCopyBufferToImage2(cmd, &copy_info);
+
+        Utils::GenerateMipmaps(
+            &device_dispatch, cmd, image.image, Extent2D(texture.full_extent), texture.dropped_mips
+        );
+        Utils::TransitionImageMips(
+            &device_dispatch,
+            cmd,
+            image.image,
+            0,
+            texture.dropped_mips,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+
+        // draws recorded after this read every mip again. The host copy is freed with this frame.
+        engine.GetCurrentFrame().buffers_in_use.push_back(std::move(texture.evicted_pixels));
+        texture.evicted_pixels = BufferHandle{};
+        texture.dropped_mips = 0;
+        texture.state = TextureResidencyState::Resident;
+        RewriteBindings(engine, texture, engine.Sampler());
+    }
+
+    ImageHandle TextureResidency::AllocateMips(
+        VulkanEngine& engine, const ResidentTexture& texture, uint32_t dropped_mips
+    )
+    {
+        const VkExtent2D extent = Utils::MipExtent(Extent2D(texture.full_extent), dropped_mips);
+        return engine.AllocateImage(
+            VkExtent3D{ extent.width, extent.height, 1 },
+            texture.image->image_format,
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            0,
+            0,
+            false,
+            "texture_residency",
+            texture.full_mip_levels - dropped_mips,
+            AllocationClass::Texture
+        );
+    }
+
+    void TextureResidency::ReplaceImage(
+        VulkanEngine& engine, ResidentTexture& texture, ImageHandle replacement
+    )
+    {
+        // every handle to the texture now sees the new image. The replacement handle holds the old one and is
+        // released with this frame, once the frames that can still draw it are done.
+        std::swap(*texture.image, *replacement);
+        engine.GetCurrentFrame().images_in_use.push_back(std::move(replacement));
+
+        // moves find the image by the storage id in its allocation, which still names the replacement.
+        VmaAllocationInfo allocation_info{};
+        vmaGetAllocationInfo(engine.Allocator(), texture.image->allocation, &allocation_info);
+        if (allocation_info.pUserData != nullptr)
+        {
+            engine.Pools().TrackImage(engine.Allocator(), texture.image->allocation, texture.image.id);
+        }
+    }
+
+    void TextureResidency::RewriteBindings(VulkanEngine& engine, ResidentTexture& texture, VkSampler sampler)
+    {
+        Material_GLTF_PBR& pbr_material = engine.PBRMaterial();
+        for (const TextureBinding& binding : texture.bindings)
+        {
+            std::shared_ptr<GLTFMaterial> material = binding.material.lock();
+            if (material == nullptr)
+            {
+                continue;
+            }
+
+            VkDescriptorSet old_set = pbr_material.ReplaceImage(
+                engine.DeviceDispatchTable(),
+                material->material,
+                binding.binding,
+                texture.image->image_view,
+                sampler
+            );
+            engine.GetCurrentFrame().deletion_queue.PushFunction(
+                "material set",
+                [&pbr_material, old_set]()
+                {
+                    pbr_material.RecycleSet(old_set);
+                }
+            );
+        }
+    }
+
+    VkSampler TextureResidency::ClampedSampler(VulkanEngine& engine, uint32_t dropped_mips)
+    {
+        VkSampler& sampler =
+            m_clamped_samplers[std::min<size_t>(dropped_mips, m_clamped_samplers.size() - 1)];
+        if (sampler == VK_NULL_HANDLE)
+        {
+            // same filter and mipmap mode as the material sampler. Lods below the first uploaded mip are
+            // clamped to it, so the sampler doesn't change while the top mips upload.
+            VkSamplerCreateInfo sampler_create_info = engine.SamplerCreateInfo();
+            sampler_create_info.minLod = float(dropped_mips);
+            sampler_create_info.maxLod = VK_LOD_CLAMP_NONE;
+            VK_CHECK(engine.DeviceDispatchTable().createSampler(&sampler_create_info, nullptr, &sampler));
+        }
+
+        return sampler;
+    }
+} // namespace Renderer
@@ -0,0 +1,90 @@
+#include "Renderer/Upscaling.h"
+#include "Renderer/Utility/VkDescriptors.h"
+#include "Renderer/Utility/VkPipelines.h"
+
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <iostream>
+
+namespace Renderer
+{
+    bool UpscalePass::BuildPipelines(vkb::DispatchTable& device_dispatch, VkFormat target_format)
+    {
+        Utils::DescriptorLayoutBuilder layout_builder;
+        layout_builder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER); // source image
+        descriptor_layout = layout_builder.Build(device_dispatch, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+        VkPushConstantRange range{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(GPUUpscalePushConstants) };
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.pSetLayouts = &descriptor_layout;
+        pipeline_layout_info.setLayoutCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &range;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+
+        VkResult result = device_dispatch.createPipelineLayout(&pipeline_layout_info, nullptr, &layout);
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "[!] Failed to create pipeline layout for upscaling. Vulkan Error: "
+                      << string_VkResult(result) << std::endl;
+            return false;
+        }
+
+        VkShaderModule vert_shader;
+        if (Utils::LoadShaderModule(device_dispatch, "../data/shader/upscale.vert.spv", &vert_shader) ==
+            false)
+        {
+            std::cerr << "[!] Failed to load upscale vertex shader." << std::endl;
+            return false;
+        }
+
+        VkShaderModule frag_shader;
+        if (Utils::LoadShaderModule(device_dispatch, "../data/shader/upscale.frag.spv", &frag_shader) ==
+            false)
+        {
+            std::cerr << "[!] Failed to load upscale fragment shader." << std::endl;
+            device_dispatch.destroyShaderModule(vert_shader, nullptr);
+            return false;
+        }
+
+        pipeline = Utils::PipelineBuilder{}
+                       .SetLayout(layout)
+                       .AddVertexShader(vert_shader)
+                       .AddFragmentShader(frag_shader)
+                       .SetCullMode(VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE)
+                       .SetInputTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+                       .SetPolygonMode(VK_POLYGON_MODE_FILL)
+                       .SetColorAttachmentFormat(target_format)
+                       .DisableDepthTest()
+                       .SetMultisamplingNone()
+                       .DisableBlending()
+                       .BuildPipeline(device_dispatch);
+
+        device_dispatch.destroyShaderModule(vert_shader, nullptr);
+        device_dispatch.destroyShaderModule(frag_shader, nullptr);
+
+        loaded = pipeline != VK_NULL_HANDLE;
+        return loaded;
+    }
+
+    void UpscalePass::DestroyResources(vkb::DispatchTable& device_dispatch)
+    {
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyPipeline(pipeline, nullptr);
+            pipeline = VK_NULL_HANDLE;
+        }
+        if (layout != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyPipelineLayout(layout, nullptr);
+            layout = VK_NULL_HANDLE;
+        }
+        if (descriptor_layout != VK_NULL_HANDLE)
+        {
+            device_dispatch.destroyDescriptorSetLayout(descriptor_layout, nullptr);
+            descriptor_layout = VK_NULL_HANDLE;
+        }
+        loaded = false;
+    }
+} // namespace Renderer
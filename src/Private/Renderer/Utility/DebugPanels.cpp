@@ -1,5 +1,6 @@
 #include "Renderer/Utility/DebugPanels.h"
 #include "Renderer/ResourceStorage.h"
+#include "Renderer/Utility/VertexFormats.h"
 #include "Renderer/Utility/VkLoader.h"
 #include "Renderer/Viewport.h"
 #include "Renderer/VkEngine.h"
@@ -11,9 +12,11 @@
 #include <glm/gtx/matrix_decompose.hpp>
 #include <imgui.h>
 
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
 #include <memory>
+#include <string>
 
 namespace Renderer::Debug
 {
@@ -39,6 +42,20 @@ namespace Renderer::Debug
 
         ImGui::Text("Draw Resolution: %dx%d", viewport.draw_extent.width, viewport.draw_extent.height);
         ImGui::SliderFloat("Render Scale", &viewport.render_scale, 0.1f, 1.0f);
+        if (ImGui::CollapsingHeader("Dynamic Resolution"))
+        {
+            DynamicResolution& dynamic_resolution = viewport.dynamic_resolution;
+            ImGui::Checkbox("Enabled", &dynamic_resolution.enabled);
+            ImGui::SliderFloat("Target GPU Time (ms)", &dynamic_resolution.target_milliseconds, 1.0f, 50.0f);
+            ImGui::SliderFloat("Min Scale", &dynamic_resolution.min_scale, 0.1f, 1.0f);
+            ImGui::SliderFloat("Max Scale", &dynamic_resolution.max_scale, 0.1f, 1.0f);
+            ImGui::SliderFloat("Tolerance", &dynamic_resolution.tolerance, 0.0f, 0.5f);
+        }
+        ImGui::SliderFloat("LOD Pixel Error", &viewport.lod_pixel_error, 0.0f, 16.0f);
+        ImGui::Checkbox("Meshlet Culling", &viewport.meshlet_culling);
+        ImGui::Checkbox("Occlusion Culling", &viewport.occlusion_culling);
+        ImGui::Checkbox("Depth Pre-pass", &viewport.depth_prepass);
+        ImGui::Checkbox("Compute Background", &viewport.compute_background);
 
         static float camera_yaw_rad = 0.0f;
         static float camera_pitch_rad = 0.0f;
@@ -53,8 +70,9 @@ namespace Renderer::Debug
             glm::mat4 rotation = glm::rotate(camera_pitch_rad, glm::vec3(1, 0, 0)) *
                                  glm::rotate(camera_yaw_rad, glm::vec3(0, 1, 0));
 
-            viewport.frame_context.camera_position = camera_pos;
-            viewport.frame_context.camera_rotation = rotation;
+            viewport.render_context.camera_position = camera_pos;
+            viewport.render_context.camera_rotation = rotation;
+            viewport.render_context.UpdateCamera();
         }
     }
 
@@ -112,6 +130,11 @@ namespace Renderer::Debug
 
                 ImageHandle img_handle = image_storage.HandleFromID(id);
                 ImTextureID texture_id = engine.ImageDebugTextureId(img_handle);
+                if (texture_id == ImTextureID{})
+                {
+                    ImGui::TextDisabled("not sampled");
+                    return;
+                }
                 ImGui::Image(texture_id, ImVec2{ 48, 48 });
                 if (ImGui::IsItemHovered())
                 {
@@ -152,19 +175,213 @@ namespace Renderer::Debug
 
     void DrawStorageTableImGui(VulkanEngine&, ResourceStorage<MeshAsset>& mesh_storage)
     {
-        constexpr int custom_column_count = 1;
+        constexpr int custom_column_count = 7;
         DrawStorageTableImGui<MeshAsset>(
             mesh_storage,
             []()
             {
                 ImGui::TableSetupColumn("Surface Count");
+                ImGui::TableSetupColumn("Vertex Format");
+                ImGui::TableSetupColumn("Vertex Buffer");
+                ImGui::TableSetupColumn("ACMR");
+                ImGui::TableSetupColumn("ATVR");
+                ImGui::TableSetupColumn("LODs");
+                ImGui::TableSetupColumn("Meshlets");
             },
             [](StorageId_t, const MeshAsset& mesh, int last_column)
             {
                 ImGui::TableSetColumnIndex(last_column + 1);
                 ImGui::Text("%zu", mesh.surfaces.size());
+                ImGui::TableSetColumnIndex(last_column + 2);
+                ImGui::Text("%s", Utils::VertexFormatName(mesh.buffers.vertex_format));
+                ImGui::TableSetColumnIndex(last_column + 3);
+                // pooled meshes only own their range of the pool buffer.
+                const VkDeviceSize vertex_bytes = mesh.buffers.vertex_range.size > 0
+                                                      ? mesh.buffers.vertex_range.size
+                                                      : mesh.buffers.vertex_buffer->allocation_info.size;
+                ImGui::Text("%zu bytes", (size_t)vertex_bytes);
+
+                // before -> after import optimisation
+                const Utils::MeshOptimisationStats& stats = mesh.optimisation_stats;
+                ImGui::TableSetColumnIndex(last_column + 4);
+                ImGui::Text("%.3f -> %.3f", stats.before.Acmr(), stats.after.Acmr());
+                ImGui::TableSetColumnIndex(last_column + 5);
+                ImGui::Text("%.3f -> %.3f", stats.before.Atvr(), stats.after.Atvr());
+
+                uint32_t lod_count = 0;
+                for (const GeoSurface& surface : mesh.surfaces)
+                {
+                    lod_count = std::max(lod_count, surface.LodCount());
+                }
+                ImGui::TableSetColumnIndex(last_column + 6);
+                ImGui::Text("%u", lod_count);
+                ImGui::TableSetColumnIndex(last_column + 7);
+                ImGui::Text("%u", mesh.buffers.meshlet_count);
             },
             custom_column_count
         );
     }
+
+    namespace
+    {
+        constexpr float BYTES_PER_MIB = 1024.0f * 1024.0f;
+
+        float Mebibytes(VkDeviceSize bytes) { return float(bytes) / BYTES_PER_MIB; }
+
+        Utils::StorageMemory ImageStorageMemory(
+            VulkanEngine& engine, ResourceStorage<AllocatedImage>& image_storage
+        )
+        {
+            Utils::StorageMemory memory{ "Images" };
+            std::lock_guard lock{ image_storage.resource_lock };
+            for (const auto& [id, image] : image_storage.resource_map)
+            {
+                VmaAllocationInfo allocation_info{};
+                vmaGetAllocationInfo(engine.Allocator(), image.allocation, &allocation_info);
+                Utils::AddStorageMemory(memory, image_storage.resource_name_map[id], allocation_info.size);
+            }
+            Utils::SortStorageCategories(memory);
+            return memory;
+        }
+
+        Utils::StorageMemory BufferStorageMemory(ResourceStorage<AllocatedBuffer>& buffer_storage)
+        {
+            Utils::StorageMemory memory{ "Buffers" };
+            std::lock_guard lock{ buffer_storage.resource_lock };
+            for (const auto& [id, buffer] : buffer_storage.resource_map)
+            {
+                const VkDeviceSize bytes = buffer.allocation_info.size;
+                Utils::AddStorageMemory(memory, buffer_storage.resource_name_map[id], bytes);
+            }
+            Utils::SortStorageCategories(memory);
+            return memory;
+        }
+
+        Utils::StorageMemory MeshStorageMemory(ResourceStorage<MeshAsset>& mesh_storage)
+        {
+            Utils::StorageMemory memory{ "Meshes" };
+            std::lock_guard lock{ mesh_storage.resource_lock };
+            for (auto& [id, mesh] : mesh_storage.resource_map)
+            {
+                GPUMeshBuffers& buffers = mesh.buffers;
+                // pooled meshes count their ranges, the pool buffers themselves are in the buffer storage.
+                VkDeviceSize bytes = buffers.vertex_range.size + buffers.index_range.size;
+                const bool pooled = bytes > 0;
+                for (BufferHandle* buffer :
+                     { &buffers.index_buffer, &buffers.vertex_buffer, &buffers.meshlet_buffer })
+                {
+                    if (buffer->IsValid() && (pooled == false || buffer == &buffers.meshlet_buffer))
+                    {
+                        bytes += (*buffer)->allocation_info.size;
+                    }
+                }
+                Utils::AddStorageMemory(memory, mesh_storage.resource_name_map[id], bytes);
+            }
+            Utils::SortStorageCategories(memory);
+            return memory;
+        }
+
+        void DrawStorageMemoryImGui(const Utils::StorageMemory& memory)
+        {
+            if (ImGui::TreeNode(
+                    memory.name,
+                    "%s: %.2f MiB in %u resources",
+                    memory.name,
+                    Mebibytes(memory.bytes),
+                    memory.resource_count
+                ))
+            {
+                if (ImGui::BeginTable("CategoryTable", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                {
+                    ImGui::TableSetupColumn("Category");
+                    ImGui::TableSetupColumn("Size");
+                    ImGui::TableSetupColumn("Resources");
+                    ImGui::TableHeadersRow();
+
+                    for (const Utils::MemoryCategory& category : memory.categories)
+                    {
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%s", category.name.c_str());
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%.2f MiB", Mebibytes(category.bytes));
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%u", category.resource_count);
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::TreePop();
+            }
+        }
+    } // namespace
+
+    void DrawMemoryImGui(
+        VulkanEngine& engine,
+        const Utils::MemoryTracker& memory_tracker,
+        ResourceStorage<AllocatedImage>& image_storage,
+        ResourceStorage<AllocatedBuffer>& buffer_storage,
+        ResourceStorage<MeshAsset>& mesh_storage
+    )
+    {
+        if (memory_tracker.BudgetExtensionEnabled() == false)
+        {
+            ImGui::Text("VK_EXT_memory_budget is not supported, budgets are estimated.");
+        }
+
+        const std::vector<Utils::HeapBudget>& heaps = memory_tracker.Heaps();
+        for (size_t heap = 0; heap < heaps.size(); ++heap)
+        {
+            const Utils::HeapBudget& budget = heaps[heap];
+            if (budget.budget == 0)
+            {
+                continue;
+            }
+
+            const float usage_mib = Mebibytes(budget.usage);
+            const float budget_mib = Mebibytes(budget.budget);
+            const bool over_budget = usage_mib > budget_mib * Utils::MemoryTracker::BUDGET_WARNING_FRACTION;
+            const std::string label =
+                "Heap " + std::to_string(heap) + (budget.device_local ? " (device)" : " (host)");
+
+            ImGui::PushID(int(heap));
+            if (over_budget)
+            {
+                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4{ 1.0f, 0.4f, 0.4f, 1.0f });
+            }
+            ImGui::Text(
+                "%s: %.1f / %.1f MiB, %.1f MiB in %u VMA allocations",
+                label.c_str(),
+                usage_mib,
+                budget_mib,
+                Mebibytes(budget.allocation_bytes),
+                budget.allocation_count
+            );
+            if (over_budget)
+            {
+                ImGui::PopStyleColor();
+            }
+
+            // the graph is scaled to the budget so a full graph means the heap is out of memory.
+            const std::array<float, Utils::MemoryTracker::HISTORY_LENGTH> history =
+                memory_tracker.UsageHistory(heap);
+            ImGui::PlotLines(
+                "##usage", history.data(), int(history.size()), 0, nullptr, 0.0f, budget_mib, ImVec2{ 0, 60 }
+            );
+            ImGui::PopID();
+        }
+
+        ImGui::Separator();
+        DrawStorageMemoryImGui(ImageStorageMemory(engine, image_storage));
+        DrawStorageMemoryImGui(BufferStorageMemory(buffer_storage));
+        DrawStorageMemoryImGui(MeshStorageMemory(mesh_storage));
+
+        ImGui::Separator();
+        static char dump_path[256] = "vma_stats.json";
+        ImGui::InputText("##dump_path", dump_path, sizeof(dump_path));
+        ImGui::SameLine();
+        if (ImGui::Button("Dump JSON"))
+        {
+            memory_tracker.DumpJson(engine.Allocator(), dump_path);
+        }
+    }
 } // namespace Renderer::Debug
\ No newline at end of file
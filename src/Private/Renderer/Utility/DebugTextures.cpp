@@ -0,0 +1,82 @@
+#include "Renderer/Utility/DebugTextures.h"
+
+#include "ThirdParty/ImGUI.h"
+#include <vulkan/vulkan_core.h>
+
+namespace Renderer::Utils
+{
+    ImTextureID DebugTextureCache::Get(
+        VkImage image, VkImageView image_view, VkSampler sampler, uint64_t frame
+    )
+    {
+        m_last_used_frame = frame;
+
+        auto existing = m_lookup.find(image);
+        if (existing != m_lookup.end())
+        {
+            existing->second->last_used_frame = frame;
+            m_entries.splice(m_entries.begin(), m_entries, existing->second);
+            return reinterpret_cast<ImTextureID>(existing->second->descriptor_set);
+        }
+
+        // textures displayed this frame are kept even over capacity, ImGui hasn't drawn them yet.
+        while (m_entries.size() >= CAPACITY && m_entries.back().last_used_frame != frame)
+        {
+            m_retired.push_back(RetiredTexture{ m_entries.back().descriptor_set, frame });
+            m_lookup.erase(m_entries.back().image);
+            m_entries.pop_back();
+        }
+
+        VkDescriptorSet descriptor_set =
+            ImGui_ImplVulkan_AddTexture(sampler, image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        m_entries.push_front(Entry{ image, descriptor_set, frame });
+        m_lookup[image] = m_entries.begin();
+        return reinterpret_cast<ImTextureID>(descriptor_set);
+    }
+
+    void DebugTextureCache::Forget(VkImage image, uint64_t frame)
+    {
+        auto existing = m_lookup.find(image);
+        if (existing == m_lookup.end())
+        {
+            return;
+        }
+
+        m_retired.push_back(RetiredTexture{ existing->second->descriptor_set, frame });
+        m_entries.erase(existing->second);
+        m_lookup.erase(existing);
+    }
+
+    void DebugTextureCache::ReleaseRetired(uint64_t frame, uint32_t frames_in_flight)
+    {
+        // once the frame after the retired one comes around again, no frame drawing it is in flight.
+        std::erase_if(
+            m_retired,
+            [&](const RetiredTexture& retired)
+            {
+                if (frame < retired.retired_frame + frames_in_flight)
+                {
+                    return false;
+                }
+
+                ImGui_ImplVulkan_RemoveTexture(retired.descriptor_set);
+                return true;
+            }
+        );
+    }
+
+    void DebugTextureCache::Clear()
+    {
+        for (const Entry& entry : m_entries)
+        {
+            ImGui_ImplVulkan_RemoveTexture(entry.descriptor_set);
+        }
+        for (const RetiredTexture& retired : m_retired)
+        {
+            ImGui_ImplVulkan_RemoveTexture(retired.descriptor_set);
+        }
+        m_entries.clear();
+        m_lookup.clear();
+        m_retired.clear();
+    }
+} // namespace Renderer::Utils
@@ -0,0 +1,186 @@
+#include "Renderer/Utility/GpuProfiler.h"
+
+#include <VkBootstrapDispatch.h>
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace Renderer::Utils
+{
+    void GpuProfiler::Init(
+        vkb::DispatchTable& device_dispatch,
+        uint32_t frame_count,
+        bool timestamps_supported,
+        float timestamp_period_ns
+    )
+    {
+        if (timestamps_supported == false)
+        {
+            std::cerr << "[!] GPU timestamps are not supported, GPU profiling is disabled." << std::endl;
+            return;
+        }
+
+        m_timestamp_period_ns = timestamp_period_ns;
+        m_timestamps_supported = true;
+
+        VkQueryPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        pool_info.pNext = nullptr;
+        pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        pool_info.queryCount = MAX_SCOPES * 2;
+
+        m_frames.resize(frame_count);
+        for (FrameQueries& frame : m_frames)
+        {
+            VkResult result = device_dispatch.createQueryPool(&pool_info, nullptr, &frame.query_pool);
+            if (result != VK_SUCCESS)
+            {
+                std::cerr << "[!] Failed to create GPU profiler query pool. Vulkan Error: "
+                          << string_VkResult(result) << std::endl;
+                Destroy(device_dispatch);
+                return;
+            }
+        }
+    }
+
+    void GpuProfiler::Destroy(vkb::DispatchTable& device_dispatch)
+    {
+        for (FrameQueries& frame : m_frames)
+        {
+            if (frame.query_pool != VK_NULL_HANDLE)
+            {
+                device_dispatch.destroyQueryPool(frame.query_pool, nullptr);
+            }
+        }
+        m_frames.clear();
+        m_timings.clear();
+    }
+
+    void GpuProfiler::SetFrameCount(vkb::DispatchTable& device_dispatch, uint32_t frame_count)
+    {
+        if (m_timestamps_supported == false)
+        {
+            return;
+        }
+
+        Destroy(device_dispatch);
+        Init(device_dispatch, frame_count, m_timestamps_supported, m_timestamp_period_ns);
+    }
+
+    void GpuProfiler::BeginFrame(
+        vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd, uint32_t frame_index
+    )
+    {
+        if (IsSupported() == false)
+        {
+            return;
+        }
+
+        m_current_frame = frame_index % uint32_t(m_frames.size());
+        FrameQueries& frame = m_frames[m_current_frame];
+
+        if (frame.scope_names.empty() == false)
+        {
+            // timestamp and availability of every query
+            const uint32_t query_count = uint32_t(frame.scope_names.size()) * 2;
+            std::vector<uint64_t> results(query_count * 2, 0);
+            VkResult result = device_dispatch.getQueryPoolResults(
+                frame.query_pool,
+                0,
+                query_count,
+                results.size() * sizeof(uint64_t),
+                results.data(),
+                2 * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+            );
+
+            if (result == VK_SUCCESS || result == VK_NOT_READY)
+            {
+                m_timings.clear();
+                for (size_t scope = 0; scope < frame.scope_names.size(); ++scope)
+                {
+                    const uint64_t begin = results[scope * 4];
+                    const uint64_t end = results[scope * 4 + 2];
+                    const bool available = results[scope * 4 + 1] != 0 && results[scope * 4 + 3] != 0;
+                    if (available == false || end < begin)
+                    {
+                        continue;
+                    }
+
+                    // scopes with the same name add up, e.g. a pass drawn once per occlusion culling phase.
+                    const double milliseconds = double(end - begin) * m_timestamp_period_ns / 1'000'000.0;
+                    auto timing = std::find_if(
+                        m_timings.begin(),
+                        m_timings.end(),
+                        [&](const GpuTiming& existing)
+                        {
+                            return existing.name == frame.scope_names[scope];
+                        }
+                    );
+                    if (timing != m_timings.end())
+                    {
+                        timing->milliseconds += milliseconds;
+                    }
+                    else
+                    {
+                        m_timings.push_back(GpuTiming{ std::move(frame.scope_names[scope]), milliseconds });
+                    }
+                }
+            }
+        }
+
+        frame.scope_names.clear();
+        device_dispatch.cmdResetQueryPool(cmd, frame.query_pool, 0, MAX_SCOPES * 2);
+    }
+
+    uint32_t GpuProfiler::BeginScope(
+        vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd, std::string name
+    )
+    {
+        if (IsSupported() == false)
+        {
+            return INVALID_SCOPE;
+        }
+
+        FrameQueries& frame = m_frames[m_current_frame];
+        if (frame.scope_names.size() >= MAX_SCOPES)
+        {
+            return INVALID_SCOPE;
+        }
+
+        const uint32_t scope = uint32_t(frame.scope_names.size());
+        frame.scope_names.emplace_back(std::move(name));
+        device_dispatch.cmdWriteTimestamp2(
+            cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, frame.query_pool, scope * 2
+        );
+
+        return scope;
+    }
+
+    void GpuProfiler::EndScope(vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd, uint32_t scope)
+    {
+        if (scope == INVALID_SCOPE)
+        {
+            return;
+        }
+
+        device_dispatch.cmdWriteTimestamp2(
+            cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_frames[m_current_frame].query_pool, scope * 2 + 1
+        );
+    }
+
+    double GpuProfiler::TimingMilliseconds(std::string_view name) const
+    {
+        for (const GpuTiming& timing : m_timings)
+        {
+            if (timing.name == name)
+            {
+                return timing.milliseconds;
+            }
+        }
+
+        return -1.0;
+    }
+} // namespace Renderer::Utils
@@ -0,0 +1,139 @@
+#include "Renderer/Utility/MemoryStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace Renderer::Utils
+{
+    void MemoryTracker::Init(VmaAllocator allocator, bool budget_extension_enabled)
+    {
+        m_budget_extension_enabled = budget_extension_enabled;
+        if (budget_extension_enabled == false)
+        {
+            std::cerr << "[!] VK_EXT_memory_budget is not supported, memory budgets are estimated."
+                      << std::endl;
+        }
+
+        const VkPhysicalDeviceMemoryProperties* memory_properties = nullptr;
+        vmaGetMemoryProperties(allocator, &memory_properties);
+
+        m_heaps.resize(memory_properties->memoryHeapCount);
+        m_history.resize(memory_properties->memoryHeapCount);
+        for (uint32_t heap = 0; heap < memory_properties->memoryHeapCount; ++heap)
+        {
+            m_heaps[heap].device_local =
+                (memory_properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        }
+        m_history_offset = 0;
+    }
+
+    void MemoryTracker::Update(VmaAllocator allocator, uint32_t frame_index)
+    {
+        vmaSetCurrentFrameIndex(allocator, frame_index);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+        vmaGetHeapBudgets(allocator, budgets.data());
+
+        constexpr float bytes_per_mib = 1024.0f * 1024.0f;
+        for (size_t heap = 0; heap < m_heaps.size(); ++heap)
+        {
+            HeapBudget& heap_budget = m_heaps[heap];
+            heap_budget.usage = budgets[heap].usage;
+            heap_budget.budget = budgets[heap].budget;
+            heap_budget.allocation_bytes = budgets[heap].statistics.allocationBytes;
+            heap_budget.allocation_count = budgets[heap].statistics.allocationCount;
+
+            HeapHistory& history = m_history[heap];
+            history.usage_mib[m_history_offset] = float(heap_budget.usage) / bytes_per_mib;
+
+            // only report crossing the threshold so a full heap doesn't print every frame.
+            const bool over_budget =
+                float(heap_budget.usage) > float(heap_budget.budget) * BUDGET_WARNING_FRACTION;
+            if (over_budget && history.over_budget == false)
+            {
+                std::cerr << "[!] Memory heap " << heap << " is using "
+                          << heap_budget.usage / (1024 * 1024) << " MiB of its "
+                          << heap_budget.budget / (1024 * 1024) << " MiB budget." << std::endl;
+            }
+            history.over_budget = over_budget;
+        }
+
+        m_history_offset = (m_history_offset + 1) % HISTORY_LENGTH;
+    }
+
+    std::array<float, MemoryTracker::HISTORY_LENGTH> MemoryTracker::UsageHistory(size_t heap) const
+    {
+        std::array<float, HISTORY_LENGTH> history{};
+        const std::array<float, HISTORY_LENGTH>& samples = m_history[heap].usage_mib;
+        const auto oldest = samples.begin() + std::ptrdiff_t(m_history_offset);
+        std::rotate_copy(samples.begin(), oldest, samples.end(), history.begin());
+        return history;
+    }
+
+    bool MemoryTracker::DumpJson(VmaAllocator allocator, const std::filesystem::path& path) const
+    {
+        std::ofstream file{ path };
+        if (file.is_open() == false)
+        {
+            std::cerr << "[!] Failed to open " << path << " to dump the memory statistics." << std::endl;
+            return false;
+        }
+
+        char* stats_string = nullptr;
+        vmaBuildStatsString(allocator, &stats_string, VK_TRUE);
+        file << stats_string;
+        vmaFreeStatsString(allocator, stats_string);
+
+        std::cout << "[*] Dumped memory statistics to " << path << std::endl;
+        return true;
+    }
+
+    std::string_view MemoryCategoryName(std::string_view debug_name)
+    {
+        // drop numbers and the separators in front of them at the end of the name.
+        const size_t last = debug_name.find_last_not_of("0123456789_- ");
+        if (last == std::string_view::npos)
+        {
+            return debug_name;
+        }
+
+        return debug_name.substr(0, last + 1);
+    }
+
+    void AddStorageMemory(StorageMemory& storage, std::string_view debug_name, VkDeviceSize bytes)
+    {
+        storage.bytes += bytes;
+        ++storage.resource_count;
+
+        const std::string_view category_name = MemoryCategoryName(debug_name);
+        auto category = std::find_if(
+            storage.categories.begin(),
+            storage.categories.end(),
+            [&](const MemoryCategory& existing)
+            {
+                return existing.name == category_name;
+            }
+        );
+        if (category == storage.categories.end())
+        {
+            storage.categories.push_back(MemoryCategory{ std::string(category_name), 0, 0 });
+            category = storage.categories.end() - 1;
+        }
+
+        category->bytes += bytes;
+        ++category->resource_count;
+    }
+
+    void SortStorageCategories(StorageMemory& storage)
+    {
+        std::sort(
+            storage.categories.begin(),
+            storage.categories.end(),
+            [](const MemoryCategory& a, const MemoryCategory& b)
+            {
+                return a.bytes > b.bytes;
+            }
+        );
+    }
+} // namespace Renderer::Utils
@@ -0,0 +1,779 @@
+#include "Renderer/Utility/MeshOptimiser.h"
+#include "Renderer/Utility/MeshSimplifier.h"
+#include "Renderer/Utility/VertexFormats.h"
+#include "Renderer/VkTypes.h"
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+    // Values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+    constexpr uint32_t forsyth_cache_size = 32;
+    constexpr float forsyth_cache_decay_power = 1.5f;
+    constexpr float forsyth_last_triangle_score = 0.75f;
+    constexpr float forsyth_valence_boost_scale = 2.0f;
+    constexpr float forsyth_valence_boost_power = 0.5f;
+
+    // cache size used to find cluster boundaries for the overdraw optimisation, same as the analysis.
+    constexpr uint32_t overdraw_cache_size = 16;
+
+    constexpr uint32_t cache_file_magic = 0x434d4843; // "CHMC"
+    constexpr uint32_t cache_file_version = 2;
+
+    // LODs that deviate more than this fraction of the mesh size are too coarse to be worth drawing.
+    constexpr float max_lod_error_ratio = 0.05f;
+    // a LOD needs to remove at least this fraction of the triangles of the previous one.
+    constexpr float min_lod_reduction = 0.15f;
+    constexpr size_t min_lod_triangles = 8;
+
+    constexpr uint64_t fnv_offset_basis = 0xcbf29ce484222325ull;
+    constexpr uint64_t fnv_prime = 0x100000001b3ull;
+
+    uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= fnv_prime;
+        }
+
+        return hash;
+    }
+
+    struct VertexBitwiseHash
+    {
+        size_t operator()(const Renderer::Vertex& vertex) const
+        {
+            return static_cast<size_t>(HashBytes(fnv_offset_basis, &vertex, sizeof(Renderer::Vertex)));
+        }
+    };
+
+    struct VertexBitwiseEqual
+    {
+        bool operator()(const Renderer::Vertex& lhs, const Renderer::Vertex& rhs) const
+        {
+            return std::memcmp(&lhs, &rhs, sizeof(Renderer::Vertex)) == 0;
+        }
+    };
+
+    /// FIFO cache simulation. A vertex is in the cache if fewer than cache_size misses happened since it was
+    /// last loaded, which saves us from actually storing the queue.
+    class FifoCacheSimulation
+    {
+      public:
+        FifoCacheSimulation(size_t vertex_count, uint32_t cache_size) :
+            m_timestamps(vertex_count, 0),
+            m_cache_size(cache_size),
+            m_time(cache_size + 1)
+        {
+        }
+
+        /// Returns the number of cache misses caused by the triangle.
+        uint32_t Triangle(const uint32_t* triangle)
+        {
+            uint32_t misses = 0;
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t& timestamp = m_timestamps[triangle[corner]];
+                if (m_time - timestamp > m_cache_size)
+                {
+                    timestamp = m_time++;
+                    ++misses;
+                }
+            }
+
+            return misses;
+        }
+
+        void Flush() { m_time += m_cache_size + 1; }
+
+      private:
+        std::vector<uint32_t> m_timestamps;
+        uint32_t m_cache_size;
+        uint32_t m_time;
+    };
+
+    float ForsythVertexScore(int32_t cache_position, uint32_t remaining_valence)
+    {
+        if (remaining_valence == 0)
+        {
+            return -1.0f; // not used by any triangle anymore
+        }
+
+        float score = 0.0f;
+        if (cache_position >= 0)
+        {
+            if (cache_position < 3)
+            {
+                // used by the last triangle, fixed score to avoid strips that just go back and forth
+                score = forsyth_last_triangle_score;
+            }
+            else
+            {
+                const float scaler = 1.0f / float(forsyth_cache_size - 3);
+                score = std::pow(1.0f - float(cache_position - 3) * scaler, forsyth_cache_decay_power);
+            }
+        }
+
+        // prefer vertices with few triangles left so we don't leave lone triangles behind
+        score += forsyth_valence_boost_scale *
+                 std::pow(float(remaining_valence), -forsyth_valence_boost_power);
+        return score;
+    }
+
+    bool IndicesInRange(std::span<const uint32_t> indices, size_t vertex_count)
+    {
+        return std::all_of(
+            indices.begin(),
+            indices.end(),
+            [vertex_count](uint32_t idx)
+            {
+                return idx < vertex_count;
+            }
+        );
+    }
+
+    template <typename T>
+    void WriteValue(std::ofstream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadValue(std::ifstream& stream, T& value)
+    {
+        stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return stream.good();
+    }
+} // namespace
+
+namespace Renderer::Utils
+{
+    float VertexCacheStatistics::Acmr() const
+    {
+        return triangle_count == 0 ? 0.0f : float(cache_misses) / float(triangle_count);
+    }
+
+    float VertexCacheStatistics::Atvr() const
+    {
+        return vertex_count == 0 ? 0.0f : float(cache_misses) / float(vertex_count);
+    }
+
+    VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& other)
+    {
+        triangle_count += other.triangle_count;
+        vertex_count += other.vertex_count;
+        cache_misses += other.cache_misses;
+        return *this;
+    }
+
+    MeshOptimisationStats& MeshOptimisationStats::operator+=(const MeshOptimisationStats& other)
+    {
+        before += other.before;
+        after += other.after;
+        return *this;
+    }
+
+    VertexCacheStatistics AnalyseVertexCache(
+        std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size
+    )
+    {
+        VertexCacheStatistics stats{};
+        stats.triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        stats.vertex_count = static_cast<uint32_t>(vertex_count);
+
+        FifoCacheSimulation cache{ vertex_count, cache_size };
+        for (size_t triangle = 0; triangle < stats.triangle_count; ++triangle)
+        {
+            stats.cache_misses += cache.Triangle(&indices[triangle * 3]);
+        }
+
+        return stats;
+    }
+
+    size_t DeduplicateVertices(std::span<uint32_t> indices, std::vector<Vertex>& vertices)
+    {
+        std::unordered_map<Vertex, uint32_t, VertexBitwiseHash, VertexBitwiseEqual> unique_lookup{};
+        unique_lookup.reserve(vertices.size());
+
+        std::vector<Vertex> unique_vertices{};
+        unique_vertices.reserve(vertices.size());
+        std::vector<uint32_t> remap(vertices.size());
+
+        for (size_t idx = 0; idx < vertices.size(); ++idx)
+        {
+            auto [it, inserted] =
+                unique_lookup.try_emplace(vertices[idx], static_cast<uint32_t>(unique_vertices.size()));
+            if (inserted)
+            {
+                unique_vertices.emplace_back(vertices[idx]);
+            }
+            remap[idx] = it->second;
+        }
+
+        for (uint32_t& idx : indices)
+        {
+            idx = remap[idx];
+        }
+
+        vertices = std::move(unique_vertices);
+        return vertices.size();
+    }
+
+    void OptimiseVertexCache(std::span<uint32_t> indices, size_t vertex_count)
+    {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+        {
+            return;
+        }
+
+        // triangles using each vertex, the first remaining_valence entries of each range are the ones that
+        // have not been emitted yet.
+        std::vector<uint32_t> remaining_valence(vertex_count, 0);
+        for (uint32_t idx : indices)
+        {
+            ++remaining_valence[idx];
+        }
+
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + remaining_valence[vertex];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+            {
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    const uint32_t vertex = indices[triangle * 3 + corner];
+                    adjacency[fill_offsets[vertex]++] = static_cast<uint32_t>(triangle);
+                }
+            }
+        }
+
+        std::vector<int32_t> cache_position(vertex_count, -1);
+        std::vector<float> vertex_score(vertex_count);
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            vertex_score[vertex] = ForsythVertexScore(-1, remaining_valence[vertex]);
+        }
+
+        std::vector<float> triangle_score(triangle_count);
+        for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+        {
+            triangle_score[triangle] = vertex_score[indices[triangle * 3 + 0]] +
+                                       vertex_score[indices[triangle * 3 + 1]] +
+                                       vertex_score[indices[triangle * 3 + 2]];
+        }
+
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> output{};
+        output.reserve(indices.size());
+
+        // +3 since the new triangle gets pushed to the front before the last entries fall off.
+        std::array<uint32_t, forsyth_cache_size + 3> cache{};
+        std::array<uint32_t, forsyth_cache_size + 3> new_cache{};
+        size_t cache_count = 0;
+
+        size_t best_triangle = static_cast<size_t>(
+            std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin()
+        );
+        size_t input_cursor = 0;
+
+        while (best_triangle != invalid_index)
+        {
+            emitted[best_triangle] = true;
+            const uint32_t* triangle = &indices[best_triangle * 3];
+            output.insert(output.end(), triangle, triangle + 3);
+
+            // remove the triangle from the adjacency of its vertices
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = triangle[corner];
+                auto begin = adjacency.begin() + adjacency_offsets[vertex];
+                auto end = begin + remaining_valence[vertex];
+                auto it = std::find(begin, end, static_cast<uint32_t>(best_triangle));
+                *it = *(end - 1);
+                --remaining_valence[vertex];
+            }
+
+            // push the triangle to the front of the cache
+            size_t new_cache_count = 0;
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                new_cache[new_cache_count++] = triangle[corner];
+            }
+            for (size_t idx = 0; idx < cache_count; ++idx)
+            {
+                const uint32_t vertex = cache[idx];
+                if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                {
+                    new_cache[new_cache_count++] = vertex;
+                }
+            }
+
+            // update the scores of everything that was touched, including vertices that fell out of the cache
+            for (size_t idx = 0; idx < new_cache_count; ++idx)
+            {
+                const uint32_t vertex = new_cache[idx];
+                cache_position[vertex] = idx < forsyth_cache_size ? static_cast<int32_t>(idx) : -1;
+
+                const float new_score = ForsythVertexScore(cache_position[vertex], remaining_valence[vertex]);
+                const float score_delta = new_score - vertex_score[vertex];
+                vertex_score[vertex] = new_score;
+
+                const uint32_t adjacency_begin = adjacency_offsets[vertex];
+                for (uint32_t adj = 0; adj < remaining_valence[vertex]; ++adj)
+                {
+                    triangle_score[adjacency[adjacency_begin + adj]] += score_delta;
+                }
+            }
+
+            // the next triangle is the best one that uses a vertex in the cache
+            best_triangle = invalid_index;
+            float best_score = -std::numeric_limits<float>::max();
+            cache_count = std::min<size_t>(new_cache_count, forsyth_cache_size);
+            for (size_t idx = 0; idx < cache_count; ++idx)
+            {
+                const uint32_t vertex = new_cache[idx];
+                cache[idx] = vertex;
+
+                const uint32_t adjacency_begin = adjacency_offsets[vertex];
+                for (uint32_t adj = 0; adj < remaining_valence[vertex]; ++adj)
+                {
+                    const uint32_t candidate = adjacency[adjacency_begin + adj];
+                    if (triangle_score[candidate] > best_score)
+                    {
+                        best_score = triangle_score[candidate];
+                        best_triangle = candidate;
+                    }
+                }
+            }
+
+            // nothing connected to the cache, continue with the next triangle in input order
+            if (best_triangle == invalid_index)
+            {
+                while (input_cursor < triangle_count && emitted[input_cursor])
+                {
+                    ++input_cursor;
+                }
+
+                if (input_cursor < triangle_count)
+                {
+                    best_triangle = input_cursor;
+                }
+            }
+        }
+
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void OptimiseOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold)
+    {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count < 2)
+        {
+            return;
+        }
+
+        // Hard boundaries are where the cache was flushed anyway, all three vertices missed. Reordering at
+        // these points doesn't cost anything.
+        std::vector<uint32_t> hard_clusters{};
+        {
+            FifoCacheSimulation cache{ vertices.size(), overdraw_cache_size };
+            for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+            {
+                if (cache.Triangle(&indices[triangle * 3]) == 3)
+                {
+                    hard_clusters.emplace_back(static_cast<uint32_t>(triangle));
+                }
+            }
+        }
+        hard_clusters.emplace_back(static_cast<uint32_t>(triangle_count)); // end marker
+
+        // Split the hard clusters further as long as the smaller clusters stay within threshold of the cache
+        // efficiency of the hard cluster. Each cluster starts with a cold cache since it may end up anywhere.
+        std::vector<uint32_t> clusters{};
+        {
+            FifoCacheSimulation cache{ vertices.size(), overdraw_cache_size };
+            for (size_t hard = 0; hard + 1 < hard_clusters.size(); ++hard)
+            {
+                const uint32_t start = hard_clusters[hard];
+                const uint32_t end = hard_clusters[hard + 1];
+
+                cache.Flush();
+                uint32_t hard_misses = 0;
+                for (uint32_t triangle = start; triangle < end; ++triangle)
+                {
+                    hard_misses += cache.Triangle(&indices[triangle * 3]);
+                }
+                const float hard_acmr = float(hard_misses) / float(end - start);
+
+                cache.Flush();
+                clusters.emplace_back(start);
+                uint32_t soft_start = start;
+                uint32_t soft_misses = 0;
+                for (uint32_t triangle = start; triangle < end; ++triangle)
+                {
+                    soft_misses += cache.Triangle(&indices[triangle * 3]);
+
+                    const float soft_acmr = float(soft_misses) / float(triangle - soft_start + 1);
+                    if (triangle + 1 < end && soft_acmr <= hard_acmr * threshold)
+                    {
+                        soft_start = triangle + 1;
+                        soft_misses = 0;
+                        clusters.emplace_back(soft_start);
+                        cache.Flush();
+                    }
+                }
+            }
+        }
+        const size_t cluster_count = clusters.size();
+        clusters.emplace_back(static_cast<uint32_t>(triangle_count)); // end marker
+
+        // Clusters facing away from the centre of the mesh are likely to occlude the rest, draw them first.
+        glm::vec3 mesh_centroid{ 0.0f };
+        float mesh_area = 0.0f;
+        std::vector<glm::vec3> cluster_centroids(cluster_count, glm::vec3(0.0f));
+        std::vector<glm::vec3> cluster_normals(cluster_count, glm::vec3(0.0f));
+        for (size_t cluster = 0; cluster < cluster_count; ++cluster)
+        {
+            float cluster_area = 0.0f;
+            for (uint32_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; ++triangle)
+            {
+                const glm::vec3& p0 = vertices[indices[triangle * 3 + 0]].position;
+                const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].position;
+                const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].position;
+
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float area = glm::length(normal);
+                const glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+
+                cluster_centroids[cluster] += centroid * area;
+                cluster_normals[cluster] += normal;
+                cluster_area += area;
+            }
+
+            mesh_centroid += cluster_centroids[cluster];
+            mesh_area += cluster_area;
+            if (cluster_area > 0.0f)
+            {
+                cluster_centroids[cluster] /= cluster_area;
+            }
+        }
+        if (mesh_area > 0.0f)
+        {
+            mesh_centroid /= mesh_area;
+        }
+
+        std::vector<float> sort_keys(cluster_count, 0.0f);
+        for (size_t cluster = 0; cluster < cluster_count; ++cluster)
+        {
+            const float normal_length = glm::length(cluster_normals[cluster]);
+            if (normal_length > 0.0f)
+            {
+                const glm::vec3 cluster_direction = cluster_normals[cluster] / normal_length;
+                sort_keys[cluster] = glm::dot(cluster_centroids[cluster] - mesh_centroid, cluster_direction);
+            }
+        }
+
+        std::vector<uint32_t> cluster_order(cluster_count);
+        std::iota(cluster_order.begin(), cluster_order.end(), 0);
+        std::stable_sort(
+            cluster_order.begin(),
+            cluster_order.end(),
+            [&sort_keys](uint32_t lhs, uint32_t rhs)
+            {
+                return sort_keys[lhs] > sort_keys[rhs];
+            }
+        );
+
+        std::vector<uint32_t> output{};
+        output.reserve(indices.size());
+        for (uint32_t cluster : cluster_order)
+        {
+            const size_t first = size_t(clusters[cluster]) * 3;
+            const size_t last = size_t(clusters[cluster + 1]) * 3;
+            output.insert(output.end(), indices.begin() + first, indices.begin() + last);
+        }
+
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    size_t OptimiseVertexFetch(std::span<uint32_t> indices, std::vector<Vertex>& vertices)
+    {
+        std::vector<uint32_t> remap(vertices.size(), invalid_index);
+        std::vector<Vertex> reordered{};
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& idx : indices)
+        {
+            if (remap[idx] == invalid_index)
+            {
+                remap[idx] = static_cast<uint32_t>(reordered.size());
+                reordered.emplace_back(vertices[idx]);
+            }
+            idx = remap[idx];
+        }
+
+        vertices = std::move(reordered);
+        return vertices.size();
+    }
+
+    MeshOptimisationStats OptimiseMesh(
+        std::vector<uint32_t>& indices, std::vector<Vertex>& vertices, float overdraw_threshold
+    )
+    {
+        MeshOptimisationStats stats{};
+        if (indices.size() % 3 != 0 || IndicesInRange(indices, vertices.size()) == false)
+        {
+            std::cout << "[!] Mesh primitive has invalid indices, skipping optimisation." << std::endl;
+            return stats;
+        }
+
+        stats.before = AnalyseVertexCache(indices, vertices.size());
+        DeduplicateVertices(indices, vertices);
+        OptimiseVertexCache(indices, vertices.size());
+        OptimiseOverdraw(indices, vertices, overdraw_threshold);
+        OptimiseVertexFetch(indices, vertices);
+
+        stats.after = AnalyseVertexCache(indices, vertices.size());
+        return stats;
+    }
+
+    void GenerateLods(OptimisedPrimitive& primitive, uint32_t max_lod_count, float lod_ratio)
+    {
+        primitive.lods.clear();
+        const std::vector<uint32_t>& indices = primitive.indices;
+        if (indices.size() % 3 != 0 || IndicesInRange(indices, primitive.vertices.size()) == false)
+        {
+            return;
+        }
+
+        const MeshBounds bounds = ComputeMeshBounds(primitive.vertices);
+        const float max_error = glm::length(bounds.Extent()) * max_lod_error_ratio;
+
+        size_t previous_index_count = indices.size();
+        float previous_error = 0.0f;
+        for (uint32_t lod = 0; lod < max_lod_count; ++lod)
+        {
+            const size_t target_triangles = size_t(float(previous_index_count / 3) * lod_ratio);
+            if (target_triangles < min_lod_triangles)
+            {
+                break;
+            }
+
+            // always simplify from the full detail mesh so the error is measured against it
+            float error = 0.0f;
+            std::vector<uint32_t> lod_indices =
+                SimplifyMesh(indices, primitive.vertices, target_triangles * 3, max_error, error);
+
+            if (float(lod_indices.size()) > float(previous_index_count) * (1.0f - min_lod_reduction))
+            {
+                break;
+            }
+
+            OptimiseVertexCache(lod_indices, primitive.vertices.size());
+
+            // keep the errors increasing so picking the LOD can stop at the first one that is too coarse
+            previous_error = std::max(previous_error, error);
+            previous_index_count = lod_indices.size();
+            primitive.lods.push_back({ std::move(lod_indices), previous_error });
+        }
+    }
+
+    uint64_t HashPrimitive(
+        std::span<const uint32_t> indices, std::span<const Vertex> vertices, uint64_t variant
+    )
+    {
+        uint64_t hash = HashBytes(fnv_offset_basis, &variant, sizeof(variant));
+        hash = HashBytes(hash, indices.data(), indices.size_bytes());
+        hash = HashBytes(hash, vertices.data(), vertices.size_bytes());
+        return hash;
+    }
+
+    MeshOptimisationCache::MeshOptimisationCache(std::filesystem::path cache_path) :
+        m_cache_path(std::move(cache_path))
+    {
+    }
+
+    bool MeshOptimisationCache::Load()
+    {
+        std::ifstream stream{ m_cache_path, std::ios::binary };
+        if (stream.is_open() == false)
+        {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t primitive_count = 0;
+        if (ReadValue(stream, magic) == false || ReadValue(stream, version) == false ||
+            ReadValue(stream, primitive_count) == false || magic != cache_file_magic ||
+            version != cache_file_version)
+        {
+            std::cout << "[!] Discarding outdated mesh cache: " << m_cache_path << std::endl;
+            return false;
+        }
+
+        std::unordered_map<uint64_t, OptimisedPrimitive> loaded{};
+        uint32_t discarded_primitives = 0;
+        for (uint32_t primitive_idx = 0; primitive_idx < primitive_count; ++primitive_idx)
+        {
+            uint64_t key = 0;
+            uint32_t index_count = 0;
+            uint32_t vertex_count = 0;
+            OptimisedPrimitive primitive{};
+            if (ReadValue(stream, key) == false || ReadValue(stream, index_count) == false ||
+                ReadValue(stream, vertex_count) == false || ReadValue(stream, primitive.stats) == false)
+            {
+                std::cout << "[!] Discarding corrupt mesh cache: " << m_cache_path << std::endl;
+                return false;
+            }
+
+            primitive.indices.resize(index_count);
+            primitive.vertices.resize(vertex_count);
+            stream.read(reinterpret_cast<char*>(primitive.indices.data()), index_count * sizeof(uint32_t));
+            stream.read(reinterpret_cast<char*>(primitive.vertices.data()), vertex_count * sizeof(Vertex));
+
+            uint32_t lod_count = 0;
+            ReadValue(stream, lod_count);
+            for (uint32_t lod_idx = 0; lod_idx < lod_count && stream.good(); ++lod_idx)
+            {
+                PrimitiveLod& lod = primitive.lods.emplace_back();
+                uint32_t lod_index_count = 0;
+                ReadValue(stream, lod_index_count);
+                ReadValue(stream, lod.error);
+                lod.indices.resize(stream.good() ? lod_index_count : 0);
+                stream.read(
+                    reinterpret_cast<char*>(lod.indices.data()), lod.indices.size() * sizeof(uint32_t)
+                );
+            }
+
+            if (stream.good() == false)
+            {
+                std::cout << "[!] Discarding corrupt mesh cache: " << m_cache_path << std::endl;
+                return false;
+            }
+
+            // an entry indexing past its vertices would read out of bounds when drawn, the primitive is
+            // optimised again instead and the cache rewritten.
+            const bool lods_valid = std::all_of(
+                primitive.lods.begin(),
+                primitive.lods.end(),
+                [&primitive](const PrimitiveLod& lod)
+                {
+                    return IndicesInRange(lod.indices, primitive.vertices.size());
+                }
+            );
+            if (IndicesInRange(primitive.indices, primitive.vertices.size()) == false || lods_valid == false)
+            {
+                discarded_primitives++;
+                continue;
+            }
+
+            loaded.emplace(key, std::move(primitive));
+        }
+
+        if (discarded_primitives > 0)
+        {
+            std::cout << "[!] Discarding " << discarded_primitives << " invalid primitives from mesh cache: "
+                      << m_cache_path << std::endl;
+        }
+
+        m_primitives = std::move(loaded);
+        m_dirty = discarded_primitives > 0;
+        return true;
+    }
+
+    bool MeshOptimisationCache::Save()
+    {
+        if (m_dirty == false)
+        {
+            return true;
+        }
+
+        std::ofstream stream{ m_cache_path, std::ios::binary | std::ios::trunc };
+        if (stream.is_open() == false)
+        {
+            std::cout << "[!] Failed to write mesh cache: " << m_cache_path << std::endl;
+            return false;
+        }
+
+        WriteValue(stream, cache_file_magic);
+        WriteValue(stream, cache_file_version);
+        WriteValue(stream, static_cast<uint32_t>(m_primitives.size()));
+        for (const auto& [key, primitive] : m_primitives)
+        {
+            WriteValue(stream, key);
+            WriteValue(stream, static_cast<uint32_t>(primitive.indices.size()));
+            WriteValue(stream, static_cast<uint32_t>(primitive.vertices.size()));
+            WriteValue(stream, primitive.stats);
+            stream.write(
+                reinterpret_cast<const char*>(primitive.indices.data()),
+                primitive.indices.size() * sizeof(uint32_t)
+            );
+            stream.write(
+                reinterpret_cast<const char*>(primitive.vertices.data()),
+                primitive.vertices.size() * sizeof(Vertex)
+            );
+
+            WriteValue(stream, static_cast<uint32_t>(primitive.lods.size()));
+            for (const PrimitiveLod& lod : primitive.lods)
+            {
+                WriteValue(stream, static_cast<uint32_t>(lod.indices.size()));
+                WriteValue(stream, lod.error);
+                stream.write(
+                    reinterpret_cast<const char*>(lod.indices.data()), lod.indices.size() * sizeof(uint32_t)
+                );
+            }
+        }
+
+        m_dirty = false;
+        return stream.good();
+    }
+
+    const OptimisedPrimitive* MeshOptimisationCache::Find(
+        uint64_t key, size_t source_index_count, size_t source_vertex_count
+    ) const
+    {
+        auto it = m_primitives.find(key);
+        if (it == m_primitives.end())
+        {
+            return nullptr;
+        }
+
+        // optimising keeps every triangle and can only merge or drop vertices, anything else was cached for
+        // a different primitive with the same hash.
+        const OptimisedPrimitive& primitive = it->second;
+        if (primitive.indices.size() != source_index_count || primitive.vertices.size() > source_vertex_count)
+        {
+            return nullptr;
+        }
+
+        return &primitive;
+    }
+
+    void MeshOptimisationCache::Store(uint64_t key, OptimisedPrimitive primitive)
+    {
+        m_primitives.insert_or_assign(key, std::move(primitive));
+        m_dirty = true;
+    }
+} // namespace Renderer::Utils
@@ -0,0 +1,381 @@
+#include "Renderer/Utility/MeshSimplifier.h"
+#include "Renderer/VkTypes.h"
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+    /// Symmetric 4x4 matrix summing the squared distances to a set of planes, weighted by triangle area.
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+        double weight = 0.0;
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a00 += other.a00;
+            a01 += other.a01;
+            a02 += other.a02;
+            a03 += other.a03;
+            a11 += other.a11;
+            a12 += other.a12;
+            a13 += other.a13;
+            a22 += other.a22;
+            a23 += other.a23;
+            a33 += other.a33;
+            weight += other.weight;
+            return *this;
+        }
+
+        Quadric operator+(const Quadric& other) const
+        {
+            Quadric result = *this;
+            result += other;
+            return result;
+        }
+
+        /// Weighted average squared distance of the point to the planes.
+        double Error(const glm::vec3& point) const
+        {
+            const double x = point.x;
+            const double y = point.y;
+            const double z = point.z;
+            const double error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+                                 a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y + a22 * z * z +
+                                 2.0 * a23 * z + a33;
+
+            return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+        }
+    };
+
+    Quadric TriangleQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+    {
+        const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(cross);
+        if (length <= 0.0)
+        {
+            return Quadric{};
+        }
+
+        // plane: n.p + d = 0
+        const double nx = cross.x / length;
+        const double ny = cross.y / length;
+        const double nz = cross.z / length;
+        const double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+        const double area = length * 0.5;
+
+        Quadric quadric{};
+        quadric.a00 = area * nx * nx;
+        quadric.a01 = area * nx * ny;
+        quadric.a02 = area * nx * nz;
+        quadric.a03 = area * nx * d;
+        quadric.a11 = area * ny * ny;
+        quadric.a12 = area * ny * nz;
+        quadric.a13 = area * ny * d;
+        quadric.a22 = area * nz * nz;
+        quadric.a23 = area * nz * d;
+        quadric.a33 = area * d * d;
+        quadric.weight = area;
+        return quadric;
+    }
+
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3& position) const
+        {
+            uint32_t bits[3];
+            std::memcpy(bits, &position, sizeof(bits));
+            return size_t(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual
+    {
+        bool operator()(const glm::vec3& lhs, const glm::vec3& rhs) const
+        {
+            return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+        }
+    };
+
+    struct EdgeCollapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    /// Vertices that can't move without tearing the mesh: the ones on open borders and the ones sharing their
+    /// position with another vertex (uv or normal seams).
+    std::vector<bool> FindLockedVertices(
+        std::span<const uint32_t> indices, std::span<const Renderer::Vertex> vertices
+    )
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> position_lookup{};
+        std::vector<uint32_t> position_ids(vertices.size());
+        std::vector<uint32_t> wedge_counts{};
+        for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            const uint32_t new_id = static_cast<uint32_t>(wedge_counts.size());
+            auto [it, inserted] = position_lookup.try_emplace(vertices[vertex].position, new_id);
+            if (inserted)
+            {
+                wedge_counts.emplace_back(0);
+            }
+            position_ids[vertex] = it->second;
+            ++wedge_counts[it->second];
+        }
+
+        // an edge is on a border if no triangle uses it in the opposite direction
+        const auto edge_key = [](uint32_t from, uint32_t to)
+        {
+            return (uint64_t(from) << 32) | uint64_t(to);
+        };
+        std::unordered_set<uint64_t> directed_edges{};
+        directed_edges.reserve(indices.size());
+        for (size_t corner = 0; corner < indices.size(); ++corner)
+        {
+            const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+            directed_edges.insert(edge_key(position_ids[indices[corner]], position_ids[indices[next]]));
+        }
+
+        std::vector<bool> locked_positions(wedge_counts.size(), false);
+        for (size_t corner = 0; corner < indices.size(); ++corner)
+        {
+            const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+            const uint32_t from = position_ids[indices[corner]];
+            const uint32_t to = position_ids[indices[next]];
+            if (directed_edges.contains(edge_key(to, from)) == false)
+            {
+                locked_positions[from] = true;
+                locked_positions[to] = true;
+            }
+        }
+
+        std::vector<bool> locked(vertices.size(), false);
+        for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            const uint32_t position_id = position_ids[vertex];
+            locked[vertex] = locked_positions[position_id] || wedge_counts[position_id] > 1;
+        }
+
+        return locked;
+    }
+
+    /// Moving a vertex must not turn any of its triangles upside down.
+    bool CollapseFlipsTriangle(
+        std::span<const uint32_t> indices,
+        std::span<const uint32_t> vertex_triangles,
+        std::span<const Renderer::Vertex> vertices,
+        uint32_t from,
+        uint32_t to
+    )
+    {
+        const glm::vec3& target = vertices[to].position;
+        for (uint32_t triangle : vertex_triangles)
+        {
+            const uint32_t* corners = &indices[triangle * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+            {
+                continue; // this one gets removed by the collapse
+            }
+
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                before[corner] = vertices[corners[corner]].position;
+                after[corner] = corners[corner] == from ? target : before[corner];
+            }
+
+            const glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normal_before, normal_after) <= 0.0f)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+} // namespace
+
+namespace Renderer::Utils
+{
+    std::vector<uint32_t> SimplifyMesh(
+        std::span<const uint32_t> indices,
+        std::span<const Vertex> vertices,
+        size_t target_index_count,
+        float max_error,
+        float& out_error
+    )
+    {
+        std::vector<uint32_t> result(indices.begin(), indices.end());
+        out_error = 0.0f;
+        if (result.size() <= target_index_count || vertices.empty())
+        {
+            return result;
+        }
+
+        const std::vector<bool> locked = FindLockedVertices(indices, vertices);
+
+        std::vector<Quadric> quadrics(vertices.size());
+        for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+        {
+            const uint32_t* corners = &indices[triangle * 3];
+            const Quadric quadric = TriangleQuadric(
+                vertices[corners[0]].position, vertices[corners[1]].position, vertices[corners[2]].position
+            );
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                quadrics[corners[corner]] += quadric;
+            }
+        }
+
+        const double max_error_squared = double(max_error) * double(max_error);
+        double result_error_squared = 0.0;
+
+        std::vector<uint32_t> adjacency_offsets(vertices.size() + 1);
+        std::vector<uint32_t> adjacency{};
+        std::vector<EdgeCollapse> collapses{};
+        std::vector<bool> touched(vertices.size());
+
+        // Collapse the cheapest independent edges in passes, the adjacency is rebuilt between passes.
+        while (result.size() > target_index_count)
+        {
+            const size_t triangle_count = result.size() / 3;
+
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (uint32_t idx : result)
+            {
+                ++adjacency_offsets[idx + 1];
+            }
+            for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+            {
+                adjacency_offsets[vertex + 1] += adjacency_offsets[vertex];
+            }
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+                {
+                    for (size_t corner = 0; corner < 3; ++corner)
+                    {
+                        const uint32_t vertex = result[triangle * 3 + corner];
+                        adjacency[fill_offsets[vertex]++] = static_cast<uint32_t>(triangle);
+                    }
+                }
+            }
+
+            collapses.clear();
+            for (size_t corner = 0; corner < result.size(); ++corner)
+            {
+                const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+                const uint32_t v0 = result[corner];
+                const uint32_t v1 = result[next];
+
+                const Quadric edge_quadric = quadrics[v0] + quadrics[v1];
+
+                if (locked[v0] == false)
+                {
+                    collapses.push_back({ v0, v1, edge_quadric.Error(vertices[v1].position) });
+                }
+                if (locked[v1] == false)
+                {
+                    collapses.push_back({ v1, v0, edge_quadric.Error(vertices[v0].position) });
+                }
+            }
+
+            std::sort(
+                collapses.begin(),
+                collapses.end(),
+                [](const EdgeCollapse& lhs, const EdgeCollapse& rhs)
+                {
+                    return lhs.error < rhs.error;
+                }
+            );
+
+            // every collapse removes around two triangles
+            const size_t triangles_to_remove = (result.size() - target_index_count) / 3;
+            size_t removed_triangles = 0;
+            bool collapsed_any = false;
+            std::fill(touched.begin(), touched.end(), false);
+
+            for (const EdgeCollapse& collapse : collapses)
+            {
+                if (removed_triangles >= triangles_to_remove || collapse.error > max_error_squared)
+                {
+                    break;
+                }
+
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                const std::span<const uint32_t> vertex_triangles{
+                    adjacency.data() + adjacency_offsets[collapse.from],
+                    adjacency.data() + adjacency_offsets[collapse.from + 1]
+                };
+                if (CollapseFlipsTriangle(result, vertex_triangles, vertices, collapse.from, collapse.to))
+                {
+                    continue;
+                }
+
+                for (uint32_t triangle : vertex_triangles)
+                {
+                    uint32_t* corners = &result[triangle * 3];
+                    bool degenerate = false;
+                    for (size_t corner = 0; corner < 3; ++corner)
+                    {
+                        degenerate |= corners[corner] == collapse.to;
+                        touched[corners[corner]] = true;
+                        if (corners[corner] == collapse.from)
+                        {
+                            corners[corner] = collapse.to;
+                        }
+                    }
+
+                    removed_triangles += degenerate ? 1 : 0;
+                }
+
+                quadrics[collapse.to] += quadrics[collapse.from];
+                result_error_squared = std::max(result_error_squared, collapse.error);
+                collapsed_any = true;
+            }
+
+            // drop the triangles that collapsed into lines
+            size_t write = 0;
+            for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+            {
+                const uint32_t a = result[triangle * 3 + 0];
+                const uint32_t b = result[triangle * 3 + 1];
+                const uint32_t c = result[triangle * 3 + 2];
+                if (a != b && b != c && a != c)
+                {
+                    result[write++] = a;
+                    result[write++] = b;
+                    result[write++] = c;
+                }
+            }
+            result.resize(write);
+
+            if (collapsed_any == false)
+            {
+                break;
+            }
+        }
+
+        out_error = static_cast<float>(std::sqrt(result_error_squared));
+        return result;
+    }
+} // namespace Renderer::Utils
@@ -0,0 +1,160 @@
+#include "Renderer/Utility/Meshlets.h"
+#include "Renderer/VkTypes.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // below this the triangles of a meshlet face too many directions for the cone to ever cull it.
+    constexpr float min_cone_spread = 0.1f;
+
+    /// Bounding sphere and normal cone of the triangles in [first_triangle, last_triangle).
+    Renderer::GPUMeshlet ComputeMeshletBounds(
+        std::span<const uint32_t> indices,
+        std::span<const Renderer::Vertex> vertices,
+        size_t first_triangle,
+        size_t last_triangle
+    )
+    {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+        for (size_t corner = first_triangle * 3; corner < last_triangle * 3; ++corner)
+        {
+            min = glm::min(min, vertices[indices[corner]].position);
+            max = glm::max(max, vertices[indices[corner]].position);
+        }
+
+        const glm::vec3 centre = (min + max) * 0.5f;
+        float radius = 0.0f;
+        for (size_t corner = first_triangle * 3; corner < last_triangle * 3; ++corner)
+        {
+            radius = std::max(radius, glm::distance(centre, vertices[indices[corner]].position));
+        }
+
+        // the cone axis is the average of the triangle normals, the cutoff the widest angle from it.
+        glm::vec3 normal_sum = glm::vec3(0.0f);
+        for (size_t triangle = first_triangle; triangle < last_triangle; ++triangle)
+        {
+            const glm::vec3& p0 = vertices[indices[triangle * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].position;
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                normal_sum += normal / length;
+            }
+        }
+
+        Renderer::GPUMeshlet meshlet{};
+        meshlet.bounding_sphere = glm::vec4(centre, radius);
+        meshlet.cone_axis_cutoff = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        const float axis_length = glm::length(normal_sum);
+        if (axis_length <= 0.0f)
+        {
+            return meshlet;
+        }
+
+        const glm::vec3 axis = normal_sum / axis_length;
+        float min_dot = 1.0f;
+        for (size_t triangle = first_triangle; triangle < last_triangle; ++triangle)
+        {
+            const glm::vec3& p0 = vertices[indices[triangle * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].position;
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                min_dot = std::min(min_dot, glm::dot(axis, normal / length));
+            }
+        }
+
+        if (min_dot > min_cone_spread)
+        {
+            // sin of the cone half angle, the culling test compares it against the view direction.
+            meshlet.cone_axis_cutoff = glm::vec4(axis, std::sqrt(1.0f - min_dot * min_dot));
+        }
+
+        return meshlet;
+    }
+} // namespace
+
+namespace Renderer::Utils
+{
+    std::vector<GPUMeshlet> BuildMeshlets(
+        std::span<const uint32_t> indices, std::span<const Vertex> vertices, uint32_t first_index
+    )
+    {
+        std::vector<GPUMeshlet> meshlets{};
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+        {
+            return meshlets;
+        }
+
+        // index of the meshlet that last used each vertex, so we can count the unique vertices of a meshlet.
+        std::vector<uint32_t> vertex_meshlet(vertices.size(), std::numeric_limits<uint32_t>::max());
+        uint32_t meshlet_vertex_count = 0;
+        size_t meshlet_first_triangle = 0;
+
+        const auto finish_meshlet = [&](size_t last_triangle)
+        {
+            GPUMeshlet meshlet =
+                ComputeMeshletBounds(indices, vertices, meshlet_first_triangle, last_triangle);
+            meshlet.first_index = first_index + static_cast<uint32_t>(meshlet_first_triangle * 3);
+            meshlet.index_count = static_cast<uint32_t>((last_triangle - meshlet_first_triangle) * 3);
+            meshlets.emplace_back(meshlet);
+
+            meshlet_first_triangle = last_triangle;
+            meshlet_vertex_count = 0;
+        };
+
+        const auto count_new_vertices = [&](const uint32_t* corners)
+        {
+            const uint32_t current_meshlet = static_cast<uint32_t>(meshlets.size());
+            uint32_t new_vertices = 0;
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                const bool repeated_in_triangle = (corner > 0 && corners[corner] == corners[0]) ||
+                                                  (corner > 1 && corners[corner] == corners[1]);
+                if (vertex_meshlet[corners[corner]] != current_meshlet && repeated_in_triangle == false)
+                {
+                    ++new_vertices;
+                }
+            }
+            return new_vertices;
+        };
+
+        for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+        {
+            const uint32_t* corners = &indices[triangle * 3];
+
+            uint32_t new_vertices = count_new_vertices(corners);
+            if (triangle - meshlet_first_triangle == MESHLET_MAX_TRIANGLES ||
+                meshlet_vertex_count + new_vertices > MESHLET_MAX_VERTICES)
+            {
+                finish_meshlet(triangle);
+                new_vertices = count_new_vertices(corners);
+            }
+
+            const uint32_t current_meshlet = static_cast<uint32_t>(meshlets.size());
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                vertex_meshlet[corners[corner]] = current_meshlet;
+            }
+            meshlet_vertex_count += new_vertices;
+        }
+
+        finish_meshlet(triangle_count);
+
+        return meshlets;
+    }
+} // namespace Renderer::Utils
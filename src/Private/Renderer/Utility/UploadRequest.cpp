@@ -31,21 +31,29 @@ namespace Renderer::Utils
     UploadExecutionResult MeshUploadRequest::ExecuteUpload(VulkanEngine& engine, VkCommandBuffer cmd)
     {
         VkBufferCopy vertex_copy{};
-        vertex_copy.dstOffset = 0;
+        // pooled meshes are copied into their ranges of the geometry pool buffers.
+        vertex_copy.dstOffset = m_target_mesh.vertex_range.offset;
         vertex_copy.srcOffset = 0;
         vertex_copy.size = m_vertex_buffer_size;
 
         VkBufferCopy index_copy{};
-        index_copy.dstOffset = 0;
+        index_copy.dstOffset = m_target_mesh.index_range.offset;
         index_copy.srcOffset = m_vertex_buffer_size;
         index_copy.size = m_index_buffer_size;
 
-        engine.DeviceDispatchTable().cmdCopyBuffer(
-            cmd, m_staging_buffer->buffer, m_target_mesh.vertex_buffer->buffer, 1, &vertex_copy
-        );
-        engine.DeviceDispatchTable().cmdCopyBuffer(
-            cmd, m_staging_buffer->buffer, m_target_mesh.index_buffer->buffer, 1, &index_copy
-        );
+        // copies can't be empty, meshes without indices only copy their vertices.
+        if (vertex_copy.size > 0)
+        {
+            engine.DeviceDispatchTable().cmdCopyBuffer(
+                cmd, m_staging_buffer->buffer, m_target_mesh.vertex_buffer->buffer, 1, &vertex_copy
+            );
+        }
+        if (index_copy.size > 0)
+        {
+            engine.DeviceDispatchTable().cmdCopyBuffer(
+                cmd, m_staging_buffer->buffer, m_target_mesh.index_buffer->buffer, 1, &index_copy
+            );
+        }
 
         return UploadExecutionResult::Success;
     }
@@ -140,13 +148,23 @@ namespace Renderer::Utils
 
         engine.DeviceDispatchTable().cmdCopyBufferToImage2(cmd, &copy_image_info);
 
+        // the rest of the mips are downsampled from the uploaded one.
+        VkImageLayout written_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        if (m_target_image->mip_levels > 1)
+        {
+            Utils::GenerateMipmaps(
+                &engine.DeviceDispatchTable(),
+                cmd,
+                m_target_image->image,
+                VkExtent2D{ m_image_extent.width, m_image_extent.height },
+                m_target_image->mip_levels
+            );
+            written_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        }
+
         // transition into the final layout. E.g. SHADER_READ_ONLY_OPTIMAL for shader binding textures
         Utils::TransitionImage(
-            &engine.DeviceDispatchTable(),
-            cmd,
-            m_target_image->image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_target_layout
+            &engine.DeviceDispatchTable(), cmd, m_target_image->image, written_layout, m_target_layout
         );
 
         return UploadExecutionResult::Success;
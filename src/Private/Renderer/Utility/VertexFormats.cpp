@@ -0,0 +1,206 @@
+#include "Renderer/Utility/VertexFormats.h"
+#include "Renderer/VkTypes.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/packing.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vector_relational.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // halfs have 11 bits of precision, so values below 1 are at most 2^-11 apart and round to within half a
+    // texel of a 2k texture. The spacing doubles with every power of two above, tiling uvs stay standard.
+    constexpr float max_compact_uv = 1.0f;
+
+    glm::vec2 SignNotZero(glm::vec2 v)
+    {
+        return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    uint32_t PackNormal(const glm::vec3& normal)
+    {
+        return glm::packSnorm2x16(Renderer::Utils::OctahedralEncode(normal));
+    }
+
+    uint32_t PackUV(const Renderer::Vertex& vertex)
+    {
+        return glm::packHalf2x16(glm::vec2(vertex.uv_x, vertex.uv_y));
+    }
+
+    uint16_t QuantisePosition(float value, float min, float extent)
+    {
+        if (extent <= 0.0f)
+        {
+            return 0;
+        }
+
+        float normalised = glm::clamp((value - min) / extent, 0.0f, 1.0f);
+        return static_cast<uint16_t>(std::lround(normalised * 65535.0f));
+    }
+} // namespace
+
+namespace Renderer::Utils
+{
+    MeshBounds ComputeMeshBounds(std::span<const Vertex> vertices)
+    {
+        if (vertices.empty())
+        {
+            return MeshBounds{};
+        }
+
+        MeshBounds bounds{ glm::vec3(std::numeric_limits<float>::max()),
+                           glm::vec3(std::numeric_limits<float>::lowest()) };
+        for (const Vertex& vertex : vertices)
+        {
+            bounds.min = glm::min(bounds.min, vertex.position);
+            bounds.max = glm::max(bounds.max, vertex.position);
+        }
+
+        return bounds;
+    }
+
+    VertexFormat SelectVertexFormat(
+        std::span<const Vertex> vertices, const MeshBounds& bounds, float position_tolerance
+    )
+    {
+        for (const Vertex& vertex : vertices)
+        {
+            // unorm8 colours can't store HDR vertex colours
+            if (glm::any(glm::lessThan(vertex.colour, glm::vec4(0.0f))) ||
+                glm::any(glm::greaterThan(vertex.colour, glm::vec4(1.0f))))
+            {
+                return VertexFormat::Standard;
+            }
+
+            if (std::abs(vertex.uv_x) > max_compact_uv || std::abs(vertex.uv_y) > max_compact_uv)
+            {
+                return VertexFormat::Standard;
+            }
+        }
+
+        // biggest distance between two quantised positions
+        const glm::vec3 extent = bounds.Extent();
+        const float quantisation_step = std::max({ extent.x, extent.y, extent.z }) / 65535.0f;
+        if (quantisation_step <= position_tolerance)
+        {
+            return VertexFormat::CompactQuantised;
+        }
+
+        return VertexFormat::Compact;
+    }
+
+    size_t VertexFormatStride(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VertexFormat::Compact:
+            return sizeof(CompactVertex);
+        case VertexFormat::CompactQuantised:
+            return sizeof(QuantisedVertex);
+        case VertexFormat::Standard:
+            break;
+        }
+
+        return sizeof(Vertex);
+    }
+
+    const char* VertexFormatName(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VertexFormat::Standard:
+            return "Standard";
+        case VertexFormat::Compact:
+            return "Compact";
+        case VertexFormat::CompactQuantised:
+            return "Compact Quantised";
+        }
+
+        return "Unknown";
+    }
+
+    std::vector<std::byte> PackVertices(
+        std::span<const Vertex> vertices, VertexFormat format, const MeshBounds& bounds
+    )
+    {
+        std::vector<std::byte> packed(vertices.size() * VertexFormatStride(format));
+
+        switch (format)
+        {
+        case VertexFormat::Standard:
+        {
+            std::memcpy(packed.data(), vertices.data(), packed.size());
+            break;
+        }
+        case VertexFormat::Compact:
+        {
+            CompactVertex* out = reinterpret_cast<CompactVertex*>(packed.data());
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                out[i].position = vertices[i].position;
+                out[i].normal = PackNormal(vertices[i].normal);
+                out[i].uv = PackUV(vertices[i]);
+                out[i].colour = glm::packUnorm4x8(vertices[i].colour);
+            }
+            break;
+        }
+        case VertexFormat::CompactQuantised:
+        {
+            const glm::vec3 extent = bounds.Extent();
+            QuantisedVertex* out = reinterpret_cast<QuantisedVertex*>(packed.data());
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                for (glm::length_t axis = 0; axis < 3; ++axis)
+                {
+                    out[i].position[axis] =
+                        QuantisePosition(vertices[i].position[axis], bounds.min[axis], extent[axis]);
+                }
+                out[i].padding = 0;
+                out[i].normal = PackNormal(vertices[i].normal);
+                out[i].uv = PackUV(vertices[i]);
+                out[i].colour = glm::packUnorm4x8(vertices[i].colour);
+            }
+            break;
+        }
+        }
+
+        return packed;
+    }
+
+    glm::vec2 OctahedralEncode(glm::vec3 normal)
+    {
+        const float l1_norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (l1_norm <= 0.0f)
+        {
+            return glm::vec2(0.0f); // meshes without normals, decodes to +Z
+        }
+
+        glm::vec2 projected = glm::vec2(normal.x, normal.y) / l1_norm;
+        if (normal.z < 0.0f)
+        {
+            // fold the lower hemisphere over the diagonals
+            projected = (1.0f - glm::abs(glm::vec2(projected.y, projected.x))) * SignNotZero(projected);
+        }
+
+        return projected;
+    }
+
+    glm::vec3 OctahedralDecode(glm::vec2 encoded)
+    {
+        glm::vec3 normal{ encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+        if (normal.z < 0.0f)
+        {
+            glm::vec2 folded = (1.0f - glm::abs(glm::vec2(normal.y, normal.x))) * SignNotZero(encoded);
+            normal.x = folded.x;
+            normal.y = folded.y;
+        }
+
+        return glm::normalize(normal);
+    }
+} // namespace Renderer::Utils
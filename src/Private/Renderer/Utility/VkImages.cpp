@@ -3,6 +3,8 @@
 #include <VkBootstrapDispatch.h>
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
+
 namespace Renderer::Utils
 {
     void TransitionImage(
@@ -44,6 +46,190 @@ namespace Renderer::Utils
         device_dispatch->cmdPipelineBarrier2(cmd, &depInfo);
     }
 
+    void TransitionImageMips(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkImage image,
+        uint32_t base_mip,
+        uint32_t mip_count,
+        VkImageLayout current_layout,
+        VkImageLayout target_layout
+    )
+    {
+        VkImageMemoryBarrier2 imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        imageBarrier.pNext = nullptr;
+
+        imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+        imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT;
+
+        imageBarrier.oldLayout = current_layout;
+        imageBarrier.newLayout = target_layout;
+
+        imageBarrier.subresourceRange = SubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
+        imageBarrier.subresourceRange.baseMipLevel = base_mip;
+        imageBarrier.subresourceRange.levelCount = mip_count;
+        imageBarrier.image = image;
+
+        VkDependencyInfo depInfo{};
+        depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        depInfo.pNext = nullptr;
+
+        depInfo.imageMemoryBarrierCount = 1;
+        depInfo.pImageMemoryBarriers = &imageBarrier;
+
+        device_dispatch->cmdPipelineBarrier2(cmd, &depInfo);
+    }
+
+    void TransferImageOwnership(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkImage image,
+        VkImageLayout current_layout,
+        VkImageLayout target_layout,
+        uint32_t src_queue_family,
+        uint32_t dst_queue_family,
+        VkPipelineStageFlags2 stage_mask,
+        VkAccessFlags2 access_mask,
+        bool release
+    )
+    {
+        VkImageMemoryBarrier2 imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        imageBarrier.pNext = nullptr;
+
+        // the masks of the other queue are ignored, they stay empty.
+        if (release)
+        {
+            imageBarrier.srcStageMask = stage_mask;
+            imageBarrier.srcAccessMask = access_mask;
+        }
+        else
+        {
+            imageBarrier.dstStageMask = stage_mask;
+            imageBarrier.dstAccessMask = access_mask;
+        }
+
+        imageBarrier.oldLayout = current_layout;
+        imageBarrier.newLayout = target_layout;
+        imageBarrier.srcQueueFamilyIndex = src_queue_family;
+        imageBarrier.dstQueueFamilyIndex = dst_queue_family;
+        imageBarrier.subresourceRange = SubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
+        imageBarrier.image = image;
+
+        VkDependencyInfo depInfo{};
+        depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        depInfo.pNext = nullptr;
+
+        depInfo.imageMemoryBarrierCount = 1;
+        depInfo.pImageMemoryBarriers = &imageBarrier;
+
+        device_dispatch->cmdPipelineBarrier2(cmd, &depInfo);
+    }
+
+    void GenerateMipmaps(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkImage image,
+        VkExtent2D extent,
+        uint32_t mip_count
+    )
+    {
+        for (uint32_t mip = 1; mip < mip_count; ++mip)
+        {
+            // the mip above is complete, read from it while this one is written.
+            TransitionImageMips(
+                device_dispatch,
+                cmd,
+                image,
+                mip - 1,
+                1,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+            );
+
+            const VkExtent2D source_size = MipExtent(extent, mip - 1);
+            const VkExtent2D dest_size = MipExtent(extent, mip);
+
+            VkImageBlit2 blit_region{};
+            blit_region.sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2;
+            blit_region.pNext = nullptr;
+
+            blit_region.srcOffsets[1].x = int32_t(source_size.width);
+            blit_region.srcOffsets[1].y = int32_t(source_size.height);
+            blit_region.srcOffsets[1].z = 1;
+            blit_region.dstOffsets[1].x = int32_t(dest_size.width);
+            blit_region.dstOffsets[1].y = int32_t(dest_size.height);
+            blit_region.dstOffsets[1].z = 1;
+
+            blit_region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit_region.srcSubresource.baseArrayLayer = 0;
+            blit_region.srcSubresource.mipLevel = mip - 1;
+            blit_region.srcSubresource.layerCount = 1;
+
+            blit_region.dstSubresource = blit_region.srcSubresource;
+            blit_region.dstSubresource.mipLevel = mip;
+
+            VkBlitImageInfo2 blit_info{};
+            blit_info.sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2;
+            blit_info.pNext = nullptr;
+
+            blit_info.srcImage = image;
+            blit_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            blit_info.dstImage = image;
+            blit_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            blit_info.filter = VK_FILTER_LINEAR;
+            blit_info.regionCount = 1;
+            blit_info.pRegions = &blit_region;
+
+            device_dispatch->cmdBlitImage2(cmd, &blit_info);
+        }
+
+        TransitionImageMips(
+            device_dispatch,
+            cmd,
+            image,
+            mip_count - 1,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+        );
+    }
+
+    VkExtent2D MipExtent(VkExtent2D extent, uint32_t mip)
+    {
+        return VkExtent2D{ std::max(extent.width >> mip, 1u), std::max(extent.height >> mip, 1u) };
+    }
+
+    void GlobalMemoryBarrier(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkPipelineStageFlags2 src_stage,
+        VkAccessFlags2 src_access,
+        VkPipelineStageFlags2 dst_stage,
+        VkAccessFlags2 dst_access
+    )
+    {
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.pNext = nullptr;
+        barrier.srcStageMask = src_stage;
+        barrier.srcAccessMask = src_access;
+        barrier.dstStageMask = dst_stage;
+        barrier.dstAccessMask = dst_access;
+
+        VkDependencyInfo depInfo{};
+        depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        depInfo.pNext = nullptr;
+
+        depInfo.memoryBarrierCount = 1;
+        depInfo.pMemoryBarriers = &barrier;
+
+        device_dispatch->cmdPipelineBarrier2(cmd, &depInfo);
+    }
+
     void CopyImageToImage(
         vkb::DispatchTable* device_dispatch,
         VkCommandBuffer cmd,
@@ -170,7 +170,7 @@ namespace Renderer::Utils
         info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
         info.pNext = nullptr;
         info.layerCount = 1;
-        info.colorAttachmentCount = 1;
+        info.colorAttachmentCount = color_attachment_info != nullptr ? 1 : 0;
         info.pColorAttachments = color_attachment_info;
         info.pDepthAttachment = depth_attachment_info;
         info.renderArea = { { 0, 0 }, { draw_extent.width, draw_extent.height } };
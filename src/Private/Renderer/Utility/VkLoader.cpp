@@ -1,5 +1,7 @@
 #include "Renderer/Utility/VkLoader.h"
 #include "Renderer/Material.h"
+#include "Renderer/Utility/MeshOptimiser.h"
+#include "Renderer/Utility/Meshlets.h"
 #include "Renderer/Utility/VkInitialisers.h"
 #include "Renderer/VkEngine.h"
 #include "Renderer/VkTypes.h"
@@ -8,6 +10,7 @@
 #include "fastgltf/types.hpp"
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/vector_float4.hpp>
+#include <glm/ext/vector_uint4.hpp>
 #include <glm/gtx/compatibility.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <stb_image.h>
@@ -17,9 +20,11 @@
 #include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <unordered_set>
 #include <utility>
 #include <variant>
@@ -89,13 +94,9 @@ namespace
         const fastgltf::Primitive& primitive,
         std::vector<uint32_t>& indices,
         std::vector<Renderer::Vertex>& vertices,
-        Renderer::GeoSurface& surface,
         const char*& out_error_mesage
     )
     {
-        surface.first_index = static_cast<uint32_t>(indices.size());
-        surface.index_count = static_cast<uint32_t>(asset.accessors[primitive.indicesAccessor.value()].count);
-
         const size_t initial_vertex = vertices.size();
 
         // load indices
@@ -108,7 +109,7 @@ namespace
                 index_accessor,
                 [&](uint32_t idx)
                 {
-                    indices.emplace_back(idx);
+                    indices.emplace_back(static_cast<uint32_t>(initial_vertex + idx));
                 }
             );
         }
@@ -195,23 +196,166 @@ namespace
         return true;
     }
 
-    std::optional<Renderer::ImageHandle> LoadImageFromFastGltfArray(
-        Renderer::VulkanEngine& engine, const fastgltf::sources::Array& arr, size_t offset, const char* name
+    /// State shared between all the meshes loaded from a single glTF file.
+    struct MeshImportContext
+    {
+        Renderer::MeshImportSettings settings{};
+        std::optional<Renderer::Utils::MeshOptimisationCache> cache{};
+        Renderer::Utils::MeshOptimisationStats total_stats{};
+        size_t processed_primitives = 0;
+        size_t cached_primitives = 0;
+
+        MeshImportContext(
+            const std::filesystem::path& file_path, const Renderer::MeshImportSettings& import_settings
+        ) :
+            settings(import_settings)
+        {
+            if ((settings.optimise || settings.generate_lods) && settings.use_cache)
+            {
+                std::filesystem::path cache_path = file_path;
+                cache_path += ".meshcache";
+                cache.emplace(cache_path);
+                cache->Load();
+            }
+        }
+
+        void Finish()
+        {
+            if (cache.has_value())
+            {
+                cache->Save();
+            }
+
+            if (settings.optimise == false && settings.generate_lods == false)
+            {
+                return;
+            }
+
+            std::cout << std::fixed << std::setprecision(3) << "[*] Mesh import ("
+                      << processed_primitives << " processed, " << cached_primitives
+                      << " from cache): ACMR " << total_stats.before.Acmr() << " -> "
+                      << total_stats.after.Acmr() << ", ATVR " << total_stats.before.Atvr() << " -> "
+                      << total_stats.after.Atvr() << std::defaultfloat << std::endl;
+        }
+    };
+
+    /// Loads a primitive and appends it to the mesh indices and vertices, optimising it and generating LODs
+    /// first if enabled. The LODs are appended after the full detail indices, the meshlets of the full detail
+    /// indices are appended to meshlets.
+    bool LoadMeshPrimitive(
+        MeshImportContext& context,
+        const fastgltf::Asset& asset,
+        const fastgltf::Primitive& primitive,
+        std::vector<uint32_t>& indices,
+        std::vector<Renderer::Vertex>& vertices,
+        std::vector<Renderer::GPUMeshlet>& meshlets,
+        Renderer::GeoSurface& surface,
+        Renderer::Utils::MeshOptimisationStats& mesh_stats,
+        const char*& out_error_mesage
     )
     {
-        int width, height, channels;
-        constexpr int desired_channels = 4;
-        unsigned char* image_data = stbi_load_from_memory(
-            reinterpret_cast<const unsigned char*>(arr.bytes.data() + offset),
-            (int)arr.bytes.size(),
-            &width,
-            &height,
-            &channels,
-            desired_channels
-        );
-        if (image_data == nullptr)
+        // primitives are loaded separately so they can be optimised (and cached) on their own.
+        Renderer::Utils::OptimisedPrimitive loaded{};
+        bool result =
+            LoadPrimitiveIndicesVertices(asset, primitive, loaded.indices, loaded.vertices, out_error_mesage);
+        if (result == false)
         {
-            return std::nullopt;
+            return false;
+        }
+
+        if (context.settings.optimise || context.settings.generate_lods)
+        {
+            const uint64_t variant =
+                (context.settings.optimise ? 1u : 0u) | (context.settings.generate_lods ? 2u : 0u);
+            const uint64_t key = Renderer::Utils::HashPrimitive(loaded.indices, loaded.vertices, variant);
+            const Renderer::Utils::OptimisedPrimitive* cached =
+                context.cache.has_value()
+                    ? context.cache->Find(key, loaded.indices.size(), loaded.vertices.size())
+                    : nullptr;
+            if (cached != nullptr)
+            {
+                loaded = *cached;
+                context.cached_primitives++;
+            }
+            else
+            {
+                if (context.settings.optimise)
+                {
+                    loaded.stats = Renderer::Utils::OptimiseMesh(loaded.indices, loaded.vertices);
+                }
+                if (context.settings.generate_lods)
+                {
+                    Renderer::Utils::GenerateLods(loaded);
+                }
+
+                context.processed_primitives++;
+                if (context.cache.has_value())
+                {
+                    context.cache->Store(key, loaded);
+                }
+            }
+
+            mesh_stats += loaded.stats;
+            context.total_stats += loaded.stats;
+        }
+
+        const uint32_t base_vertex = static_cast<uint32_t>(vertices.size());
+        surface.first_index = static_cast<uint32_t>(indices.size());
+        surface.index_count = static_cast<uint32_t>(loaded.indices.size());
+
+        const auto append_indices = [&](const std::vector<uint32_t>& source)
+        {
+            indices.reserve(indices.size() + source.size());
+            for (uint32_t idx : source)
+            {
+                indices.emplace_back(base_vertex + idx);
+            }
+        };
+
+        append_indices(loaded.indices);
+        if (context.settings.build_meshlets)
+        {
+            std::vector<Renderer::GPUMeshlet> surface_meshlets =
+                Renderer::Utils::BuildMeshlets(loaded.indices, loaded.vertices, surface.first_index);
+            surface.first_meshlet = static_cast<uint32_t>(meshlets.size());
+            surface.meshlet_count = static_cast<uint32_t>(surface_meshlets.size());
+            meshlets.insert(meshlets.end(), surface_meshlets.begin(), surface_meshlets.end());
+        }
+
+        for (const Renderer::Utils::PrimitiveLod& lod : loaded.lods)
+        {
+            surface.lods.push_back({ static_cast<uint32_t>(indices.size()),
+                                     static_cast<uint32_t>(lod.indices.size()),
+                                     lod.error });
+            append_indices(lod.indices);
+        }
+        vertices.insert(vertices.end(), loaded.vertices.begin(), loaded.vertices.end());
+
+        return true;
+    }
+
+    // textures too large for device memory become virtual textures, sampled through the page table with the
+    // white image bound in their place. Takes ownership of the stbi image data.
+    Renderer::ImageHandle CreateGltfImage(
+        Renderer::VulkanEngine& engine,
+        unsigned char* image_data,
+        int width,
+        int height,
+        const char* name,
+        std::optional<glm::uvec4>& out_virtual_texture
+    )
+    {
+        VkExtent2D extent{ (uint32_t)width, (uint32_t)height };
+        if (Renderer::VirtualTexturing::WantsVirtual(extent))
+        {
+            out_virtual_texture = engine.VirtualTextures().Create(image_data, extent, name);
+            if (out_virtual_texture.has_value())
+            {
+                stbi_image_free(image_data);
+                return engine.WhiteImage();
+            }
+            std::cout << "[!] Virtual page table is full, loading " << name << " as a regular image."
+                      << std::endl;
         }
 
         VkExtent3D extents{ (uint32_t)width, (uint32_t)height, 1 };
@@ -222,7 +366,8 @@ namespace
             VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
             true,
-            name
+            name,
+            Renderer::AllocationClass::Texture
         );
 
         stbi_image_free(image_data);
@@ -230,8 +375,37 @@ namespace
         return loaded_image;
     }
 
+    std::optional<Renderer::ImageHandle> LoadImageFromFastGltfArray(
+        Renderer::VulkanEngine& engine,
+        const fastgltf::sources::Array& arr,
+        size_t offset,
+        const char* name,
+        std::optional<glm::uvec4>& out_virtual_texture
+    )
+    {
+        int width, height, channels;
+        constexpr int desired_channels = 4;
+        unsigned char* image_data = stbi_load_from_memory(
+            reinterpret_cast<const unsigned char*>(arr.bytes.data() + offset),
+            (int)arr.bytes.size(),
+            &width,
+            &height,
+            &channels,
+            desired_channels
+        );
+        if (image_data == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        return CreateGltfImage(engine, image_data, width, height, name, out_virtual_texture);
+    }
+
     std::optional<Renderer::ImageHandle> LoadGltfImage(
-        Renderer::VulkanEngine& engine, const fastgltf::Asset& asset, const fastgltf::Image& image
+        Renderer::VulkanEngine& engine,
+        const fastgltf::Asset& asset,
+        const fastgltf::Image& image,
+        std::optional<glm::uvec4>& out_virtual_texture
     )
     {
         std::optional<Renderer::ImageHandle> out_handle = std::nullopt;
@@ -240,14 +414,23 @@ namespace
             fastgltf::visitor{
                 [&](const fastgltf::sources::Array& arr)
                 {
-                    out_handle = LoadImageFromFastGltfArray(engine, arr, 0, image.name.data());
+                    out_handle =
+                        LoadImageFromFastGltfArray(engine, arr, 0, image.name.data(), out_virtual_texture);
                 },
                 [&](const fastgltf::sources::URI& uri)
                 {
-                    if (uri.uri.isLocalPath())
+                    if (!uri.uri.isLocalPath())
                     {
-                        out_handle =
-                            Renderer::Utils::LoadImageFromPath(engine, uri.uri.c_str(), image.name.data());
+                        return;
+                    }
+
+                    int width, height, channels;
+                    unsigned char* image_data = stbi_load(uri.uri.c_str(), &width, &height, &channels, 4);
+                    if (image_data != nullptr)
+                    {
+                        out_handle = CreateGltfImage(
+                            engine, image_data, width, height, image.name.data(), out_virtual_texture
+                        );
                     }
                 },
                 [&](const fastgltf::sources::BufferView& view)
@@ -263,7 +446,11 @@ namespace
                                            [&](const fastgltf::sources::Array& arr)
                                            {
                                                out_handle = LoadImageFromFastGltfArray(
-                                                   engine, arr, buffer_view.byteOffset, image.name.data()
+                                                   engine,
+                                                   arr,
+                                                   buffer_view.byteOffset,
+                                                   image.name.data(),
+                                                   out_virtual_texture
                                                );
                                            } },
                         buffer.data
@@ -282,10 +469,10 @@ namespace
 
 namespace Renderer
 {
-    void DestroyMeshAsset(VulkanEngine&, const MeshAsset&)
+    void DestroyMeshAsset(VulkanEngine& engine, const MeshAsset& asset)
     {
-        // there's actually nothing to delete for a mesh asset at the moment. The only things it contains that
-        // needs deletion are the buffers and those are already reference counted.
+        // the buffers are reference counted, only the ranges of the geometry pool need giving back.
+        engine.Geometry().Free(engine, asset.buffers);
     }
 } // namespace Renderer
 
@@ -318,7 +505,7 @@ namespace Renderer::Utils
     }
 
     std::optional<std::vector<MeshHandle>> LoadGltfMeshes(
-        VulkanEngine* engine, std::filesystem::path file_path
+        VulkanEngine* engine, std::filesystem::path file_path, const MeshImportSettings& settings
     )
     {
         std::optional<fastgltf::Asset> opt_asset = FastGltfLoadAsset(file_path);
@@ -331,13 +518,17 @@ namespace Renderer::Utils
         std::vector<MeshHandle> mesh_assets;
         mesh_assets.reserve(asset.meshes.size());
 
+        MeshImportContext import_context{ file_path, settings };
+
         // we re-use the same vectors to avoid re-allocating them for each mesh
         std::vector<uint32_t> indices;
         std::vector<Vertex> vertices;
+        std::vector<GPUMeshlet> meshlets;
         for (const fastgltf::Mesh& mesh : asset.meshes)
         {
             indices.clear();
             vertices.clear();
+            meshlets.clear();
 
             MeshAsset mesh_asset;
             mesh_asset.name = mesh.name;
@@ -347,8 +538,17 @@ namespace Renderer::Utils
                 GeoSurface surface;
                 // any errors will be written here.
                 const char* error_message = "";
-                bool result =
-                    LoadPrimitiveIndicesVertices(asset, primitive, indices, vertices, surface, error_message);
+                bool result = LoadMeshPrimitive(
+                    import_context,
+                    asset,
+                    primitive,
+                    indices,
+                    vertices,
+                    meshlets,
+                    surface,
+                    mesh_asset.optimisation_stats,
+                    error_message
+                );
                 if (result == false)
                 {
                     std::cout << error_message << "\nSkipping mesh: " << mesh_asset.name << std::endl;
@@ -359,13 +559,17 @@ namespace Renderer::Utils
             }
 
             mesh_asset.buffers = engine->UploadMesh(indices, vertices);
+            engine->UploadMeshlets(mesh_asset.buffers, meshlets);
             mesh_assets.emplace_back(engine->RegisterMeshAsset(std::move(mesh_asset), mesh.name));
         }
+        import_context.Finish();
 
         return mesh_assets;
     }
 
-    std::optional<GLTFScene> LoadGltfScene(VulkanEngine& engine, std::filesystem::path file_path)
+    std::optional<GLTFScene> LoadGltfScene(
+        VulkanEngine& engine, std::filesystem::path file_path, const MeshImportSettings& settings
+    )
     {
         // we want to load the textures in as well, so we can create the materials with correct textures
         const std::optional<const fastgltf::Asset>& opt_asset = FastGltfLoadAsset(
@@ -387,14 +591,17 @@ namespace Renderer::Utils
         std::chrono::high_resolution_clock clock{};
         auto before = clock.now();
         out_images.resize(asset.textures.size());
+        // page table parameters of the textures that were loaded as virtual textures.
+        std::vector<std::optional<glm::uvec4>> virtual_textures(asset.textures.size());
         tbb::parallel_for(
             size_t(0),
             out_images.size(),
-            [&out_images, &engine, &asset](size_t gltf_texture_idx)
+            [&out_images, &virtual_textures, &engine, &asset](size_t gltf_texture_idx)
             {
                 const fastgltf::Texture& texture = asset.textures[gltf_texture_idx];
                 const fastgltf::Image& image = asset.images[texture.imageIndex.value()];
-                std::optional<ImageHandle> out_image = LoadGltfImage(engine, asset, image);
+                std::optional<ImageHandle> out_image =
+                    LoadGltfImage(engine, asset, image, virtual_textures[gltf_texture_idx]);
 
                 // default to placeholder image
                 out_images[gltf_texture_idx] = out_image.value_or(engine.PlaceholderImage());
@@ -414,7 +621,8 @@ namespace Renderer::Utils
             &default_mat_params,
             sizeof(default_mat_params),
             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            "default material uniform buffer"
+            "default material uniform buffer",
+            AllocationClass::Material
         );
 
         Material_GLTF_PBR::Resources default_mat_resources;
@@ -442,8 +650,17 @@ namespace Renderer::Utils
             mat_params.colour =
                 glm::vec4(colour_factor.x(), colour_factor.y(), colour_factor.z(), colour_factor.w());
             mat_params.metal_roughness = glm::vec4(metal_roughness_factor); // #TODO: figure this out later
+            if (gltf_mat.pbrData.baseColorTexture.has_value())
+            {
+                size_t idx = gltf_mat.pbrData.baseColorTexture->textureIndex;
+                mat_params.virtual_texture = virtual_textures[idx].value_or(glm::uvec4(0));
+            }
             BufferHandle mat_uniform = engine.CreateBuffer(
-                &mat_params, sizeof(mat_params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, gltf_mat.name.data()
+                &mat_params,
+                sizeof(mat_params),
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                gltf_mat.name.data(),
+                AllocationClass::Material
             );
 
             ImageHandle colour_image = engine.WhiteImage();
@@ -487,14 +704,24 @@ namespace Renderer::Utils
             new_mat->material = engine.PBRMaterial().CreateInstance(
                 engine.DeviceDispatchTable(), pass, mat_resources, engine.PBRMaterial().descriptor_allocator
             );
+
+            // only the materials of the scene sample its textures, so they can be evicted when memory runs
+            // out. Defaults, placeholders and the white image bound for virtual textures aren't mipmapped and
+            // are ignored.
+            TextureResidency& residency = engine.Residency();
+            residency.Register(new_mat, Material_GLTF_PBR::COLOUR_BINDING, colour_image);
+            residency.Register(new_mat, Material_GLTF_PBR::METAL_ROUGHNESS_BINDING, metal_roughness_image);
         }
 
+        MeshImportContext import_context{ file_path, settings };
         std::vector<uint32_t> indices;
         std::vector<Vertex> vertices;
+        std::vector<GPUMeshlet> meshlets;
         for (const fastgltf::Mesh& mesh : asset.meshes)
         {
             indices.clear();
             vertices.clear();
+            meshlets.clear();
 
             MeshAsset mesh_asset;
             mesh_asset.name = mesh.name;
@@ -504,8 +731,17 @@ namespace Renderer::Utils
                 GeoSurface surface;
                 // any errors will be written here.
                 const char* error_message = "";
-                bool result =
-                    LoadPrimitiveIndicesVertices(asset, primitive, indices, vertices, surface, error_message);
+                bool result = LoadMeshPrimitive(
+                    import_context,
+                    asset,
+                    primitive,
+                    indices,
+                    vertices,
+                    meshlets,
+                    surface,
+                    mesh_asset.optimisation_stats,
+                    error_message
+                );
                 if (result == false)
                 {
                     std::cout << error_message << "\nSkipping mesh: " << mesh_asset.name << std::endl;
@@ -526,9 +762,11 @@ namespace Renderer::Utils
             }
 
             mesh_asset.buffers = engine.UploadMesh(indices, vertices);
+            engine.UploadMeshlets(mesh_asset.buffers, meshlets);
             MeshHandle created_mesh = engine.RegisterMeshAsset(std::move(mesh_asset), mesh.name);
             out_meshes.emplace_back(created_mesh);
         }
+        import_context.Finish();
 
         scene.scene_nodes = asset.nodes;
         if (scene.scene_nodes.empty())
@@ -212,10 +212,10 @@ namespace Renderer::Utils
         return *this;
     }
 
-    PipelineBuilder PipelineBuilder::EnableDepthTest(VkCompareOp compare_op)
+    PipelineBuilder PipelineBuilder::EnableDepthTest(VkCompareOp compare_op, bool depth_write)
     {
         m_depth_stencil.depthTestEnable = VK_TRUE;
-        m_depth_stencil.depthWriteEnable = VK_TRUE;
+        m_depth_stencil.depthWriteEnable = depth_write ? VK_TRUE : VK_FALSE;
         m_depth_stencil.depthCompareOp = compare_op;
         m_depth_stencil.depthBoundsTestEnable = VK_FALSE;
         m_depth_stencil.stencilTestEnable = VK_FALSE;
@@ -240,9 +240,15 @@ namespace Renderer::Utils
         color_blending.pNext = nullptr;
         color_blending.logicOpEnable = VK_FALSE;
         color_blending.logicOp = VK_LOGIC_OP_COPY;
-        color_blending.attachmentCount = 1;
+        color_blending.attachmentCount = m_render_info.colorAttachmentCount; // zero for depth only pipelines
         color_blending.pAttachments = &m_color_blend_attachment;
 
+        // the builder gets copied around, point at our own copy of the format.
+        if (m_render_info.colorAttachmentCount > 0)
+        {
+            m_render_info.pColorAttachmentFormats = &m_color_attachment_format;
+        }
+
         // we don't use this so it's okay to be empty.
         VkPipelineVertexInputStateCreateInfo vertex_input_info{};
         vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -283,4 +289,26 @@ namespace Renderer::Utils
             return new_pipeline;
         }
     }
+
+    VkPipeline BuildComputePipeline(
+        const vkb::DispatchTable& device_dispatch, VkPipelineLayout layout, VkShaderModule shader
+    )
+    {
+        VkComputePipelineCreateInfo pipeline_info{};
+        pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_info.pNext = nullptr;
+        pipeline_info.layout = layout;
+        pipeline_info.stage = ShaderStageCreateInfo("main", shader, VK_SHADER_STAGE_COMPUTE_BIT);
+
+        VkPipeline new_pipeline;
+        VkResult result =
+            device_dispatch.createComputePipelines(VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &new_pipeline);
+        if (result != VK_SUCCESS)
+        {
+            std::cout << "[!] Failed to create compute pipeline." << std::endl;
+            return VK_NULL_HANDLE;
+        }
+
+        return new_pipeline;
+    }
 } // namespace Renderer::Utils
\ No newline at end of file
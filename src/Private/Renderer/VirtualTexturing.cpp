@@ -0,0 +1,713 @@
+#include "Renderer/VirtualTexturing.h"
+#include "Renderer/Utility/UploadRequest.h"
+#include "Renderer/Utility/VkImages.h"
+#include "Renderer/VkEngine.h"
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <utility>
+
+namespace Renderer
+{
+    namespace
+    {
+        constexpr uint32_t BYTES_PER_TEXEL = 4; // only RGBA8 textures are virtual
+
+        // cache tile in the low 16 bits and mip of the tile in the next 8, needs to match
+        // data/shader/virtual_texture.glsl. Entries without the valid bit have nothing to sample yet.
+        constexpr uint32_t PAGE_VALID_BIT = 1u << 31;
+
+        uint32_t PackPageEntry(uint32_t cache_slot, uint32_t mip)
+        {
+            const uint32_t tile_x = cache_slot % VirtualTexturing::CACHE_TILES;
+            const uint32_t tile_y = cache_slot / VirtualTexturing::CACHE_TILES;
+            return tile_x | (tile_y << 8) | (mip << 16) | PAGE_VALID_BIT;
+        }
+
+        // pages per side of a mip, every mip is a square power of two grid half the size of the one before.
+        uint32_t MipSide(uint32_t mip_count, uint32_t mip) { return 1u << (mip_count - 1 - mip); }
+
+        // first page of a mip relative to the first page of the texture, mips are stored finest first.
+        uint32_t MipOffset(uint32_t mip_count, uint32_t mip)
+        {
+            uint32_t offset = 0;
+            for (uint32_t finer_mip = 0; finer_mip < mip; ++finer_mip)
+            {
+                const uint32_t side = MipSide(mip_count, finer_mip);
+                offset += side * side;
+            }
+            return offset;
+        }
+
+        // 2x2 box filter, the last row and column are repeated for odd sizes.
+        std::vector<uint8_t> Downsample(
+            const std::vector<uint8_t>& source, VkExtent2D source_extent, VkExtent2D extent
+        )
+        {
+            std::vector<uint8_t> result(size_t(extent.width) * extent.height * BYTES_PER_TEXEL);
+            tbb::parallel_for(
+                uint32_t(0),
+                extent.height,
+                [&](uint32_t y)
+                {
+                    const uint32_t y0 = std::min(y * 2, source_extent.height - 1);
+                    const uint32_t y1 = std::min(y * 2 + 1, source_extent.height - 1);
+                    for (uint32_t x = 0; x < extent.width; ++x)
+                    {
+                        const uint32_t x0 = std::min(x * 2, source_extent.width - 1);
+                        const uint32_t x1 = std::min(x * 2 + 1, source_extent.width - 1);
+                        for (uint32_t channel = 0; channel < BYTES_PER_TEXEL; ++channel)
+                        {
+                            auto texel = [&](uint32_t source_x, uint32_t source_y)
+                            {
+                                const size_t index = size_t(source_y) * source_extent.width + source_x;
+                                return uint32_t(source[index * BYTES_PER_TEXEL + channel]);
+                            };
+                            const uint32_t sum =
+                                texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+                            const size_t index = size_t(y) * extent.width + x;
+                            result[index * BYTES_PER_TEXEL + channel] = uint8_t((sum + 2) / 4);
+                        }
+                    }
+                }
+            );
+            return result;
+        }
+
+        // puts the cache in the sampled layout and marks every page unloaded before anything is bound.
+        class VirtualCacheClearRequest : public Utils::IUploadRequest
+        {
+          public:
+            VirtualCacheClearRequest(ImageHandle cache, BufferHandle page_table) :
+                m_cache(std::move(cache)),
+                m_page_table(std::move(page_table))
+            {
+            }
+
+            Utils::UploadExecutionResult ExecuteUpload(VulkanEngine& engine, VkCommandBuffer cmd) override
+            {
+                vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+                Utils::TransitionImage(
+                    &device_dispatch,
+                    cmd,
+                    m_cache->image,
+                    VK_IMAGE_LAYOUT_UNDEFINED,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                );
+
+                VkClearColorValue clear_colour{};
+                VkImageSubresourceRange range = Utils::SubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
+                device_dispatch.cmdClearColorImage(
+                    cmd, m_cache->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_colour, 1, &range
+                );
+
+                Utils::TransitionImage(
+                    &device_dispatch,
+                    cmd,
+                    m_cache->image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                );
+
+                // zero entries are pages that aren't loaded, the page table updates and draws come after.
+                device_dispatch.cmdFillBuffer(cmd, m_page_table->buffer, 0, VK_WHOLE_SIZE, 0);
+                Utils::GlobalMemoryBarrier(
+                    &device_dispatch,
+                    cmd,
+                    VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                    VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                    VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT
+                );
+                return Utils::UploadExecutionResult::Success;
+            }
+
+            void DestroyResources(VulkanEngine&) override {}
+            std::string_view DebugName() const override { return "virtual texture cache clear"; }
+            Utils::UploadType GetUploadType() const override { return Utils::UploadType::Deferred; }
+
+          private:
+            ImageHandle m_cache;
+            BufferHandle m_page_table;
+        };
+    } // namespace
+
+    /// Copies a page cut out by a loading task into its tile of the cache atlas.
+    class VirtualTileUploadRequest : public Utils::IUploadRequest
+    {
+      public:
+        VirtualTileUploadRequest(
+            VirtualTexturing& virtual_texturing,
+            BufferHandle staging_buffer,
+            ImageHandle cache,
+            uint32_t page,
+            uint32_t cache_slot
+        ) :
+            m_virtual_texturing(virtual_texturing),
+            m_staging_buffer(std::move(staging_buffer)),
+            m_cache(std::move(cache)),
+            m_page(page),
+            m_cache_slot(cache_slot)
+        {
+        }
+
+        Utils::UploadExecutionResult ExecuteUpload(VulkanEngine& engine, VkCommandBuffer cmd) override
+        {
+            constexpr uint32_t tile_size = VirtualTexturing::TILE_SIZE;
+            vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+
+            // earlier frames might still sample the tile, the transitions wait for them.
+            Utils::TransitionImage(
+                &device_dispatch,
+                cmd,
+                m_cache->image,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+            );
+
+            VkBufferImageCopy2 copy{};
+            copy.sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2;
+            copy.imageSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            copy.imageOffset = VkOffset3D{ int32_t(m_cache_slot % VirtualTexturing::CACHE_TILES * tile_size),
+                                           int32_t(m_cache_slot / VirtualTexturing::CACHE_TILES * tile_size),
+                                           0 };
+            copy.imageExtent = VkExtent3D{ tile_size, tile_size, 1 };
+
+            VkCopyBufferToImageInfo2 copy_info{};
+            copy_info.sType = VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2;
+            copy_info.srcBuffer = m_staging_buffer->buffer;
+            copy_info.dstImage = m_cache->image;
+            copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            copy_info.regionCount = 1;
+            copy_info.pRegions = &copy;
+            device_dispatch.cmdCopyBufferToImage2(cmd, &copy_info);
+
+            Utils::TransitionImage(
+                &device_dispatch,
+                cmd,
+                m_cache->image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            );
+
+            m_virtual_texturing.TileUploaded(m_page);
+            return Utils::UploadExecutionResult::Success;
+        }
+
+        void DestroyResources(VulkanEngine&) override
+        {
+            // the reference counted handles take care of the staging buffer.
+        }
+
+        std::string_view DebugName() const override { return "virtual texture tile"; }
+        Utils::UploadType GetUploadType() const override { return Utils::UploadType::Deferred; }
+
+      private:
+        VirtualTexturing& m_virtual_texturing;
+        BufferHandle m_staging_buffer;
+        ImageHandle m_cache;
+        uint32_t m_page;
+        uint32_t m_cache_slot;
+    };
+
+    void VirtualTexturing::Init(VulkanEngine& engine)
+    {
+        constexpr uint32_t cache_size = TILE_SIZE * CACHE_TILES;
+        m_cache = engine.AllocateImage(
+            VkExtent3D{ cache_size, cache_size, 1 },
+            VK_FORMAT_R8G8B8A8_UNORM,
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            0,
+            false,
+            "virtual_texture_cache"
+        );
+        m_page_table_buffer = engine.CreateBuffer(
+            MAX_PAGES * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0,
+            "virtual_texture_page_table"
+        );
+        m_page_table_address = engine.BufferDeviceAddress(m_page_table_buffer);
+        engine.RequestUpload(std::make_unique<VirtualCacheClearRequest>(m_cache, m_page_table_buffer));
+
+        // read back by the CPU, so they live in host memory.
+        for (size_t slot = 0; slot < m_feedback_buffers.size(); ++slot)
+        {
+            BufferHandle& feedback = m_feedback_buffers[slot];
+            feedback = engine.CreateBuffer(
+                MAX_PAGES * sizeof(uint32_t),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+                "virtual_texture_feedback"
+            );
+            std::memset(feedback->allocation_info.pMappedData, 0, MAX_PAGES * sizeof(uint32_t));
+            vmaFlushAllocation(engine.Allocator(), feedback->allocation, 0, VK_WHOLE_SIZE);
+            m_feedback_addresses[slot] = engine.BufferDeviceAddress(feedback);
+        }
+
+        m_cache_slots.resize(CACHE_TILES * CACHE_TILES);
+        m_page_table.resize(MAX_PAGES, 0);
+    }
+
+    void VirtualTexturing::Destroy()
+    {
+        m_loader.wait();
+
+        m_cache = ImageHandle{};
+        m_page_table_buffer = BufferHandle{};
+        m_feedback_buffers = {};
+
+        std::lock_guard lock{ m_created_mutex };
+        m_created.clear();
+        m_textures.clear();
+    }
+
+    std::optional<glm::uvec4> VirtualTexturing::Create(
+        const uint8_t* pixels, VkExtent2D extent, std::string_view name
+    )
+    {
+        const uint32_t pages_wide = (extent.width + TILE_SIZE - 1) / TILE_SIZE;
+        const uint32_t pages_high = (extent.height + TILE_SIZE - 1) / TILE_SIZE;
+        const uint32_t side = std::bit_ceil(std::max(pages_wide, pages_high));
+
+        std::unique_ptr<VirtualTexture> texture = std::make_unique<VirtualTexture>();
+        texture->name = name;
+        texture->extent = extent;
+        texture->mip_count = uint32_t(std::countr_zero(side)) + 1;
+        texture->page_count = MipOffset(texture->mip_count, texture->mip_count);
+
+        // mips past the one covered by a single page are never sampled.
+        const size_t mip_0_bytes = size_t(extent.width) * extent.height * BYTES_PER_TEXEL;
+        texture->mips.reserve(texture->mip_count);
+        texture->mips.emplace_back(pixels, pixels + mip_0_bytes);
+        for (uint32_t mip = 1; mip < texture->mip_count; ++mip)
+        {
+            texture->mips.push_back(Downsample(
+                texture->mips[mip - 1], Utils::MipExtent(extent, mip - 1), Utils::MipExtent(extent, mip)
+            ));
+        }
+
+        std::lock_guard lock{ m_created_mutex };
+        if (m_allocated_pages + texture->page_count > MAX_PAGES)
+        {
+            std::cerr << "[!] Virtual texture page table is full, \"" << name
+                      << "\" can't be loaded as a virtual texture." << std::endl;
+            return std::nullopt;
+        }
+
+        texture->page_offset = m_allocated_pages;
+        m_allocated_pages += texture->page_count;
+
+        const glm::uvec4 parameters{ texture->page_offset, extent.width, extent.height, texture->mip_count };
+        std::cout << "[*] Loaded \"" << name << "\" as a virtual texture with " << texture->page_count
+                  << " pages." << std::endl;
+        m_created.push_back(std::move(texture));
+        return parameters;
+    }
+
+    void VirtualTexturing::Update(VulkanEngine& engine, VkCommandBuffer cmd)
+    {
+        m_frame = uint64_t(engine.frame_number);
+        m_feedback_slot = uint32_t(engine.frame_number % engine.FramesInFlight());
+
+        AddCreatedTextures();
+        FinishUploadedTiles();
+
+        std::vector<uint32_t> missing_pages{};
+        ReadFeedback(engine, cmd, missing_pages);
+        LoadMissingPages(engine, missing_pages);
+        UpdatePageTable(engine, cmd);
+
+        // the feedback was cleared and the page table might have changed.
+        Utils::GlobalMemoryBarrier(
+            &engine.DeviceDispatchTable(),
+            cmd,
+            VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        );
+    }
+
+    void VirtualTexturing::EndFrame(vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd)
+    {
+        Utils::GlobalMemoryBarrier(
+            &device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_HOST_BIT,
+            VK_ACCESS_2_HOST_READ_BIT
+        );
+    }
+
+    void VirtualTexturing::AddCreatedTextures()
+    {
+        std::vector<std::unique_ptr<VirtualTexture>> created{};
+        {
+            std::lock_guard lock{ m_created_mutex };
+            created.swap(m_created);
+        }
+
+        // pages are allocated in the order textures are created, so the textures stay sorted by page.
+        for (std::unique_ptr<VirtualTexture>& texture : created)
+        {
+            m_pages.resize(texture->page_offset + texture->page_count);
+            m_textures.push_back(std::move(texture));
+            m_dirty_textures.push_back(true);
+        }
+    }
+
+    void VirtualTexturing::FinishUploadedTiles()
+    {
+        std::vector<uint32_t> uploaded_pages{};
+        {
+            std::lock_guard lock{ m_uploaded_mutex };
+            uploaded_pages.swap(m_uploaded_pages);
+        }
+
+        for (uint32_t page : uploaded_pages)
+        {
+            PageState& state = m_pages[page];
+            state.loading = false;
+            state.resident = true;
+            m_dirty_textures[PageToCoordinate(page).texture] = true;
+            --m_pending_loads;
+            ++m_resident_tiles;
+        }
+    }
+
+    void VirtualTexturing::ReadFeedback(
+        VulkanEngine& engine, VkCommandBuffer cmd, std::vector<uint32_t>& missing_pages
+    )
+    {
+        // the coarsest page is the fallback of the whole texture, it is loaded whether it was sampled or not.
+        for (const std::unique_ptr<VirtualTexture>& texture : m_textures)
+        {
+            const uint32_t root_page = texture->page_offset + texture->page_count - 1;
+            PageState& root = m_pages[root_page];
+            if (root.resident == false && root.loading == false)
+            {
+                root.last_requested_frame = m_frame;
+                missing_pages.push_back(root_page);
+            }
+        }
+
+        // the fence of the frame slot was waited on, whatever its last frame wrote is there.
+        const BufferHandle& feedback = m_feedback_buffers[m_feedback_slot];
+        vmaInvalidateAllocation(engine.Allocator(), feedback->allocation, 0, VK_WHOLE_SIZE);
+        const uint32_t* requested = static_cast<const uint32_t*>(feedback->allocation_info.pMappedData);
+
+        for (uint32_t page = 0; page < uint32_t(m_pages.size()); ++page)
+        {
+            if (requested[page] == 0)
+            {
+                continue;
+            }
+
+            // coarser pages are sampled instead until the page is loaded, they are in use too.
+            for (uint32_t used_page = page; used_page != INVALID_INDEX; used_page = ParentPage(used_page))
+            {
+                PageState& state = m_pages[used_page];
+                if (state.last_requested_frame == m_frame)
+                {
+                    break; // the rest of the chain was visited through another page
+                }
+
+                state.last_requested_frame = m_frame;
+                if (state.resident)
+                {
+                    m_cache_slots[state.cache_slot].last_used_frame = m_frame;
+                }
+                else if (state.loading == false)
+                {
+                    missing_pages.push_back(used_page);
+                }
+            }
+        }
+
+        // cleared for the next frame using the slot, this frame's draws write into it after.
+        engine.DeviceDispatchTable().cmdFillBuffer(cmd, feedback->buffer, 0, VK_WHOLE_SIZE, 0);
+    }
+
+    void VirtualTexturing::LoadMissingPages(VulkanEngine& engine, const std::vector<uint32_t>& missing_pages)
+    {
+        // coarse pages first, they are what the finer pages fall back to.
+        std::vector<std::pair<uint32_t, uint32_t>> mip_pages{};
+        mip_pages.reserve(missing_pages.size());
+        for (uint32_t page : missing_pages)
+        {
+            mip_pages.emplace_back(PageToCoordinate(page).mip, page);
+        }
+        std::sort(mip_pages.begin(), mip_pages.end(), std::greater<>{});
+
+        uint32_t started_loads = 0;
+        for (const auto& [mip, page] : mip_pages)
+        {
+            if (started_loads >= MAX_LOADS_PER_FRAME || m_pending_loads >= MAX_PENDING_LOADS)
+            {
+                break;
+            }
+
+            const VirtualTexture& texture = *m_textures[PageToCoordinate(page).texture];
+            if (StartLoad(engine, page, mip + 1 == texture.mip_count) == false)
+            {
+                break; // every tile is in use, the rest waits until something goes out of view
+            }
+            ++started_loads;
+        }
+    }
+
+    void VirtualTexturing::UpdatePageTable(VulkanEngine& engine, VkCommandBuffer cmd)
+    {
+        std::vector<VkBufferCopy> copies{};
+        VkDeviceSize staging_size = 0;
+        for (uint32_t texture_index = 0; texture_index < uint32_t(m_textures.size()); ++texture_index)
+        {
+            if (m_dirty_textures[texture_index] == false)
+            {
+                continue;
+            }
+            m_dirty_textures[texture_index] = false;
+
+            // coarse to fine, pages that aren't resident copy the entry of the page covering them.
+            const VirtualTexture& texture = *m_textures[texture_index];
+            for (uint32_t mip = texture.mip_count; mip-- > 0;)
+            {
+                const uint32_t side = MipSide(texture.mip_count, mip);
+                const uint32_t first_page = texture.page_offset + MipOffset(texture.mip_count, mip);
+                const uint32_t first_parent = first_page + side * side;
+                for (uint32_t y = 0; y < side; ++y)
+                {
+                    for (uint32_t x = 0; x < side; ++x)
+                    {
+                        const uint32_t page = first_page + y * side + x;
+                        const PageState& state = m_pages[page];
+                        if (state.resident)
+                        {
+                            m_page_table[page] = PackPageEntry(state.cache_slot, mip);
+                        }
+                        else if (mip + 1 == texture.mip_count)
+                        {
+                            m_page_table[page] = 0;
+                        }
+                        else
+                        {
+                            m_page_table[page] = m_page_table[first_parent + (y / 2) * (side / 2) + x / 2];
+                        }
+                    }
+                }
+            }
+
+            VkBufferCopy& copy = copies.emplace_back();
+            copy.srcOffset = staging_size;
+            copy.dstOffset = VkDeviceSize(texture.page_offset) * sizeof(uint32_t);
+            copy.size = VkDeviceSize(texture.page_count) * sizeof(uint32_t);
+            staging_size += copy.size;
+        }
+
+        if (copies.empty())
+        {
+            return;
+        }
+
+        BufferHandle staging_buffer = engine.CreateBuffer(
+            staging_size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "virtual_texture_page_table_staging"
+        );
+        for (const VkBufferCopy& copy : copies)
+        {
+            vmaCopyMemoryToAllocation(
+                engine.Allocator(),
+                &m_page_table[copy.dstOffset / sizeof(uint32_t)],
+                staging_buffer->allocation,
+                copy.srcOffset,
+                copy.size
+            );
+        }
+
+        // frames in flight might still be reading the page table.
+        vkb::DispatchTable& device_dispatch = engine.DeviceDispatchTable();
+        Utils::GlobalMemoryBarrier(
+            &device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_NONE,
+            VK_PIPELINE_STAGE_2_COPY_BIT,
+            VK_ACCESS_2_NONE
+        );
+        device_dispatch.cmdCopyBuffer(
+            cmd, staging_buffer->buffer, m_page_table_buffer->buffer, uint32_t(copies.size()), copies.data()
+        );
+        engine.GetCurrentFrame().buffers_in_use.push_back(std::move(staging_buffer));
+    }
+
+    bool VirtualTexturing::StartLoad(VulkanEngine& engine, uint32_t page, bool pinned)
+    {
+        const uint32_t cache_slot = FindCacheSlot();
+        if (cache_slot == INVALID_INDEX)
+        {
+            return false;
+        }
+
+        // the replaced page falls back to a coarser mip. The page table is updated this frame, before the
+        // tile is overwritten by a later upload.
+        CacheSlot& slot = m_cache_slots[cache_slot];
+        if (slot.page != INVALID_INDEX)
+        {
+            PageState& replaced = m_pages[slot.page];
+            replaced.resident = false;
+            replaced.cache_slot = INVALID_INDEX;
+            m_dirty_textures[PageToCoordinate(slot.page).texture] = true;
+            --m_resident_tiles;
+        }
+        slot = CacheSlot{ page, m_frame, pinned };
+
+        PageState& state = m_pages[page];
+        state.cache_slot = cache_slot;
+        state.loading = true;
+        ++m_pending_loads;
+
+        // textures are never destroyed while the loader runs, Destroy waits for it.
+        const PageCoordinate coordinate = PageToCoordinate(page);
+        const VirtualTexture* texture = m_textures[coordinate.texture].get();
+        m_loader.run(
+            [this, &engine, texture, coordinate, page, cache_slot]()
+            {
+                LoadTile(engine, *texture, coordinate, page, cache_slot);
+            }
+        );
+        return true;
+    }
+
+    uint32_t VirtualTexturing::FindCacheSlot()
+    {
+        // a free slot, or the least recently used one that wasn't sampled by the frame the feedback is from.
+        uint32_t oldest_slot = INVALID_INDEX;
+        for (uint32_t index = 0; index < uint32_t(m_cache_slots.size()); ++index)
+        {
+            const CacheSlot& slot = m_cache_slots[index];
+            if (slot.page == INVALID_INDEX)
+            {
+                return index;
+            }
+            if (slot.pinned || m_pages[slot.page].loading || slot.last_used_frame == m_frame)
+            {
+                continue;
+            }
+            if (oldest_slot == INVALID_INDEX ||
+                slot.last_used_frame < m_cache_slots[oldest_slot].last_used_frame)
+            {
+                oldest_slot = index;
+            }
+        }
+        return oldest_slot;
+    }
+
+    void VirtualTexturing::LoadTile(
+        VulkanEngine& engine,
+        const VirtualTexture& texture,
+        PageCoordinate coordinate,
+        uint32_t page,
+        uint32_t cache_slot
+    )
+    {
+        const VkExtent2D mip_extent = Utils::MipExtent(texture.extent, coordinate.mip);
+        const std::vector<uint8_t>& mip = texture.mips[coordinate.mip];
+
+        // pages at the edge of the texture repeat its last row and column.
+        std::vector<uint8_t> tile(size_t(TILE_SIZE) * TILE_SIZE * BYTES_PER_TEXEL);
+        for (uint32_t y = 0; y < TILE_SIZE; ++y)
+        {
+            const uint32_t source_y = std::min(coordinate.y * TILE_SIZE + y, mip_extent.height - 1);
+            for (uint32_t x = 0; x < TILE_SIZE; ++x)
+            {
+                const uint32_t source_x = std::min(coordinate.x * TILE_SIZE + x, mip_extent.width - 1);
+                const size_t source_index = size_t(source_y) * mip_extent.width + source_x;
+                const size_t tile_index = size_t(y) * TILE_SIZE + x;
+                std::memcpy(
+                    &tile[tile_index * BYTES_PER_TEXEL], &mip[source_index * BYTES_PER_TEXEL], BYTES_PER_TEXEL
+                );
+            }
+        }
+
+        BufferHandle staging_buffer = engine.CreateBuffer(
+            tile.size(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "virtual_texture_tile"
+        );
+        vmaCopyMemoryToAllocation(
+            engine.Allocator(), tile.data(), staging_buffer->allocation, 0, tile.size()
+        );
+
+        engine.RequestUpload(std::make_unique<VirtualTileUploadRequest>(
+            *this, std::move(staging_buffer), m_cache, page, cache_slot
+        ));
+    }
+
+    void VirtualTexturing::TileUploaded(uint32_t page)
+    {
+        std::lock_guard lock{ m_uploaded_mutex };
+        m_uploaded_pages.push_back(page);
+    }
+
+    VirtualTexturing::PageCoordinate VirtualTexturing::PageToCoordinate(uint32_t page) const
+    {
+        // textures are sorted by their first page.
+        auto next_texture = std::upper_bound(
+            m_textures.begin(),
+            m_textures.end(),
+            page,
+            [](uint32_t value, const std::unique_ptr<VirtualTexture>& texture)
+            {
+                return value < texture->page_offset;
+            }
+        );
+        const uint32_t texture_index = uint32_t(next_texture - m_textures.begin()) - 1;
+        const VirtualTexture& texture = *m_textures[texture_index];
+
+        uint32_t local_page = page - texture.page_offset;
+        for (uint32_t mip = 0; mip < texture.mip_count; ++mip)
+        {
+            const uint32_t side = MipSide(texture.mip_count, mip);
+            if (local_page < side * side)
+            {
+                return PageCoordinate{ texture_index, mip, local_page % side, local_page / side };
+            }
+            local_page -= side * side;
+        }
+        return PageCoordinate{ texture_index, texture.mip_count - 1, 0, 0 };
+    }
+
+    uint32_t VirtualTexturing::ParentPage(uint32_t page) const
+    {
+        const PageCoordinate coordinate = PageToCoordinate(page);
+        const VirtualTexture& texture = *m_textures[coordinate.texture];
+        const uint32_t parent_mip = coordinate.mip + 1;
+        if (parent_mip == texture.mip_count)
+        {
+            return INVALID_INDEX;
+        }
+
+        const uint32_t side = MipSide(texture.mip_count, parent_mip);
+        return texture.page_offset + MipOffset(texture.mip_count, parent_mip) + (coordinate.y / 2) * side +
+               coordinate.x / 2;
+    }
+} // namespace Renderer
@@ -6,6 +6,7 @@
 #include "Renderer/RenderObject.h"
 #include "Renderer/Utility/DebugPanels.h"
 #include "Renderer/Utility/UploadRequest.h"
+#include "Renderer/Utility/VertexFormats.h"
 #include "Renderer/Utility/VkDescriptors.h"
 #include "Renderer/Utility/VkImages.h"
 #include "Renderer/Utility/VkInitialisers.h"
@@ -34,9 +35,11 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -55,13 +58,20 @@ namespace Renderer
         SDL_Window* window,
         float backbuffer_scale,
         bool use_validation_layers,
-        bool immediate_uploads
+        bool immediate_uploads,
+        bool compress_vertices,
+        PresentMode present_mode,
+        uint32_t frames_in_flight
     ) :
         m_backbuffer_scale(backbuffer_scale),
+        m_frames(std::clamp(frames_in_flight, 1u, MAX_FRAME_OVERLAP)),
+        m_requested_frames_in_flight(uint32_t(m_frames.size())),
+        m_present_mode(present_mode),
         m_window_extent({ window_width, window_height }),
         m_window(window),
         m_use_validation_layers(use_validation_layers),
-        m_force_all_uploads_immediate(immediate_uploads)
+        m_force_all_uploads_immediate(immediate_uploads),
+        m_compress_vertices(compress_vertices)
     {
     }
 
@@ -76,7 +86,9 @@ namespace Renderer
         CreateSwapchain(m_window_extent.width, m_window_extent.height);
         InitCommands();
         InitSyncStructures();
-        InitFrameDescriptors();
+        InitSceneDescriptors();
+        InitFrames();
+        m_render_graph.Init(&m_device_dispatch, m_allocator, FramesInFlight());
         InitDefaultDescriptors();
 
         // InitPipelines is where we initialise materials for the first time so the material interface needs
@@ -110,14 +122,37 @@ namespace Renderer
         {
             frame.deletion_queue.Flush();
         }
+        for (PresentWindow& window : m_present_windows)
+        {
+            RetirePresentWindow(window);
+        }
+        m_present_windows.clear();
+        ReleaseRetiredResources(true);
 
         // swapchain isn't handled by the deletion queue because it gets recreated at runtime
         DestroySwapchain();
 
+        // views of the depth pyramids aren't owned by the image storage
+        for (Viewport& viewport : active_viewports)
+        {
+            for (VkImageView view : viewport.depth_pyramid.mip_views)
+            {
+                m_device_dispatch.destroyImageView(view, nullptr);
+            }
+            viewport.depth_pyramid.mip_views.clear();
+        }
+
+        m_texture_residency.Destroy(m_device_dispatch);
+        m_virtual_texturing.Destroy();
+        m_geometry_pool.Destroy();
+        m_render_graph.Destroy();
+        m_memory_pools.EndDefragmentation(*this);
+
         // destroy all resource storages
         m_image_storage.Clear(*this);
         m_buffer_storage.Clear(*this);
         m_mesh_storage.Clear(*this);
+        m_debug_textures.Clear();
 
         active_viewports.clear();
         main_viewport = 0;
@@ -148,6 +183,15 @@ namespace Renderer
         {
             if (ImGui::Begin("Resource Debugger", &m_draw_resource_debugger))
             {
+                if (ImGui::CollapsingHeader("Memory"))
+                {
+                    ImGui::PushID("Memory");
+                    Renderer::Debug::DrawMemoryImGui(
+                        *this, m_memory_tracker, m_image_storage, m_buffer_storage, m_mesh_storage
+                    );
+                    ImGui::PopID();
+                }
+
                 if (ImGui::CollapsingHeader("Images"))
                 {
                     ImGui::PushID("Images");
@@ -182,19 +226,253 @@ namespace Renderer
                     "Swapchain Resolution: %dx%d", m_swapchain_extent.width, m_swapchain_extent.height
                 );
                 ImGui::Text("Window Resolution: %dx%d", m_window_extent.width, m_window_extent.height);
+                ImGui::Checkbox("Bicubic Upscale", &m_bicubic_upscale);
+            }
+
+            if (ImGui::CollapsingHeader("Background"))
+            {
+                if (m_background.loaded == false)
+                {
+                    ImGui::Text("Compute backgrounds are unavailable.");
+                }
+                else
+                {
+                    ComputeEffect& current_effect =
+                        m_background.effects[std::min(m_current_effect, m_background.effects.size() - 1)];
+                    if (ImGui::BeginCombo("Effect", current_effect.name))
+                    {
+                        for (size_t i = 0; i < m_background.effects.size(); ++i)
+                        {
+                            if (ImGui::Selectable(m_background.effects[i].name, i == m_current_effect))
+                            {
+                                m_current_effect = i;
+                            }
+                        }
+                        ImGui::EndCombo();
+                    }
+                    ImGui::ColorEdit4("Data 1", &current_effect.push_constants.data1.x);
+                    ImGui::ColorEdit4("Data 2", &current_effect.push_constants.data2.x);
+                    ImGui::DragFloat4("Data 3", &current_effect.push_constants.data3.x, 0.01f);
+                    ImGui::DragFloat4("Data 4", &current_effect.push_constants.data4.x, 0.01f);
+                }
+
+                ImGui::BeginDisabled(m_compute_queue == nullptr);
+                ImGui::Checkbox("Async Compute", &m_async_background);
+                ImGui::EndDisabled();
+                if (m_compute_queue == nullptr)
+                {
+                    ImGui::SameLine();
+                    ImGui::Text("(no separate compute queue)");
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Render Graph"))
+            {
+                const RenderGraph::Stats& stats = m_render_graph.LastStats();
+                ImGui::Text("Passes: %u (%u culled)", stats.pass_count, stats.culled_pass_count);
+                ImGui::Text("Barriers: %u in %u batches", stats.barrier_count, stats.barrier_batch_count);
+                ImGui::Text(
+                    "Transient Memory: %.2f MiB (%.2f MiB without aliasing)",
+                    float(stats.transient_bytes) / (1024.0f * 1024.0f),
+                    float(stats.unaliased_bytes) / (1024.0f * 1024.0f)
+                );
+
+                ImGui::SeparatorText("Passes");
+                for (const RenderGraphPass& pass : m_render_graph.Passes())
+                {
+                    ImGui::BeginDisabled(pass.culled);
+                    ImGui::Text("%s%s", pass.name.c_str(), pass.culled ? " (culled)" : "");
+                    ImGui::EndDisabled();
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Frame Pacing"))
+            {
+                if (ImGui::BeginCombo("Present Mode", PresentModeName(m_present_mode)))
+                {
+                    for (PresentMode mode : PRESENT_MODES)
+                    {
+                        if (ImGui::Selectable(PresentModeName(mode), mode == m_present_mode))
+                        {
+                            SetPresentMode(mode);
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGui::Text("Active Present Mode: %s", PresentModeName(m_active_present_mode));
+                ImGui::DragFloat("Max FPS (0 = unlimited)", &m_frame_limiter.max_fps, 1.0f, 0.0f, 1000.0f);
+                int frames_in_flight = int(m_requested_frames_in_flight);
+                if (ImGui::SliderInt("Frames In Flight", &frames_in_flight, 1, int(MAX_FRAME_OVERLAP)))
+                {
+                    SetFramesInFlight(uint32_t(frames_in_flight));
+                }
+
+                ImGui::SeparatorText("Input To Present Latency");
+                ImGui::Text("Last: %.2f ms", m_input_latency.last_milliseconds);
+                ImGui::Text("Average: %.2f ms", m_input_latency.average_milliseconds);
+                ImGui::Text("Max: %.2f ms", m_input_latency.max_milliseconds);
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Reset"))
+                {
+                    m_input_latency.max_milliseconds = 0.0;
+                }
+
+                ImGui::SeparatorText("Frames In Flight Benchmark");
+                ImGui::BeginDisabled(m_frames_in_flight_benchmark.running);
+                if (ImGui::Button("Run Benchmark"))
+                {
+                    SetFramesInFlight(m_frames_in_flight_benchmark.Start(FramesInFlight()));
+                }
+                ImGui::EndDisabled();
+                if (m_frames_in_flight_benchmark.running)
+                {
+                    ImGui::SameLine();
+                    ImGui::Text("Running with %u frames in flight...", FramesInFlight());
+                }
+
+                if (m_frames_in_flight_benchmark.results.empty() == false &&
+                    ImGui::BeginTable("frames_in_flight_benchmark", 5, ImGuiTableFlags_Borders))
+                {
+                    ImGui::TableSetupColumn("Frames");
+                    ImGui::TableSetupColumn("Frame (ms)");
+                    ImGui::TableSetupColumn("Fence Wait (ms)");
+                    ImGui::TableSetupColumn("GPU (ms)");
+                    ImGui::TableSetupColumn("GPU Busy");
+                    ImGui::TableHeadersRow();
+
+                    for (const FramesInFlightResult& result : m_frames_in_flight_benchmark.results)
+                    {
+                        // the running stage only has sums so far.
+                        if (result.measured_frames < FramesInFlightBenchmark::MEASURED_FRAMES)
+                        {
+                            continue;
+                        }
+
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", result.frames_in_flight);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", result.frame_milliseconds);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", result.fence_wait_milliseconds);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", result.gpu_milliseconds);
+                        ImGui::TableNextColumn();
+                        if (result.gpu_milliseconds >= 0.0)
+                        {
+                            const double gpu_busy = result.gpu_milliseconds / result.frame_milliseconds;
+                            ImGui::Text("%.1f%%", 100.0 * gpu_busy);
+                        }
+                    }
+                    ImGui::EndTable();
+                }
+            }
+
+            if (ImGui::CollapsingHeader("GPU Timings"))
+            {
+                if (m_gpu_profiler.IsSupported() == false)
+                {
+                    ImGui::Text("GPU timestamps are not supported.");
+                }
+                for (const Utils::GpuTiming& timing : m_gpu_profiler.Timings())
+                {
+                    ImGui::Text("%s: %.3f ms", timing.name.c_str(), timing.milliseconds);
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Texture Residency"))
+            {
+                ImGui::Checkbox("Enabled", &m_texture_residency.enabled);
+                ImGui::InputScalar(
+                    "Budget Override (MiB)", ImGuiDataType_U32, &m_texture_residency.budget_override_mib
+                );
+                ImGui::Text(
+                    "%zu / %zu textures evicted, %.1f MiB freed",
+                    m_texture_residency.EvictedCount(),
+                    m_texture_residency.TextureCount(),
+                    double(m_texture_residency.EvictedBytes()) / (1024.0 * 1024.0)
+                );
+            }
+
+            if (ImGui::CollapsingHeader("Memory Pools"))
+            {
+                ImGui::Checkbox("Defragmentation", &m_memory_pools.defragmentation_enabled);
+                for (size_t pool_index = 1; pool_index < size_t(AllocationClass::Count); ++pool_index)
+                {
+                    const AllocationClass allocation_class = static_cast<AllocationClass>(pool_index);
+                    const VmaStatistics stats = m_memory_pools.PoolStatistics(m_allocator, allocation_class);
+                    ImGui::PushID(int(pool_index));
+                    ImGui::Text(
+                        "%s: %u allocations, %.1f / %.1f MiB in %u blocks",
+                        AllocationClassName(allocation_class),
+                        stats.allocationCount,
+                        double(stats.allocationBytes) / (1024.0 * 1024.0),
+                        double(stats.blockBytes) / (1024.0 * 1024.0),
+                        stats.blockCount
+                    );
+                    if (IsMovableClass(allocation_class))
+                    {
+                        ImGui::SameLine();
+                        if (ImGui::SmallButton("Defragment"))
+                        {
+                            m_memory_pools.RequestDefragmentation(allocation_class);
+                        }
+                    }
+                    ImGui::PopID();
+                }
+                if (m_memory_pools.IsDefragmenting())
+                {
+                    ImGui::Text("Defragmenting %s", AllocationClassName(m_memory_pools.DefragmentedClass()));
+                }
+                ImGui::Text(
+                    "%llu allocations moved, %.1f MiB",
+                    (unsigned long long)m_memory_pools.MovedAllocations(),
+                    double(m_memory_pools.MovedBytes()) / (1024.0 * 1024.0)
+                );
+            }
+
+            if (ImGui::CollapsingHeader("Virtual Texturing"))
+            {
+                ImGui::Text("%zu virtual textures", m_virtual_texturing.TextureCount());
+                ImGui::Text(
+                    "%u / %u cache tiles resident, %u loading",
+                    m_virtual_texturing.ResidentTiles(),
+                    VirtualTexturing::CACHE_TILES * VirtualTexturing::CACHE_TILES,
+                    m_virtual_texturing.PendingLoads()
+                );
+            }
+
+            if (ImGui::CollapsingHeader("Geometry Pool"))
+            {
+                ImGui::Text(
+                    "Vertices: %.2f / %.2f MiB, largest free range %.2f MiB",
+                    double(m_geometry_pool.UsedVertexBytes()) / (1024.0 * 1024.0),
+                    double(m_geometry_pool.VertexCapacity()) / (1024.0 * 1024.0),
+                    double(m_geometry_pool.LargestFreeVertexRange()) / (1024.0 * 1024.0)
+                );
+                ImGui::Text(
+                    "Indices: %.2f / %.2f MiB",
+                    double(m_geometry_pool.UsedIndexBytes()) / (1024.0 * 1024.0),
+                    double(m_geometry_pool.IndexCapacity()) / (1024.0 * 1024.0)
+                );
+                ImGui::Text(
+                    "%zu free ranges, %zu meshes with buffers of their own",
+                    m_geometry_pool.FreeRangeCount(),
+                    m_geometry_pool.FallbackMeshCount()
+                );
             }
 
             if (ImGui::CollapsingHeader("Scene Lighting"))
             {
                 ImGui::ColorEdit3(
-                    "Ambient Colour", &active_viewports[main_viewport].frame_context.ambient_colour.r
+                    "Ambient Colour", &active_viewports[main_viewport].render_context.ambient_colour.r
                 );
                 ImGui::ColorEdit3(
-                    "Light Colour", &active_viewports[main_viewport].frame_context.light_colour.r
+                    "Light Colour", &active_viewports[main_viewport].render_context.light_colour.r
                 );
                 ImGui::SliderFloat3(
                     "Light Direction",
-                    &active_viewports[main_viewport].frame_context.light_direction.x,
+                    &active_viewports[main_viewport].render_context.light_direction.x,
                     -1.0f,
                     1.0f
                 );
@@ -238,7 +516,23 @@ namespace Renderer
         if (m_resize_requested)
         {
             ResizeSwapchain();
-            return; // no render while resizing (or minimised!)
+            if (m_resize_requested)
+            {
+                return; // no render while minimised
+            }
+        }
+        for (PresentWindow& window : m_present_windows)
+        {
+            if (window.resize_requested)
+            {
+                ResizePresentWindow(window);
+            }
+        }
+
+        if (m_requested_frames_in_flight != FramesInFlight())
+        {
+            RecreateFrames(m_requested_frames_in_flight);
+            m_requested_frames_in_flight = FramesInFlight();
         }
 
         Draw();
@@ -251,9 +545,15 @@ namespace Renderer
         VkBufferUsageFlags usage,
         VmaMemoryUsage memory_usage,
         VmaAllocationCreateFlags allocation_flags,
-        const char* debug_name
+        const char* debug_name,
+        AllocationClass allocation_class
     )
     {
+        if (IsMovableClass(allocation_class))
+        {
+            usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        }
+
         VkBufferCreateInfo buffer_info{};
         buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         buffer_info.pNext = nullptr;
@@ -263,35 +563,68 @@ namespace Renderer
         VmaAllocationCreateInfo alloc_create_info{};
         alloc_create_info.usage = memory_usage;
         alloc_create_info.flags = allocation_flags;
+        alloc_create_info.pool = m_memory_pools.Pool(allocation_class);
         AllocatedBuffer buffer;
+        buffer.size = allocation_size;
+        buffer.usage = usage;
 
-        VK_CHECK(vmaCreateBuffer(
+        VkResult result = vmaCreateBuffer(
             m_allocator,
             &buffer_info,
             &alloc_create_info,
             &buffer.buffer,
             &buffer.allocation,
             &buffer.allocation_info
-        ));
+        );
+        if (result != VK_SUCCESS && alloc_create_info.pool != VK_NULL_HANDLE)
+        {
+            // the pool's memory type doesn't suit every buffer of the class, or its heap is full.
+            alloc_create_info.pool = VK_NULL_HANDLE;
+            result = vmaCreateBuffer(
+                m_allocator,
+                &buffer_info,
+                &alloc_create_info,
+                &buffer.buffer,
+                &buffer.allocation,
+                &buffer.allocation_info
+            );
+        }
+        VK_CHECK(result);
         SetAllocationName(buffer.allocation, debug_name);
 
-        return m_buffer_storage.AddResource(buffer, debug_name);
+        BufferHandle handle = m_buffer_storage.AddResource(buffer, debug_name);
+        if (alloc_create_info.pool != VK_NULL_HANDLE && IsMovableClass(allocation_class))
+        {
+            m_memory_pools.TrackBuffer(m_allocator, buffer.allocation, handle.id);
+        }
+
+        return handle;
     }
 
     BufferHandle VulkanEngine::CreateBuffer(
-        void* buffer_data, size_t buffer_size, VkBufferUsageFlags usage, const char* debug_name
+        void* buffer_data,
+        size_t buffer_size,
+        VkBufferUsageFlags usage,
+        const char* debug_name,
+        AllocationClass allocation_class
     )
     {
         // we set up the flags so that the memory can end up in either BAR or VRAM that is
         // inaccessible by host. If it ends up in bar, we can simply map it and copy into it. If
         // not, we need to create a staging buffer and upload it with a command.
-        VkBufferUsageFlags created_buffer_usage = usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        VkBufferUsageFlags created_buffer_usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         VmaMemoryUsage allocation_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
         VmaAllocationCreateFlags allocation_flags =
             VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
             VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
-        BufferHandle buffer =
-            CreateBuffer(buffer_size, created_buffer_usage, allocation_usage, allocation_flags, debug_name);
+        BufferHandle buffer = CreateBuffer(
+            buffer_size,
+            created_buffer_usage,
+            allocation_usage,
+            allocation_flags,
+            debug_name,
+            allocation_class
+        );
 
         VkMemoryPropertyFlags memory_properties;
         vmaGetAllocationMemoryProperties(m_allocator, buffer->allocation, &memory_properties);
@@ -303,12 +636,17 @@ namespace Renderer
         }
         else
         {
-            VkBufferUsageFlags staging_buffer_usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            VkBufferUsageFlags staging_buffer_usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
             VmaMemoryUsage staging_memory_usage = VMA_MEMORY_USAGE_AUTO;
             VmaAllocationCreateFlags allocation_flags =
                 VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
             BufferHandle staging_buffer = CreateBuffer(
-                buffer_size, staging_buffer_usage, staging_memory_usage, allocation_flags, debug_name
+                buffer_size,
+                staging_buffer_usage,
+                staging_memory_usage,
+                allocation_flags,
+                debug_name,
+                AllocationClass::Transient
             );
 
             vmaCopyMemoryToAllocation(m_allocator, buffer_data, staging_buffer->allocation, 0, buffer_size);
@@ -326,9 +664,24 @@ namespace Renderer
 
     void VulkanEngine::DestroyBuffer(const AllocatedBuffer& buffer)
     {
+        if (m_memory_pools.AbandonMove(buffer.allocation))
+        {
+            m_device_dispatch.destroyBuffer(buffer.buffer, nullptr);
+            return;
+        }
+
         vmaDestroyBuffer(m_allocator, buffer.buffer, buffer.allocation);
     }
 
+    VkDeviceAddress VulkanEngine::BufferDeviceAddress(const BufferHandle& buffer)
+    {
+        VkBufferDeviceAddressInfo device_address{};
+        device_address.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        device_address.pNext = nullptr;
+        device_address.buffer = buffer->buffer;
+        return m_device_dispatch.getBufferDeviceAddress(&device_address);
+    }
+
     ImageHandle VulkanEngine::AllocateImage(
         VkExtent3D image_extent,
         VkFormat format,
@@ -338,18 +691,20 @@ namespace Renderer
         VkMemoryPropertyFlags required_memory_flags,
         VmaAllocationCreateFlags allocation_flags,
         bool mipmapped,
-        const char* debug_name
+        const char* debug_name,
+        uint32_t mip_levels,
+        AllocationClass allocation_class
     )
     {
         AllocatedImage image{};
         image.image_extent = image_extent;
         image.image_format = format;
 
-        // if image debugging is enabled, any image might be sampled by imgui.
-        if (m_enable_image_debugging)
+        if (IsMovableClass(allocation_class))
         {
-            usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         }
+        image.image_usage = usage;
         VkImageCreateInfo image_info = Utils::ImageCreateInfo(format, usage, image_extent);
         if (mipmapped)
         {
@@ -358,15 +713,29 @@ namespace Renderer
             // more than 10 is useless though
             image_info.mipLevels = std::min(static_cast<uint32_t>(mipLevels), 10u);
         }
+        if (mip_levels != 0)
+        {
+            image_info.mipLevels = mip_levels;
+        }
+        image.mip_levels = image_info.mipLevels;
 
         VmaAllocationCreateInfo allocation_info{};
         allocation_info.usage = memory_usage;
         allocation_info.requiredFlags = required_memory_flags;
         allocation_info.flags = allocation_flags;
+        allocation_info.pool = m_memory_pools.Pool(allocation_class);
 
         VkResult result = vmaCreateImage(
             m_allocator, &image_info, &allocation_info, &image.image, &image.allocation, nullptr
         );
+        if (result != VK_SUCCESS && allocation_info.pool != VK_NULL_HANDLE)
+        {
+            // same as buffers, fall back to the default pools.
+            allocation_info.pool = VK_NULL_HANDLE;
+            result = vmaCreateImage(
+                m_allocator, &image_info, &allocation_info, &image.image, &image.allocation, nullptr
+            );
+        }
         VK_CHECK(result);
         SetAllocationName(image.allocation, debug_name);
 
@@ -375,10 +744,10 @@ namespace Renderer
         VK_CHECK(m_device_dispatch.createImageView(&image_view_info, nullptr, &image.image_view));
 
         ImageHandle handle = m_image_storage.AddResource(image, debug_name);
-
-        m_debug_image_map[handle->image] = ImGui_ImplVulkan_AddTexture(
-            m_default_sampler_nearest, handle->image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        );
+        if (allocation_info.pool != VK_NULL_HANDLE && IsMovableClass(allocation_class))
+        {
+            m_memory_pools.TrackImage(m_allocator, image.allocation, handle.id);
+        }
 
         return handle;
     }
@@ -390,7 +759,8 @@ namespace Renderer
         VkImageUsageFlags image_usage,
         VkImageLayout layout,
         bool mipmapped,
-        const char* debug_name
+        const char* debug_name,
+        AllocationClass allocation_class
     )
     {
         // we'll try to use the BAR, which is addressable by both CPU and GPU. If cannot use, we'll
@@ -402,6 +772,11 @@ namespace Renderer
         // because we might be allocating into non host visible memory, we need to make sure the target image
         // can be copied into
         VkImageUsageFlags target_image_usage = image_usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        if (mipmapped)
+        {
+            // the mips are blitted down from the uploaded one.
+            target_image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
         VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_AUTO;
         VkMemoryPropertyFlags required_memory_flags =
             0; // actually anything is fine, we want the most performant one
@@ -423,7 +798,9 @@ namespace Renderer
             required_memory_flags,
             allocation_flags,
             mipmapped,
-            debug_name
+            debug_name,
+            0,
+            allocation_class
         );
 
         VkMemoryPropertyFlags memory_properties;
@@ -432,8 +809,13 @@ namespace Renderer
         // since the wise allocator decided that the most optimal place for the image to be read from is
         // not host visible, we need to create a staging image that is visible on host and copy that over
         // with a command buffer.
-        BufferHandle staging_buffer =
-            CreateBuffer(image_data, image_data_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, debug_name);
+        BufferHandle staging_buffer = CreateBuffer(
+            image_data,
+            image_data_size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            debug_name,
+            AllocationClass::Transient
+        );
 
         std::unique_ptr<Utils::IUploadRequest> upload_request = std::make_unique<Utils::ImageUploadRequest>(
             image_extent, staging_buffer, image, Utils::UploadType::Deferred, layout, debug_name
@@ -446,42 +828,84 @@ namespace Renderer
     void VulkanEngine::DestroyImage(const AllocatedImage& image)
     {
         // nuke the debug image
-        if (m_debug_image_map.contains(image.image))
+        m_debug_textures.Forget(image.image, uint64_t(frame_number));
+
+        m_device_dispatch.destroyImageView(image.image_view, nullptr);
+        if (m_memory_pools.AbandonMove(image.allocation))
         {
-            ImGui_ImplVulkan_RemoveTexture(m_debug_image_map[image.image]);
-            m_debug_image_map.erase(image.image);
+            m_device_dispatch.destroyImage(image.image, nullptr);
+            return;
         }
 
-        m_device_dispatch.destroyImageView(image.image_view, nullptr);
         vmaDestroyImage(m_allocator, image.image, image.allocation);
     }
 
-    GPUMeshBuffers VulkanEngine::UploadMesh(std::span<uint32_t> indices, std::span<Vertex> vertices)
+    GPUMeshBuffers VulkanEngine::UploadMesh(
+        std::span<uint32_t> indices, std::span<Vertex> vertices, std::optional<VertexFormat> vertex_format
+    )
     {
-        const size_t vertex_buffer_size = vertices.size() * sizeof(Vertex);
+        GPUMeshBuffers buffers{};
+        buffers.bounds = Utils::ComputeMeshBounds(vertices);
+        buffers.vertex_format = VertexFormat::Standard;
+        if (vertex_format.has_value())
+        {
+            buffers.vertex_format = *vertex_format;
+        }
+        else if (m_compress_vertices)
+        {
+            buffers.vertex_format = Utils::SelectVertexFormat(vertices, buffers.bounds);
+        }
+
+        // standard vertices can be copied as they are, others need to be converted first.
+        std::vector<std::byte> packed_vertices;
+        std::span<const std::byte> vertex_data = std::as_bytes(vertices);
+        if (buffers.vertex_format != VertexFormat::Standard)
+        {
+            packed_vertices = Utils::PackVertices(vertices, buffers.vertex_format, buffers.bounds);
+            vertex_data = packed_vertices;
+        }
+
+        const size_t vertex_buffer_size = vertex_data.size();
         const size_t index_buffer_size = indices.size() * sizeof(uint32_t);
 
-        GPUMeshBuffers buffers{};
+        if (m_geometry_pool.Allocate(buffers, vertex_buffer_size, index_buffer_size) == false)
+        {
+            // storage and shader device address to make VB an SSBO that we can access through vertex
+            // pulling. Transfer so we can copy into them.
+            VkBufferUsageFlags vertex_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                              VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                              VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+            buffers.vertex_buffer = CreateBuffer(
+                vertex_buffer_size,
+                vertex_usage,
+                VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                0,
+                "buffer_mesh_vertex",
+                AllocationClass::Mesh
+            );
 
-        // storage and shader device address to make VB an SSBO that we can access through vertex
-        // pulling. Transfer so we can copy into them.
-        VkBufferUsageFlags vertex_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-                                          VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                          VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-        buffers.vertex_buffer = CreateBuffer(
-            vertex_buffer_size, vertex_usage, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, 0, "buffer_mesh_vertex"
-        );
+            buffers.vertex_buffer_address = BufferDeviceAddress(buffers.vertex_buffer);
 
-        VkBufferDeviceAddressInfo device_address{};
-        device_address.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
-        device_address.pNext = nullptr;
-        device_address.buffer = buffers.vertex_buffer->buffer;
-        buffers.vertex_buffer_address = m_device_dispatch.getBufferDeviceAddress(&device_address);
+            // the index buffer is also read as an SSBO by the meshlet culling pass.
+            VkBufferUsageFlags index_usage =
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+            buffers.index_buffer = CreateBuffer(
+                index_buffer_size,
+                index_usage,
+                VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                0,
+                "buffer_mesh_index",
+                AllocationClass::Mesh
+            );
+            buffers.index_buffer_address = BufferDeviceAddress(buffers.index_buffer);
+        }
 
-        VkBufferUsageFlags index_usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        buffers.index_buffer = CreateBuffer(
-            index_buffer_size, index_usage, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, 0, "buffer_mesh_index"
-        );
+        // nothing to upload for an empty mesh.
+        if (vertex_buffer_size + index_buffer_size == 0)
+        {
+            return buffers;
+        }
 
         // the buffers are created. Now we need to do the same thing basically and create a staging
         // buffer.
@@ -491,10 +915,13 @@ namespace Renderer
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VMA_MEMORY_USAGE_CPU_ONLY,
             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-            "buffer_mesh_staging"
+            "buffer_mesh_staging",
+            AllocationClass::Transient
         );
 
-        vmaCopyMemoryToAllocation(m_allocator, vertices.data(), staging->allocation, 0, vertex_buffer_size);
+        vmaCopyMemoryToAllocation(
+            m_allocator, vertex_data.data(), staging->allocation, 0, vertex_buffer_size
+        );
         vmaCopyMemoryToAllocation(
             m_allocator, indices.data(), staging->allocation, vertex_buffer_size, index_buffer_size
         );
@@ -510,6 +937,26 @@ namespace Renderer
         return buffers;
     }
 
+    void VulkanEngine::UploadMeshlets(GPUMeshBuffers& buffers, std::span<GPUMeshlet> meshlets)
+    {
+        if (meshlets.empty())
+        {
+            return;
+        }
+
+        VkBufferUsageFlags meshlet_usage =
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+        buffers.meshlet_buffer = CreateBuffer(
+            meshlets.data(),
+            meshlets.size_bytes(),
+            meshlet_usage,
+            "buffer_mesh_meshlets",
+            AllocationClass::Mesh
+        );
+        buffers.meshlet_buffer_address = BufferDeviceAddress(buffers.meshlet_buffer);
+        buffers.meshlet_count = static_cast<uint32_t>(meshlets.size());
+    }
+
     MeshHandle VulkanEngine::RegisterMeshAsset(MeshAsset&& asset, std::string_view debug_name)
     {
         return m_mesh_storage.AddResource(std::move(asset), debug_name);
@@ -541,14 +988,29 @@ namespace Renderer
         m_mesh_storage.DestroyPendingResources(*this);
     }
 
-    void VulkanEngine::FinishPendingUploads(VkCommandBuffer cmd)
+    void VulkanEngine::PrepareUploads()
     {
+        // uploads are requested from loading threads too. Taking them out of the pending list early means
+        // those threads don't wait for the frame to record them.
+        std::lock_guard lock(m_pending_upload_mutex);
+        m_frame_uploads.insert(
+            m_frame_uploads.end(),
+            std::make_move_iterator(m_pending_uploads.begin()),
+            std::make_move_iterator(m_pending_uploads.end())
+        );
+        m_pending_uploads.clear();
+    }
+
+    bool VulkanEngine::FinishPendingUploads(VkCommandBuffer cmd)
+    {
+        // anything requested since the frame was prepared.
+        PrepareUploads();
+        const bool any_uploads = m_frame_uploads.empty() == false;
+
         // some uploads might need to wait until next frame to execute
         std::vector<std::unique_ptr<Utils::IUploadRequest>> next_frame_uploads;
 
-        // consider using a double buffer instead. This might be a big wait.
-        std::lock_guard lock(m_pending_upload_mutex);
-        for (std::unique_ptr<Utils::IUploadRequest>& request : m_pending_uploads)
+        for (std::unique_ptr<Utils::IUploadRequest>& request : m_frame_uploads)
         {
             Utils::UploadExecutionResult result = request->ExecuteUpload(*this, cmd);
             if (result == Utils::UploadExecutionResult::RetryNextFrame)
@@ -581,11 +1043,10 @@ namespace Renderer
             );
         }
 
-        // nothing inside m_pending_uploads is valid anymore
-        m_pending_uploads.clear();
+        // nothing inside m_frame_uploads is valid anymore, the retried ones stay ahead of new requests.
+        m_frame_uploads = std::move(next_frame_uploads);
 
-        // move the next frame uploads into the pending uploads
-        m_pending_uploads = std::move(next_frame_uploads);
+        return any_uploads;
     }
 
     void VulkanEngine::ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function)
@@ -620,17 +1081,28 @@ namespace Renderer
 
     void VulkanEngine::Draw()
     {
+        const int64_t draw_start_us = FramePacingTimeMicroseconds();
+
         constexpr uint64_t one_second_ns = 1'000'000'000;
-        VK_CHECK(m_device_dispatch.waitForFences(1, &GetCurrentFrame().render_fence, true, one_second_ns));
-        VK_CHECK(m_device_dispatch.resetFences(1, &GetCurrentFrame().render_fence));
+        VkResult fence_result =
+            m_device_dispatch.waitForFences(1, &GetCurrentFrame().render_fence, true, one_second_ns);
+        const int64_t fence_wait_us = FramePacingTimeMicroseconds() - draw_start_us;
+        if (fence_result == VK_TIMEOUT)
+        {
+            return; // the GPU is still busy with this frame, try again next frame
+        }
+        VK_CHECK(fence_result);
 
         GetCurrentFrame().deletion_queue.Flush();
         GetCurrentFrame().buffers_in_use.clear();
         GetCurrentFrame().images_in_use.clear();
         GetCurrentFrame().frame_descriptors.ClearDescriptors(m_device_dispatch);
+        ReleaseRetiredResources(false);
+        m_debug_textures.ReleaseRetired(uint64_t(frame_number), FramesInFlight());
 
         // this is where we exterminate the resources pending destruction.
         DestroyPendingResources();
+        m_memory_tracker.Update(m_allocator, uint32_t(frame_number));
 
         uint32_t swapchain_image_index;
         VkResult result = m_device_dispatch.acquireNextImageKHR(
@@ -646,21 +1118,17 @@ namespace Renderer
             return; // try again next frame
         }
 
-        VkCommandBuffer cmd = GetCurrentFrame().command_buffer;
-        VK_CHECK(m_device_dispatch.resetCommandBuffer(cmd, 0));
-
-        VkCommandBufferBeginInfo cmdBeginInfo =
-            Utils::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-        VK_CHECK(m_device_dispatch.beginCommandBuffer(cmd, &cmdBeginInfo));
-        // COMMAND BEGIN
+        // only reset once the frame is going to be submitted, so returning early doesn't leave the fence
+        // unsignalled for the next wait.
+        VK_CHECK(m_device_dispatch.resetFences(1, &GetCurrentFrame().render_fence));
+        AcquirePresentWindowImages();
 
-        FinishPendingUploads(cmd);
+        // input handled since the last frame, the latency is measured once this frame is presented.
+        const int64_t input_us = m_input_latency.TakeInput();
 
-        // draw onto draw image.
-        for (size_t i = 0; i < active_viewports.size(); ++i)
+        // sized before anything is recorded, the async backgrounds only cover the draw extents.
+        for (Viewport& viewport : active_viewports)
         {
-            Viewport& viewport = active_viewports[i];
-
             // might be drawing on a subsection of the image.
             glm::vec2 viewport_extent = viewport.viewport_extent;
             if (viewport_extent.x == 0.0f && viewport_extent.y == 0.0f)
@@ -670,112 +1138,1199 @@ namespace Renderer
                 );
             }
 
-            viewport.draw_extent.height = uint32_t(viewport_extent.x * viewport.render_scale);
-            viewport.draw_extent.width = uint32_t(viewport_extent.y * viewport.render_scale);
-
-            VkImageLayout current = VK_IMAGE_LAYOUT_UNDEFINED;
-            VkImageLayout target = VK_IMAGE_LAYOUT_GENERAL;
-            Utils::TransitionImage(&m_device_dispatch, cmd, viewport.draw_image->image, current, target);
-            if (viewport.clear_before_draw)
-            {
-                VkClearColorValue clear_colour;
-                clear_colour.float32[0] = 0;
-                clear_colour.float32[1] = 0;
-                clear_colour.float32[2] = 0;
-                clear_colour.float32[3] = 0;
-                VkImageSubresourceRange range = Utils::SubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
-                m_device_dispatch.cmdClearColorImage(
-                    cmd, viewport.draw_image->image, target, &clear_colour, 1, &range
+            // the viewport's GPU time is from a previous frame, see GpuProfiler.
+            if (viewport.dynamic_resolution.enabled)
+            {
+                viewport.render_scale = viewport.dynamic_resolution.Update(
+                    viewport.render_scale, m_gpu_profiler.TimingMilliseconds(viewport.name)
                 );
             }
-            current = target;
-            target = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            Utils::TransitionImage(&m_device_dispatch, cmd, viewport.draw_image->image, current, target);
-            DrawViewportGeometry(viewport, cmd);
-            current = target;
-            target = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            Utils::TransitionImage(&m_device_dispatch, cmd, viewport.draw_image->image, current, target);
 
-            // clear the frame context so it's empty for the next frame
-            viewport.frame_context = {};
+            viewport.draw_extent.height = uint32_t(viewport_extent.x * viewport.render_scale);
+            viewport.draw_extent.width = uint32_t(viewport_extent.y * viewport.render_scale);
         }
 
-        // copy the main draw into swapchain
-        VkImageLayout current = VK_IMAGE_LAYOUT_UNDEFINED;
-        VkImageLayout target = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        Utils::TransitionImage(
-            &m_device_dispatch, cmd, m_swapchain_images[swapchain_image_index], current, target
-        );
-        Utils::CopyImageToImage(
-            &m_device_dispatch,
-            cmd,
-            active_viewports[main_viewport].draw_image->image,
-            m_swapchain_images[swapchain_image_index],
-            active_viewports[main_viewport].draw_extent,
-            m_swapchain_extent
-        );
-        current = target;
-        target = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        Utils::TransitionImage(
-            &m_device_dispatch, cmd, m_swapchain_images[swapchain_image_index], current, target
-        );
-        DrawImgui(cmd, m_swapchain_image_views[swapchain_image_index]);
-        current = target;
-        target = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        Utils::TransitionImage(
-            &m_device_dispatch, cmd, m_swapchain_images[swapchain_image_index], current, target
-        );
+        // submitted first so the compute queue can work on them while this frame's uploads and culling run.
+        const bool async_backgrounds = SubmitAsyncBackgrounds();
+
+        VkCommandBuffer cmd = GetCurrentFrame().command_buffer;
+        VK_CHECK(m_device_dispatch.resetCommandBuffer(cmd, 0));
+
+        VkCommandBufferBeginInfo cmdBeginInfo =
+            Utils::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        VK_CHECK(m_device_dispatch.beginCommandBuffer(cmd, &cmdBeginInfo));
+        // COMMAND BEGIN
+
+        m_gpu_profiler.BeginFrame(m_device_dispatch, cmd, uint32_t(frame_number % m_frames.size()));
+        const uint32_t frame_scope = m_gpu_profiler.BeginScope(m_device_dispatch, cmd, "frame");
+
+        const bool uploads_recorded = FinishPendingUploads(cmd);
+        m_texture_residency.Update(*this, cmd, m_memory_tracker);
+        m_virtual_texturing.Update(*this, cmd);
+        // frames that are streaming things in aren't idle.
+        m_memory_pools.Update(*this, cmd, uploads_recorded == false);
 
-        // if texture debugging, transition all draw images for viewports to shader read only.
-        if (m_enable_image_debugging)
+        // the rest of the frame is built as a render graph. It places the barriers between the passes and
+        // culls the passes whose results nothing uses.
+        m_render_graph.BeginFrame(uint32_t(frame_number % m_frames.size()));
+
+        // culling results are recorded by one pass and drawn with by the next ones.
+        struct ViewportDraws
+        {
+            MeshletDrawCommands meshlet_draws;
+            OcclusionDrawCommands occlusion_draws;
+        };
+        std::vector<ViewportDraws> viewport_draws(active_viewports.size());
+        std::vector<RenderGraphResource> draw_images(active_viewports.size());
+        for (size_t i = 0; i < active_viewports.size(); ++i)
         {
-            for (Viewport& viewport : active_viewports)
+            Viewport& viewport = active_viewports[i];
+            ViewportDraws& draws = viewport_draws[i];
+
+            // the viewport might have changed since the frame was prepared, or it wasn't prepared at all.
+            if (IsViewportPrepared(viewport) == false)
+            {
+                PrepareViewportDraws(viewport, nullptr);
+            }
+
+            // the previous frame might still be reading the draw image.
+            ImageState draw_state{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT };
+            const bool draw_background = viewport.compute_background && m_background.loaded;
+            if (draw_background && async_backgrounds)
             {
-                Utils::TransitionImage(
+                // the compute queue released it in the layout the geometry pass needs.
+                Utils::TransferImageOwnership(
                     &m_device_dispatch,
                     cmd,
                     viewport.draw_image->image,
-                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                    VK_IMAGE_LAYOUT_GENERAL,
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    m_compute_queue_family,
+                    m_graphics_queue_family,
+                    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                    false
                 );
+                draw_state = ImageState{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
             }
-        }
-
-        // COMMAND END
-        VK_CHECK(m_device_dispatch.endCommandBuffer(cmd));
 
+            const RenderGraphResource draw_image = m_render_graph.ImportImage(
+                viewport.name, viewport.draw_image->image, viewport.draw_image->image_view, draw_state
+            );
+            draw_images[i] = draw_image;
+
+            // only lives for the frame, viewports that aren't drawn at the same time share its memory.
+            TransientImageDesc depth_desc{};
+            depth_desc.extent = VkExtent2D{ viewport.draw_image->image_extent.width,
+                                            viewport.draw_image->image_extent.height };
+            depth_desc.format = VKENGINE_DEPTH_IMAGE_FORMAT;
+            // sampled by the depth pyramid reduction.
+            depth_desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            depth_desc.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+            depth_desc.name = "viewport depth";
+            const RenderGraphResource depth_image = m_render_graph.CreateImage(depth_desc);
+
+            if (draw_background && async_backgrounds == false)
+            {
+                m_render_graph
+                    .AddPass(
+                        viewport.name + " background",
+                        viewport.name,
+                        [this, &viewport](VkCommandBuffer cmd)
+                        {
+                            const uint32_t background_scope =
+                                m_gpu_profiler.BeginScope(m_device_dispatch, cmd, "background");
+                            DrawViewportBackground(viewport, cmd);
+                            m_gpu_profiler.EndScope(m_device_dispatch, cmd, background_scope);
+                        }
+                    )
+                    .Write(draw_image, ImageUsage::StorageWrite);
+            }
+            else if (draw_background == false && viewport.clear_before_draw)
+            {
+                m_render_graph
+                    .AddPass(
+                        viewport.name + " clear",
+                        viewport.name,
+                        [this, &viewport](VkCommandBuffer cmd)
+                        {
+                            VkClearColorValue clear_colour;
+                            clear_colour.float32[0] = 0;
+                            clear_colour.float32[1] = 0;
+                            clear_colour.float32[2] = 0;
+                            clear_colour.float32[3] = 0;
+                            VkImageSubresourceRange range =
+                                Utils::SubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
+                            m_device_dispatch.cmdClearColorImage(
+                                cmd,
+                                viewport.draw_image->image,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                &clear_colour,
+                                1,
+                                &range
+                            );
+                        }
+                    )
+                    .Write(draw_image, ImageUsage::TransferDst);
+            }
+
+            // the culling buffers aren't tracked by the graph, the virtual resources order the passes using
+            // them and keep the culling alive while something draws with it.
+            const RenderGraphResource early_culling =
+                m_render_graph.CreateVirtualResource(viewport.name + " early culling");
+            m_render_graph
+                .AddPass(
+                    viewport.name + " geometry",
+                    viewport.name,
+                    [this, &viewport, &draws, depth_image](VkCommandBuffer cmd)
+                    {
+                        // needs to happen outside of rendering, before the geometry pass reads the results.
+                        draws.meshlet_draws = CullViewportMeshlets(viewport, cmd);
+                        draws.occlusion_draws = CullViewportObjects(viewport, cmd);
+                        DrawViewportGeometry(
+                            viewport,
+                            cmd,
+                            m_render_graph.ImageView(depth_image),
+                            draws.meshlet_draws,
+                            draws.occlusion_draws,
+                            OcclusionPhase::Early
+                        );
+                    }
+                )
+                .Write(draw_image, ImageUsage::ColorAttachment)
+                .Write(depth_image, ImageUsage::DepthAttachment)
+                .Write(early_culling, ImageUsage::None);
+
+            if (UsesOcclusionCulling(viewport))
+            {
+                // reduce the depth of the early phase, then draw whatever it no longer occludes.
+                const RenderGraphResource late_culling =
+                    m_render_graph.CreateVirtualResource(viewport.name + " late culling");
+                m_render_graph
+                    .AddPass(
+                        viewport.name + " depth pyramid",
+                        viewport.name,
+                        [this, &viewport, &draws, depth_image](VkCommandBuffer cmd)
+                        {
+                            BuildDepthPyramid(viewport, cmd, m_render_graph.ImageView(depth_image));
+                            DispatchOcclusionCulling(
+                                viewport, cmd, draws.occlusion_draws, OcclusionPhase::Late
+                            );
+                        }
+                    )
+                    .Read(depth_image, ImageUsage::ComputeSampled)
+                    .Read(early_culling, ImageUsage::None)
+                    .Write(late_culling, ImageUsage::None);
+                m_render_graph
+                    .AddPass(
+                        viewport.name + " late geometry",
+                        viewport.name,
+                        [this, &viewport, &draws, depth_image](VkCommandBuffer cmd)
+                        {
+                            DrawViewportGeometry(
+                                viewport,
+                                cmd,
+                                m_render_graph.ImageView(depth_image),
+                                draws.meshlet_draws,
+                                draws.occlusion_draws,
+                                OcclusionPhase::Late
+                            );
+                        }
+                    )
+                    .Read(late_culling, ImageUsage::None)
+                    .Write(draw_image, ImageUsage::ColorAttachment)
+                    .Write(depth_image, ImageUsage::DepthAttachment);
+            }
+        }
+
+        for (const PresentWindow& window : m_present_windows)
+        {
+            if (window.acquired_image == PresentWindow::NO_IMAGE)
+            {
+                continue;
+            }
+
+            // the acquire semaphore is waited on at the blit, the first barrier has to wait for it as well.
+            const RenderGraphResource window_image = m_render_graph.ImportImage(
+                "present window",
+                window.swapchain_images[window.acquired_image],
+                VK_NULL_HANDLE,
+                ImageState{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_BLIT_BIT },
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+            );
+            m_render_graph
+                .AddPass(
+                    "present window",
+                    "",
+                    [this, &window](VkCommandBuffer cmd)
+                    {
+                        CopyToPresentWindow(cmd, window);
+                    }
+                )
+                .Read(draw_images[window.viewport], ImageUsage::TransferSrc)
+                .Write(window_image, ImageUsage::TransferDst);
+        }
+
+        // same for the acquire semaphore of the main swapchain.
+        const RenderGraphResource swapchain_image = m_render_graph.ImportImage(
+            "swapchain",
+            m_swapchain_images[swapchain_image_index],
+            m_swapchain_image_views[swapchain_image_index],
+            ImageState{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT },
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        );
+
+        // copy the main draw into swapchain, filtered if we can.
+        if (m_bicubic_upscale && m_upscale.loaded)
+        {
+            m_render_graph
+                .AddPass(
+                    "upscale",
+                    "",
+                    [this, swapchain_image](VkCommandBuffer cmd)
+                    {
+                        DrawUpscaledViewport(
+                            active_viewports[main_viewport], cmd, m_render_graph.ImageView(swapchain_image)
+                        );
+                    }
+                )
+                .Read(draw_images[main_viewport], ImageUsage::FragmentSampled)
+                .Write(swapchain_image, ImageUsage::ColorAttachment);
+        }
+        else
+        {
+            m_render_graph
+                .AddPass(
+                    "blit",
+                    "",
+                    [this, swapchain_image](VkCommandBuffer cmd)
+                    {
+                        Utils::CopyImageToImage(
+                            &m_device_dispatch,
+                            cmd,
+                            active_viewports[main_viewport].draw_image->image,
+                            m_render_graph.Image(swapchain_image),
+                            active_viewports[main_viewport].draw_extent,
+                            m_swapchain_extent
+                        );
+                    }
+                )
+                .Read(draw_images[main_viewport], ImageUsage::TransferSrc)
+                .Write(swapchain_image, ImageUsage::TransferDst);
+        }
+
+        RenderGraphPass& imgui_pass = m_render_graph.AddPass(
+            "imgui",
+            "",
+            [this, swapchain_image](VkCommandBuffer cmd)
+            {
+                DrawImgui(cmd, m_render_graph.ImageView(swapchain_image));
+            }
+        );
+        imgui_pass.Write(swapchain_image, ImageUsage::ColorAttachment);
+        // the resource debugger might display the draw images.
+        if (m_debug_textures.UsedInFrame(uint64_t(frame_number)))
+        {
+            for (RenderGraphResource draw_image : draw_images)
+            {
+                imgui_pass.Read(draw_image, ImageUsage::FragmentSampled);
+            }
+        }
+
+        m_render_graph.Execute(cmd, m_gpu_profiler);
+
+        m_virtual_texturing.EndFrame(m_device_dispatch, cmd);
+        m_gpu_profiler.EndScope(m_device_dispatch, cmd, frame_scope);
+
+        // COMMAND END
+        VK_CHECK(m_device_dispatch.endCommandBuffer(cmd));
+
+        VkCommandBufferSubmitInfo cmd_info = Utils::CommandBufferSubmitInfo(cmd);
+
+        // the main swapchain comes first, then every window that got an image this frame.
+        const size_t frame_slot = frame_number % m_frames.size();
+        std::vector<VkSemaphoreSubmitInfo> wait_infos{ Utils::SemaphoreSubmitInfo(
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, GetCurrentFrame().swapchain_semaphore
+        ) };
+        std::vector<VkSwapchainKHR> present_swapchains{ m_swapchain };
+        std::vector<uint32_t> present_image_indices{ swapchain_image_index };
+        std::vector<PresentWindow*> presented_windows{ nullptr };
+        for (PresentWindow& window : m_present_windows)
+        {
+            if (window.acquired_image == PresentWindow::NO_IMAGE)
+            {
+                continue;
+            }
+
+            // the copy into the window is a blit.
+            wait_infos.push_back(Utils::SemaphoreSubmitInfo(
+                VK_PIPELINE_STAGE_2_BLIT_BIT, window.acquire_semaphores[frame_slot]
+            ));
+            present_swapchains.push_back(window.swapchain);
+            present_image_indices.push_back(window.acquired_image);
+            presented_windows.push_back(&window);
+        }
+        if (async_backgrounds)
+        {
+            // the geometry passes draw onto the backgrounds.
+            wait_infos.push_back(Utils::SemaphoreSubmitInfo(
+                VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, GetCurrentFrame().background_semaphore
+            ));
+        }
+
+        std::vector<VkSemaphoreSubmitInfo> signal_infos{ Utils::SemaphoreSubmitInfo(
+            VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, GetCurrentFrame().render_semaphore
+        ) };
+        if (m_graphics_timeline != nullptr)
+        {
+            VkSemaphoreSubmitInfo timeline_info =
+                Utils::SemaphoreSubmitInfo(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_graphics_timeline);
+            timeline_info.value = ++m_graphics_submits;
+            signal_infos.push_back(timeline_info);
+        }
+
+        VkSubmitInfo2 submit_info = Utils::SubmitInfo(&cmd_info, signal_infos.data(), wait_infos.data());
+        submit_info.waitSemaphoreInfoCount = uint32_t(wait_infos.size());
+        submit_info.signalSemaphoreInfoCount = uint32_t(signal_infos.size());
+
+        VK_CHECK(
+            m_device_dispatch.queueSubmit2(m_graphics_queue, 1, &submit_info, GetCurrentFrame().render_fence)
+        );
+
+        // one present for every swapchain, they all wait for the same render semaphore.
+        std::vector<VkResult> present_results(present_swapchains.size(), VK_SUCCESS);
+        VkPresentInfoKHR present_info = Utils::PresentInfo(
+            present_swapchains.data(), &GetCurrentFrame().render_semaphore, present_image_indices.data()
+        );
+        present_info.swapchainCount = uint32_t(present_swapchains.size());
+        present_info.pResults = present_results.data();
+        m_device_dispatch.queuePresentKHR(m_graphics_queue, &present_info);
+        m_input_latency.RecordPresent(input_us);
+
+        // other windows are recreated before the next frame, the main window decides about this one.
+        std::vector<SDL_Window*> lost_windows{};
+        for (size_t i = 1; i < present_results.size(); ++i)
+        {
+            if (present_results[i] == VK_SUBOPTIMAL_KHR || present_results[i] == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                presented_windows[i]->resize_requested = true;
+            }
+            else if (present_results[i] != VK_SUCCESS)
+            {
+                // usually a lost surface, the window can't be presented to anymore.
+                PresentWindow& window = *presented_windows[i];
+                std::cerr << "[!] Can't present to window \"" << SDL_GetWindowTitle(window.window)
+                          << "\" anymore: " << string_VkResult(present_results[i]) << std::endl;
+                RetirePresentWindow(window);
+                lost_windows.push_back(window.window);
+            }
+        }
+        std::erase_if(
+            m_present_windows,
+            [&](const PresentWindow& window)
+            {
+                return std::find(lost_windows.begin(), lost_windows.end(), window.window) !=
+                       lost_windows.end();
+            }
+        );
+        result = present_results[0];
+
+        if (m_last_draw_us != 0)
+        {
+            m_requested_frames_in_flight = m_frames_in_flight_benchmark.Update(
+                FramesInFlight(),
+                double(draw_start_us - m_last_draw_us) / 1000.0,
+                double(fence_wait_us) / 1000.0,
+                m_gpu_profiler.TimingMilliseconds("frame")
+            );
+        }
+        m_last_draw_us = draw_start_us;
+        if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            m_resize_requested = true;
+            return;
+        }
+        else if (result != VK_SUCCESS)
+        {
+            abort(); // if this happens, investigate why the heck
+        }
+
+        ++frame_number;
+    }
+
+    void VulkanEngine::PrepareFrame(Jobs::JobSystem& job_system)
+    {
+        job_system.ParallelFor(
+            active_viewports.size(),
+            1,
+            [this, &job_system](size_t first_viewport, size_t last_viewport)
+            {
+                for (size_t i = first_viewport; i < last_viewport; ++i)
+                {
+                    PrepareViewportDraws(active_viewports[i], &job_system);
+                }
+            }
+        );
+    }
+
+    void VulkanEngine::PublishFrameContexts()
+    {
+        // nothing extracts the scene while the frame is published.
+        m_memory_pools.PublishMovedAddresses(*this);
+
+        for (Viewport& viewport : active_viewports)
+        {
+            std::swap(viewport.frame_context, viewport.render_context);
+
+            // the old snapshot becomes the next frame's context, keeping its render object allocation.
+            std::vector<RenderObject> render_objects = std::move(viewport.frame_context.render_objects);
+            render_objects.clear();
+            viewport.frame_context = {};
+            viewport.frame_context.render_objects = std::move(render_objects);
+            viewport.frame_context.draw_extent = viewport.draw_extent;
+            viewport.frame_context.lod_pixel_error = viewport.lod_pixel_error;
+
+            viewport.prepared_draws.prepared = false;
+        }
+    }
+
+    void VulkanEngine::PrepareViewportDraws(Viewport& viewport, Jobs::JobSystem* job_system)
+    {
+        const std::vector<RenderObject>& render_objects = viewport.render_context.render_objects;
+        const size_t object_count = render_objects.size();
+
+        PreparedDraws& prepared = viewport.prepared_draws;
+        prepared.prepared = true;
+        prepared.object_count = object_count;
+        prepared.meshlet_culling = viewport.meshlet_culling && m_meshlet_culling.loaded;
+        prepared.occlusion_culling = viewport.occlusion_culling && m_occlusion_culling.loaded;
+        prepared.meshlet_command_indices.assign(object_count, -1);
+        prepared.meshlet_commands.clear();
+        prepared.meshlet_index_count = 0;
+        prepared.occlusion_command_indices.assign(object_count, -1);
+        prepared.occlusion_spheres.clear();
+        prepared.occlusion_commands.clear();
+        prepared.draw_order.resize(object_count);
+
+        if (prepared.meshlet_culling)
+        {
+            // each culled object gets an index range as big as all of its meshlets, the shader fills it from
+            // the start with the visible ones and counts them in the indirect command.
+            for (size_t i = 0; i < object_count; ++i)
+            {
+                if (render_objects[i].meshlet_count == 0)
+                {
+                    continue;
+                }
+
+                VkDrawIndexedIndirectCommand command{};
+                command.indexCount = 0;
+                command.instanceCount = 1;
+                command.firstIndex = prepared.meshlet_index_count;
+                command.vertexOffset = 0;
+                command.firstInstance = 0;
+
+                prepared.meshlet_command_indices[i] = int32_t(prepared.meshlet_commands.size());
+                prepared.meshlet_commands.emplace_back(command);
+                prepared.meshlet_index_count += render_objects[i].index_count;
+            }
+        }
+
+        // pooled meshes come first so the index buffer of the geometry pool is only bound once, then meshes
+        // with buffers of their own and the culled meshlets last.
+        const VkBuffer pool_index_buffer =
+            m_geometry_pool.IndexBuffer().IsValid() ? m_geometry_pool.IndexBuffer()->buffer : VK_NULL_HANDLE;
+        const auto index_buffer_group = [&](uint32_t object) -> std::pair<uint32_t, VkBuffer>
+        {
+            if (prepared.meshlet_command_indices[object] >= 0)
+            {
+                return { 2, VK_NULL_HANDLE };
+            }
+            const VkBuffer index_buffer = render_objects[object].index_buffer;
+            return { index_buffer == pool_index_buffer ? 0 : 1, index_buffer };
+        };
+        std::iota(prepared.draw_order.begin(), prepared.draw_order.end(), 0u);
+        std::stable_sort(
+            prepared.draw_order.begin(),
+            prepared.draw_order.end(),
+            [&](uint32_t a, uint32_t b)
+            {
+                const auto [a_group, a_buffer] = index_buffer_group(a);
+                const auto [b_group, b_buffer] = index_buffer_group(b);
+                if (a_group != b_group)
+                {
+                    return a_group < b_group;
+                }
+                return std::less<VkBuffer>{}(a_buffer, b_buffer);
+            }
+        );
+
+        if (prepared.occlusion_culling == false)
+        {
+            return;
+        }
+
+        // the spheres are the expensive part and independent of each other, the compaction after is cheap.
+        std::vector<glm::vec4> bounding_spheres(object_count);
+        const auto compute_spheres = [&](size_t first_object, size_t last_object)
+        {
+            for (size_t i = first_object; i < last_object; ++i)
+            {
+                const RenderObject& render_object = render_objects[i];
+                const glm::vec3 scale{ glm::length(glm::vec3(render_object.transform[0])),
+                                       glm::length(glm::vec3(render_object.transform[1])),
+                                       glm::length(glm::vec3(render_object.transform[2])) };
+                const float max_scale = std::max(std::max(scale.x, scale.y), scale.z);
+                const glm::vec4 centre =
+                    render_object.transform * glm::vec4(render_object.bounds.Centre(), 1.0f);
+                const float radius = glm::length(render_object.bounds.Extent()) * 0.5f * max_scale;
+                bounding_spheres[i] = glm::vec4(glm::vec3(centre), radius);
+            }
+        };
+        constexpr size_t objects_per_job = 256;
+        if (job_system != nullptr)
+        {
+            job_system->ParallelFor(object_count, objects_per_job, compute_spheres);
+        }
+        else
+        {
+            compute_spheres(0, object_count);
+        }
+
+        // objects with culled meshlets are already culled against the frustum and always drawn early so
+        // they can occlude everything else.
+        for (size_t i = 0; i < object_count; ++i)
+        {
+            if (prepared.meshlet_command_indices[i] >= 0)
+            {
+                continue;
+            }
+
+            const RenderObject& render_object = render_objects[i];
+            VkDrawIndexedIndirectCommand command{};
+            command.indexCount = render_object.index_count;
+            command.instanceCount = 0; // set by the culling pass
+            command.firstIndex = render_object.first_index;
+            command.vertexOffset = 0;
+            command.firstInstance = 0;
+
+            prepared.occlusion_command_indices[i] = int32_t(prepared.occlusion_commands.size());
+            prepared.occlusion_spheres.push_back(bounding_spheres[i]);
+            prepared.occlusion_commands.push_back(command);
+        }
+    }
+
+    bool VulkanEngine::IsViewportPrepared(const Viewport& viewport) const
+    {
+        const PreparedDraws& prepared = viewport.prepared_draws;
+        const size_t object_count = viewport.render_context.render_objects.size();
+        return prepared.prepared && prepared.object_count == object_count &&
+               prepared.meshlet_culling == (viewport.meshlet_culling && m_meshlet_culling.loaded) &&
+               prepared.occlusion_culling == (viewport.occlusion_culling && m_occlusion_culling.loaded);
+    }
+
+    bool VulkanEngine::UsesOcclusionCulling(const Viewport& viewport) const
+    {
+        return viewport.prepared_draws.occlusion_commands.empty() == false &&
+               viewport.draw_extent.width != 0 && viewport.draw_extent.height != 0;
+    }
+
+    bool VulkanEngine::SubmitAsyncBackgrounds()
+    {
+        if (m_async_background == false || m_compute_queue == nullptr || m_background.loaded == false)
+        {
+            return false;
+        }
+        const bool any_background = std::any_of(
+            active_viewports.begin(),
+            active_viewports.end(),
+            [](const Viewport& viewport)
+            {
+                return viewport.compute_background;
+            }
+        );
+        if (any_background == false)
+        {
+            return false;
+        }
+
+        FrameData& frame = GetCurrentFrame();
+        VkCommandBuffer cmd = frame.compute_command_buffer;
+        VK_CHECK(m_device_dispatch.resetCommandBuffer(cmd, 0));
+
+        VkCommandBufferBeginInfo cmdBeginInfo =
+            Utils::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        VK_CHECK(m_device_dispatch.beginCommandBuffer(cmd, &cmdBeginInfo));
+
+        for (const Viewport& viewport : active_viewports)
+        {
+            if (viewport.compute_background == false)
+            {
+                continue;
+            }
+
+            // the contents of the last frame are overwritten, no need to take them over from graphics.
+            Utils::TransitionImage(
+                &m_device_dispatch,
+                cmd,
+                viewport.draw_image->image,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_GENERAL
+            );
+            DrawViewportBackground(viewport, cmd);
+            Utils::TransferImageOwnership(
+                &m_device_dispatch,
+                cmd,
+                viewport.draw_image->image,
+                VK_IMAGE_LAYOUT_GENERAL,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                m_compute_queue_family,
+                m_graphics_queue_family,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                true
+            );
+        }
+
+        VK_CHECK(m_device_dispatch.endCommandBuffer(cmd));
+
+        // the draw images are shared between frames, the previous frame has to be done reading them.
+        VkSemaphoreSubmitInfo wait_info =
+            Utils::SemaphoreSubmitInfo(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_graphics_timeline);
+        wait_info.value = m_graphics_submits;
+        VkSemaphoreSubmitInfo signal_info =
+            Utils::SemaphoreSubmitInfo(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, frame.background_semaphore);
         VkCommandBufferSubmitInfo cmd_info = Utils::CommandBufferSubmitInfo(cmd);
+        VkSubmitInfo2 submit_info = Utils::SubmitInfo(&cmd_info, &signal_info, &wait_info);
+
+        // no fence, the graphics submit of the frame waits for it and the frame fence covers both.
+        VK_CHECK(m_device_dispatch.queueSubmit2(m_compute_queue, 1, &submit_info, nullptr));
+        return true;
+    }
+
+    void VulkanEngine::DrawViewportBackground(const Viewport& viewport, VkCommandBuffer cmd)
+    {
+        const ComputeEffect& effect =
+            m_background.effects[std::min(m_current_effect, m_background.effects.size() - 1)];
+
+        VkDescriptorSet image_descriptor =
+            GetCurrentFrame().frame_descriptors.Allocate(m_device_dispatch, m_background.descriptor_layout);
+        Utils::DescriptorWriter writer{};
+        writer.WriteImage(
+            0,
+            viewport.draw_image->image_view,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_NULL_HANDLE,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+        );
+        writer.UpdateSet(m_device_dispatch, image_descriptor);
+
+        m_device_dispatch.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, effect.pipeline);
+        m_device_dispatch.cmdBindDescriptorSets(
+            cmd, VK_PIPELINE_BIND_POINT_COMPUTE, effect.layout, 0, 1, &image_descriptor, 0, nullptr
+        );
+        m_device_dispatch.cmdPushConstants(
+            cmd,
+            effect.layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(BackgroundPushConstants),
+            &effect.push_constants
+        );
+
+        // only the part of the image the viewport draws this frame.
+        constexpr uint32_t group_size = BackgroundPass::WORKGROUP_SIZE;
+        m_device_dispatch.cmdDispatch(
+            cmd,
+            (viewport.draw_extent.width + group_size - 1) / group_size,
+            (viewport.draw_extent.height + group_size - 1) / group_size,
+            1
+        );
+    }
+
+    MeshletDrawCommands VulkanEngine::CullViewportMeshlets(const Viewport& viewport, VkCommandBuffer cmd)
+    {
+        const std::vector<RenderObject>& render_objects = viewport.render_context.render_objects;
+        const PreparedDraws& prepared = viewport.prepared_draws;
+
+        MeshletDrawCommands meshlet_draws{};
+        meshlet_draws.command_indices = prepared.meshlet_command_indices;
+        const std::vector<VkDrawIndexedIndirectCommand>& commands = prepared.meshlet_commands;
+        const uint32_t total_index_count = prepared.meshlet_index_count;
+        if (commands.empty())
+        {
+            return meshlet_draws;
+        }
+
+        meshlet_draws.index_buffer = CreateBuffer(
+            total_index_count * sizeof(uint32_t),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0,
+            "meshlet index buffer"
+        );
+        meshlet_draws.command_buffer = CreateBuffer(
+            commands.size() * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "meshlet draw command buffer"
+        );
+        BufferHandle cull_data_buffer = CreateBuffer(
+            sizeof(GPUMeshletCullData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "meshlet cull data buffer"
+        );
+        // delete them next frame
+        GetCurrentFrame().buffers_in_use.emplace_back(meshlet_draws.index_buffer);
+        GetCurrentFrame().buffers_in_use.emplace_back(meshlet_draws.command_buffer);
+        GetCurrentFrame().buffers_in_use.emplace_back(cull_data_buffer);
+
+        const FrameDrawContext& context = viewport.render_context;
+        const glm::mat4 view_projection = ViewportProjection(viewport) * context.ViewMatrix();
+        GPUMeshletCullData cull_data =
+            MeshletCullingPass::CullData(view_projection, context.CameraWorldPosition());
+        vmaCopyMemoryToAllocation(
+            m_allocator, &cull_data, cull_data_buffer->allocation, 0, sizeof(cull_data)
+        );
+        vmaCopyMemoryToAllocation(
+            m_allocator,
+            commands.data(),
+            meshlet_draws.command_buffer->allocation,
+            0,
+            commands.size() * sizeof(VkDrawIndexedIndirectCommand)
+        );
+
+        const VkDeviceAddress output_index_buffer_address = BufferDeviceAddress(meshlet_draws.index_buffer);
+        const VkDeviceAddress command_buffer_address = BufferDeviceAddress(meshlet_draws.command_buffer);
+        const VkDeviceAddress cull_data_address = BufferDeviceAddress(cull_data_buffer);
+
+        m_device_dispatch.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_meshlet_culling.pipeline);
+        for (size_t i = 0; i < render_objects.size(); ++i)
+        {
+            const int32_t command_index = meshlet_draws.command_indices[i];
+            if (command_index < 0)
+            {
+                continue;
+            }
+
+            const RenderObject& render_object = render_objects[i];
+
+            GPUMeshletCullPushConstants push_constants{};
+            push_constants.world_matrix = render_object.transform;
+            push_constants.meshlet_buffer_address = render_object.meshlet_buffer_address;
+            push_constants.index_buffer_address = render_object.index_buffer_address;
+            push_constants.output_index_buffer_address = output_index_buffer_address;
+            push_constants.draw_command_address =
+                command_buffer_address + command_index * sizeof(VkDrawIndexedIndirectCommand);
+            push_constants.cull_data_address = cull_data_address;
+            push_constants.first_meshlet = render_object.first_meshlet;
+            push_constants.meshlet_count = render_object.meshlet_count;
+
+            m_device_dispatch.cmdPushConstants(
+                cmd,
+                m_meshlet_culling.layout,
+                VK_SHADER_STAGE_COMPUTE_BIT,
+                0,
+                sizeof(push_constants),
+                &push_constants
+            );
+            const VkExtent2D group_count = MeshletCullingPass::DispatchSize(render_object.meshlet_count);
+            m_device_dispatch.cmdDispatch(cmd, group_count.width, group_count.height, 1);
+        }
+
+        // the geometry pass reads the written indices and commands.
+        Utils::GlobalMemoryBarrier(
+            &m_device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+            VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT
+        );
+
+        return meshlet_draws;
+    }
+
+    OcclusionDrawCommands VulkanEngine::CullViewportObjects(Viewport& viewport, VkCommandBuffer cmd)
+    {
+        const std::vector<RenderObject>& render_objects = viewport.render_context.render_objects;
+        const PreparedDraws& prepared = viewport.prepared_draws;
+        const std::vector<glm::vec4>& bounding_spheres = prepared.occlusion_spheres;
+        const std::vector<VkDrawIndexedIndirectCommand>& commands = prepared.occlusion_commands;
+
+        OcclusionDrawCommands occlusion_draws{};
+        if (UsesOcclusionCulling(viewport) == false)
+        {
+            occlusion_draws.command_indices.assign(render_objects.size(), -1);
+            return occlusion_draws;
+        }
+        occlusion_draws.command_indices = prepared.occlusion_command_indices;
+
+        occlusion_draws.object_count = uint32_t(commands.size());
+        const size_t command_buffer_size = commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+        const VkBufferUsageFlags command_buffer_usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+        occlusion_draws.object_buffer = CreateBuffer(
+            bounding_spheres.size() * sizeof(glm::vec4),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "occlusion object buffer"
+        );
+        occlusion_draws.cull_data_buffer = CreateBuffer(
+            sizeof(GPUOcclusionCullData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "occlusion cull data buffer"
+        );
+        occlusion_draws.early_command_buffer = CreateBuffer(
+            command_buffer_size,
+            command_buffer_usage,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "occlusion early draw command buffer"
+        );
+        occlusion_draws.late_command_buffer = CreateBuffer(
+            command_buffer_size,
+            command_buffer_usage,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            "occlusion late draw command buffer"
+        );
+        // delete them next frame
+        GetCurrentFrame().buffers_in_use.emplace_back(occlusion_draws.object_buffer);
+        GetCurrentFrame().buffers_in_use.emplace_back(occlusion_draws.cull_data_buffer);
+        GetCurrentFrame().buffers_in_use.emplace_back(occlusion_draws.early_command_buffer);
+        GetCurrentFrame().buffers_in_use.emplace_back(occlusion_draws.late_command_buffer);
+
+        UpdateDepthPyramid(viewport, cmd);
+        UpdateObjectVisibility(viewport, cmd, occlusion_draws.object_count);
+
+        const glm::mat4 view = viewport.render_context.ViewMatrix();
+        const glm::mat4 projection = ViewportProjection(viewport);
+        const GPUMeshletCullData frustum = MeshletCullingPass::CullData(
+            projection * view, viewport.render_context.CameraWorldPosition()
+        );
+
+        GPUOcclusionCullData cull_data{};
+        cull_data.view = view;
+        std::copy(
+            std::begin(frustum.frustum_planes), std::end(frustum.frustum_planes), cull_data.frustum_planes
+        );
+        cull_data.projection =
+            glm::vec4(projection[0][0], std::abs(projection[1][1]), projection[2][2], projection[3][2]);
+        cull_data.pyramid_size =
+            glm::vec2(viewport.depth_pyramid.extent.width, viewport.depth_pyramid.extent.height);
+        cull_data.near_plane = VKENGINE_CAMERA_NEAR_PLANE;
+        cull_data.pyramid_mip_count = viewport.depth_pyramid.mip_count;
+
+        vmaCopyMemoryToAllocation(
+            m_allocator, &cull_data, occlusion_draws.cull_data_buffer->allocation, 0, sizeof(cull_data)
+        );
+        vmaCopyMemoryToAllocation(
+            m_allocator,
+            bounding_spheres.data(),
+            occlusion_draws.object_buffer->allocation,
+            0,
+            bounding_spheres.size() * sizeof(glm::vec4)
+        );
+        for (const BufferHandle* command_buffer :
+             { &occlusion_draws.early_command_buffer, &occlusion_draws.late_command_buffer })
+        {
+            vmaCopyMemoryToAllocation(
+                m_allocator, commands.data(), (*command_buffer)->allocation, 0, command_buffer_size
+            );
+        }
+
+        DispatchOcclusionCulling(viewport, cmd, occlusion_draws, OcclusionPhase::Early);
+
+        return occlusion_draws;
+    }
+
+    void VulkanEngine::DispatchOcclusionCulling(
+        Viewport& viewport,
+        VkCommandBuffer cmd,
+        const OcclusionDrawCommands& occlusion_draws,
+        OcclusionPhase phase
+    )
+    {
+        VkDescriptorSet pyramid_descriptor = GetCurrentFrame().frame_descriptors.Allocate(
+            m_device_dispatch, m_occlusion_culling.cull_descriptor_layout
+        );
+        Utils::DescriptorWriter writer{};
+        writer.WriteImage(
+            0,
+            viewport.depth_pyramid.image->image_view,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            m_default_sampler_nearest,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        );
+        writer.UpdateSet(m_device_dispatch, pyramid_descriptor);
+
+        GPUOcclusionCullPushConstants push_constants{};
+        push_constants.object_buffer_address = BufferDeviceAddress(occlusion_draws.object_buffer);
+        push_constants.draw_command_address = BufferDeviceAddress(
+            phase == OcclusionPhase::Early ? occlusion_draws.early_command_buffer
+                                           : occlusion_draws.late_command_buffer
+        );
+        push_constants.visibility_address = BufferDeviceAddress(viewport.object_visibility);
+        push_constants.cull_data_address = BufferDeviceAddress(occlusion_draws.cull_data_buffer);
+        push_constants.object_count = occlusion_draws.object_count;
+        push_constants.phase = phase;
+
+        m_device_dispatch.cmdBindPipeline(
+            cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_occlusion_culling.cull_pipeline
+        );
+        m_device_dispatch.cmdBindDescriptorSets(
+            cmd,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            m_occlusion_culling.cull_layout,
+            0,
+            1,
+            &pyramid_descriptor,
+            0,
+            nullptr
+        );
+        m_device_dispatch.cmdPushConstants(
+            cmd,
+            m_occlusion_culling.cull_layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(push_constants),
+            &push_constants
+        );
+        m_device_dispatch.cmdDispatch(cmd, (occlusion_draws.object_count + 63) / 64, 1, 1);
+
+        // the geometry pass reads the commands, the next culling pass reads and writes the visibility.
+        Utils::GlobalMemoryBarrier(
+            &m_device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        );
+    }
+
+    void VulkanEngine::UpdateObjectVisibility(Viewport& viewport, VkCommandBuffer cmd, uint32_t object_count)
+    {
+        if (viewport.object_visibility_count == object_count)
+        {
+            return;
+        }
+
+        // objects are matched to last frame's visibility by index, so a different count is likely a different
+        // set of objects. Start over with everything visible, the late phase fixes it up this frame.
+        if (viewport.object_visibility.IsValid())
+        {
+            GetCurrentFrame().buffers_in_use.emplace_back(viewport.object_visibility);
+        }
+        viewport.object_visibility = CreateBuffer(
+            object_count * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0,
+            "object visibility buffer"
+        );
+        viewport.object_visibility_count = object_count;
+
+        m_device_dispatch.cmdFillBuffer(cmd, viewport.object_visibility->buffer, 0, VK_WHOLE_SIZE, 1);
+        Utils::GlobalMemoryBarrier(
+            &m_device_dispatch,
+            cmd,
+            VK_PIPELINE_STAGE_2_CLEAR_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        );
+    }
+
+    void VulkanEngine::UpdateDepthPyramid(Viewport& viewport, VkCommandBuffer cmd)
+    {
+        DepthPyramid& pyramid = viewport.depth_pyramid;
+        const VkExtent2D extent = OcclusionCullingPass::PyramidExtent(viewport.draw_extent);
+        if (pyramid.image.IsValid() && pyramid.extent.width == extent.width &&
+            pyramid.extent.height == extent.height)
+        {
+            return;
+        }
+
+        if (pyramid.image.IsValid())
+        {
+            // the previous frame might still be reading it.
+            GetCurrentFrame().images_in_use.emplace_back(pyramid.image);
+            GetCurrentFrame().deletion_queue.PushFunction(
+                "depth pyramid views",
+                [this, views = pyramid.mip_views]()
+                {
+                    for (VkImageView view : views)
+                    {
+                        m_device_dispatch.destroyImageView(view, nullptr);
+                    }
+                }
+            );
+        }
+
+        pyramid = {};
+        pyramid.extent = extent;
+        pyramid.mip_count = OcclusionCullingPass::PyramidMipCount(extent);
+        pyramid.image = AllocateImage(
+            VkExtent3D{ extent.width, extent.height, 1 },
+            VKENGINE_DEPTH_PYRAMID_FORMAT,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            0,
+            false,
+            "image_depth_pyramid",
+            pyramid.mip_count
+        );
+
+        for (uint32_t mip = 0; mip < pyramid.mip_count; ++mip)
+        {
+            VkImageViewCreateInfo view_info = Utils::ImageViewCreateInfo(
+                VKENGINE_DEPTH_PYRAMID_FORMAT, pyramid.image->image, VK_IMAGE_ASPECT_COLOR_BIT
+            );
+            view_info.subresourceRange.baseMipLevel = mip;
+            view_info.subresourceRange.levelCount = 1;
+            VkImageView& view = pyramid.mip_views.emplace_back();
+            VK_CHECK(m_device_dispatch.createImageView(&view_info, nullptr, &view));
+        }
 
-        VkSemaphoreSubmitInfo wait_info = Utils::SemaphoreSubmitInfo(
-            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, GetCurrentFrame().swapchain_semaphore
-        );
-        VkSemaphoreSubmitInfo signal_info = Utils::SemaphoreSubmitInfo(
-            VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, GetCurrentFrame().render_semaphore
+        // the pyramid stays readable outside of BuildDepthPyramid.
+        Utils::TransitionImage(
+            &m_device_dispatch,
+            cmd,
+            pyramid.image->image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
         );
+    }
 
-        VkSubmitInfo2 submit_info = Utils::SubmitInfo(&cmd_info, &signal_info, &wait_info);
+    void VulkanEngine::BuildDepthPyramid(Viewport& viewport, VkCommandBuffer cmd, VkImageView depth_view)
+    {
+        DepthPyramid& pyramid = viewport.depth_pyramid;
+        Utils::TransitionImage(
+            &m_device_dispatch,
+            cmd,
+            pyramid.image->image,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_GENERAL
+        );
 
-        VK_CHECK(
-            m_device_dispatch.queueSubmit2(m_graphics_queue, 1, &submit_info, GetCurrentFrame().render_fence)
+        m_device_dispatch.cmdBindPipeline(
+            cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_occlusion_culling.pyramid_pipeline
         );
 
-        VkPresentInfoKHR present_info =
-            Utils::PresentInfo(&m_swapchain, &GetCurrentFrame().render_semaphore, &swapchain_image_index);
-        result = m_device_dispatch.queuePresentKHR(m_graphics_queue, &present_info);
-        if (result == VK_SUBOPTIMAL_KHR)
+        // every mip reduces the previous one, mip 0 reduces the depth image.
+        VkExtent2D source_size = viewport.draw_extent;
+        for (uint32_t mip = 0; mip < pyramid.mip_count; ++mip)
         {
-            m_resize_requested = true;
-            return;
-        }
-        else if (result != VK_SUCCESS)
-        {
-            abort(); // if this happens, investigate why the heck
+            const VkExtent2D destination_size{ std::max(pyramid.extent.width >> mip, 1u),
+                                               std::max(pyramid.extent.height >> mip, 1u) };
+
+            VkDescriptorSet descriptor = GetCurrentFrame().frame_descriptors.Allocate(
+                m_device_dispatch, m_occlusion_culling.pyramid_descriptor_layout
+            );
+            Utils::DescriptorWriter writer{};
+            writer.WriteImage(
+                0,
+                mip == 0 ? depth_view : pyramid.mip_views[mip - 1],
+                mip == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL,
+                m_default_sampler_nearest,
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+            );
+            writer.WriteImage(
+                1,
+                pyramid.mip_views[mip],
+                VK_IMAGE_LAYOUT_GENERAL,
+                VK_NULL_HANDLE,
+                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+            );
+            writer.UpdateSet(m_device_dispatch, descriptor);
+
+            GPUDepthPyramidPushConstants push_constants{};
+            push_constants.source_size = glm::uvec2(source_size.width, source_size.height);
+            push_constants.destination_size = glm::uvec2(destination_size.width, destination_size.height);
+
+            m_device_dispatch.cmdBindDescriptorSets(
+                cmd,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                m_occlusion_culling.pyramid_layout,
+                0,
+                1,
+                &descriptor,
+                0,
+                nullptr
+            );
+            m_device_dispatch.cmdPushConstants(
+                cmd,
+                m_occlusion_culling.pyramid_layout,
+                VK_SHADER_STAGE_COMPUTE_BIT,
+                0,
+                sizeof(push_constants),
+                &push_constants
+            );
+            m_device_dispatch.cmdDispatch(
+                cmd, (destination_size.width + 7) / 8, (destination_size.height + 7) / 8, 1
+            );
+
+            // the next mip reads this one.
+            Utils::GlobalMemoryBarrier(
+                &m_device_dispatch,
+                cmd,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_SAMPLED_READ_BIT
+            );
+            source_size = destination_size;
         }
 
-        ++frame_number;
+        Utils::TransitionImage(
+            &m_device_dispatch,
+            cmd,
+            pyramid.image->image,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+    }
+
+    glm::mat4 VulkanEngine::ViewportProjection(const Viewport& viewport) const
+    {
+        glm::mat4 projection = glm::perspective(
+            glm::radians(viewport.render_context.camera_vertical_fov),
+            (float)viewport.draw_extent.width / (float)viewport.draw_extent.height,
+            VKENGINE_CAMERA_FAR_PLANE,
+            VKENGINE_CAMERA_NEAR_PLANE
+        );
+
+        // invert the Y direction on projection matrix so that we are more similar
+        // to opengl and gltf axis
+        projection[1][1] *= -1;
+
+        return projection;
     }
 
-    void VulkanEngine::DrawViewportGeometry(const Viewport& viewport, VkCommandBuffer cmd)
+    void VulkanEngine::DrawViewportGeometry(
+        const Viewport& viewport,
+        VkCommandBuffer cmd,
+        VkImageView depth_view,
+        const MeshletDrawCommands& meshlet_draws,
+        const OcclusionDrawCommands& occlusion_draws,
+        OcclusionPhase phase
+    )
     {
         // create the scene data!
         // cpu to gpu so we can skip uploading it. Hopefully the data is small enough to fit in the
@@ -790,26 +2345,24 @@ namespace Renderer
         // delete it next frame
         GetCurrentFrame().buffers_in_use.emplace_back(scene_data_buffer);
 
-        glm::mat4 view =
-            viewport.frame_context.camera_rotation * glm::translate(viewport.frame_context.camera_position);
-        glm::mat4 projection = glm::perspective(
-            glm::radians(viewport.frame_context.camera_vertical_fov),
-            (float)viewport.draw_extent.width / (float)viewport.draw_extent.height,
-            10000.f,
-            0.1f
-        );
-
-        // invert the Y direction on projection matrix so that we are more similar
-        // to opengl and gltf axis
-        projection[1][1] *= -1;
+        glm::mat4 view = viewport.render_context.ViewMatrix();
+        glm::mat4 projection = ViewportProjection(viewport);
 
         GPUSceneData scene_data{};
         scene_data.view = view;
         scene_data.projection = projection;
         scene_data.view_projection = projection * view;
-        scene_data.ambient_colour = viewport.frame_context.ambient_colour;
-        scene_data.light_colour = viewport.frame_context.light_colour;
-        scene_data.light_direction = viewport.frame_context.light_direction;
+        scene_data.ambient_colour = viewport.render_context.ambient_colour;
+        scene_data.light_colour = viewport.render_context.light_colour;
+        scene_data.light_direction = viewport.render_context.light_direction;
+        const VkDeviceAddress page_table_address = m_virtual_texturing.PageTableAddress();
+        const VkDeviceAddress feedback_address = m_virtual_texturing.FeedbackAddress();
+        scene_data.virtual_texturing = glm::uvec4(
+            uint32_t(page_table_address),
+            uint32_t(page_table_address >> 32),
+            uint32_t(feedback_address),
+            uint32_t(feedback_address >> 32)
+        );
 
         vmaCopyMemoryToAllocation(
             m_allocator, &scene_data, scene_data_buffer->allocation, 0, sizeof(scene_data)
@@ -824,6 +2377,14 @@ namespace Renderer
         writer.WriteBuffer(
             0, scene_data_buffer->buffer, sizeof(GPUSceneData), 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
         );
+        // the virtual texture cache is fetched texel by texel, its tiles have no border to filter across.
+        writer.WriteImage(
+            1,
+            m_virtual_texturing.CacheView(),
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            m_default_sampler_nearest,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        );
         writer.UpdateSet(m_device_dispatch, scene_data_descriptor);
 
         VkViewport vk_viewport{};
@@ -842,29 +2403,115 @@ namespace Renderer
 
         m_device_dispatch.cmdSetScissor(cmd, 0, 1, &scissor);
 
-        VkRenderingAttachmentInfo color_attachment =
-            Utils::AttachmentInfo(viewport.draw_image->image_view, nullptr);
-
         VkClearValue clear_value{};
         clear_value.depthStencil.depth = 0.0f; // zero is far in reversed depth
 
+        // the late phase draws on top of the depth of the early phase.
+        VkClearValue* depth_clear = phase == OcclusionPhase::Early ? &clear_value : nullptr;
+
+        if (viewport.depth_prepass)
+        {
+            const uint32_t prepass_scope =
+                m_gpu_profiler.BeginScope(m_device_dispatch, cmd, viewport.name + " depth pre-pass");
+
+            VkRenderingAttachmentInfo depth_attachment = Utils::AttachmentInfo(
+                depth_view, depth_clear, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+            );
+            VkRenderingInfo render_info =
+                Utils::RenderingInfo(nullptr, &depth_attachment, viewport.draw_extent);
+
+            m_device_dispatch.cmdBeginRendering(cmd, &render_info);
+            DrawRenderObjects(
+                viewport, cmd, scene_data_descriptor, meshlet_draws, occlusion_draws, phase, true
+            );
+            m_device_dispatch.cmdEndRendering(cmd);
+
+            m_gpu_profiler.EndScope(m_device_dispatch, cmd, prepass_scope);
+
+            // the colour pass tests against the pre-pass depth.
+            Utils::GlobalMemoryBarrier(
+                &m_device_dispatch,
+                cmd,
+                VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+            );
+            depth_clear = nullptr;
+        }
+
+        const uint32_t colour_scope =
+            m_gpu_profiler.BeginScope(m_device_dispatch, cmd, viewport.name + " colour");
+
+        VkRenderingAttachmentInfo color_attachment =
+            Utils::AttachmentInfo(viewport.draw_image->image_view, nullptr);
         VkRenderingAttachmentInfo depth_attachment = Utils::AttachmentInfo(
-            viewport.depth_image->image_view, &clear_value, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+            depth_view, depth_clear, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
         );
 
         VkRenderingInfo render_info =
             Utils::RenderingInfo(&color_attachment, &depth_attachment, viewport.draw_extent);
 
         m_device_dispatch.cmdBeginRendering(cmd, &render_info);
+        DrawRenderObjects(viewport, cmd, scene_data_descriptor, meshlet_draws, occlusion_draws, phase, false);
+        m_device_dispatch.cmdEndRendering(cmd);
+
+        m_gpu_profiler.EndScope(m_device_dispatch, cmd, colour_scope);
+    }
+
+    void VulkanEngine::DrawRenderObjects(
+        const Viewport& viewport,
+        VkCommandBuffer cmd,
+        VkDescriptorSet scene_data_descriptor,
+        const MeshletDrawCommands& meshlet_draws,
+        const OcclusionDrawCommands& occlusion_draws,
+        OcclusionPhase phase,
+        bool depth_only
+    )
+    {
+        // the draw order groups the objects by index buffer, so each one is only bound once.
+        VkBuffer bound_index_buffer = VK_NULL_HANDLE;
+        const auto bind_index_buffer = [&](VkBuffer index_buffer)
+        {
+            if (index_buffer != bound_index_buffer)
+            {
+                m_device_dispatch.cmdBindIndexBuffer(cmd, index_buffer, 0, VK_INDEX_TYPE_UINT32);
+                bound_index_buffer = index_buffer;
+            }
+        };
 
-        for (const RenderObject& render_object : viewport.frame_context.render_objects)
+        for (uint32_t i : viewport.prepared_draws.draw_order)
         {
+            // only occlusion culled objects can become visible in the late phase.
+            const int32_t occlusion_command = occlusion_draws.command_indices[i];
+            if (phase == OcclusionPhase::Late && occlusion_command < 0)
+            {
+                continue;
+            }
+
+            const RenderObject& render_object = viewport.render_context.render_objects[i];
+            const MaterialPipeline& material_pipeline = *render_object.material->pipeline;
+            render_object.material->last_drawn_frame = uint64_t(frame_number);
+
+            // the pre-pass only draws what can be shaded with an equal depth test afterwards.
+            VkPipeline pipeline = material_pipeline.pipeline;
+            if (depth_only)
+            {
+                pipeline = material_pipeline.depth_prepass_pipeline;
+                if (pipeline == VK_NULL_HANDLE)
+                {
+                    continue;
+                }
+            }
+            else if (viewport.depth_prepass && material_pipeline.depth_equal_pipeline != VK_NULL_HANDLE)
+            {
+                pipeline = material_pipeline.depth_equal_pipeline;
+            }
+
             std::array<VkDescriptorSet, 2> sets{ scene_data_descriptor,
                                                  render_object.material->material_set };
 
-            m_device_dispatch.cmdBindPipeline(
-                cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, render_object.material->pipeline->pipeline
-            );
+            m_device_dispatch.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
             m_device_dispatch.cmdBindDescriptorSets(
                 cmd,
@@ -881,6 +2528,9 @@ namespace Renderer
             push_constants.opacity = 1.0f;
             push_constants.vertex_buffer_address = render_object.vertex_buffer_address;
             push_constants.world_matrix = render_object.transform;
+            push_constants.vertex_format = render_object.vertex_format;
+            push_constants.position_offset = glm::vec4(render_object.bounds.min, 0.0f);
+            push_constants.position_scale = glm::vec4(render_object.bounds.Extent(), 0.0f);
 
             m_device_dispatch.cmdPushConstants(
                 cmd,
@@ -891,14 +2541,95 @@ namespace Renderer
                 &push_constants
             );
 
-            m_device_dispatch.cmdBindIndexBuffer(cmd, render_object.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+            // culled objects draw the visible meshlets the culling pass wrote out for them.
+            const int32_t meshlet_command = meshlet_draws.command_indices[i];
+            if (meshlet_command >= 0)
+            {
+                bind_index_buffer(meshlet_draws.index_buffer->buffer);
+                m_device_dispatch.cmdDrawIndexedIndirect(
+                    cmd,
+                    meshlet_draws.command_buffer->buffer,
+                    meshlet_command * sizeof(VkDrawIndexedIndirectCommand),
+                    1,
+                    sizeof(VkDrawIndexedIndirectCommand)
+                );
+                continue;
+            }
+
+            bind_index_buffer(render_object.index_buffer);
+
+            // occlusion culled objects have their instance count set by the culling pass of this phase.
+            if (occlusion_command >= 0)
+            {
+                const BufferHandle& command_buffer = phase == OcclusionPhase::Early
+                                                         ? occlusion_draws.early_command_buffer
+                                                         : occlusion_draws.late_command_buffer;
+                m_device_dispatch.cmdDrawIndexedIndirect(
+                    cmd,
+                    command_buffer->buffer,
+                    occlusion_command * sizeof(VkDrawIndexedIndirectCommand),
+                    1,
+                    sizeof(VkDrawIndexedIndirectCommand)
+                );
+                continue;
+            }
 
             m_device_dispatch.cmdDrawIndexed(
                 cmd, render_object.index_count, 1, render_object.first_index, 0, 0
             );
         }
+    }
+
+    void VulkanEngine::DrawUpscaledViewport(
+        const Viewport& viewport, VkCommandBuffer cmd, VkImageView target_image_view
+    )
+    {
+        const uint32_t upscale_scope = m_gpu_profiler.BeginScope(m_device_dispatch, cmd, "upscale");
 
+        VkDescriptorSet source_descriptor =
+            GetCurrentFrame().frame_descriptors.Allocate(m_device_dispatch, m_upscale.descriptor_layout);
+        Utils::DescriptorWriter writer{};
+        writer.WriteImage(
+            0,
+            viewport.draw_image->image_view,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            m_default_sampler_linear,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        );
+        writer.UpdateSet(m_device_dispatch, source_descriptor);
+
+        VkViewport vk_viewport{};
+        vk_viewport.width = float(m_swapchain_extent.width);
+        vk_viewport.height = float(m_swapchain_extent.height);
+        vk_viewport.minDepth = 0.0f;
+        vk_viewport.maxDepth = 1.0f;
+        m_device_dispatch.cmdSetViewport(cmd, 0, 1, &vk_viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = VkOffset2D{ 0, 0 };
+        scissor.extent = m_swapchain_extent;
+        m_device_dispatch.cmdSetScissor(cmd, 0, 1, &scissor);
+
+        GPUUpscalePushConstants push_constants{};
+        push_constants.source_size =
+            glm::vec2(viewport.draw_image->image_extent.width, viewport.draw_image->image_extent.height);
+        push_constants.draw_extent = glm::vec2(viewport.draw_extent.width, viewport.draw_extent.height);
+
+        VkRenderingAttachmentInfo attachment_info = Utils::AttachmentInfo(target_image_view, nullptr);
+        VkRenderingInfo rendering_info = Utils::RenderingInfo(&attachment_info, nullptr, m_swapchain_extent);
+
+        m_device_dispatch.cmdBeginRendering(cmd, &rendering_info);
+        m_device_dispatch.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_upscale.pipeline);
+        m_device_dispatch.cmdBindDescriptorSets(
+            cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_upscale.layout, 0, 1, &source_descriptor, 0, nullptr
+        );
+        m_device_dispatch.cmdPushConstants(
+            cmd, m_upscale.layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_constants), &push_constants
+        );
+        m_device_dispatch.cmdDraw(cmd, 3, 1, 0, 0);
         m_device_dispatch.cmdEndRendering(cmd);
+
+        m_gpu_profiler.EndScope(m_device_dispatch, cmd, upscale_scope);
     }
 
     void VulkanEngine::DrawImgui(VkCommandBuffer cmd, VkImageView target_image_view)
@@ -952,15 +2683,25 @@ namespace Renderer
         features12.bufferDeviceAddress = true;
         features12.descriptorIndexing = true;
         features12.descriptorBindingSampledImageUpdateAfterBind = true;
+        features12.timelineSemaphore = true; // the async backgrounds wait for graphics submits with one
+
+        // the glTF PBR fragment shader writes virtual texture feedback.
+        VkPhysicalDeviceFeatures features{};
+        features.fragmentStoresAndAtomics = true;
 
         vkb::PhysicalDeviceSelector selector(vkb_instance);
         vkb::PhysicalDevice vkb_gpu = selector.set_minimum_version(1, 3)
+                                          .set_required_features(features)
                                           .set_required_features_13(features13)
                                           .set_required_features_12(features12)
                                           .set_surface(m_surface)
+                                          .add_desired_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
                                           .select()
                                           .value();
 
+        // lets VMA query the real budget of every heap instead of estimating it from the heap sizes.
+        m_memory_budget_supported = vkb_gpu.is_extension_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
         vkb::DeviceBuilder deviceBuilder(vkb_gpu);
         vkb::Device vkb_device = deviceBuilder.build().value();
 
@@ -968,165 +2709,332 @@ namespace Renderer
         m_device = vkb_device.device;
         m_device_dispatch = vkb::DispatchTable(m_device, vkb_device.fp_vkGetDeviceProcAddr);
 
-        m_graphics_queue = vkb_device.get_queue(vkb::QueueType::graphics).value();
-        m_graphics_queue_family = vkb_device.get_queue_index(vkb::QueueType::graphics).value();
+        m_graphics_queue = vkb_device.get_queue(vkb::QueueType::graphics).value();
+        m_graphics_queue_family = vkb_device.get_queue_index(vkb::QueueType::graphics).value();
+
+        // vkb only hands out compute queues of families other than the graphics one, ideally one without
+        // graphics support at all. Backgrounds stay on the graphics queue without one.
+        auto compute_queue = vkb_device.get_dedicated_queue(vkb::QueueType::compute);
+        auto compute_queue_family = vkb_device.get_dedicated_queue_index(vkb::QueueType::compute);
+        if (compute_queue.has_value() == false)
+        {
+            compute_queue = vkb_device.get_queue(vkb::QueueType::compute);
+            compute_queue_family = vkb_device.get_queue_index(vkb::QueueType::compute);
+        }
+        if (compute_queue.has_value() && compute_queue_family.has_value())
+        {
+            m_compute_queue = compute_queue.value();
+            m_compute_queue_family = compute_queue_family.value();
+        }
+        else
+        {
+            std::cout << "[*] No separate compute queue, backgrounds are drawn on the graphics queue."
+                      << std::endl;
+        }
+
+        m_gpu_profiler.Init(
+            m_device_dispatch,
+            FramesInFlight(),
+            vkb_gpu.properties.limits.timestampComputeAndGraphics == VK_TRUE,
+            vkb_gpu.properties.limits.timestampPeriod
+        );
+        m_deletion_queue.PushFunction(
+            "gpu profiler",
+            [this]()
+            {
+                m_gpu_profiler.Destroy(m_device_dispatch);
+            }
+        );
+
+        // make sure we destroy the surface when we're done
+        m_deletion_queue.PushFunction(
+            "main surface",
+            [this]()
+            {
+                m_instance_dispatch.destroySurfaceKHR(m_surface, nullptr);
+            }
+        );
+
+        return true;
+    }
+
+    void VulkanEngine::InitAllocator()
+    {
+        VmaVulkanFunctions vulkan_functions{};
+        vulkan_functions.vkGetInstanceProcAddr = m_get_instance_proc_addr;
+        vulkan_functions.vkGetDeviceProcAddr = m_get_device_proc_addr;
+
+        VmaAllocatorCreateInfo allocator_info{};
+        allocator_info.instance = m_instance;
+        allocator_info.device = m_device;
+        allocator_info.physicalDevice = m_gpu;
+        // VMA assumes 1.0 otherwise and looks up the KHR entry points of what is core in 1.3.
+        allocator_info.vulkanApiVersion = VK_API_VERSION_1_3;
+        allocator_info.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+        if (m_memory_budget_supported)
+        {
+            allocator_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
+        allocator_info.pVulkanFunctions = &vulkan_functions;
+        vmaCreateAllocator(&allocator_info, &m_allocator);
+        m_memory_tracker.Init(m_allocator, m_memory_budget_supported);
+        m_memory_pools.Init(m_allocator);
+
+        m_deletion_queue.PushFunction(
+            "vmaAllocator",
+            [this]()
+            {
+                vmaDestroyAllocator(m_allocator);
+            }
+        );
+        // pools are destroyed before the allocator, once the storages freed their allocations.
+        m_deletion_queue.PushFunction(
+            "memory pools",
+            [this]()
+            {
+                m_memory_pools.Destroy(m_allocator);
+            }
+        );
+    }
+
+    void VulkanEngine::InitCommands()
+    {
+        VkCommandPoolCreateInfo commandPoolInfo = Utils::CommandPoolCreateInfo(
+            m_graphics_queue_family, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+        );
+
+        // immediate command buffer for short tasks
+        VK_CHECK(m_device_dispatch.createCommandPool(&commandPoolInfo, nullptr, &m_immediate_command_pool));
+        VkCommandBufferAllocateInfo cmdAllocInfo =
+            Utils::CommandBufferAllocateInfo(m_immediate_command_pool, 1);
+        VK_CHECK(m_device_dispatch.allocateCommandBuffers(&cmdAllocInfo, &m_immediate_command_buffer));
+        m_deletion_queue.PushFunction(
+            "Immediate command pool",
+            [this]()
+            {
+                m_device_dispatch.destroyCommandPool(m_immediate_command_pool, nullptr);
+            }
+        );
+    }
+
+    void VulkanEngine::InitSyncStructures()
+    {
+        VkFenceCreateInfo fenceCreateInfo = Utils::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+
+        // immediate command buffer for short tasks
+        VK_CHECK(m_device_dispatch.createFence(&fenceCreateInfo, nullptr, &m_immediate_fence));
+        m_deletion_queue.PushFunction(
+            "Immediate fence",
+            [this]()
+            {
+                m_device_dispatch.destroyFence(m_immediate_fence, nullptr);
+            }
+        );
+
+        if (m_compute_queue == nullptr)
+        {
+            return;
+        }
+
+        VkSemaphoreTypeCreateInfo timeline_info{};
+        timeline_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timeline_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timeline_info.initialValue = 0;
+        VkSemaphoreCreateInfo semaphoreCreateInfo = Utils::SemaphoreCreateInfo(0);
+        semaphoreCreateInfo.pNext = &timeline_info;
+        VK_CHECK(m_device_dispatch.createSemaphore(&semaphoreCreateInfo, nullptr, &m_graphics_timeline));
+        m_deletion_queue.PushFunction(
+            "graphics timeline",
+            [this]()
+            {
+                m_device_dispatch.destroySemaphore(m_graphics_timeline, nullptr);
+            }
+        );
+    }
+
+    void VulkanEngine::InitSceneDescriptors()
+    {
+        // create the layout
+        Utils::DescriptorLayoutBuilder builder;
+        builder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        builder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER); // virtual texture cache
+
+        // all stages maybe a bit heavy-handed but meh
+        m_scene_data_descriptor_layout = builder.Build(m_device_dispatch, VK_SHADER_STAGE_ALL_GRAPHICS);
 
-        // make sure we destroy the surface when we're done
         m_deletion_queue.PushFunction(
-            "main surface",
+            "scene descriptor layout",
             [this]()
             {
-                m_instance_dispatch.destroySurfaceKHR(m_surface, nullptr);
+                m_device_dispatch.destroyDescriptorSetLayout(m_scene_data_descriptor_layout, nullptr);
             }
         );
-
-        return true;
     }
 
-    void VulkanEngine::InitAllocator()
+    void VulkanEngine::InitFrames()
     {
-        VmaVulkanFunctions vulkan_functions{};
-        vulkan_functions.vkGetInstanceProcAddr = m_get_instance_proc_addr;
-        vulkan_functions.vkGetDeviceProcAddr = m_get_device_proc_addr;
-
-        VmaAllocatorCreateInfo allocator_info{};
-        allocator_info.instance = m_instance;
-        allocator_info.device = m_device;
-        allocator_info.physicalDevice = m_gpu;
-        allocator_info.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
-        allocator_info.pVulkanFunctions = &vulkan_functions;
-        vmaCreateAllocator(&allocator_info, &m_allocator);
+        for (FrameData& frame : m_frames)
+        {
+            InitFrame(frame);
+        }
 
+        // the frames can be recreated at runtime, so whatever frames exist at shutdown are destroyed.
         m_deletion_queue.PushFunction(
-            "vmaAllocator",
+            "frames",
             [this]()
             {
-                vmaDestroyAllocator(m_allocator);
+                for (FrameData& frame : m_frames)
+                {
+                    DestroyFrame(frame);
+                }
+                m_frames.clear();
             }
         );
     }
 
-    void VulkanEngine::InitCommands()
+    void VulkanEngine::InitFrame(FrameData& frame)
     {
         VkCommandPoolCreateInfo commandPoolInfo = Utils::CommandPoolCreateInfo(
             m_graphics_queue_family, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
         );
+        VK_CHECK(m_device_dispatch.createCommandPool(&commandPoolInfo, nullptr, &frame.command_pool));
+
+        VkCommandBufferAllocateInfo cmdAllocInfo = Utils::CommandBufferAllocateInfo(frame.command_pool, 1);
+        VK_CHECK(m_device_dispatch.allocateCommandBuffers(&cmdAllocInfo, &frame.command_buffer));
+
+        VkFenceCreateInfo fenceCreateInfo = Utils::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+        VkSemaphoreCreateInfo semaphoreCreateInfo = Utils::SemaphoreCreateInfo(0);
+        VK_CHECK(m_device_dispatch.createFence(&fenceCreateInfo, nullptr, &frame.render_fence));
+        VK_CHECK(
+            m_device_dispatch.createSemaphore(&semaphoreCreateInfo, nullptr, &frame.swapchain_semaphore)
+        );
+        VK_CHECK(m_device_dispatch.createSemaphore(&semaphoreCreateInfo, nullptr, &frame.render_semaphore));
 
-        for (std::size_t i = 0; i < FRAME_OVERLAP; ++i)
+        if (m_compute_queue != nullptr)
         {
+            VkCommandPoolCreateInfo computePoolInfo = Utils::CommandPoolCreateInfo(
+                m_compute_queue_family, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+            );
             VK_CHECK(
-                m_device_dispatch.createCommandPool(&commandPoolInfo, nullptr, &m_frames[i].command_pool)
+                m_device_dispatch.createCommandPool(&computePoolInfo, nullptr, &frame.compute_command_pool)
             );
-
-            VkCommandBufferAllocateInfo cmdAllocInfo =
-                Utils::CommandBufferAllocateInfo(m_frames[i].command_pool, 1);
-
-            VK_CHECK(m_device_dispatch.allocateCommandBuffers(&cmdAllocInfo, &m_frames[i].command_buffer));
-
-            m_deletion_queue.PushFunction(
-                "command pool",
-                [i, this]()
-                {
-                    m_device_dispatch.destroyCommandPool(m_frames[i].command_pool, nullptr);
-                }
+            VkCommandBufferAllocateInfo computeAllocInfo =
+                Utils::CommandBufferAllocateInfo(frame.compute_command_pool, 1);
+            VK_CHECK(
+                m_device_dispatch.allocateCommandBuffers(&computeAllocInfo, &frame.compute_command_buffer)
+            );
+            VK_CHECK(
+                m_device_dispatch.createSemaphore(&semaphoreCreateInfo, nullptr, &frame.background_semaphore)
             );
         }
 
-        // immediate command buffer for short tasks
-        VK_CHECK(m_device_dispatch.createCommandPool(&commandPoolInfo, nullptr, &m_immediate_command_pool));
-        VkCommandBufferAllocateInfo cmdAllocInfo =
-            Utils::CommandBufferAllocateInfo(m_immediate_command_pool, 1);
-        VK_CHECK(m_device_dispatch.allocateCommandBuffers(&cmdAllocInfo, &m_immediate_command_buffer));
-        m_deletion_queue.PushFunction(
-            "Immediate command pool",
-            [this]()
-            {
-                m_device_dispatch.destroyCommandPool(m_immediate_command_pool, nullptr);
-            }
-        );
+        constexpr uint32_t frame_inital_sets = 32;
+        // scene data uniforms, the virtual texture cache, the images of the occlusion culling passes and the
+        // draw images the backgrounds write
+        std::vector<Utils::DescriptorPoolSizeRatio> sizes{
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+            { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 },
+        };
+        frame.frame_descriptors.Init(m_device_dispatch, frame_inital_sets, sizes);
     }
 
-    void VulkanEngine::InitSyncStructures()
+    void VulkanEngine::DestroyFrame(FrameData& frame)
     {
-        VkFenceCreateInfo fenceCreateInfo = Utils::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-        VkSemaphoreCreateInfo semaphoreCreateInfo = Utils::SemaphoreCreateInfo(0);
-
-        for (std::size_t i = 0; i < FRAME_OVERLAP; ++i)
+        // resources the frame kept alive go first, they might be the last references.
+        frame.deletion_queue.Flush();
+        frame.buffers_in_use.clear();
+        frame.images_in_use.clear();
+
+        frame.frame_descriptors.DestroyPools(m_device_dispatch);
+        m_device_dispatch.destroySemaphore(frame.render_semaphore, nullptr);
+        m_device_dispatch.destroySemaphore(frame.swapchain_semaphore, nullptr);
+        m_device_dispatch.destroyFence(frame.render_fence, nullptr);
+        m_device_dispatch.destroyCommandPool(frame.command_pool, nullptr);
+        if (frame.compute_command_pool != nullptr)
         {
-            VK_CHECK(m_device_dispatch.createFence(&fenceCreateInfo, nullptr, &m_frames[i].render_fence));
+            m_device_dispatch.destroySemaphore(frame.background_semaphore, nullptr);
+            m_device_dispatch.destroyCommandPool(frame.compute_command_pool, nullptr);
+        }
+    }
 
-            m_deletion_queue.PushFunction(
-                "fence",
-                [i, this]()
-                {
-                    m_device_dispatch.destroyFence(m_frames[i].render_fence, nullptr);
-                }
-            );
+    void VulkanEngine::RecreateFrames(uint32_t frames_in_flight)
+    {
+        m_device_dispatch.deviceWaitIdle();
 
-            VK_CHECK(m_device_dispatch.createSemaphore(
-                &semaphoreCreateInfo, nullptr, &m_frames[i].swapchain_semaphore
-            ));
-            VK_CHECK(m_device_dispatch.createSemaphore(
-                &semaphoreCreateInfo, nullptr, &m_frames[i].render_semaphore
-            ));
+        for (FrameData& frame : m_frames)
+        {
+            DestroyFrame(frame);
+        }
 
-            m_deletion_queue.PushFunction(
-                "semaphores x2",
-                [i, this]()
-                {
-                    m_device_dispatch.destroySemaphore(m_frames[i].render_semaphore, nullptr);
-                    m_device_dispatch.destroySemaphore(m_frames[i].swapchain_semaphore, nullptr);
-                }
-            );
+        m_frames = std::vector<FrameData>(std::clamp(frames_in_flight, 1u, MAX_FRAME_OVERLAP));
+        for (FrameData& frame : m_frames)
+        {
+            InitFrame(frame);
         }
 
-        // immediate command buffer for short tasks
-        VK_CHECK(m_device_dispatch.createFence(&fenceCreateInfo, nullptr, &m_immediate_fence));
+        m_gpu_profiler.SetFrameCount(m_device_dispatch, FramesInFlight());
+        m_render_graph.SetFrameCount(FramesInFlight());
+    }
+
+    void VulkanEngine::InitDefaultDescriptors() {}
+
+    bool VulkanEngine::InitPipelines()
+    {
+        // meshlet culling is optional, viewports fall back to drawing everything without it.
+        if (m_meshlet_culling.BuildPipelines(m_device_dispatch) == false)
+        {
+            std::cerr << "[!] Meshlet culling is unavailable." << std::endl;
+        }
         m_deletion_queue.PushFunction(
-            "Immediate fence",
+            "meshlet culling",
             [this]()
             {
-                m_device_dispatch.destroyFence(m_immediate_fence, nullptr);
+                m_meshlet_culling.DestroyResources(m_device_dispatch);
             }
         );
-    }
 
-    void VulkanEngine::InitFrameDescriptors()
-    {
-        for (size_t i = 0; i < FRAME_OVERLAP; ++i)
+        // the main viewport is blitted to the swapchain without upscaling.
+        if (m_upscale.BuildPipelines(m_device_dispatch, m_swapchain_format) == false)
         {
-            constexpr uint32_t frame_inital_sets = 32;
-            // only uniform buffers for now
-            std::vector<Utils::DescriptorPoolSizeRatio> sizes{ { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 } };
-            m_frames[i].frame_descriptors.Init(m_device_dispatch, frame_inital_sets, sizes);
-            m_deletion_queue.PushFunction(
-                "frame descriptors",
-                [i, this]()
-                {
-                    m_frames[i].frame_descriptors.DestroyPools(m_device_dispatch);
-                }
-            );
+            std::cerr << "[!] Upscaling is unavailable." << std::endl;
         }
+        m_deletion_queue.PushFunction(
+            "upscale pass",
+            [this]()
+            {
+                m_upscale.DestroyResources(m_device_dispatch);
+            }
+        );
 
-        // create the layout
-        Utils::DescriptorLayoutBuilder builder;
-        builder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-
-        // all stages maybe a bit heavy-handed but meh
-        m_scene_data_descriptor_layout = builder.Build(m_device_dispatch, VK_SHADER_STAGE_ALL_GRAPHICS);
-
+        // viewports clear their draw images instead.
+        if (m_background.BuildPipelines(m_device_dispatch) == false)
+        {
+            std::cerr << "[!] Compute backgrounds are unavailable." << std::endl;
+        }
         m_deletion_queue.PushFunction(
-            "scene descriptor layout",
+            "background pass",
             [this]()
             {
-                m_device_dispatch.destroyDescriptorSetLayout(m_scene_data_descriptor_layout, nullptr);
+                m_background.DestroyResources(m_device_dispatch);
             }
         );
-    }
 
-    void VulkanEngine::InitDefaultDescriptors() {}
+        // same for occlusion culling.
+        if (m_occlusion_culling.BuildPipelines(m_device_dispatch) == false)
+        {
+            std::cerr << "[!] Occlusion culling is unavailable." << std::endl;
+        }
+        m_deletion_queue.PushFunction(
+            "occlusion culling",
+            [this]()
+            {
+                m_occlusion_culling.DestroyResources(m_device_dispatch);
+            }
+        );
 
-    bool VulkanEngine::InitPipelines() { return InitMaterialPipelines(); }
+        return InitMaterialPipelines();
+    }
 
     bool VulkanEngine::InitMaterialPipelines()
     {
@@ -1156,12 +3064,15 @@ namespace Renderer
 
     void VulkanEngine::InitDefaultData()
     {
+        m_geometry_pool.Init(*this);
+
         // Create the default samplers
         VkSamplerCreateInfo sampler_create_info{};
         sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
         sampler_create_info.magFilter = VK_FILTER_NEAREST;
         sampler_create_info.minFilter = VK_FILTER_NEAREST;
         m_device_dispatch.createSampler(&sampler_create_info, nullptr, &m_default_sampler_nearest);
+        m_default_sampler_nearest_info = sampler_create_info;
         sampler_create_info.magFilter = VK_FILTER_LINEAR;
         sampler_create_info.minFilter = VK_FILTER_LINEAR;
         m_device_dispatch.createSampler(&sampler_create_info, nullptr, &m_default_sampler_linear);
@@ -1181,12 +3092,13 @@ namespace Renderer
 
         Renderer::Viewport& new_viewport = active_viewports.emplace_back();
         new_viewport.draw_image = CreateDrawImage((uint32_t)backbuffer_size.x, (uint32_t)backbuffer_size.y);
-        new_viewport.depth_image = CreateDepthImage((uint32_t)backbuffer_size.x, (uint32_t)backbuffer_size.y);
         new_viewport.name = "main viewport";
         new_viewport.render_scale = 1.0f;
+        new_viewport.compute_background = true;
 
         new_viewport.frame_context.camera_position = glm::vec3(0.0f, 0.0f, -1.0f);
         new_viewport.frame_context.camera_rotation = glm::mat4{ 1.0f }; // no rotation
+        new_viewport.frame_context.UpdateCamera();
         new_viewport.frame_context.camera_vertical_fov = 70.0f;
 
         main_viewport = 0;
@@ -1247,6 +3159,8 @@ namespace Renderer
             false,
             "checkerboard_image"
         );
+
+        m_virtual_texturing.Init(*this);
     }
 
     void VulkanEngine::InitImgui()
@@ -1318,35 +3232,35 @@ namespace Renderer
 
     void VulkanEngine::CreateSwapchain(uint32_t width, uint32_t height)
     {
-        // destroy in case it already exists
-        for (std::size_t i = 0; i < m_swapchain_image_views.size(); ++i)
-        {
-            m_device_dispatch.destroyImageView(m_swapchain_image_views[i], nullptr);
-        }
-        m_device_dispatch.destroySwapchainKHR(m_swapchain, nullptr);
-
-        vkb::SwapchainBuilder builder(m_gpu, m_device, m_surface);
-
+        // an existing swapchain is handed over to the new one, destroying it is up to the caller.
         m_swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
-
-        vkb::Swapchain vkb_swapchain =
-            builder
-                .set_desired_format(
-                    VkSurfaceFormatKHR{ .format = m_swapchain_format,
-                                        .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }
-                )
-                .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR) // #TODO: Implement MAILBOX present
-                .set_desired_extent(width, height)
-                .add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
-                .build()
-                .value();
+        vkb::Swapchain vkb_swapchain = BuildSwapchain(m_surface, width, height, m_swapchain);
 
         m_swapchain_extent = vkb_swapchain.extent;
         m_swapchain = vkb_swapchain.swapchain;
+        m_active_present_mode = vkb_swapchain.present_mode;
         m_swapchain_images = vkb_swapchain.get_images().value();
         m_swapchain_image_views = vkb_swapchain.get_image_views().value();
     }
 
+    vkb::Swapchain VulkanEngine::BuildSwapchain(
+        VkSurfaceKHR surface, uint32_t width, uint32_t height, VkSwapchainKHR old_swapchain
+    )
+    {
+        vkb::SwapchainBuilder builder(m_gpu, m_device, surface);
+        return builder
+            .set_desired_format(
+                VkSurfaceFormatKHR{ .format = m_swapchain_format,
+                                    .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }
+            )
+            .set_desired_present_mode(ToVkPresentMode(m_present_mode)) // falls back to FIFO
+            .set_desired_extent(width, height)
+            .add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+            .set_old_swapchain(old_swapchain)
+            .build()
+            .value();
+    }
+
     ImageHandle VulkanEngine::CreateDrawImage(uint32_t width, uint32_t height)
     {
         VkExtent3D image_extent{ width, height, 1 };
@@ -1357,6 +3271,7 @@ namespace Renderer
         usage_flags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         usage_flags |= VK_IMAGE_USAGE_STORAGE_BIT;
         usage_flags |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        usage_flags |= VK_IMAGE_USAGE_SAMPLED_BIT; // upscaled onto the swapchain
         VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
         VkImageAspectFlagBits aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT;
         VkMemoryPropertyFlags required_memory_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
@@ -1376,35 +3291,18 @@ namespace Renderer
         );
     }
 
-    ImageHandle VulkanEngine::CreateDepthImage(uint32_t width, uint32_t height)
+    ImTextureID VulkanEngine::ImageDebugTextureId(const ImageHandle& image)
     {
-        VkExtent3D image_extent{ width, height, 1 };
-        VkFormat image_format = VKENGINE_DEPTH_IMAGE_FORMAT;
-        VkImageUsageFlags usage_flags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-        VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-        VkImageAspectFlagBits aspect_flags = VK_IMAGE_ASPECT_DEPTH_BIT;
-        VkMemoryPropertyFlags required_memory_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-        VmaAllocationCreateFlags allocation_flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-        constexpr bool mipmapped = false;
+        if ((image->image_usage & VK_IMAGE_USAGE_SAMPLED_BIT) == 0)
+        {
+            return ImTextureID{};
+        }
 
-        return AllocateImage(
-            image_extent,
-            image_format,
-            usage_flags,
-            memory_usage,
-            aspect_flags,
-            required_memory_flags,
-            allocation_flags,
-            mipmapped,
-            "image_depth"
+        return m_debug_textures.Get(
+            image->image, image->image_view, m_default_sampler_nearest, uint64_t(frame_number)
         );
     }
 
-    ImTextureID VulkanEngine::ImageDebugTextureId(const ImageHandle& image)
-    {
-        return reinterpret_cast<ImTextureID>(m_debug_image_map[image->image]);
-    }
-
     void VulkanEngine::DestroySwapchain()
     {
         for (std::size_t i = 0; i < m_swapchain_image_views.size(); ++i)
@@ -1417,12 +3315,19 @@ namespace Renderer
         m_swapchain = VK_NULL_HANDLE;
     }
 
-    void VulkanEngine::ResizeSwapchain()
+    void VulkanEngine::SetPresentMode(PresentMode mode)
     {
-        m_device_dispatch.deviceWaitIdle();
+        if (mode == m_present_mode)
+        {
+            return;
+        }
 
-        DestroySwapchain();
+        m_present_mode = mode;
+        m_resize_requested = true;
+    }
 
+    void VulkanEngine::ResizeSwapchain()
+    {
         int32_t width, height;
         SDL_GetWindowSize(m_window, &width, &height);
         if (width == 0 || height == 0)
@@ -1431,12 +3336,196 @@ namespace Renderer
             return;
         }
 
+        // frames in flight might still render to or present the old swapchain images.
+        RetiredResources& retired = m_retired_resources.emplace_back();
+        retired.retired_frame = frame_number;
+        retired.swapchain = m_swapchain;
+        retired.swapchain_image_views = std::move(m_swapchain_image_views);
+
         m_window_extent = VkExtent2D{ uint32_t(width), uint32_t(height) };
         CreateSwapchain(m_window_extent.width, m_window_extent.height);
+        ResizeMainViewport(m_window_extent.width, m_window_extent.height, retired);
 
         m_resize_requested = false;
     }
 
+    void VulkanEngine::ResizeMainViewport(uint32_t width, uint32_t height, RetiredResources& retired)
+    {
+        if (main_viewport >= active_viewports.size())
+        {
+            return;
+        }
+
+        Viewport& viewport = active_viewports[main_viewport];
+        const uint32_t backbuffer_width = uint32_t(float(width) * m_backbuffer_scale);
+        const uint32_t backbuffer_height = uint32_t(float(height) * m_backbuffer_scale);
+        if (viewport.draw_image->image_extent.width == backbuffer_width &&
+            viewport.draw_image->image_extent.height == backbuffer_height)
+        {
+            return;
+        }
+
+        // the depth pyramid follows the draw extent by itself.
+        retired.images.emplace_back(std::move(viewport.draw_image));
+        viewport.draw_image = CreateDrawImage(backbuffer_width, backbuffer_height);
+    }
+
+    void VulkanEngine::ReleaseRetiredResources(bool device_idle)
+    {
+        // the fence of a frame covers everything submitted before it, so once the frame after the retired
+        // ones comes around again none of them can be in flight.
+        const int frames_in_flight = int(FramesInFlight());
+        std::erase_if(
+            m_retired_resources,
+            [&](RetiredResources& retired)
+            {
+                if (device_idle == false && frame_number < retired.retired_frame + frames_in_flight)
+                {
+                    return false;
+                }
+
+                for (VkImageView view : retired.swapchain_image_views)
+                {
+                    m_device_dispatch.destroyImageView(view, nullptr);
+                }
+                m_device_dispatch.destroySwapchainKHR(retired.swapchain, nullptr);
+                for (VkSemaphore semaphore : retired.semaphores)
+                {
+                    m_device_dispatch.destroySemaphore(semaphore, nullptr);
+                }
+                if (retired.surface != nullptr)
+                {
+                    m_instance_dispatch.destroySurfaceKHR(retired.surface, nullptr);
+                }
+                return true; // the images are released with the handles
+            }
+        );
+    }
+
+    bool VulkanEngine::AddPresentWindow(SDL_Window* window, size_t viewport_index)
+    {
+        PresentWindow& present_window = m_present_windows.emplace_back();
+        present_window.window = window;
+        present_window.viewport = viewport_index;
+        present_window.resize_requested = true; // the swapchain is created before the next frame
+
+        VkBool32 present_supported = VK_FALSE;
+        if (SDL_Vulkan_CreateSurface(window, m_instance, &present_window.surface) == SDL_FALSE ||
+            m_instance_dispatch.getPhysicalDeviceSurfaceSupportKHR(
+                m_gpu, m_graphics_queue_family, present_window.surface, &present_supported
+            ) != VK_SUCCESS ||
+            present_supported == VK_FALSE)
+        {
+            std::cerr << "[!] Can't present to window \"" << SDL_GetWindowTitle(window) << "\"." << std::endl;
+            if (present_window.surface != nullptr)
+            {
+                m_instance_dispatch.destroySurfaceKHR(present_window.surface, nullptr);
+            }
+            m_present_windows.pop_back();
+            return false;
+        }
+
+        VkSemaphoreCreateInfo semaphore_info = Utils::SemaphoreCreateInfo(0);
+        for (VkSemaphore& semaphore : present_window.acquire_semaphores)
+        {
+            VK_CHECK(m_device_dispatch.createSemaphore(&semaphore_info, nullptr, &semaphore));
+        }
+
+        return true;
+    }
+
+    void VulkanEngine::RemovePresentWindow(SDL_Window* window)
+    {
+        // the SDL window is usually destroyed right after, its surface has to go first. Rare enough to wait.
+        m_device_dispatch.deviceWaitIdle();
+        std::erase_if(
+            m_present_windows,
+            [&](PresentWindow& present_window)
+            {
+                if (present_window.window != window)
+                {
+                    return false;
+                }
+
+                RetirePresentWindow(present_window);
+                return true;
+            }
+        );
+        ReleaseRetiredResources(true);
+    }
+
+    void VulkanEngine::ResizePresentWindow(PresentWindow& window)
+    {
+        int32_t width, height;
+        SDL_GetWindowSize(window.window, &width, &height);
+        if (width == 0 || height == 0)
+        {
+            return; // minimised, it's skipped until it has a size again
+        }
+
+        // same as the main window, frames in flight might still use the old swapchain.
+        RetiredResources& retired = m_retired_resources.emplace_back();
+        retired.retired_frame = frame_number;
+        retired.swapchain = window.swapchain;
+
+        vkb::Swapchain vkb_swapchain =
+            BuildSwapchain(window.surface, uint32_t(width), uint32_t(height), window.swapchain);
+        window.swapchain = vkb_swapchain.swapchain;
+        window.swapchain_images = vkb_swapchain.get_images().value();
+        window.swapchain_extent = vkb_swapchain.extent;
+        window.resize_requested = false;
+    }
+
+    void VulkanEngine::RetirePresentWindow(PresentWindow& window)
+    {
+        RetiredResources& retired = m_retired_resources.emplace_back();
+        retired.retired_frame = frame_number;
+        retired.swapchain = window.swapchain;
+        retired.surface = window.surface;
+        retired.semaphores.assign(window.acquire_semaphores.begin(), window.acquire_semaphores.end());
+    }
+
+    void VulkanEngine::AcquirePresentWindowImages()
+    {
+        const size_t frame_slot = frame_number % m_frames.size();
+        for (PresentWindow& window : m_present_windows)
+        {
+            window.acquired_image = PresentWindow::NO_IMAGE;
+            if (window.swapchain == nullptr || window.resize_requested ||
+                window.viewport >= active_viewports.size())
+            {
+                continue;
+            }
+
+            // no timeout, a window that isn't ready yet is skipped instead of holding up the frame.
+            uint32_t image_index;
+            VkResult result = m_device_dispatch.acquireNextImageKHR(
+                window.swapchain, 0, window.acquire_semaphores[frame_slot], nullptr, &image_index
+            );
+            if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+            {
+                window.acquired_image = image_index;
+            }
+            if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                window.resize_requested = true;
+            }
+        }
+    }
+
+    void VulkanEngine::CopyToPresentWindow(VkCommandBuffer cmd, const PresentWindow& window)
+    {
+        const Viewport& viewport = active_viewports[window.viewport];
+        Utils::CopyImageToImage(
+            &m_device_dispatch,
+            cmd,
+            viewport.draw_image->image,
+            window.swapchain_images[window.acquired_image],
+            viewport.draw_extent,
+            window.swapchain_extent
+        );
+    }
+
     void VulkanEngine::SetAllocationName(
         [[maybe_unused]] VmaAllocation allocation, [[maybe_unused]] const char* name
     )
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 
 struct CVars
 {
@@ -12,6 +14,19 @@ struct CVars
     float backbuffer_scale = 1.0f;
     bool use_validation_layers = true;
     bool force_immediate_uploads = false;
+    bool compress_vertices = true;
+    bool optimise_meshes = true;
+    bool generate_lods = true;
+    bool use_mesh_cache = true;
+    bool build_meshlets = true;
+    uint32_t present_mode = 0; // 0 FIFO, 1 MAILBOX, 2 IMMEDIATE, 3 FIFO_RELAXED like Renderer::PresentMode
+    float max_fps = 0.0f;      // no limit if zero
+    uint32_t frames_in_flight = 2;
+    uint32_t job_workers = 0;    // every hardware thread if zero
+    bool pipeline_frames = true; // extract the next frame while the current one is recorded
+    float tick_rate = 60.0f;     // fixed game ticks per second
+    uint32_t max_catch_up_steps = 4;
+    uint32_t present_windows = 0; // additional windows presenting the main viewport
     char default_scene_path[512] = "../data/resources/BarramundiFish.glb";
 
     uint32_t ReadFromFile(std::filesystem::path path)
@@ -58,6 +73,115 @@ struct CVars
                 continue;
             }
 
+            if (std::strstr(line.data(), "COMPRESS_VERTICES=false;") ||
+                std::strstr(line.data(), "COMPRESS_VERTICES=0;"))
+            {
+                compress_vertices = false;
+                total_read++;
+                continue;
+            }
+
+            if (std::strstr(line.data(), "OPTIMISE_MESHES=false;") ||
+                std::strstr(line.data(), "OPTIMISE_MESHES=0;"))
+            {
+                optimise_meshes = false;
+                total_read++;
+                continue;
+            }
+
+            if (std::strstr(line.data(), "GENERATE_LODS=false;") ||
+                std::strstr(line.data(), "GENERATE_LODS=0;"))
+            {
+                generate_lods = false;
+                total_read++;
+                continue;
+            }
+
+            if (std::strstr(line.data(), "USE_MESH_CACHE=false;") ||
+                std::strstr(line.data(), "USE_MESH_CACHE=0;"))
+            {
+                use_mesh_cache = false;
+                total_read++;
+                continue;
+            }
+
+            if (std::strstr(line.data(), "BUILD_MESHLETS=false;") ||
+                std::strstr(line.data(), "BUILD_MESHLETS=0;"))
+            {
+                build_meshlets = false;
+                total_read++;
+                continue;
+            }
+
+            // in the order of Renderer::PresentMode
+            constexpr const char* present_modes[] = {
+                "PRESENT_MODE=FIFO;",
+                "PRESENT_MODE=MAILBOX;",
+                "PRESENT_MODE=IMMEDIATE;",
+                "PRESENT_MODE=FIFO_RELAXED;",
+            };
+            bool read_present_mode = false;
+            for (size_t i = 0; i < std::size(present_modes); ++i)
+            {
+                if (std::strstr(line.data(), present_modes[i]))
+                {
+                    present_mode = uint32_t(i);
+                    read_present_mode = true;
+                    break;
+                }
+            }
+            if (read_present_mode)
+            {
+                total_read++;
+                continue;
+            }
+
+            if (std::sscanf(line.data(), "MAX_FPS=%f;", &max_fps) == 1)
+            {
+                total_read++;
+                continue;
+            }
+
+            if (std::sscanf(line.data(), "FRAMES_IN_FLIGHT=%u;", &frames_in_flight) == 1)
+            {
+                total_read++;
+                continue;
+            }
+
+            if (std::sscanf(line.data(), "JOB_WORKERS=%u;", &job_workers) == 1)
+            {
+                total_read++;
+                continue;
+            }
+
+            if (std::strstr(line.data(), "PIPELINE_FRAMES=false;") ||
+                std::strstr(line.data(), "PIPELINE_FRAMES=0;"))
+            {
+                pipeline_frames = false;
+                total_read++;
+                continue;
+            }
+
+            if (std::sscanf(line.data(), "TICK_RATE=%f;", &tick_rate) == 1)
+            {
+                total_read++;
+                continue;
+            }
+
+            if (std::sscanf(line.data(), "MAX_CATCH_UP_STEPS=%u;", &max_catch_up_steps) == 1)
+            {
+                // zero steps would never tick the game.
+                max_catch_up_steps = std::max(max_catch_up_steps, 1u);
+                total_read++;
+                continue;
+            }
+
+            if (std::sscanf(line.data(), "PRESENT_WINDOWS=%u;", &present_windows) == 1)
+            {
+                total_read++;
+                continue;
+            }
+
             if (std::sscanf(line.data(), "DEFAULT_SCENE_PATH=\"%s\";", default_scene_path))
             {
                 size_t len = strlen(default_scene_path);
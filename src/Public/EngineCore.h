@@ -2,8 +2,11 @@
 
 #include "CVars.h"
 #include "Game/GameMain.h"
+#include "Jobs/FrameTaskGraph.h"
+#include "Jobs/JobSystem.h"
 #include "Renderer/VkEngine.h"
 #include <memory>
+#include <vector>
 
 struct SDL_Window;
 
@@ -22,15 +25,21 @@ class EngineCore
   private:
     void Update();
     void OnImgui();
+    void BuildFrameTaskGraph();
 
     SDL_Window* m_window;
+    std::vector<SDL_Window*> m_present_windows; // show the main viewport, see CVars::present_windows
     std::unique_ptr<Renderer::VulkanEngine> m_renderer;
     std::unique_ptr<Game::GameMain> m_game;
+    std::unique_ptr<Jobs::JobSystem> m_job_system;
+    Jobs::FrameTaskGraph m_frame_graph{};
 
     double m_last_delta_ms = 0;
     int64_t m_last_update_us = 0;
     bool m_initialisation_failure = false;
+    bool m_pipeline_frames = true; // see BuildFrameTaskGraph
 
     bool m_show_imgui_demo = false;
     bool m_show_fps = true;
+    bool m_show_frame_graph = false;
 };
\ No newline at end of file
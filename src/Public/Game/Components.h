@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Game/Node.h"
+#include "Renderer/Utility/VkLoader.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Game
+{
+    // entities have no hierarchy, this is their world transform.
+    struct TransformComponent
+    {
+        Transform transform{};
+        Transform previous_transform{}; // before the last tick, drawn interpolated like nodes
+    };
+
+    // draws a mesh at the transform of the entity, the same way MeshNode does.
+    struct MeshRendererComponent
+    {
+        Renderer::MeshHandle mesh;
+        std::vector<uint32_t> surface_lods{}; // LOD drawn last frame for each surface, for hysteresis
+    };
+
+    // bridge to the node hierarchy. The transform of the entity follows the world transform of the node after
+    // every tick, offset by the given transform.
+    struct NodeLinkComponent
+    {
+        NodeId_t node = INVALID_NODE_ID;
+        Transform offset{};
+    };
+} // namespace Game
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "Jobs/JobSystem.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Game
+{
+    /// Index into the component storages and the generation of that index, so a handle to a destroyed entity
+    /// doesn't resolve to the next entity that reuses its index.
+    struct Entity
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const Entity& other) const = default;
+    };
+
+    constexpr Entity INVALID_ENTITY{};
+
+    class ComponentStorageBase
+    {
+      public:
+        virtual ~ComponentStorageBase() = default;
+
+        virtual void Remove(uint32_t entity_index) = 0;
+        virtual size_t Size() const = 0;
+    };
+
+    /// Sparse set of one component type. The components are packed in a dense array in no particular order,
+    /// the sparse array maps an entity index to its position in there. Adding, removing and lookups are
+    /// constant time and iterating touches only the dense array.
+    template <typename T>
+    class ComponentStorage final : public ComponentStorageBase
+    {
+      public:
+        template <typename... Args>
+        T& Emplace(uint32_t entity_index, Args&&... args)
+        {
+            if (entity_index >= m_sparse.size())
+            {
+                m_sparse.resize(size_t(entity_index) + 1, ABSENT);
+            }
+            if (m_sparse[entity_index] != ABSENT)
+            {
+                return m_components[m_sparse[entity_index]] = T{ std::forward<Args>(args)... };
+            }
+
+            m_sparse[entity_index] = uint32_t(m_components.size());
+            m_entity_indices.push_back(entity_index);
+            return m_components.emplace_back(T{ std::forward<Args>(args)... });
+        }
+
+        // moves the last component into the place of the removed one.
+        void Remove(uint32_t entity_index) override
+        {
+            if (Contains(entity_index) == false)
+            {
+                return;
+            }
+
+            const uint32_t dense_index = m_sparse[entity_index];
+            if (dense_index + 1 < m_components.size())
+            {
+                m_components[dense_index] = std::move(m_components.back());
+                m_entity_indices[dense_index] = m_entity_indices.back();
+                m_sparse[m_entity_indices[dense_index]] = dense_index;
+            }
+            m_components.pop_back();
+            m_entity_indices.pop_back();
+            m_sparse[entity_index] = ABSENT;
+        }
+
+        bool Contains(uint32_t entity_index) const
+        {
+            return entity_index < m_sparse.size() && m_sparse[entity_index] != ABSENT;
+        }
+
+        T* Find(uint32_t entity_index)
+        {
+            return Contains(entity_index) ? &m_components[m_sparse[entity_index]] : nullptr;
+        }
+
+        size_t Size() const override { return m_components.size(); }
+
+        // entity_indices[i] is the entity components[i] belongs to.
+        std::span<T> Components() { return m_components; }
+        std::span<const uint32_t> EntityIndices() const { return m_entity_indices; }
+
+      private:
+        static constexpr uint32_t ABSENT = UINT32_MAX;
+
+        std::vector<uint32_t> m_sparse{};
+        std::vector<uint32_t> m_entity_indices{};
+        std::vector<T> m_components{};
+    };
+
+    inline uint32_t NextComponentTypeId()
+    {
+        static std::atomic<uint32_t> next_id = 0;
+        return next_id++;
+    }
+
+    // small dense id for each component type, used to index the storages of a registry.
+    template <typename T>
+    uint32_t ComponentTypeId()
+    {
+        static const uint32_t id = NextComponentTypeId();
+        return id;
+    }
+
+    /// Entities and their components for simulations too large for nodes. Entities are only indices, every
+    /// component type lives in its own contiguous storage. Creating and destroying entities or components
+    /// isn't thread safe, parallel loops can only change the components they are given.
+    class EntityRegistry
+    {
+      public:
+        Entity Create();
+        void Destroy(Entity entity);
+        bool IsAlive(Entity entity) const;
+        size_t AliveCount() const { return m_alive_count; }
+
+        // the entity of a component at an index of a storage.
+        Entity EntityAt(uint32_t entity_index) const
+        {
+            return Entity{ entity_index, m_generations[entity_index] };
+        }
+
+        template <typename T, typename... Args>
+        T& Add(Entity entity, Args&&... args)
+        {
+            return Storage<T>().Emplace(entity.index, std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        void Remove(Entity entity)
+        {
+            if (IsAlive(entity))
+            {
+                Storage<T>().Remove(entity.index);
+            }
+        }
+
+        template <typename T>
+        T* TryGet(Entity entity)
+        {
+            return IsAlive(entity) ? Storage<T>().Find(entity.index) : nullptr;
+        }
+
+        template <typename T>
+        ComponentStorage<T>& Storage()
+        {
+            const uint32_t type_id = ComponentTypeId<T>();
+            if (type_id >= m_storages.size())
+            {
+                m_storages.resize(size_t(type_id) + 1);
+            }
+            if (m_storages[type_id] == nullptr)
+            {
+                m_storages[type_id] = std::make_unique<ComponentStorage<T>>();
+            }
+
+            return static_cast<ComponentStorage<T>&>(*m_storages[type_id]);
+        }
+
+        /// Calls function(entity, First&, Others&...) for every entity with all of the components. Walks the
+        /// dense array of First, so it should be the rarest of them.
+        template <typename First, typename... Others, typename Function>
+        void Each(Function&& function)
+        {
+            ComponentStorage<First>& first = Storage<First>();
+            std::tuple<ComponentStorage<Others>&...> others{ Storage<Others>()... };
+            EachInRange<First, Others...>(first, others, 0, first.Size(), function);
+        }
+
+        /// Same as Each, but chunks of the entities run in parallel on the job system.
+        template <typename First, typename... Others, typename Function>
+        void ParallelEach(Jobs::JobSystem& job_system, size_t grain_size, Function&& function)
+        {
+            ComponentStorage<First>& first = Storage<First>();
+            std::tuple<ComponentStorage<Others>&...> others{ Storage<Others>()... };
+            job_system.ParallelFor(
+                first.Size(),
+                grain_size,
+                [&](size_t first_component, size_t last_component)
+                {
+                    EachInRange<First, Others...>(first, others, first_component, last_component, function);
+                }
+            );
+        }
+
+      private:
+        template <typename First, typename... Others, typename Function>
+        void EachInRange(
+            ComponentStorage<First>& first,
+            std::tuple<ComponentStorage<Others>&...>& others,
+            size_t first_component,
+            size_t last_component,
+            Function& function
+        )
+        {
+            std::span<First> components = first.Components();
+            std::span<const uint32_t> entity_indices = first.EntityIndices();
+            for (size_t component = first_component; component < last_component; ++component)
+            {
+                const uint32_t entity_index = entity_indices[component];
+                std::tuple<Others*...> other_components{
+                    std::get<ComponentStorage<Others>&>(others).Find(entity_index)...
+                };
+                const bool has_all = std::apply(
+                    [](auto*... found)
+                    {
+                        return ((found != nullptr) && ... && true);
+                    },
+                    other_components
+                );
+                if (has_all == false)
+                {
+                    continue;
+                }
+
+                std::apply(
+                    [&](auto*... found)
+                    {
+                        function(EntityAt(entity_index), components[component], *found...);
+                    },
+                    other_components
+                );
+            }
+        }
+
+        std::vector<uint32_t> m_generations{};
+        std::vector<uint32_t> m_free_indices{};
+        size_t m_alive_count = 0;
+        std::vector<std::unique_ptr<ComponentStorageBase>> m_storages{};
+    };
+} // namespace Game
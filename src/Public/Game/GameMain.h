@@ -4,6 +4,8 @@
 #include "Game/Editor/SceneEditor.h"
 #include "Game/GameScene.h"
 #include "Game/GameTime.h"
+#include "Game/TickScheduler.h"
+#include "Jobs/JobSystem.h"
 #include "Renderer/Viewport.h"
 #include "Renderer/VkEngine.h"
 
@@ -19,17 +21,25 @@ namespace Game
         GameMain(const GameMain&) = delete; // no copy
 
         void MainSceneSetup();
-        void Draw(double delta_time_seconds);
+        // runs the fixed ticks the frame time adds up to, the first job of the frame.
+        void Tick(double delta_time_seconds, Jobs::JobSystem& job_system);
+        // extracts the render objects of the scene into the frame context of the main viewport. May run while
+        // the renderer records the previous frame, so it can't touch anything the renderer reads.
+        void Draw(Jobs::JobSystem& job_system);
         void OnImGui();
 
       private:
+        void DrawSimulationImGui();
+
         std::unique_ptr<Editor::SceneEditor> m_main_editor{};
         std::unique_ptr<GameScene> m_main_scene;
         Renderer::Viewport* m_main_viewport;
         Renderer::VulkanEngine* m_renderer;
         GameTime m_game_time{};
+        TickScheduler m_tick_scheduler{};
         CVars m_cvars{};
 
         bool m_editor_enabled = true;
+        bool m_show_simulation = false;
     };
 } // namespace Game
\ No newline at end of file
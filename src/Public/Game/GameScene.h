@@ -1,10 +1,17 @@
 #pragma once
 
+#include "Game/EntityRegistry.h"
 #include "Game/GameTime.h"
 #include "Game/Node.h"
+#include "Game/NodePool.h"
 #include "Renderer/VkEngine.h"
 
+#include <tbb/concurrent_queue.h>
+
+#include <array>
+#include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 namespace Renderer
@@ -12,10 +19,20 @@ namespace Renderer
     struct FrameDrawContext;
 }
 
+namespace Jobs
+{
+    class JobSystem;
+}
+
 namespace Game
 {
+    // bulk update of the entities of a scene. The job system is null when the scene ticks without one.
+    using EntitySystemUpdate = std::function<void(EntityRegistry&, const GameTime&, Jobs::JobSystem*)>;
+
     /// A GameScene defines a hierarchy of nodes and a render scene.
     /// Each node has a set of children and a single parent (except for the root).
+    /// Next to the nodes, the scene has an entity registry for large numbers of simple objects. Entities
+    /// with a TransformComponent and a MeshRendererComponent are drawn along with the nodes.
     class GameScene
     {
       public:
@@ -31,27 +48,90 @@ namespace Game
         void SetPaused(bool paused);
         Node* NodeFromId(NodeId_t node_id);
         RootNode& Root() { return *m_root.get(); }
+        NodeAllocator& Allocator() { return *m_node_allocator; }
+        EntityRegistry& Registry() { return m_registry; }
+
+        /// Systems of a tick group run in the order they were added, before the nodes of the group.
+        void AddSystem(std::string name, TickGroup group, EntitySystemUpdate update);
 
         /// May get called multiple times per frame to draw the same scene on different views.
         /// If camera is specified, will force that camera for the draw, otherwise will use the active
         /// camera.
         void Draw(Renderer::FrameDrawContext& ctx, const CameraNode* camera_node = nullptr);
 
-        /// Called once a frame for the logical update of the game.
+        /// Same as Draw, but the renderable nodes are drawn in parallel. The render objects end up in the
+        /// same order as they would with Draw.
+        void Draw(
+            Renderer::FrameDrawContext& ctx,
+            Jobs::JobSystem& job_system,
+            const CameraNode* camera_node = nullptr
+        );
+
+        /// Called once per fixed tick for the logical update of the game. Keeps the world transforms from
+        /// before the tick so draws can interpolate between the two.
         void TickUpdate(const GameTime& time);
 
+        /// Same as TickUpdate, but the parallel nodes of each tick group are ticked on the job system.
+        void TickUpdate(const GameTime& time, Jobs::JobSystem& job_system);
+
+        /// Runs the change right away, or at the sync point after the current tick group if the scene is
+        /// ticking. Can be called from any thread. Nodes defer their own structural changes.
+        void DeferChange(std::function<void()> change);
+        bool IsTicking() const { return m_ticking; }
+
+        size_t TickingNodeCount(TickGroup group, bool parallel) const;
+
+        /// How far the next draw is between the last two ticks, from 0 to 1.
+        void SetTickInterpolation(float alpha) { m_tick_interpolation = alpha; }
+        float TickInterpolation() const { return m_tick_interpolation; }
+
       private:
         void SetNodeRenderable(Node& node, bool is_renderable);
-        void UpdateAllNodes(const GameTime& time);
+        void SetupDrawCamera(Renderer::FrameDrawContext& ctx, const CameraNode* camera_node) const;
+        void DrawEntities(Renderer::FrameDrawContext& ctx, Jobs::JobSystem* job_system);
+        // draws the chunks into copies of the context in parallel, then appends them in order.
+        void DrawChunks(
+            Renderer::FrameDrawContext& ctx,
+            Jobs::JobSystem* job_system,
+            size_t chunk_count,
+            const std::function<void(size_t chunk, Renderer::FrameDrawContext& chunk_ctx)>& draw_chunk
+        ) const;
+        void UpdateNodeLinks();
+        void KeepPreviousTransforms();
+        void UpdateAllNodes(const GameTime& time, Jobs::JobSystem* job_system);
+        void ApplyDeferredChanges();
+
+        struct TickGroupNodes
+        {
+            std::vector<Node*> serial;
+            std::vector<Node*> parallel;
+        };
+        std::vector<Node*>& TickList(const Node& node);
+
+        struct EntitySystem
+        {
+            std::string name;
+            TickGroup group;
+            EntitySystemUpdate update;
+        };
 
         std::unordered_map<NodeId_t, Node*> m_active_nodes{};
-        std::vector<Node*> m_updating_nodes;
+        std::array<TickGroupNodes, TICK_GROUP_COUNT> m_tick_groups{};
         std::vector<Node*> m_renderable_nodes;
 
+        tbb::concurrent_queue<std::function<void()>> m_deferred_changes{};
+        bool m_ticking = false;
+
+        EntityRegistry m_registry{};
+        std::vector<EntitySystem> m_systems{};
+
+        // declared before the root so the pools outlive the nodes.
+        std::unique_ptr<NodeAllocator> m_node_allocator;
         std::unique_ptr<RootNode> m_root;
         CameraNode* m_active_camera = nullptr;
 
         bool m_paused = false;
+        float m_tick_interpolation = 1.0f;
 
         NodeId_t m_next_node_id = 1; // starting from 1 to avoid invalid node id
     };
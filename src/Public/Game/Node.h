@@ -1,12 +1,18 @@
 #pragma once
 
 #include "Game/GameTime.h"
+#include "Game/NodePool.h"
 
 #include <glm/ext/vector_float3.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <typeindex>
 #include <utility>
 #include <vector>
 
@@ -28,11 +34,23 @@ namespace Game
 
         Transform Transformed(const Transform& other) const;
         Transform InverseTransformed(const Transform& other) const;
+
+        // linear between the positions and scales, spherical between the rotations.
+        static Transform Interpolated(const Transform& from, const Transform& to, float alpha);
     };
 
     using NodeId_t = uint32_t;
     constexpr NodeId_t INVALID_NODE_ID = 0u;
 
+    // every node of a group ticks before the nodes of the next group.
+    enum class TickGroup : uint8_t
+    {
+        Early, // e.g. controllers other nodes read from
+        Default,
+        Late, // e.g. cameras following nodes that moved this tick
+    };
+    constexpr size_t TICK_GROUP_COUNT = 3;
+
     class GameScene;
     class RootNode;
 
@@ -47,10 +65,15 @@ namespace Game
         // getters
         NodeId_t Id() const { return m_id; }
         const std::string& Name() const { return m_name; }
-        const std::vector<std::unique_ptr<Node>>& Children() const { return m_children; }
+        // not in creation order, removing a child moves the last one into its place.
+        const std::vector<NodePtr>& Children() const { return m_children; }
         const Transform& WorldTransform() const { return m_world_transform; }
         const Transform& LocalTransform() const { return m_local_transform; }
+        // world transform between the last two ticks of the scene, for drawing.
+        Transform InterpolatedWorldTransform() const;
         bool IsRootNode() const { return m_parent == nullptr; }
+        TickGroup GetTickGroup() const { return m_tick_group; }
+        bool TicksInParallel() const { return m_parallel_tick; }
 
         Node* Parent() { return m_parent; }
         const Node* Parent() const { return m_parent; }
@@ -62,12 +85,19 @@ namespace Game
         // operations
 
         /// Create a child of this node. This is the intended way of creating any nodes within a game scene.
+        /// Nodes are allocated from a pool of their type in the scene. During a tick the child only gets
+        /// registered with the scene at the next sync point.
         template <typename T, typename... Args>
         T& CreateChild(Args... args);
 
         /// Set whether this node should be updated every tick through OnTickUpdate.
         void SetTickUpdate(bool tick_update_enabled);
 
+        /// Set the group this node ticks in. Parallel nodes of a group tick at the same time on the job
+        /// system before the serial ones, so their OnTickUpdate may only change the node and its children and
+        /// can't read other parallel nodes.
+        void SetTickGroup(TickGroup group, bool parallel = false);
+
         /// Destroy this node.
         void Destroy();
 
@@ -106,20 +136,40 @@ namespace Game
         virtual std::string DebugDisplayName() { return m_name; }
 
       private:
+        static constexpr size_t INVALID_INDEX = SIZE_MAX;
+
+        NodePool& PoolFor(std::type_index type, size_t size, size_t alignment);
         void PostCreateChild(Node& node);
-        Node* AddChild(std::unique_ptr<Node>&& node);
+        Node* AddChild(NodePtr&& node);
+        // removes the child in constant time by moving the last child into its place.
+        NodePtr TakeChild(Node& child);
+        // releases every node under this one from the scene, the deepest first.
+        void ReleaseChildren();
         void RefreshTransform();
 
+        // defers the change to the next sync point if the scene is ticking, the node is looked up by id
+        // again by then. Returns false if the change can be made right away.
+        bool DeferWhileTicking(std::function<void(Node&)> change);
+
         NodeId_t m_id{};
         std::string m_name = "node";
         GameScene* m_owning_scene = nullptr;
-        std::vector<std::unique_ptr<Node>> m_children{};
+        std::vector<NodePtr> m_children{};
         Node* m_parent = nullptr;
+        size_t m_child_index = INVALID_INDEX; // in the children of the parent
+
+        // position in the tick and renderable lists of the scene, so leaving them doesn't need a search.
+        size_t m_tick_list_index = INVALID_INDEX;
+        size_t m_renderable_list_index = INVALID_INDEX;
+
         bool m_tick_updating = false; // can be changed at runtime
         bool m_is_renderable = false; // cannot be changed at runtime
+        TickGroup m_tick_group = TickGroup::Default;
+        bool m_parallel_tick = false;
 
         Transform m_local_transform{};
         Transform m_world_transform{};
+        Transform m_previous_world_transform{}; // world transform before the last tick
 
         friend class GameScene; // so the scene can access the runtime calls.
     };
@@ -146,10 +196,10 @@ namespace Game
             "Trying to create a child node that does not inherit from Game::Node. This is unsupported."
         );
 
-        std::unique_ptr<T> node_unique = std::make_unique<T>(std::forward<Args>(args)...);
-        T& node_ref = *node_unique.get();
-        AddChild(std::move(node_unique));
-        PostCreateChild(node_ref);
-        return node_ref;
+        NodePool& pool = PoolFor(std::type_index(typeid(T)), sizeof(T), alignof(T));
+        T* node = new (pool.Allocate()) T(std::forward<Args>(args)...);
+        AddChild(NodePtr(node, NodeDeleter{ &pool }));
+        PostCreateChild(*node);
+        return *node;
     }
 } // namespace Game
\ No newline at end of file
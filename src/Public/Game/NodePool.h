@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace Game
+{
+    class Node;
+
+    /// Fixed size blocks for the nodes of one type. Blocks are carved out of chunks that live as long as the
+    /// pool, freed blocks are handed out again first so spawning and despawning doesn't hit the heap.
+    class NodePool
+    {
+      public:
+        static constexpr size_t BLOCKS_PER_CHUNK = 256;
+
+        NodePool(std::string type_name, size_t block_size, size_t block_alignment);
+        NodePool(const NodePool&) = delete; // no copy
+        ~NodePool();
+
+        // can be called from any thread, nodes created by parallel ticks allocate from the workers.
+        void* Allocate();
+        void Free(void* block);
+
+        const std::string& TypeName() const { return m_type_name; }
+        size_t BlockSize() const { return m_block_size; }
+        size_t LiveCount() const;
+        size_t Capacity() const;
+
+      private:
+        void AddChunk();
+
+        std::string m_type_name;
+        size_t m_block_size;
+        size_t m_block_alignment;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::byte*> m_chunks{};
+        std::vector<void*> m_free_blocks{};
+        size_t m_live_count = 0;
+    };
+
+    /// Destroys a pooled node and gives its block back to the pool it came from.
+    struct NodeDeleter
+    {
+        NodePool* pool = nullptr;
+
+        void operator()(Node* node) const;
+    };
+
+    using NodePtr = std::unique_ptr<Node, NodeDeleter>;
+
+    /// The pools of every node type created in a scene.
+    class NodeAllocator
+    {
+      public:
+        // creates the pool the first time a type is used, can be called from any thread.
+        NodePool& PoolFor(std::type_index type, size_t size, size_t alignment);
+
+        // every pool, for debugging. Can be called from any thread, pools live as long as the allocator.
+        std::vector<const NodePool*> Pools() const;
+
+      private:
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::type_index, std::unique_ptr<NodePool>> m_pools{};
+    };
+} // namespace Game
@@ -10,6 +10,15 @@ namespace Renderer
 
 namespace Game
 {
+    /// Appends a render object for every surface of the mesh. The LOD of each surface is picked from its
+    /// screen space error, surface_lods keeps the LODs of the last draw for hysteresis.
+    void AppendMeshRenderObjects(
+        Renderer::FrameDrawContext& ctx,
+        const Renderer::MeshHandle& mesh,
+        const glm::mat4& world_matrix,
+        std::vector<uint32_t>& surface_lods
+    );
+
     class MeshNode : public Node
     {
       public:
@@ -21,5 +30,6 @@ namespace Game
 
       private:
         Renderer::MeshHandle m_mesh_asset;
+        std::vector<uint32_t> m_surface_lods{}; // LOD drawn last frame for each surface, for hysteresis
     };
 } // namespace Game
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Game
+{
+    /// Runs the game logic at a fixed rate no matter the frame rate. Frame time accumulates and is spent in
+    /// whole ticks, what is left over interpolates the drawn transforms between the last two ticks.
+    struct TickScheduler
+    {
+        float tick_rate = 60.0f;         // ticks per second
+        uint32_t max_catch_up_steps = 4; // ticks a single frame can run, the rest of a long frame is dropped
+
+        // adds the time of a frame and returns how many ticks to run for it.
+        uint32_t Advance(double delta_time_seconds);
+
+        double TickSeconds() const;
+
+        // how far the frame is between the last tick and the next one, from 0 to 1.
+        float Interpolation() const;
+
+        void RecordTick(double milliseconds);
+        void ResetStats();
+
+        double accumulated_seconds = 0.0;
+
+        uint32_t last_steps = 0;
+        uint32_t max_steps = 0; // since the last reset
+        uint64_t total_ticks = 0;
+        double dropped_seconds = 0.0; // frame time thrown away because of max_catch_up_steps
+        double last_tick_milliseconds = 0.0;
+        double average_tick_milliseconds = 0.0;
+        double max_tick_milliseconds = 0.0; // since the last reset
+    };
+} // namespace Game
@@ -1,9 +1,15 @@
 #pragma once
 
 #include "Game/GameScene.h"
+#include "Renderer/Utility/VkLoader.h"
 
 namespace Game::Utils
 {
     /// Load the given gltf file as a scene under the given node.
-    void LoadGltfIntoGameScene(Renderer::VulkanEngine& engine, Node& node, std::filesystem::path file_path);
+    void LoadGltfIntoGameScene(
+        Renderer::VulkanEngine& engine,
+        Node& node,
+        std::filesystem::path file_path,
+        const Renderer::MeshImportSettings& import_settings = {}
+    );
 } // namespace Game::Utils
\ No newline at end of file
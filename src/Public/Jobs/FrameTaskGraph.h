@@ -0,0 +1,97 @@
+#pragma once
+
+#include <tbb/task_group.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Jobs
+{
+    class JobSystem;
+
+    using JobId = uint32_t;
+
+    enum class JobAffinity : uint8_t
+    {
+        Any,        // runs on whichever worker is free
+        MainThread, // runs on the thread that called Run, for work that touches SDL or ImGui
+    };
+
+    // when a job ran during the last run of the graph, relative to the start of the run.
+    struct JobTiming
+    {
+        int64_t start_us = 0;
+        int64_t end_us = 0;
+        int32_t thread_slot = -1; // arena slot of the worker, -1 for the main thread
+    };
+
+    /// Named jobs with dependencies that run once a frame. A job starts as soon as every job it depends on is
+    /// done, so independent jobs run in parallel. Jobs can start parallel work of their own through the job
+    /// system.
+    class FrameTaskGraph
+    {
+      public:
+        FrameTaskGraph() = default;
+        FrameTaskGraph(const FrameTaskGraph&) = delete; // no copy
+
+        // dependencies need to be added before the jobs that depend on them, so there can't be any cycles.
+        JobId AddJob(
+            std::string name,
+            std::function<void()> work,
+            std::vector<JobId> dependencies = {},
+            JobAffinity affinity = JobAffinity::Any
+        );
+
+        // removes every job so the graph can be built again. Can't be called while it runs.
+        void Clear();
+
+        // runs every job and blocks until they are all done.
+        void Run(JobSystem& job_system);
+
+        const JobTiming& Timing(JobId job) const { return m_jobs[job].timing; }
+        int64_t LastRunMicroseconds() const { return m_last_run_us; }
+
+        // the jobs, their dependencies and a timeline of the last run.
+        void DrawImGui() const;
+
+        // the graph in graphviz dot format.
+        std::string ToGraphviz() const;
+
+      private:
+        struct Job
+        {
+            std::string name;
+            std::function<void()> work;
+            std::vector<JobId> dependencies;
+            std::vector<JobId> dependents;
+            JobAffinity affinity;
+            JobTiming timing;
+        };
+
+        void Schedule(JobId job);
+        void Execute(JobId job);
+
+        std::vector<Job> m_jobs{};
+
+        // state of the current run
+        JobSystem* m_job_system = nullptr;
+        tbb::task_group m_tasks{};
+        std::vector<std::atomic<uint32_t>> m_remaining_dependencies{};
+        std::atomic<uint32_t> m_unfinished_jobs = 0;
+
+        // main thread jobs that are ready. The main thread sleeps on the condition until one is queued or the
+        // last job finished.
+        std::mutex m_main_thread_mutex{};
+        std::condition_variable m_main_thread_condition{};
+        std::deque<JobId> m_main_thread_jobs{};
+        int64_t m_run_start_us = 0;
+
+        int64_t m_last_run_us = 0;
+    };
+} // namespace Jobs
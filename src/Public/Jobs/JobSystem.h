@@ -0,0 +1,34 @@
+#pragma once
+
+#include <tbb/task_arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Jobs
+{
+    /// Runs engine work on a fixed set of worker threads. Everything is executed inside one TBB task arena,
+    /// so engine jobs can't be starved by other TBB work like asset loading and nested parallel loops stay
+    /// on the same workers.
+    class JobSystem
+    {
+      public:
+        // uses every hardware thread if the worker count is zero.
+        explicit JobSystem(uint32_t worker_count = 0);
+        JobSystem(const JobSystem&) = delete; // no copy
+
+        uint32_t WorkerCount() const { return uint32_t(m_arena.max_concurrency()); }
+        tbb::task_arena& Arena() { return m_arena; }
+
+        // runs body(begin, end) over chunks of [0, count) of at least grain_size elements. Returns once every
+        // chunk is done, the calling thread helps out.
+        void ParallelFor(size_t count, size_t grain_size, const std::function<void(size_t, size_t)>& body);
+
+        // slot of the calling thread in the arena, -1 for threads outside of it.
+        static int32_t CurrentThreadSlot();
+
+      private:
+        tbb::task_arena m_arena;
+    };
+} // namespace Jobs
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <VkBootstrapDispatch.h>
+#include <glm/vec4.hpp>
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+namespace Renderer
+{
+    struct BackgroundPushConstants
+    {
+        glm::vec4 data1;
+        glm::vec4 data2;
+        glm::vec4 data3;
+        glm::vec4 data4;
+    };
+
+    struct ComputeEffect
+    {
+        const char* name;
+        const char* path;
+        VkPipeline pipeline;
+        VkPipelineLayout layout;
+        BackgroundPushConstants push_constants;
+    };
+
+    // Compute pass that fills the draw image of a viewport before its geometry is drawn, instead of clearing
+    // it. Every effect writes the storage image at binding 0 in 16x16 workgroups and shares the same layout.
+    struct BackgroundPass
+    {
+        static constexpr uint32_t WORKGROUP_SIZE = 16;
+
+        VkDescriptorSetLayout descriptor_layout = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        std::vector<ComputeEffect> effects{};
+        bool loaded = false;
+
+        bool BuildPipelines(vkb::DispatchTable& device_dispatch);
+        void DestroyResources(vkb::DispatchTable& device_dispatch);
+    };
+} // namespace Renderer
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Renderer
+{
+    /// Adjusts the render scale of a viewport so its GPU time stays around a target. The scale only changes
+    /// when the smoothed time leaves the tolerance band around the target, and is then left alone for a few
+    /// frames until timings of the new scale come in.
+    struct DynamicResolution
+    {
+        bool enabled = false;
+        float target_milliseconds = 12.0f; // GPU time budget of the viewport
+        float min_scale = 0.5f;
+        float max_scale = 1.0f;
+        float tolerance = 0.1f; // fraction of the target the time can be off by before the scale changes
+
+        // returns the render scale for the next frame. Negative timings mean there is no measurement yet.
+        float Update(float render_scale, double gpu_milliseconds);
+
+        double smoothed_milliseconds = 0.0;
+        uint32_t frames_until_change = 0;
+    };
+} // namespace Renderer
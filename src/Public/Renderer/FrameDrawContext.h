@@ -3,6 +3,9 @@
 #include "Renderer/RenderObject.h"
 #include "Renderer/Utility/VkLoader.h"
 #include "Renderer/VkTypes.h"
+
+#include <glm/gtx/transform.hpp>
+#include <glm/matrix.hpp>
 #include <memory>
 
 namespace Renderer
@@ -16,6 +19,18 @@ namespace Renderer
         float camera_vertical_fov = 70.0f;
         glm::mat4 camera_rotation = glm::mat4(1.0f);
         glm::vec3 camera_position = glm::vec3(0.0f);
+        glm::vec3 camera_world_position = glm::vec3(0.0f); // derived from the view matrix by UpdateCamera
+
+        // filled in by the renderer from the previous draw of the viewport.
+        VkExtent2D draw_extent = { 0, 0 };
+        // largest screen space error in pixels that LOD selection is allowed to introduce. 0 disables LODs.
+        float lod_pixel_error = 1.0f;
+
+        glm::mat4 ViewMatrix() const { return camera_rotation * glm::translate(camera_position); }
+        glm::vec3 CameraWorldPosition() const { return camera_world_position; }
+
+        // needs to be called after the camera changed, so the view matrix is only inverted once a frame.
+        void UpdateCamera() { camera_world_position = glm::vec3(glm::inverse(ViewMatrix())[3]); }
 
         // environment data
         glm::vec4 ambient_colour = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
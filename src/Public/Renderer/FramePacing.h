@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Renderer
+{
+    // frames the CPU can record ahead of the GPU.
+    constexpr uint32_t DEFAULT_FRAME_OVERLAP = 2;
+    constexpr uint32_t MAX_FRAME_OVERLAP = 4;
+
+    // present modes the swapchain can be created with. Unsupported modes fall back to FIFO, which every
+    // device supports.
+    enum class PresentMode : uint8_t
+    {
+        Fifo,        // vsync, frames queue up behind the display
+        Mailbox,     // vsync, newer frames replace queued ones
+        Immediate,   // no vsync, might tear
+        FifoRelaxed, // vsync unless a frame is late, then it tears instead of waiting another refresh
+    };
+
+    constexpr PresentMode PRESENT_MODES[] = {
+        PresentMode::Fifo, PresentMode::Mailbox, PresentMode::Immediate, PresentMode::FifoRelaxed
+    };
+
+    VkPresentModeKHR ToVkPresentMode(PresentMode mode);
+    const char* PresentModeName(PresentMode mode);
+    const char* PresentModeName(VkPresentModeKHR mode);
+
+    /// Caps the frame rate by sleeping at the start of a frame. Waiting before input is polled instead of
+    /// before present means the frame is built from the freshest input.
+    struct FrameLimiter
+    {
+        float max_fps = 0.0f; // no limit if zero or less
+
+        void Wait();
+
+        int64_t next_frame_us = 0;
+    };
+
+    /// Measures the time between the oldest input event a frame handled and the present of that frame. This
+    /// is the CPU side of the latency, the time the frame spends queued for the display isn't included.
+    struct InputLatency
+    {
+        // keeps the oldest input that wasn't taken by a frame yet.
+        void RecordInput();
+
+        // the input the next frame handles, zero if there wasn't any.
+        int64_t TakeInput();
+        void RecordPresent(int64_t input_us);
+
+        double last_milliseconds = 0.0;
+        double average_milliseconds = 0.0;
+        double max_milliseconds = 0.0; // since the last reset
+
+        int64_t pending_input_us = 0;
+    };
+
+    struct FramesInFlightResult
+    {
+        uint32_t frames_in_flight = 0;
+        double frame_milliseconds = 0.0;      // CPU time between frames
+        double fence_wait_milliseconds = 0.0; // CPU time spent waiting for the GPU to finish a frame
+        double gpu_milliseconds = 0.0;        // negative if GPU timings aren't supported
+        uint32_t measured_frames = 0;
+        uint32_t gpu_measured_frames = 0;
+    };
+
+    /// Runs a number of frames with every frames in flight count from 1 to MAX_FRAME_OVERLAP and averages
+    /// their timings. The closer the GPU time is to the frame time, the better the CPU and GPU overlap.
+    struct FramesInFlightBenchmark
+    {
+        static constexpr uint32_t WARMUP_FRAMES = 30; // GPU timings lag behind by the frames in flight
+        static constexpr uint32_t MEASURED_FRAMES = 300;
+
+        // returns the frames in flight to run the first frames with.
+        uint32_t Start(uint32_t current_frames_in_flight);
+
+        // called after every frame, returns the frames in flight for the next one. The frames in flight from
+        // before the benchmark are restored once it is done.
+        uint32_t Update(
+            uint32_t frames_in_flight,
+            double frame_milliseconds,
+            double fence_wait_milliseconds,
+            double gpu_milliseconds
+        );
+
+        bool running = false;
+        std::vector<FramesInFlightResult> results{};
+
+        uint32_t restore_frames_in_flight = DEFAULT_FRAME_OVERLAP;
+        uint32_t stage_frames = 0;
+    };
+
+    // time of the clock the frame pacing is measured with.
+    int64_t FramePacingTimeMicroseconds();
+} // namespace Renderer
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Renderer/ResourceStorage.h"
+#include "Renderer/VkTypes.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+
+namespace Renderer
+{
+    class VulkanEngine;
+
+    /// First fit free list over a range of bytes. Free ranges are kept sorted by offset and merged with their
+    /// neighbours when released, so the list stays as short as the number of holes.
+    class RangeAllocator
+    {
+      public:
+        void Init(VkDeviceSize capacity);
+
+        std::optional<GeometryRange> Allocate(VkDeviceSize size, VkDeviceSize alignment);
+        void Free(GeometryRange range);
+
+        VkDeviceSize Capacity() const { return m_capacity; }
+        VkDeviceSize UsedBytes() const { return m_used_bytes; }
+        size_t FreeRangeCount() const { return m_free_ranges.size(); }
+        VkDeviceSize LargestFreeRange() const;
+
+      private:
+        std::map<VkDeviceSize, VkDeviceSize> m_free_ranges{}; // offset -> size
+        VkDeviceSize m_capacity = 0;
+        VkDeviceSize m_used_bytes = 0;
+    };
+
+    /// Vertex and index buffers shared by every mesh, meshes get ranges of them instead of buffers of their
+    /// own. The vertex buffer is only read through device addresses, so meshes keep vertex formats of their
+    /// own. All pooled meshes draw with the same index buffer, it is bound once per pass. Meshes that don't
+    /// fit anymore fall back to buffers of their own.
+    class GeometryPool
+    {
+      public:
+        static constexpr VkDeviceSize VERTEX_POOL_BYTES = 128ull * 1024 * 1024;
+        static constexpr VkDeviceSize INDEX_POOL_BYTES = 64ull * 1024 * 1024;
+        // vertex ranges start at addresses the vertex buffer references of the shaders can be aligned to.
+        static constexpr VkDeviceSize VERTEX_ALIGNMENT = 16;
+
+        void Init(VulkanEngine& engine);
+        void Destroy();
+
+        // points the buffers of the mesh at ranges of the pool. Returns false if the pool is full. Can be
+        // called from loading threads.
+        bool Allocate(GPUMeshBuffers& buffers, VkDeviceSize vertex_bytes, VkDeviceSize index_bytes);
+        // the ranges of the mesh are reused once the frames in flight are done with them.
+        void Free(VulkanEngine& engine, const GPUMeshBuffers& buffers);
+
+        const BufferHandle& IndexBuffer() const { return m_index_buffer; }
+
+        VkDeviceSize VertexCapacity() const { return m_vertex_ranges.Capacity(); }
+        VkDeviceSize IndexCapacity() const { return m_index_ranges.Capacity(); }
+        // sizes and counts are only read by the debug panels, a frame old value is fine.
+        VkDeviceSize UsedVertexBytes() const { return m_vertex_ranges.UsedBytes(); }
+        VkDeviceSize UsedIndexBytes() const { return m_index_ranges.UsedBytes(); }
+        VkDeviceSize LargestFreeVertexRange() const { return m_vertex_ranges.LargestFreeRange(); }
+        size_t FreeRangeCount() const
+        {
+            return m_vertex_ranges.FreeRangeCount() + m_index_ranges.FreeRangeCount();
+        }
+        size_t FallbackMeshCount() const { return m_fallback_meshes; }
+
+      private:
+        std::mutex m_mutex{};
+        RangeAllocator m_vertex_ranges{};
+        RangeAllocator m_index_ranges{};
+
+        BufferHandle m_vertex_buffer{};
+        BufferHandle m_index_buffer{};
+        VkDeviceAddress m_vertex_buffer_address = 0;
+        VkDeviceAddress m_index_buffer_address = 0;
+
+        size_t m_fallback_meshes = 0;
+    };
+} // namespace Renderer
@@ -2,9 +2,11 @@
 
 #include "Renderer/MaterialInterface.h"
 #include "Renderer/Utility/VkDescriptors.h"
+#include "Renderer/Utility/VkPipelines.h"
 #include "Renderer/VkTypes.h"
 #include "VkBootstrapDispatch.h"
 #include <glm/ext/vector_float4.hpp>
+#include <glm/ext/vector_uint4.hpp>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -25,6 +27,11 @@ namespace Renderer
     {
         VkPipeline pipeline;
         VkPipelineLayout layout;
+
+        // optional variants for viewports with a depth pre-pass, sharing the layout. The pre-pass pipeline
+        // only writes depth, the equal pipeline shades the surfaces the pre-pass left visible.
+        VkPipeline depth_prepass_pipeline = VK_NULL_HANDLE;
+        VkPipeline depth_equal_pipeline = VK_NULL_HANDLE;
     };
 
     struct MaterialInstance
@@ -36,11 +43,18 @@ namespace Renderer
         // keep a list of handles around to make sure the referenced resources don't get deleted mid-use
         std::vector<ImageHandle> referenced_images;
         std::vector<BufferHandle> referenced_buffers;
+
+        // frame the instance was last drawn in, the texture residency evicts textures nothing drew recently.
+        uint64_t last_drawn_frame = 0;
     };
 
     // Material type that supports (a subset of)glTF PBR specification.
     struct Material_GLTF_PBR
     {
+        static constexpr uint32_t PARAMETERS_BINDING = 0;
+        static constexpr uint32_t COLOUR_BINDING = 1;
+        static constexpr uint32_t METAL_ROUGHNESS_BINDING = 2;
+
         MaterialPipeline opaque_pipeline;
         MaterialPipeline transparent_pipeline;
 
@@ -54,14 +68,19 @@ namespace Renderer
         Utils::DescriptorAllocatorDynamic descriptor_allocator;
         bool loaded = false;
 
+        // sets of instances that had an image replaced, reused by later replacements.
+        std::vector<VkDescriptorSet> recycled_sets;
+
         // This is what gets written into the uniform buffer
         struct MaterialParameters
         {
             glm::vec4 colour;
             glm::vec4 metal_roughness;
+            // sampled instead of the colour image if w isn't 0, written by VirtualTexturing::Create.
+            glm::uvec4 virtual_texture = glm::uvec4(0);
 
             // padding for extra crap later
-            glm::vec4 extra[14];
+            glm::vec4 extra[13];
         };
 
         // These are the resources required to draw a single instance of this material
@@ -76,6 +95,9 @@ namespace Renderer
         };
 
         bool BuildPipelines(MaterialEngineInterface& interface);
+        void BuildDepthPrepassPipelines(
+            MaterialEngineInterface& interface, Utils::PipelineBuilder& opaque_builder
+        );
         void DestroyResources(vkb::DispatchTable& device_dispatch);
 
         // create a material instance that can be used to render objects using the given resources.
@@ -85,5 +107,17 @@ namespace Renderer
             const Resources& resources,
             Utils::DescriptorAllocatorDynamic& descriptor_allocator
         ) const;
+
+        // points an image binding of the instance at another image view and sampler. Frames in flight can
+        // still be using the current set, so the instance is given a new one and the old set is returned. It
+        // can be handed to RecycleSet once those frames are done.
+        VkDescriptorSet ReplaceImage(
+            vkb::DispatchTable& device_dispatch,
+            MaterialInstance& instance,
+            uint32_t binding,
+            VkImageView image_view,
+            VkSampler sampler
+        );
+        void RecycleSet(VkDescriptorSet set) { recycled_sets.push_back(set); }
     };
 } // namespace Renderer
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Renderer/ResourceStorage.h"
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Renderer
+{
+    class VulkanEngine;
+
+    // what a buffer or image is used for, decides the VMA pool it is allocated from.
+    enum class AllocationClass : uint8_t
+    {
+        General,   // default VMA pools
+        Mesh,      // vertex, index and meshlet buffers
+        Material,  // material uniform buffers
+        Texture,   // sampled RGBA8 textures
+        Transient, // staging buffers, freed once their upload is done
+        Count
+    };
+
+    const char* AllocationClassName(AllocationClass allocation_class);
+
+    // movable classes get transfer usage added so the defragmentation can copy them.
+    constexpr bool IsMovableClass(AllocationClass allocation_class)
+    {
+        return allocation_class == AllocationClass::Mesh || allocation_class == AllocationClass::Texture;
+    }
+
+    /// Custom VMA pools for every allocation class but General, so resources with different lifetimes don't
+    /// share memory blocks. Pools of movable classes are defragmented incrementally: once enough of their
+    /// blocks is unused, every idle frame moves a few allocations into new buffers and images, patches the
+    /// storage entries and the device addresses of the meshes using them, and gives the materials sampling
+    /// moved textures new descriptor sets. The old memory is released once the frames that can still read it
+    /// are done. Material uniform buffers are pooled but never moved, their descriptor sets aren't tracked.
+    class MemoryPools
+    {
+      public:
+        static constexpr uint32_t CHECK_INTERVAL_FRAMES = 120;
+        // pools with at least this fraction and amount of their blocks unused are defragmented.
+        static constexpr float DEFRAGMENT_UNUSED_FRACTION = 0.25f;
+        static constexpr VkDeviceSize DEFRAGMENT_UNUSED_BYTES = 16ull * 1024 * 1024;
+        static constexpr VkDeviceSize MAX_BYTES_PER_PASS = 16ull * 1024 * 1024;
+        static constexpr uint32_t MAX_MOVES_PER_PASS = 32;
+
+        bool defragmentation_enabled = true;
+
+        void Init(VmaAllocator allocator);
+        void Destroy(VmaAllocator allocator);
+
+        // finishes the pass in progress and stops defragmenting. Needs the device to be idle.
+        void EndDefragmentation(VulkanEngine& engine);
+
+        // VK_NULL_HANDLE for General and for classes whose pool couldn't be created.
+        VmaPool Pool(AllocationClass allocation_class) const
+        {
+            return m_pools[static_cast<size_t>(allocation_class)];
+        }
+
+        // stores the storage id of the resource in the allocation, only tracked allocations are moved.
+        void TrackBuffer(VmaAllocator allocator, VmaAllocation allocation, StorageId_t id);
+        void TrackImage(VmaAllocator allocator, VmaAllocation allocation, StorageId_t id);
+
+        // true if the allocation is part of the pass in progress. The caller then only destroys its buffer or
+        // image, the memory is freed by VMA when the pass ends.
+        bool AbandonMove(VmaAllocation allocation);
+
+        // ends the pass whose frames are done and starts the next one on idle frames. Records the copies of
+        // the moved allocations into the frame command buffer before anything is drawn.
+        void Update(VulkanEngine& engine, VkCommandBuffer cmd, bool idle_frame);
+
+        // patches the device addresses the meshes copied from the buffers moved since the last call. The game
+        // reads them without locking while it extracts the scene, so this runs when the frame is published.
+        void PublishMovedAddresses(VulkanEngine& engine);
+
+        // starts defragmenting the pool on the next idle frame regardless of how much of it is unused.
+        void RequestDefragmentation(AllocationClass allocation_class);
+
+        VmaStatistics PoolStatistics(VmaAllocator allocator, AllocationClass allocation_class) const;
+        bool IsDefragmenting() const { return m_context != VK_NULL_HANDLE; }
+        AllocationClass DefragmentedClass() const { return m_defragmented_class; }
+        VkDeviceSize MovedBytes() const { return m_moved_bytes; }
+        uint64_t MovedAllocations() const { return m_moved_allocations; }
+
+      private:
+        // resources of the pass in progress that are destroyed once it ends.
+        struct MovedResources
+        {
+            std::vector<VkBuffer> buffers{};
+            std::vector<VkImage> images{};
+            std::vector<VkImageView> image_views{};
+            std::vector<StorageId_t> buffer_ids{}; // their mapped pointers change when the pass ends
+        };
+
+        void CheckFragmentation(VmaAllocator allocator);
+        void BeginDefragmentation(VmaAllocator allocator, AllocationClass allocation_class);
+        void FinishDefragmentation(VmaAllocator allocator);
+        void BeginPass(VulkanEngine& engine, VkCommandBuffer cmd);
+        void EndPass(VulkanEngine& engine);
+
+        // both return nullopt/false if the resource can't be moved. A moved buffer returns its new device
+        // address, 0 if it has none.
+        std::optional<VkDeviceAddress> MoveBuffer(
+            VulkanEngine& engine, VkCommandBuffer cmd, VmaDefragmentationMove& move, StorageId_t id
+        );
+        bool MoveImage(
+            VulkanEngine& engine, VkCommandBuffer cmd, VmaDefragmentationMove& move, StorageId_t id
+        );
+
+        // meshes copy the device addresses of their buffers. Buffers no mesh was registered with yet can't be
+        // moved, their addresses might still be copied into one.
+        bool IsRegisteredMeshBuffer(VulkanEngine& engine, StorageId_t buffer_id);
+        void UpdateMeshAddresses(VulkanEngine& engine, StorageId_t buffer_id, VkDeviceAddress address);
+
+        std::array<VmaPool, size_t(AllocationClass::Count)> m_pools{};
+        std::array<bool, size_t(AllocationClass::Count)> m_requested{};
+
+        VmaDefragmentationContext m_context = VK_NULL_HANDLE;
+        AllocationClass m_defragmented_class = AllocationClass::General;
+        VmaDefragmentationPassMoveInfo m_pass{}; // moves of the pass in progress, pMoves is owned by VMA
+        bool m_pass_active = false;
+        int m_pass_frame = 0; // frame that recorded the copies of the pass
+        uint32_t m_pass_moved_count = 0;
+        MovedResources m_moved{};
+        std::vector<std::pair<StorageId_t, VkDeviceAddress>> m_moved_addresses{}; // not published yet
+
+        VkDeviceSize m_moved_bytes = 0;
+        uint64_t m_moved_allocations = 0;
+    };
+} // namespace Renderer
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Renderer/VkTypes.h"
+
+#include <VkBootstrapDispatch.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Renderer
+{
+    // Camera data the meshlets are culled against. Layout needs to match data/shader/meshlet_cull.comp.
+    struct GPUMeshletCullData
+    {
+        glm::vec4 frustum_planes[6]; // world space, normals point inside the frustum
+        glm::vec4 camera_position;
+    };
+
+    struct GPUMeshletCullPushConstants
+    {
+        glm::mat4 world_matrix;
+        VkDeviceAddress meshlet_buffer_address;
+        VkDeviceAddress index_buffer_address;
+        VkDeviceAddress output_index_buffer_address;
+        VkDeviceAddress draw_command_address;
+        VkDeviceAddress cull_data_address;
+        uint32_t first_meshlet;
+        uint32_t meshlet_count;
+    };
+
+    // Output of the meshlet culling pass for a single viewport, drawn by the geometry pass.
+    struct MeshletDrawCommands
+    {
+        BufferHandle index_buffer;   // indices of the visible meshlets
+        BufferHandle command_buffer; // a VkDrawIndexedIndirectCommand for each culled render object
+
+        // draw command of each render object, -1 for the objects that weren't culled.
+        std::vector<int32_t> command_indices{};
+    };
+
+    // Compute pass that culls the meshlets of render objects against the view frustum and their normal cones.
+    // The indices of the visible meshlets are written into a new index buffer and drawn indirectly.
+    struct MeshletCullingPass
+    {
+        // lowest maxComputeWorkGroupCount a device can have, objects with more meshlets dispatch more rows.
+        static constexpr uint32_t MAX_GROUPS_PER_ROW = 65535;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        bool loaded = false;
+
+        bool BuildPipelines(vkb::DispatchTable& device_dispatch);
+        void DestroyResources(vkb::DispatchTable& device_dispatch);
+
+        static GPUMeshletCullData CullData(
+            const glm::mat4& view_projection, const glm::vec3& camera_position
+        );
+
+        // workgroups to dispatch for an object, one per meshlet split into rows.
+        static VkExtent2D DispatchSize(uint32_t meshlet_count);
+    };
+} // namespace Renderer
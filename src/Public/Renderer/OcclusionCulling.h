@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Renderer/VkTypes.h"
+
+#include <VkBootstrapDispatch.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+constexpr VkFormat VKENGINE_DEPTH_PYRAMID_FORMAT = VK_FORMAT_R32_SFLOAT;
+
+namespace Renderer
+{
+    // Objects are culled twice a frame. The early phase draws the objects that were visible last frame, a
+    // depth pyramid is built from the result and the late phase tests everything against it, drawing the
+    // objects that became visible.
+    enum class OcclusionPhase : uint32_t
+    {
+        Early = 0,
+        Late = 1,
+    };
+
+    // Layout needs to match data/shader/occlusion_cull.comp.
+    struct GPUOcclusionCullData
+    {
+        glm::mat4 view;
+        glm::vec4 frustum_planes[6]; // world space, normals point inside the frustum
+        glm::vec4 projection;        // P00, abs(P11), P22, P32 of the projection matrix
+        glm::vec2 pyramid_size;
+        float near_plane;
+        uint32_t pyramid_mip_count;
+    };
+
+    struct GPUOcclusionCullPushConstants
+    {
+        VkDeviceAddress object_buffer_address; // world space bounding sphere of each object
+        VkDeviceAddress draw_command_address;  // VkDrawIndexedIndirectCommand of each object
+        VkDeviceAddress visibility_address;    // visibility of each object from the last late phase
+        VkDeviceAddress cull_data_address;
+        uint32_t object_count;
+        OcclusionPhase phase;
+        uint32_t padding[2];
+    };
+
+    struct GPUDepthPyramidPushConstants
+    {
+        glm::uvec2 source_size;
+        glm::uvec2 destination_size;
+    };
+
+    // Mip chain of the farthest depth of the viewport. Mip 0 is the draw extent rounded down to a power of
+    // two.
+    struct DepthPyramid
+    {
+        ImageHandle image;
+        std::vector<VkImageView> mip_views{}; // the reduction writes into single mips
+        VkExtent2D extent{ 0, 0 };
+        uint32_t mip_count = 0;
+    };
+
+    // Output of the occlusion culling pass for a single viewport, drawn by the geometry pass.
+    struct OcclusionDrawCommands
+    {
+        BufferHandle object_buffer;
+        BufferHandle cull_data_buffer;
+        BufferHandle early_command_buffer;
+        BufferHandle late_command_buffer;
+        uint32_t object_count = 0;
+
+        // draw command of each render object, -1 for the objects that aren't occlusion culled.
+        std::vector<int32_t> command_indices{};
+    };
+
+    // Compute passes that build the depth pyramid and cull objects against it.
+    struct OcclusionCullingPass
+    {
+        VkDescriptorSetLayout pyramid_descriptor_layout = VK_NULL_HANDLE;
+        VkPipelineLayout pyramid_layout = VK_NULL_HANDLE;
+        VkPipeline pyramid_pipeline = VK_NULL_HANDLE;
+
+        VkDescriptorSetLayout cull_descriptor_layout = VK_NULL_HANDLE;
+        VkPipelineLayout cull_layout = VK_NULL_HANDLE;
+        VkPipeline cull_pipeline = VK_NULL_HANDLE;
+
+        bool loaded = false;
+
+        bool BuildPipelines(vkb::DispatchTable& device_dispatch);
+        void DestroyResources(vkb::DispatchTable& device_dispatch);
+
+        // size of mip 0 and the number of mips of the depth pyramid for the given draw extent.
+        static VkExtent2D PyramidExtent(VkExtent2D draw_extent);
+        static uint32_t PyramidMipCount(VkExtent2D pyramid_extent);
+    };
+} // namespace Renderer
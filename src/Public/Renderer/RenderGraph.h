@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vkb
+{
+    struct DispatchTable;
+}
+
+namespace Renderer
+{
+    namespace Utils
+    {
+        class GpuProfiler;
+    }
+
+    using RenderGraphResource = uint32_t;
+
+    // how a pass uses an image, decides the layout it needs and what barriers wait for.
+    enum class ImageUsage : uint8_t
+    {
+        ColorAttachment, // loaded and stored
+        DepthAttachment, // loaded and stored
+        StorageWrite,    // written by compute shaders
+        ComputeSampled,
+        FragmentSampled,
+        TransferSrc,
+        TransferDst,
+        None, // virtual resources, they don't need barriers
+    };
+
+    // layout an image is in and the last stages and accesses that used it.
+    struct ImageState
+    {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+    };
+
+    ImageState ImageUsageState(ImageUsage usage);
+
+    // image the graph allocates for the frame. Its contents don't outlive the frame, so transient images
+    // whose passes don't overlap share memory.
+    struct TransientImageDesc
+    {
+        VkExtent2D extent{};
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkImageUsageFlags usage = 0;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        const char* name = "transient";
+    };
+
+    struct RenderGraphPass
+    {
+        struct Access
+        {
+            RenderGraphResource resource;
+            ImageUsage usage;
+            bool write;
+        };
+
+        std::string name;
+        std::string group; // passes of the same group are measured as one GPU profiler scope
+        std::function<void(VkCommandBuffer cmd)> execute;
+        std::vector<Access> accesses{};
+        bool side_effects = false; // writes something the graph doesn't track, never culled
+        bool culled = false;
+
+        RenderGraphPass& Read(RenderGraphResource resource, ImageUsage usage);
+        RenderGraphPass& Write(RenderGraphResource resource, ImageUsage usage);
+        RenderGraphPass& HasSideEffects();
+    };
+
+    /// Passes of a frame in the order they are recorded, with the resources they read and write. Executing
+    /// the graph culls passes nothing uses, records one batched barrier in front of every pass that needs
+    /// one and moves imported images into their final layout at the end. Transient images are placed in one
+    /// allocation per frame in flight, images whose passes don't overlap get the same memory. The
+    /// allocation is kept until a frame needs a different placement.
+    class RenderGraph
+    {
+      public:
+        struct Stats
+        {
+            uint32_t pass_count = 0;
+            uint32_t culled_pass_count = 0;
+            uint32_t barrier_count = 0;       // image barriers
+            uint32_t barrier_batch_count = 0; // pipeline barrier commands they were batched into
+            VkDeviceSize transient_bytes = 0; // memory of the transient images
+            VkDeviceSize unaliased_bytes = 0; // what they would need without aliasing
+        };
+
+        void Init(vkb::DispatchTable* device_dispatch, VmaAllocator allocator, uint32_t frame_count);
+        // releases the transient images of every frame. Needs the device to be idle.
+        void Destroy();
+        void SetFrameCount(uint32_t frame_count);
+
+        // starts building the graph of a frame. The frame's fence needs to be waited on first.
+        void BeginFrame(uint32_t frame_index);
+
+        // colour images only. Images with a final layout are outputs of the frame, passes writing them aren't
+        // culled.
+        RenderGraphResource ImportImage(
+            std::string name,
+            VkImage image,
+            VkImageView view,
+            ImageState initial_state,
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED
+        );
+        RenderGraphResource CreateImage(const TransientImageDesc& desc);
+        // stands in for work the graph doesn't track, like the buffers written by culling, so the passes
+        // reading it keep the passes writing it from being culled.
+        RenderGraphResource CreateVirtualResource(std::string name);
+
+        // passes are recorded in the order they are added.
+        RenderGraphPass& AddPass(
+            std::string name, std::string group, std::function<void(VkCommandBuffer cmd)> execute
+        );
+
+        // only valid while the graph executes.
+        VkImage Image(RenderGraphResource resource) const { return m_images[resource].image; }
+        VkImageView ImageView(RenderGraphResource resource) const { return m_images[resource].view; }
+
+        void Execute(VkCommandBuffer cmd, Utils::GpuProfiler& profiler);
+
+        const std::vector<RenderGraphPass>& Passes() const { return m_passes; }
+        const Stats& LastStats() const { return m_stats; }
+
+      private:
+        struct GraphImage
+        {
+            std::string name;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            ImageState state{};
+            VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE; // reading since the last write
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            bool transient = false;
+            bool is_virtual = false;
+            TransientImageDesc desc{};
+            uint32_t first_pass = UINT32_MAX;
+            uint32_t last_pass = 0;
+        };
+
+        struct TransientImage
+        {
+            TransientImageDesc desc{};
+            VkDeviceSize offset = 0;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+        };
+
+        // transient images of a frame in flight and the allocation they are bound to.
+        struct TransientHeap
+        {
+            VmaAllocation allocation = VK_NULL_HANDLE;
+            VkDeviceSize size = 0;
+            std::vector<TransientImage> images{};
+        };
+
+        void CullPasses();
+        void AllocateTransientImages();
+        void ReleaseHeap(TransientHeap& heap);
+        void RecordBarriers(VkCommandBuffer cmd, uint32_t pass_index);
+        void RecordFinalBarriers(VkCommandBuffer cmd);
+        void AddImageBarrier(GraphImage& image, const ImageState& target, bool write);
+
+        vkb::DispatchTable* m_device_dispatch = nullptr;
+        VmaAllocator m_allocator = VK_NULL_HANDLE;
+
+        std::vector<TransientHeap> m_heaps{};
+        uint32_t m_frame_index = 0;
+
+        std::vector<GraphImage> m_images{};
+        std::vector<RenderGraphPass> m_passes{};
+        std::vector<VkImageMemoryBarrier2> m_barriers{}; // of the pass being recorded
+        Stats m_stats{};
+    };
+} // namespace Renderer
@@ -17,5 +17,13 @@ namespace Renderer
         MaterialInstance* material;
         glm::mat4 transform;
         VkDeviceAddress vertex_buffer_address;
+        VertexFormat vertex_format;
+        MeshBounds bounds; // object space, also used to decode quantised vertices
+
+        // meshlets covering the index range, for GPU culling. meshlet_count is 0 if there are none.
+        VkDeviceAddress index_buffer_address;
+        VkDeviceAddress meshlet_buffer_address;
+        uint32_t first_meshlet;
+        uint32_t meshlet_count;
     };
 } // namespace Renderer
\ No newline at end of file
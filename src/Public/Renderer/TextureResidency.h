@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Renderer/ResourceStorage.h"
+#include "Renderer/VkTypes.h"
+
+#include <VkBootstrapDispatch.h>
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Renderer
+{
+    class VulkanEngine;
+    struct GLTFMaterial;
+
+    namespace Utils
+    {
+        class MemoryTracker;
+    }
+
+    // image binding of a material sampling a tracked texture, rewritten whenever the texture is reallocated.
+    struct TextureBinding
+    {
+        std::weak_ptr<GLTFMaterial> material;
+        uint32_t binding;
+    };
+
+    enum class TextureResidencyState : uint8_t
+    {
+        Resident,    // every mip the texture was loaded with is in memory
+        Evicted,     // the top mips were dropped, the image was reallocated at a smaller size
+        StreamingIn, // full size again, but the sampler is clamped to the old mips until the top ones upload
+    };
+
+    struct ResidentTexture
+    {
+        ImageHandle image; // the storage entry keeps its id, its contents are swapped when reallocated
+        VkExtent3D full_extent;
+        uint32_t full_mip_levels;
+        uint32_t dropped_mips = 0;
+        TextureResidencyState state = TextureResidencyState::Resident;
+        uint64_t last_used_frame = 0;
+        uint64_t registered_frame = 0; // its upload is recorded by the frame after at the latest
+        std::vector<TextureBinding> bindings{};
+
+        // mip 0 copied to host memory by the first eviction, the top mips are rebuilt from it.
+        BufferHandle evicted_pixels{};
+    };
+
+    /// Keeps the textures of loaded scenes within the device memory budget. While a device local heap is
+    /// over budget, textures that no material drew for a while lose their top mip. Once they are drawn again
+    /// and the budget has room, they are streamed back in. Reallocated textures give the materials sampling
+    /// them new descriptor sets, frames in flight keep drawing the old image until they are done with it.
+    class TextureResidency
+    {
+      public:
+        static constexpr uint64_t COLD_FRAMES = 120; // frames without a draw before a texture can be evicted
+        static constexpr float EVICT_BUDGET_FRACTION = 0.9f;     // evict above this fraction of the budget
+        static constexpr float STREAM_IN_BUDGET_FRACTION = 0.8f; // stream in while staying below this one
+        static constexpr uint32_t MIN_RESIDENT_SIZE = 64;        // mips smaller than this are never dropped
+        static constexpr uint32_t MAX_CHANGES_PER_FRAME = 4;
+        static constexpr VkDeviceSize MAX_UPLOAD_BYTES_PER_FRAME = 32ull * 1024 * 1024;
+
+        bool enabled = true;
+        // replaces the budget of device local heaps if not zero, to try eviction out without running out.
+        uint32_t budget_override_mib = 0;
+
+        void Destroy(vkb::DispatchTable& device_dispatch);
+
+        // tracks a mipmapped RGBA8 texture sampled by a binding of a glTF PBR material. Every material
+        // sampling the texture has to be registered, others would keep sampling the image it replaced.
+        // Can be called from loading threads.
+        void Register(
+            const std::shared_ptr<GLTFMaterial>& material, uint32_t binding, const ImageHandle& image
+        );
+
+        // evicts and streams in textures. Records into the frame command buffer before anything is drawn.
+        void Update(VulkanEngine& engine, VkCommandBuffer cmd, const Utils::MemoryTracker& memory_tracker);
+
+        // moved textures are copied in the shader read layout, which only settled textures are in.
+        bool CanMove(StorageId_t image_id) const;
+        // gives the materials sampling the texture descriptor sets pointing at the image it was moved to.
+        void ImageMoved(VulkanEngine& engine, StorageId_t image_id);
+
+        size_t TextureCount() const { return m_textures.size(); }
+        size_t EvictedCount() const { return m_evicted_count; }
+        VkDeviceSize EvictedBytes() const { return m_evicted_bytes; } // device memory freed by dropped mips
+
+      private:
+        struct Registration
+        {
+            std::weak_ptr<GLTFMaterial> material;
+            uint32_t binding;
+            ImageHandle image;
+        };
+
+        void AddRegistrations();
+        void UpdateLastUsedFrames();
+
+        void EvictColdTextures(VulkanEngine& engine, VkCommandBuffer cmd, VkDeviceSize bytes_over_budget);
+        void StreamInUsedTextures(VulkanEngine& engine, VkCommandBuffer cmd, VkDeviceSize headroom_bytes);
+        void UploadStreamedMips(VulkanEngine& engine, VkCommandBuffer cmd);
+
+        void DropTopMip(VulkanEngine& engine, VkCommandBuffer cmd, ResidentTexture& texture);
+        void StreamIn(VulkanEngine& engine, VkCommandBuffer cmd, ResidentTexture& texture);
+        void UploadTopMips(VulkanEngine& engine, VkCommandBuffer cmd, ResidentTexture& texture);
+
+        ImageHandle AllocateMips(VulkanEngine& engine, const ResidentTexture& texture, uint32_t dropped_mips);
+        void ReplaceImage(VulkanEngine& engine, ResidentTexture& texture, ImageHandle replacement);
+        void RewriteBindings(VulkanEngine& engine, ResidentTexture& texture, VkSampler sampler);
+
+        // the material sampler with the lod range starting at the first mip that is uploaded, hides the mips
+        // that aren't uploaded yet.
+        VkSampler ClampedSampler(VulkanEngine& engine, uint32_t dropped_mips);
+
+        std::mutex m_registration_mutex{};
+        std::vector<Registration> m_registrations{};
+
+        std::vector<ResidentTexture> m_textures{};
+        std::array<VkSampler, 16> m_clamped_samplers{};
+        uint64_t m_frame = 0;
+
+        size_t m_evicted_count = 0;
+        VkDeviceSize m_evicted_bytes = 0;
+    };
+} // namespace Renderer
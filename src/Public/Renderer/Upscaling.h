@@ -0,0 +1,27 @@
+#pragma once
+
+#include <VkBootstrapDispatch.h>
+#include <glm/vec2.hpp>
+#include <vulkan/vulkan_core.h>
+
+namespace Renderer
+{
+    struct GPUUpscalePushConstants
+    {
+        glm::vec2 source_size; // size of the whole source image in texels
+        glm::vec2 draw_extent; // part of the source image that was drawn, in texels
+    };
+
+    // Fullscreen pass that scales the draw extent of a viewport onto a colour attachment with a Catmull-Rom
+    // filter. Replaces the nearest neighbour blit when the viewport renders at a lower resolution.
+    struct UpscalePass
+    {
+        VkDescriptorSetLayout descriptor_layout = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        bool loaded = false;
+
+        bool BuildPipelines(vkb::DispatchTable& device_dispatch, VkFormat target_format);
+        void DestroyResources(vkb::DispatchTable& device_dispatch);
+    };
+} // namespace Renderer
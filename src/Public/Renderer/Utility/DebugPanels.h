@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderer/ResourceStorage.h"
+#include "Renderer/Utility/MemoryStats.h"
 #include "Renderer/Utility/VkLoader.h"
 #include "Renderer/VkTypes.h"
 
@@ -11,4 +12,13 @@ namespace Renderer::Debug
     void DrawStorageTableImGui(VulkanEngine& engine, ResourceStorage<AllocatedImage>& image_storage);
     void DrawStorageTableImGui(VulkanEngine& engine, ResourceStorage<AllocatedBuffer>& buffer_storage);
     void DrawStorageTableImGui(VulkanEngine& engine, ResourceStorage<MeshAsset>& mesh_storage);
+
+    // heap budget graphs and the bytes held by every storage. Meshes are counted in the buffers too.
+    void DrawMemoryImGui(
+        VulkanEngine& engine,
+        const Utils::MemoryTracker& memory_tracker,
+        ResourceStorage<AllocatedImage>& image_storage,
+        ResourceStorage<AllocatedBuffer>& buffer_storage,
+        ResourceStorage<MeshAsset>& mesh_storage
+    );
 } // namespace Renderer::Debug
\ No newline at end of file
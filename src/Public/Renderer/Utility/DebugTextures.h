@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ThirdParty/ImGUI.h"
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer::Utils
+{
+    /// ImGui textures of the images shown by the debug panels. They are only created once an image is
+    /// displayed, and the least recently displayed ones are removed once there are more than CAPACITY.
+    class DebugTextureCache
+    {
+      public:
+        static constexpr size_t CAPACITY = 64;
+
+        // creates the texture if the image doesn't have one yet. Evicted textures are retired, frames in
+        // flight might still draw them.
+        ImTextureID Get(VkImage image, VkImageView image_view, VkSampler sampler, uint64_t frame);
+
+        // retires the texture of an image that is destroyed or replaced.
+        void Forget(VkImage image, uint64_t frame);
+        // removes the retired textures no frame in flight can draw anymore. Call after waiting for the
+        // fence of the frame.
+        void ReleaseRetired(uint64_t frame, uint32_t frames_in_flight);
+        // needs the device to be idle.
+        void Clear();
+
+        // true if any texture was displayed during the frame, its images need to be readable by ImGui.
+        bool UsedInFrame(uint64_t frame) const
+        {
+            return m_entries.empty() == false && m_last_used_frame == frame;
+        }
+        size_t Size() const { return m_entries.size(); }
+
+      private:
+        struct Entry
+        {
+            VkImage image;
+            VkDescriptorSet descriptor_set;
+            uint64_t last_used_frame;
+        };
+
+        std::list<Entry> m_entries{}; // most recently displayed first
+        std::unordered_map<VkImage, std::list<Entry>::iterator> m_lookup{};
+
+        struct RetiredTexture
+        {
+            VkDescriptorSet descriptor_set;
+            uint64_t retired_frame; // the frame being recorded might have drawn it as well
+        };
+        std::vector<RetiredTexture> m_retired{};
+        uint64_t m_last_used_frame = 0;
+    };
+} // namespace Renderer::Utils
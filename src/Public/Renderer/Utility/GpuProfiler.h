@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vkb
+{
+    struct DispatchTable;
+}
+
+namespace Renderer::Utils
+{
+    // GPU time of every scope with the same name in a frame.
+    struct GpuTiming
+    {
+        std::string name;
+        double milliseconds;
+    };
+
+    /// Measures named scopes of the frame command buffers with timestamp queries. Every frame in flight has
+    /// its own query pool, results of a frame are read back when its pool is used again so they are a few
+    /// frames old.
+    class GpuProfiler
+    {
+      public:
+        static constexpr uint32_t MAX_SCOPES = 64;
+        static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+        // does nothing if the queue doesn't support timestamps, every scope will be invalid.
+        void Init(
+            vkb::DispatchTable& device_dispatch,
+            uint32_t frame_count,
+            bool timestamps_supported,
+            float timestamp_period_ns
+        );
+        void Destroy(vkb::DispatchTable& device_dispatch);
+
+        // recreates the query pools for a new number of frames in flight. Timings of the old frames are lost.
+        void SetFrameCount(vkb::DispatchTable& device_dispatch, uint32_t frame_count);
+
+        // resolves the last frame recorded with the given frame index and resets its queries. The fence of
+        // the frame needs to be waited on first.
+        void BeginFrame(vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd, uint32_t frame_index);
+
+        uint32_t BeginScope(vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd, std::string name);
+        void EndScope(vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd, uint32_t scope);
+
+        bool IsSupported() const { return m_frames.empty() == false; }
+
+        // timings of the last resolved frame in the order the scopes began.
+        const std::vector<GpuTiming>& Timings() const { return m_timings; }
+
+        // time of the named scopes in the last resolved frame, negative if it wasn't measured.
+        double TimingMilliseconds(std::string_view name) const;
+
+      private:
+        struct FrameQueries
+        {
+            VkQueryPool query_pool = VK_NULL_HANDLE;
+            std::vector<std::string> scope_names{}; // scope i writes queries 2i and 2i + 1
+        };
+
+        std::vector<FrameQueries> m_frames{};
+        uint32_t m_current_frame = 0;
+        float m_timestamp_period_ns = 1.0f;
+        bool m_timestamps_supported = false;
+
+        std::vector<GpuTiming> m_timings{};
+    };
+} // namespace Renderer::Utils
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Renderer::Utils
+{
+    // usage and budget of one memory heap, both in bytes. Usage includes memory allocated outside of VMA
+    // by this process when the budget extension is enabled.
+    struct HeapBudget
+    {
+        VkDeviceSize usage = 0;
+        VkDeviceSize budget = 0;
+        VkDeviceSize allocation_bytes = 0; // bytes of the allocations VMA made in the heap
+        uint32_t allocation_count = 0;
+        bool device_local = false;
+    };
+
+    // bytes of every resource sharing a debug name, numbered names like "texture_12" share "texture".
+    struct MemoryCategory
+    {
+        std::string name;
+        VkDeviceSize bytes = 0;
+        uint32_t resource_count = 0;
+    };
+
+    // bytes of the resources held by one ResourceStorage.
+    struct StorageMemory
+    {
+        const char* name;
+        VkDeviceSize bytes = 0;
+        uint32_t resource_count = 0;
+        std::vector<MemoryCategory> categories{}; // sorted by bytes, largest first
+    };
+
+    /// Samples the heap budgets of a VMA allocator every frame and keeps a short history of them for graphs.
+    /// Without VK_EXT_memory_budget the budgets are estimated by VMA from the heap sizes and only count
+    /// memory allocated through it.
+    class MemoryTracker
+    {
+      public:
+        static constexpr size_t HISTORY_LENGTH = 256;
+        // heaps using more than this fraction of their budget are reported.
+        static constexpr float BUDGET_WARNING_FRACTION = 0.9f;
+
+        void Init(VmaAllocator allocator, bool budget_extension_enabled);
+
+        // tells VMA the frame changed so it refreshes its cached budgets, then samples them.
+        void Update(VmaAllocator allocator, uint32_t frame_index);
+
+        bool BudgetExtensionEnabled() const { return m_budget_extension_enabled; }
+        const std::vector<HeapBudget>& Heaps() const { return m_heaps; }
+
+        // usage of the heap over the last HISTORY_LENGTH frames in MiB, oldest first.
+        std::array<float, HISTORY_LENGTH> UsageHistory(size_t heap) const;
+
+        // writes vmaBuildStatsString with the detailed map of every allocation to the given file.
+        bool DumpJson(VmaAllocator allocator, const std::filesystem::path& path) const;
+
+      private:
+        struct HeapHistory
+        {
+            std::array<float, HISTORY_LENGTH> usage_mib{};
+            bool over_budget = false;
+        };
+
+        std::vector<HeapBudget> m_heaps{};
+        std::vector<HeapHistory> m_history{};
+        size_t m_history_offset = 0; // next sample written, the oldest one once the history is full
+        bool m_budget_extension_enabled = false;
+    };
+
+    // category a resource with the given debug name is counted in.
+    std::string_view MemoryCategoryName(std::string_view debug_name);
+
+    // adds a resource to the storage and to the category of its name.
+    void AddStorageMemory(StorageMemory& storage, std::string_view debug_name, VkDeviceSize bytes);
+    void SortStorageCategories(StorageMemory& storage);
+} // namespace Renderer::Utils
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Renderer/VkTypes.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace Renderer::Utils
+{
+    /// Result of simulating a FIFO post-transform vertex cache over an index buffer.
+    struct VertexCacheStatistics
+    {
+        uint32_t triangle_count = 0;
+        uint32_t vertex_count = 0;
+        uint32_t cache_misses = 0; // number of vertex shader invocations
+
+        /// Average cache miss ratio, transformed vertices per triangle. ~0.5 at best, 3 at worst.
+        float Acmr() const;
+
+        /// Average transformed to vertex ratio. 1 is the best possible, each vertex is transformed once.
+        float Atvr() const;
+
+        VertexCacheStatistics& operator+=(const VertexCacheStatistics& other);
+    };
+
+    struct MeshOptimisationStats
+    {
+        VertexCacheStatistics before{};
+        VertexCacheStatistics after{};
+
+        MeshOptimisationStats& operator+=(const MeshOptimisationStats& other);
+    };
+
+    /// Simplified indices of a primitive, indexing the same vertices as the full detail version.
+    struct PrimitiveLod
+    {
+        std::vector<uint32_t> indices;
+        float error = 0.0f; // object space distance from the full detail surface
+    };
+
+    /// Indices and vertices of a single primitive after going through OptimiseMesh and GenerateLods.
+    struct OptimisedPrimitive
+    {
+        std::vector<uint32_t> indices;
+        std::vector<Vertex> vertices;
+        MeshOptimisationStats stats{};
+        std::vector<PrimitiveLod> lods{}; // increasingly coarse
+    };
+
+    /// Simulates a FIFO vertex cache of the given size. Most GPUs behave close to a 16-32 entry FIFO.
+    VertexCacheStatistics AnalyseVertexCache(
+        std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size = 16
+    );
+
+    /// Merges bitwise identical vertices and remaps the indices. Returns the new vertex count.
+    size_t DeduplicateVertices(std::span<uint32_t> indices, std::vector<Vertex>& vertices);
+
+    /// Reorders the triangles for post-transform vertex cache locality. (Tom Forsyth's linear speed vertex
+    /// cache optimisation)
+    void OptimiseVertexCache(std::span<uint32_t> indices, size_t vertex_count);
+
+    /// Reorders clusters of triangles so the ones facing outwards are drawn first, reducing overdraw. Expects
+    /// the indices to be optimised for the vertex cache already, clusters are split where the cache
+    /// efficiency stays within threshold of the original ordering.
+    void OptimiseOverdraw(
+        std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold = 1.05f
+    );
+
+    /// Reorders the vertices in the order they are first referenced by the indices and drops unreferenced
+    /// vertices. Returns the new vertex count.
+    size_t OptimiseVertexFetch(std::span<uint32_t> indices, std::vector<Vertex>& vertices);
+
+    /// Runs all of the above on a single primitive in order and measures the results.
+    MeshOptimisationStats OptimiseMesh(
+        std::vector<uint32_t>& indices, std::vector<Vertex>& vertices, float overdraw_threshold = 1.05f
+    );
+
+    /// Generates up to max_lod_count simplified versions of the primitive, each with around lod_ratio of the
+    /// triangles of the previous one. Stops early once the simplifier can't reduce the triangle count further
+    /// without the error growing beyond a fraction of the mesh size.
+    void GenerateLods(OptimisedPrimitive& primitive, uint32_t max_lod_count = 4, float lod_ratio = 0.5f);
+
+    /// Hash of the primitive contents, used to look up previously optimised primitives. variant separates
+    /// results of the same primitive that were processed with different settings.
+    uint64_t HashPrimitive(
+        std::span<const uint32_t> indices, std::span<const Vertex> vertices, uint64_t variant = 0
+    );
+
+    /// On-disk cache of optimised primitives, keyed by the hash of the source primitive. Lives next to the
+    /// asset it was generated from.
+    class MeshOptimisationCache
+    {
+      public:
+        explicit MeshOptimisationCache(std::filesystem::path cache_path);
+
+        /// Reads the cache file if it exists. A cache that is corrupt or from an older version is discarded,
+        /// primitives with indices past their vertices are dropped from it.
+        bool Load();
+
+        /// Writes the cache file if anything was added since it was loaded.
+        bool Save();
+
+        /// Returns nullptr if the cached primitive doesn't fit the source it is looked up for.
+        const OptimisedPrimitive* Find(
+            uint64_t key, size_t source_index_count, size_t source_vertex_count
+        ) const;
+        void Store(uint64_t key, OptimisedPrimitive primitive);
+
+      private:
+        std::filesystem::path m_cache_path;
+        std::unordered_map<uint64_t, OptimisedPrimitive> m_primitives{};
+        bool m_dirty = false;
+    };
+} // namespace Renderer::Utils
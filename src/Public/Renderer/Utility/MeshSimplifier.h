@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Renderer/VkTypes.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Renderer::Utils
+{
+    /// Simplifies the mesh with quadric error metric edge collapses until it has target_index_count indices
+    /// or the error would exceed max_error. Edges only collapse onto existing vertices so the result still
+    /// indexes the same vertex buffer. Vertices on open borders and attribute seams are never moved.
+    /// out_error is set to the biggest object space distance the simplified surface moved from the original.
+    std::vector<uint32_t> SimplifyMesh(
+        std::span<const uint32_t> indices,
+        std::span<const Vertex> vertices,
+        size_t target_index_count,
+        float max_error,
+        float& out_error
+    );
+} // namespace Renderer::Utils
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Renderer/VkTypes.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Renderer::Utils
+{
+    // limits of a single meshlet. 64 vertices & 124 triangles suit most mesh shader hardware, the compute
+    // culling path uses the same limits so the meshlets can be shared.
+    constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+    constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+    /// Splits the triangles of a primitive into meshlets, in order. Each meshlet is a contiguous range of the
+    /// indices so the index buffer doesn't need to be duplicated, which works well when the indices are
+    /// optimised for the vertex cache first. first_index is the offset of the indices in the mesh index
+    /// buffer and is added to the index ranges of the meshlets.
+    std::vector<GPUMeshlet> BuildMeshlets(
+        std::span<const uint32_t> indices, std::span<const Vertex> vertices, uint32_t first_index
+    );
+} // namespace Renderer::Utils
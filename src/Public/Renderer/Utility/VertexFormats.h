@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Renderer/VkTypes.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace Renderer::Utils
+{
+    MeshBounds ComputeMeshBounds(std::span<const Vertex> vertices);
+
+    /// Picks the smallest vertex format that can represent the given vertices without visible loss.
+    /// Falls back to VertexFormat::Standard for HDR colours or uvs that would lose too much precision as
+    /// halfs. Quantised positions are only used if the quantisation step stays under position_tolerance.
+    VertexFormat SelectVertexFormat(
+        std::span<const Vertex> vertices, const MeshBounds& bounds, float position_tolerance = 0.0005f
+    );
+
+    size_t VertexFormatStride(VertexFormat format);
+    const char* VertexFormatName(VertexFormat format);
+
+    /// Converts the vertices into the given format. The result can be copied directly into a vertex buffer.
+    std::vector<std::byte> PackVertices(
+        std::span<const Vertex> vertices, VertexFormat format, const MeshBounds& bounds
+    );
+
+    /// Octahedral encoding of a unit vector into [-1, 1]^2.
+    glm::vec2 OctahedralEncode(glm::vec3 normal);
+    glm::vec3 OctahedralDecode(glm::vec2 encoded);
+} // namespace Renderer::Utils
@@ -17,6 +17,56 @@ namespace Renderer::Utils
         VkImageLayout target_layout
     );
 
+    // same as TransitionImage but only for mip_count colour mips starting at base_mip.
+    void TransitionImageMips(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkImage image,
+        uint32_t base_mip,
+        uint32_t mip_count,
+        VkImageLayout current_layout,
+        VkImageLayout target_layout
+    );
+
+    // queue family ownership transfer of a colour image. Recorded once on the releasing queue with its stage
+    // and access masks, then once on the acquiring queue with its own, both with the same layouts. The
+    // layout transition happens between the two.
+    void TransferImageOwnership(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkImage image,
+        VkImageLayout current_layout,
+        VkImageLayout target_layout,
+        uint32_t src_queue_family,
+        uint32_t dst_queue_family,
+        VkPipelineStageFlags2 stage_mask,
+        VkAccessFlags2 access_mask,
+        bool release
+    );
+
+    // fills mips 1 to mip_count - 1 by blitting every mip down from the one before it. The mips need to be
+    // in TRANSFER_DST_OPTIMAL with mip 0 written, they end up in TRANSFER_SRC_OPTIMAL.
+    void GenerateMipmaps(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkImage image,
+        VkExtent2D extent,
+        uint32_t mip_count
+    );
+
+    // size of the given mip of an image, never smaller than a texel.
+    VkExtent2D MipExtent(VkExtent2D extent, uint32_t mip);
+
+    // barrier over all memory, for buffers written and read by different stages.
+    void GlobalMemoryBarrier(
+        vkb::DispatchTable* device_dispatch,
+        VkCommandBuffer cmd,
+        VkPipelineStageFlags2 src_stage,
+        VkAccessFlags2 src_access,
+        VkPipelineStageFlags2 dst_stage,
+        VkAccessFlags2 dst_access
+    );
+
     void CopyImageToImage(
         vkb::DispatchTable* device_dispatch,
         VkCommandBuffer cmd,
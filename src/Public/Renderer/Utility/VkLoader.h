@@ -2,6 +2,7 @@
 
 #include "Renderer/Material.h"
 #include "Renderer/ResourceStorage.h"
+#include "Renderer/Utility/MeshOptimiser.h"
 #include "Renderer/VkTypes.h"
 
 #include "ThirdParty/fastgltf.h"
@@ -19,12 +20,33 @@ namespace Renderer
         MaterialInstance material;
     };
 
+    // simplified index range of a GeoSurface, in the same index buffer.
+    struct GeoSurfaceLod
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        float error; // object space distance from the full detail surface
+    };
+
     // #TODO: rename to IndexedGeometry
     struct GeoSurface
     {
         uint32_t first_index;
         uint32_t index_count;
         std::shared_ptr<GLTFMaterial> material;
+
+        // increasingly coarse versions of the surface, LOD 0 is the full detail range above.
+        std::vector<GeoSurfaceLod> lods{};
+
+        // range of the mesh meshlets covering LOD 0, meshlet_count is 0 if the mesh has no meshlets.
+        uint32_t first_meshlet = 0;
+        uint32_t meshlet_count = 0;
+
+        uint32_t LodCount() const { return static_cast<uint32_t>(lods.size()) + 1; }
+        GeoSurfaceLod Lod(uint32_t lod) const
+        {
+            return lod == 0 ? GeoSurfaceLod{ first_index, index_count, 0.0f } : lods[lod - 1];
+        }
     };
 
     struct MeshAsset
@@ -33,6 +55,21 @@ namespace Renderer
 
         GPUMeshBuffers buffers;
         std::vector<GeoSurface> surfaces;
+
+        // vertex cache efficiency before and after import, summed over all surfaces.
+        Utils::MeshOptimisationStats optimisation_stats{};
+    };
+
+    struct MeshImportSettings
+    {
+        // deduplicate vertices, reorder indices & vertices for the vertex cache, overdraw and vertex fetch.
+        bool optimise = true;
+        // generate simplified LODs for each surface.
+        bool generate_lods = true;
+        // read & write optimised primitives from <file>.meshcache next to the asset.
+        bool use_cache = true;
+        // split the full detail surfaces into meshlets for GPU cluster culling.
+        bool build_meshlets = true;
     };
 
     struct Viewport;
@@ -76,8 +113,10 @@ namespace Renderer::Utils
 
     /// Loads meshes from a glTF file. Supports both binary and json gltf. Returns nullopt on failure.
     std::optional<std::vector<MeshHandle>> LoadGltfMeshes(
-        VulkanEngine* engine, std::filesystem::path file_path
+        VulkanEngine* engine, std::filesystem::path file_path, const MeshImportSettings& settings = {}
     );
 
-    std::optional<GLTFScene> LoadGltfScene(VulkanEngine& engine, std::filesystem::path file_path);
+    std::optional<GLTFScene> LoadGltfScene(
+        VulkanEngine& engine, std::filesystem::path file_path, const MeshImportSettings& settings = {}
+    );
 } // namespace Renderer::Utils
\ No newline at end of file
@@ -10,6 +10,11 @@ namespace Renderer::Utils
         const vkb::DispatchTable& device_dispatch, const char* file_path, VkShaderModule* out_shader_module
     );
 
+    // compute pipelines only have a single stage so they don't need a builder.
+    VkPipeline BuildComputePipeline(
+        const vkb::DispatchTable& device_dispatch, VkPipelineLayout layout, VkShaderModule shader
+    );
+
     class PipelineBuilder
     {
       public:
@@ -31,7 +36,7 @@ namespace Renderer::Utils
         PipelineBuilder SetColorAttachmentFormat(VkFormat format);
         PipelineBuilder SetDepthFormat(VkFormat format);
         PipelineBuilder DisableDepthTest();
-        PipelineBuilder EnableDepthTest(VkCompareOp compare_op = VK_COMPARE_OP_LESS);
+        PipelineBuilder EnableDepthTest(VkCompareOp compare_op = VK_COMPARE_OP_LESS, bool depth_write = true);
         VkPipeline BuildPipeline(const vkb::DispatchTable& device_dispatch);
 
       private:
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Renderer/DynamicResolution.h"
 #include "Renderer/FrameDrawContext.h"
+#include "Renderer/OcclusionCulling.h"
 #include "Renderer/ResourceStorage.h"
 #include "Renderer/VkTypes.h"
 
@@ -14,6 +16,29 @@
 
 namespace Renderer
 {
+    /// CPU side of the culling passes of a viewport. Prepared on the job system before the frame is recorded,
+    /// or while recording if the viewport changed in between.
+    struct PreparedDraws
+    {
+        bool prepared = false;
+        size_t object_count = 0;
+        bool meshlet_culling = false;
+        bool occlusion_culling = false;
+
+        // indirect commands of the render objects with culled meshlets, see MeshletDrawCommands.
+        std::vector<int32_t> meshlet_command_indices{};
+        std::vector<VkDrawIndexedIndirectCommand> meshlet_commands{};
+        uint32_t meshlet_index_count = 0;
+
+        // world space bounding spheres and commands of occlusion culled objects, see OcclusionDrawCommands.
+        std::vector<int32_t> occlusion_command_indices{};
+        std::vector<glm::vec4> occlusion_spheres{};
+        std::vector<VkDrawIndexedIndirectCommand> occlusion_commands{};
+
+        // render objects in the order they are drawn, grouped by the index buffer they are drawn from.
+        std::vector<uint32_t> draw_order{};
+    };
+
     /// Structure that contains all the necessary information to render a single viewport and everything in
     /// it.
     struct Viewport
@@ -25,18 +50,29 @@ namespace Renderer
         Viewport& operator=(const Viewport&) = delete;
         Viewport& operator=(Viewport&&) = default;
 
-        ImageHandle depth_image;
         ImageHandle draw_image;
-        FrameDrawContext frame_context; // gets reset every frame for a new draw.
+        DepthPyramid depth_pyramid;     // farthest depth of the last draw, used for occlusion culling
+        BufferHandle object_visibility; // visibility of each occlusion culled object in the last draw
+        uint32_t object_visibility_count = 0;
+        FrameDrawContext frame_context;  // filled by the game, see VulkanEngine::PublishFrameContexts
+        FrameDrawContext render_context; // snapshot the renderer draws, the game never touches it
+        PreparedDraws prepared_draws;    // built from render_context, reset when it is published
 
         // if true, a clear command will be issued to clear the draw image every frame.
         bool clear_before_draw = true;
+        // if true, the draw image is filled with the current compute effect instead of cleared.
+        bool compute_background = false;
 
         // if you want to draw multiple scenes onto the same textures, use the viewport options below. If
         // zero, will cover the entire draw_image.
         glm::vec2 viewport_position;
         glm::vec2 viewport_extent;
         float render_scale = 1.0f;
+        DynamicResolution dynamic_resolution; // drives render_scale from the GPU time when enabled
+        float lod_pixel_error = 1.0f; // see FrameDrawContext::lod_pixel_error
+        bool meshlet_culling = false; // cull the meshlets of full detail surfaces on the GPU before drawing
+        bool occlusion_culling = false; // cull objects against the depth of the previously visible objects
+        bool depth_prepass = false;     // lay down depth first so opaque surfaces are only shaded once
 
         VkExtent2D draw_extent; // calculated every frame from image size and render scale.
         std::string name;
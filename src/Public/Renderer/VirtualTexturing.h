@@ -0,0 +1,168 @@
+#pragma once
+
+#include "Renderer/FramePacing.h"
+#include "Renderer/ResourceStorage.h"
+#include "Renderer/VkTypes.h"
+
+#include <VkBootstrapDispatch.h>
+#include <glm/vec4.hpp>
+#include <tbb/task_group.h>
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Renderer
+{
+    class VulkanEngine;
+
+    // RGBA8 texture kept in CPU memory, only the pages that were sampled recently are on the GPU.
+    struct VirtualTexture
+    {
+        std::string name;
+        VkExtent2D extent;
+        uint32_t page_offset; // first entry of the texture in the page table
+        uint32_t page_count;
+        uint32_t mip_count; // page mips, the coarsest one is a single page covering the whole texture
+
+        // CPU mip chain the pages are cut out of, mip 0 is the loaded image.
+        std::vector<std::vector<uint8_t>> mips{};
+    };
+
+    /// Software virtual texturing for textures too large to keep in device memory. Textures are split into
+    /// TILE_SIZE pages per mip, addressed through a page table that maps every page to a tile of the cache
+    /// atlas. Pages that aren't resident map to the closest resident page of a coarser mip, the coarsest mip
+    /// of every texture is always resident. The glTF PBR fragment shader writes the pages it wanted into a
+    /// feedback buffer, missing pages are cut out of the CPU mips by background tasks and uploaded through
+    /// the upload requests. Least recently used tiles are replaced once the cache is full.
+    class VirtualTexturing
+    {
+      public:
+        // page size and cache size need to match data/shader/virtual_texture.glsl.
+        static constexpr uint32_t TILE_SIZE = 128;
+        static constexpr uint32_t CACHE_TILES = 32; // tiles per side of the cache atlas
+        // textures at least this large in either dimension are loaded as virtual textures.
+        static constexpr uint32_t MIN_VIRTUAL_SIZE = 8192;
+        static constexpr uint32_t MAX_PAGES = 1u << 18; // page table entries shared by every virtual texture
+        static constexpr uint32_t MAX_LOADS_PER_FRAME = 16;
+        static constexpr uint32_t MAX_PENDING_LOADS = 64;
+
+        void Init(VulkanEngine& engine);
+        // waits for the page loads that are still running.
+        void Destroy();
+
+        static bool WantsVirtual(VkExtent2D extent)
+        {
+            return extent.width >= MIN_VIRTUAL_SIZE || extent.height >= MIN_VIRTUAL_SIZE;
+        }
+
+        // copies the pixels and builds the mip chain on the CPU, pages are uploaded once they are sampled.
+        // Returns what to write into MaterialParameters::virtual_texture to sample the texture, nullopt if
+        // the page table is full. Virtual textures live until the engine shuts down. Can be called from
+        // loading threads.
+        std::optional<glm::uvec4> Create(const uint8_t* pixels, VkExtent2D extent, std::string_view name);
+
+        // reads the pages the frame in the current frame slot wanted, starts loading the missing ones and
+        // updates the page table. Records into the frame command buffer before anything is drawn.
+        void Update(VulkanEngine& engine, VkCommandBuffer cmd);
+        // makes the feedback written by the frame visible to the host, once everything is drawn.
+        void EndFrame(vkb::DispatchTable& device_dispatch, VkCommandBuffer cmd);
+
+        // bound to the scene descriptor of every viewport. Tiles have no filtering border, the shader fetches
+        // single texels so it doesn't filter across tile edges.
+        VkImageView CacheView() const { return m_cache->image_view; }
+        VkDeviceAddress PageTableAddress() const { return m_page_table_address; }
+        VkDeviceAddress FeedbackAddress() const { return m_feedback_addresses[m_feedback_slot]; }
+
+        size_t TextureCount() const { return m_textures.size(); }
+        uint32_t ResidentTiles() const { return m_resident_tiles; }
+        uint32_t PendingLoads() const { return m_pending_loads; }
+
+      private:
+        friend class VirtualTileUploadRequest;
+
+        static constexpr uint32_t INVALID_INDEX = ~0u;
+
+        struct PageState
+        {
+            uint32_t cache_slot = INVALID_INDEX; // reserved once a load starts, sampled once resident
+            uint64_t last_requested_frame = 0;
+            bool loading = false;
+            bool resident = false;
+        };
+
+        struct CacheSlot
+        {
+            uint32_t page = INVALID_INDEX;
+            uint64_t last_used_frame = 0;
+            bool pinned = false; // coarsest mip of a texture, never replaced
+        };
+
+        struct PageCoordinate
+        {
+            uint32_t texture;
+            uint32_t mip;
+            uint32_t x;
+            uint32_t y;
+        };
+
+        void AddCreatedTextures();
+        void FinishUploadedTiles();
+        void ReadFeedback(VulkanEngine& engine, VkCommandBuffer cmd, std::vector<uint32_t>& missing_pages);
+        void LoadMissingPages(VulkanEngine& engine, const std::vector<uint32_t>& missing_pages);
+        void UpdatePageTable(VulkanEngine& engine, VkCommandBuffer cmd);
+
+        // reserves a cache slot and starts cutting the page out on a background task. Fails if every slot is
+        // pinned, loading or used this frame.
+        bool StartLoad(VulkanEngine& engine, uint32_t page, bool pinned);
+        uint32_t FindCacheSlot();
+        void LoadTile(
+            VulkanEngine& engine,
+            const VirtualTexture& texture,
+            PageCoordinate coordinate,
+            uint32_t page,
+            uint32_t cache_slot
+        );
+
+        // called by the tile upload once the copy into the cache is recorded, from any thread.
+        void TileUploaded(uint32_t page);
+
+        PageCoordinate PageToCoordinate(uint32_t page) const;
+        // page of the next coarser mip covering the page, INVALID_INDEX for the coarsest mip.
+        uint32_t ParentPage(uint32_t page) const;
+
+        // textures are created by loading threads, everything else is only touched by the render thread.
+        std::mutex m_created_mutex{};
+        std::vector<std::unique_ptr<VirtualTexture>> m_created{};
+        uint32_t m_allocated_pages = 0;
+
+        std::mutex m_uploaded_mutex{};
+        std::vector<uint32_t> m_uploaded_pages{};
+
+        std::vector<std::unique_ptr<VirtualTexture>> m_textures{};
+        std::vector<bool> m_dirty_textures{};
+        std::vector<PageState> m_pages{};
+        std::vector<CacheSlot> m_cache_slots{};
+        std::vector<uint32_t> m_page_table{}; // CPU copy of the page table, uploaded per dirty texture
+
+        ImageHandle m_cache{};
+        BufferHandle m_page_table_buffer{};
+        VkDeviceAddress m_page_table_address = 0;
+
+        // one per frame slot, read once the frame that wrote it is done.
+        std::array<BufferHandle, MAX_FRAME_OVERLAP> m_feedback_buffers{};
+        std::array<VkDeviceAddress, MAX_FRAME_OVERLAP> m_feedback_addresses{};
+        uint32_t m_feedback_slot = 0;
+
+        tbb::task_group m_loader{};
+        uint64_t m_frame = 0;
+        uint32_t m_resident_tiles = 0;
+        uint32_t m_pending_loads = 0;
+    };
+} // namespace Renderer
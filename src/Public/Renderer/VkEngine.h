@@ -1,46 +1,51 @@
 #pragma once
 
+#include "Jobs/JobSystem.h"
+#include "Renderer/Background.h"
+#include "Renderer/FramePacing.h"
+#include "Renderer/GeometryPool.h"
 #include "Renderer/Material.h"
 #include "Renderer/MaterialInterface.h"
+#include "Renderer/MemoryPools.h"
+#include "Renderer/MeshletCulling.h"
+#include "Renderer/OcclusionCulling.h"
+#include "Renderer/RenderGraph.h"
 #include "Renderer/RenderObject.h"
 #include "Renderer/ResourceStorage.h"
+#include "Renderer/TextureResidency.h"
+#include "Renderer/Upscaling.h"
+#include "Renderer/Utility/DebugTextures.h"
 #include "Renderer/Utility/DeletionQueue.h"
+#include "Renderer/Utility/GpuProfiler.h"
+#include "Renderer/Utility/MemoryStats.h"
 #include "Renderer/Utility/UploadRequest.h"
 #include "Renderer/Utility/VkDescriptors.h"
 #include "Renderer/Utility/VkLoader.h"
+#include "Renderer/VirtualTexturing.h"
 #include "Renderer/Viewport.h"
 #include "Renderer/VkTypes.h"
 
 #include "ThirdParty/ImGUI.h"
 #include <VkBootstrapDispatch.h>
+#include <array>
 #include <unordered_map>
 #include <vulkan/vulkan_core.h>
 
 struct SDL_Window;
 
+namespace vkb
+{
+    struct Swapchain;
+}
+
 // we don't support having separate formats for viewports, these are unified across the engine.
 constexpr VkFormat VKENGINE_DRAW_IMAGE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
 constexpr VkFormat VKENGINE_DEPTH_IMAGE_FORMAT = VK_FORMAT_D32_SFLOAT;
+constexpr float VKENGINE_CAMERA_NEAR_PLANE = 0.1f;
+constexpr float VKENGINE_CAMERA_FAR_PLANE = 10000.f;
 
 namespace Renderer
 {
-    struct BackgroundPushConstants
-    {
-        glm::vec4 data1;
-        glm::vec4 data2;
-        glm::vec4 data3;
-        glm::vec4 data4;
-    };
-
-    struct ComputeEffect
-    {
-        const char* name;
-        const char* path;
-        VkPipeline pipeline;
-        VkPipelineLayout layout;
-        BackgroundPushConstants push_constants;
-    };
-
     struct FrameData
     {
         VkCommandPool command_pool = nullptr;
@@ -50,6 +55,11 @@ namespace Renderer
         VkSemaphore render_semaphore = nullptr;    // so the present can wait for this frame to finish
         VkFence render_fence = nullptr;            // so we can wait for this frame on cpu
 
+        // backgrounds of the frame recorded for the compute queue, only created if there is one.
+        VkCommandPool compute_command_pool = nullptr;
+        VkCommandBuffer compute_command_buffer = nullptr;
+        VkSemaphore background_semaphore = nullptr; // so the frame waits for its backgrounds
+
         Utils::DescriptorAllocatorDynamic frame_descriptors;
         Utils::DeletionQueue deletion_queue;
 
@@ -58,7 +68,34 @@ namespace Renderer
         std::vector<ImageHandle> images_in_use;
     };
 
-    constexpr int FRAME_OVERLAP = 2;
+    // swapchain and images replaced by a resize while frames in flight might still use them.
+    struct RetiredResources
+    {
+        int retired_frame = 0; // the first frame that doesn't use them anymore
+        VkSwapchainKHR swapchain = nullptr;
+        std::vector<VkImageView> swapchain_image_views;
+        std::vector<ImageHandle> images;
+
+        // of removed present windows, destroyed after the swapchain.
+        VkSurfaceKHR surface = nullptr;
+        std::vector<VkSemaphore> semaphores;
+    };
+
+    // another window a viewport is presented to, see VulkanEngine::AddPresentWindow.
+    struct PresentWindow
+    {
+        static constexpr uint32_t NO_IMAGE = UINT32_MAX;
+
+        SDL_Window* window = nullptr;
+        size_t viewport = 0;
+        VkSurfaceKHR surface = nullptr;
+        VkSwapchainKHR swapchain = nullptr;
+        std::vector<VkImage> swapchain_images;
+        VkExtent2D swapchain_extent{};
+        std::array<VkSemaphore, MAX_FRAME_OVERLAP> acquire_semaphores{}; // one per frame slot
+        bool resize_requested = false;
+        uint32_t acquired_image = NO_IMAGE; // image of the frame being recorded
+    };
 
     class VulkanEngine
     {
@@ -69,7 +106,10 @@ namespace Renderer
             SDL_Window* window,
             float backbuffer_scale,
             bool use_validation_layers,
-            bool immediate_uploads
+            bool immediate_uploads,
+            bool compress_vertices,
+            PresentMode present_mode = PresentMode::Fifo,
+            uint32_t frames_in_flight = DEFAULT_FRAME_OVERLAP
         );
         VulkanEngine(const VulkanEngine&) = delete; // no copy pls
 
@@ -86,40 +126,69 @@ namespace Renderer
         // run main loop
         void Update();
 
-        std::vector<ComputeEffect>& ComputeEffects() { return m_compute_effects; }
+        // CPU work of the frame that can run on the job system before Update records it. Update still works
+        // without them, it just does the work itself.
+        void PrepareFrame(Jobs::JobSystem& job_system);
+        void PrepareUploads();
+
+        // hands the contexts the game extracted to the renderer as its snapshots to draw, and gives the game
+        // empty contexts for the next frame. Neither extraction nor recording can be running.
+        void PublishFrameContexts();
+
+        std::vector<ComputeEffect>& ComputeEffects() { return m_background.effects; }
         std::size_t CurrentComputeEffect() { return m_current_effect; }
         void SetCurrentComputeEffect(std::size_t target) { m_current_effect = target; }
 
         float GetRenderScale() const;
         void SetRenderScale(float scale);
 
+        // the swapchain is recreated with the new mode before the next frame.
+        void SetPresentMode(PresentMode mode);
+        PresentMode GetPresentMode() const { return m_present_mode; }
+        uint32_t FramesInFlight() const { return uint32_t(m_frames.size()); }
+        // the frames are recreated with the new count before the next frame. Clamped to MAX_FRAME_OVERLAP.
+        void SetFramesInFlight(uint32_t frames_in_flight) { m_requested_frames_in_flight = frames_in_flight; }
+
+        // frame pacing, called by the main loop. The limiter waits before input is polled.
+        void LimitFrameRate() { m_frame_limiter.Wait(); }
+        void SetMaxFrameRate(float max_fps) { m_frame_limiter.max_fps = max_fps; }
+        void RecordInput() { m_input_latency.RecordInput(); }
+
         // these are used by things that write to the GPU memory like uploads.
         // can probably be interfaced to avoid making them public on the engine.
-        FrameData& GetCurrentFrame() { return m_frames[frame_number % FRAME_OVERLAP]; }
+        FrameData& GetCurrentFrame() { return m_frames[frame_number % m_frames.size()]; }
         vkb::DispatchTable& DeviceDispatchTable() { return m_device_dispatch; }
         vkb::InstanceDispatchTable& InstanceDispatchTable() { return m_instance_dispatch; }
         VmaAllocator& Allocator() { return m_allocator; }
         Material_GLTF_PBR& PBRMaterial() { return m_gltf_pbr_material; }
         VkSampler Sampler() { return m_default_sampler_nearest; }
+        const VkSamplerCreateInfo& SamplerCreateInfo() const { return m_default_sampler_nearest_info; }
         ImageHandle PlaceholderImage() { return m_checkerboard_image; }
         ImageHandle WhiteImage() { return m_white_image; }
         ImageHandle BlackImage() { return m_black_image; }
         ImageHandle GreyImage() { return m_grey_image; }
+        TextureResidency& Residency() { return m_texture_residency; }
+        VirtualTexturing& VirtualTextures() { return m_virtual_texturing; }
+        GeometryPool& Geometry() { return m_geometry_pool; }
+        MemoryPools& Pools() { return m_memory_pools; }
 
         BufferHandle CreateBuffer(
             size_t allocation_size,
             VkBufferUsageFlags usage,
             VmaMemoryUsage memory_usage,
             VmaAllocationCreateFlags allocation_flags = 0,
-            const char* debug_name = "unnamed_buffer"
+            const char* debug_name = "unnamed_buffer",
+            AllocationClass allocation_class = AllocationClass::General
         );
         BufferHandle CreateBuffer(
             void* buffer_data,
             size_t buffer_size,
             VkBufferUsageFlags usage,
-            const char* debug_name = "unnamed_buffer"
+            const char* debug_name = "unnamed_buffer",
+            AllocationClass allocation_class = AllocationClass::General
         );
         void DestroyBuffer(const AllocatedBuffer& buffer);
+        VkDeviceAddress BufferDeviceAddress(const BufferHandle& buffer);
 
         // allocate an empty image with given dimensions.
         ImageHandle AllocateImage(
@@ -131,7 +200,9 @@ namespace Renderer
             VkMemoryPropertyFlags required_memory_flags = 0,
             VmaAllocationCreateFlags allocation_flags = 0,
             bool mipmapped = false,
-            const char* debug_name = "unnamed_image"
+            const char* debug_name = "unnamed_image",
+            uint32_t mip_levels = 0, // overrides the mip count picked by mipmapped if not zero
+            AllocationClass allocation_class = AllocationClass::General
         );
 
         // allocate an image and copy the given data inside. RGBA8 format is assumed.
@@ -142,40 +213,103 @@ namespace Renderer
             VkImageUsageFlags usage,
             VkImageLayout layout,
             bool mipmapped = false,
-            const char* debug_name = "unnamed_image"
+            const char* debug_name = "unnamed_image",
+            AllocationClass allocation_class = AllocationClass::General
         );
         void DestroyImage(const AllocatedImage& image);
 
-        GPUMeshBuffers UploadMesh(std::span<uint32_t> indices, std::span<Vertex> vertices);
+        // if no vertex format is given, the most compact format that fits the vertices is used. The mesh is
+        // sub-allocated from the geometry pool, it gets buffers of its own only once the pool is full.
+        GPUMeshBuffers UploadMesh(
+            std::span<uint32_t> indices,
+            std::span<Vertex> vertices,
+            std::optional<VertexFormat> vertex_format = std::nullopt
+        );
+        // uploads the meshlets of a mesh uploaded with UploadMesh. Does nothing if there are no meshlets.
+        void UploadMeshlets(GPUMeshBuffers& buffers, std::span<GPUMeshlet> meshlets);
         MeshHandle RegisterMeshAsset(MeshAsset&& asset, std::string_view debug_name = "unnamed mesh");
 
         void RequestUpload(std::unique_ptr<Utils::IUploadRequest>&& upload_request);
 
         // helpers for creating viewports
         ImageHandle CreateDrawImage(uint32_t width, uint32_t height);
-        ImageHandle CreateDepthImage(uint32_t width, uint32_t height);
 
+        // ImGui texture of the image, created the first time it is displayed. Null for images that can't be
+        // sampled.
         ImTextureID ImageDebugTextureId(const ImageHandle& image);
 
+        // presents the viewport to another window as well. Every window gets a swapchain of its own, all of
+        // them are presented by one present call after the frame. Returns false if the GPU can't present to
+        // the window.
+        bool AddPresentWindow(SDL_Window* window, size_t viewport_index);
+        void RemovePresentWindow(SDL_Window* window);
+        size_t PresentWindowCount() const { return m_present_windows.size(); }
+
         size_t main_viewport; // this is the viewport that is rendered on the main window swapchain.
         std::vector<Viewport> active_viewports; // #TODO: make into unique ptrs for ptr stability
 
       private:
+        // moves allocations of the pools and patches the storages.
+        friend class MemoryPools;
+
         void DestroyPendingResources();
-        void FinishPendingUploads(VkCommandBuffer cmd);
+        // returns true if any upload was recorded.
+        bool FinishPendingUploads(VkCommandBuffer cmd);
+        void PrepareViewportDraws(Viewport& viewport, Jobs::JobSystem* job_system);
+        bool IsViewportPrepared(const Viewport& viewport) const;
+        // prepared viewports with occlusion culled objects draw them in an early and a late phase.
+        bool UsesOcclusionCulling(const Viewport& viewport) const;
         void ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function);
 
         // draw loop
         void Draw();
+        // records the backgrounds of the frame on the compute queue and submits them. Returns false if they
+        // have to be drawn on the graphics queue instead.
+        bool SubmitAsyncBackgrounds();
         void DrawViewportBackground(const Viewport& viewport, VkCommandBuffer cmd);
-        void DrawViewportGeometry(const Viewport& viewport, VkCommandBuffer cmd);
+        MeshletDrawCommands CullViewportMeshlets(const Viewport& viewport, VkCommandBuffer cmd);
+        OcclusionDrawCommands CullViewportObjects(Viewport& viewport, VkCommandBuffer cmd);
+        void DispatchOcclusionCulling(
+            Viewport& viewport,
+            VkCommandBuffer cmd,
+            const OcclusionDrawCommands& occlusion_draws,
+            OcclusionPhase phase
+        );
+        void UpdateObjectVisibility(Viewport& viewport, VkCommandBuffer cmd, uint32_t object_count);
+        void UpdateDepthPyramid(Viewport& viewport, VkCommandBuffer cmd);
+        void BuildDepthPyramid(Viewport& viewport, VkCommandBuffer cmd, VkImageView depth_view);
+        void DrawViewportGeometry(
+            const Viewport& viewport,
+            VkCommandBuffer cmd,
+            VkImageView depth_view,
+            const MeshletDrawCommands& meshlet_draws,
+            const OcclusionDrawCommands& occlusion_draws,
+            OcclusionPhase phase
+        );
+        void DrawRenderObjects(
+            const Viewport& viewport,
+            VkCommandBuffer cmd,
+            VkDescriptorSet scene_data_descriptor,
+            const MeshletDrawCommands& meshlet_draws,
+            const OcclusionDrawCommands& occlusion_draws,
+            OcclusionPhase phase,
+            bool depth_only
+        );
+        glm::mat4 ViewportProjection(const Viewport& viewport) const;
+        void DrawUpscaledViewport(
+            const Viewport& viewport, VkCommandBuffer cmd, VkImageView target_image_view
+        );
         void DrawImgui(VkCommandBuffer cmd, VkImageView target_image_view);
 
         bool InitVulkan();
         void InitAllocator();
         void InitCommands();
         void InitSyncStructures();
-        void InitFrameDescriptors();
+        void InitSceneDescriptors();
+        void InitFrames();
+        void InitFrame(FrameData& frame);
+        void DestroyFrame(FrameData& frame);
+        void RecreateFrames(uint32_t frames_in_flight);
         void InitDefaultDescriptors();
         bool InitPipelines();
         bool InitMaterialPipelines();
@@ -183,9 +317,23 @@ namespace Renderer
         void InitImgui();
 
         void CreateSwapchain(uint32_t width, uint32_t height);
+        vkb::Swapchain BuildSwapchain(
+            VkSurfaceKHR surface, uint32_t width, uint32_t height, VkSwapchainKHR old_swapchain
+        );
 
         void DestroySwapchain();
+        // recreates the swapchain from the old one without waiting for the device, the old one is retired.
         void ResizeSwapchain();
+        // the main viewport renders at the window size.
+        void ResizeMainViewport(uint32_t width, uint32_t height, RetiredResources& retired);
+        // releases the retired resources whose frames are done, or all of them if the device is idle.
+        void ReleaseRetiredResources(bool device_idle);
+
+        void ResizePresentWindow(PresentWindow& window);
+        void RetirePresentWindow(PresentWindow& window);
+        // windows without an image this frame are skipped, they don't hold up the main window.
+        void AcquirePresentWindowImages();
+        void CopyToPresentWindow(VkCommandBuffer cmd, const PresentWindow& window);
         void SetAllocationName(VmaAllocation allocation, const char* name);
 
         VkInstance m_instance = nullptr;
@@ -211,12 +359,11 @@ namespace Renderer
 
         // samplers we use for these
         VkSampler m_default_sampler_nearest;
+        VkSamplerCreateInfo m_default_sampler_nearest_info{}; // variants of it are made by the residency
         VkSampler m_default_sampler_linear;
 
         float m_backbuffer_scale;
 
-        VkPipelineLayout m_gradient_pipeline_layout;
-        std::vector<ComputeEffect> m_compute_effects{};
         std::size_t m_current_effect = 0;
 
         // test mesh and material instance
@@ -227,8 +374,18 @@ namespace Renderer
         std::vector<VkImage> m_swapchain_images;
         std::vector<VkImageView> m_swapchain_image_views;
         VkExtent2D m_swapchain_extent;
+        std::vector<RetiredResources> m_retired_resources;
+        std::vector<PresentWindow> m_present_windows;
 
-        FrameData m_frames[FRAME_OVERLAP];
+        std::vector<FrameData> m_frames;
+        uint32_t m_requested_frames_in_flight;
+        FramesInFlightBenchmark m_frames_in_flight_benchmark{};
+        int64_t m_last_draw_us = 0;
+
+        PresentMode m_present_mode;
+        VkPresentModeKHR m_active_present_mode = VK_PRESENT_MODE_FIFO_KHR; // can differ if unsupported
+        FrameLimiter m_frame_limiter{};
+        InputLatency m_input_latency{};
 
         // immediate submit structures. For copying stuff to gpu
         VkFence m_immediate_fence;
@@ -238,18 +395,36 @@ namespace Renderer
         VkQueue m_graphics_queue;
         uint32_t m_graphics_queue_family;
 
+        // queue of another family for the async backgrounds, null if the device has none.
+        VkQueue m_compute_queue = nullptr;
+        uint32_t m_compute_queue_family = 0;
+        // signalled with the count of graphics submits, the backgrounds wait for the previous frame with it
+        // before they overwrite its draw images.
+        VkSemaphore m_graphics_timeline = nullptr;
+        uint64_t m_graphics_submits = 0;
+
         VkExtent2D m_window_extent;
         SDL_Window* m_window;
 
         VmaAllocator m_allocator;
+        Utils::GpuProfiler m_gpu_profiler;
+        Utils::MemoryTracker m_memory_tracker;
+        MemoryPools m_memory_pools;
+        GeometryPool m_geometry_pool;
+        TextureResidency m_texture_residency;
+        VirtualTexturing m_virtual_texturing;
+        RenderGraph m_render_graph; // built from scratch every frame, keeps the transient images around
+        bool m_memory_budget_supported = false; // VK_EXT_memory_budget was enabled on the device
 
         bool m_use_validation_layers;
         bool m_force_all_uploads_immediate;
-        bool m_enable_image_debugging = true;
+        bool m_compress_vertices;
 
         // uploads that are pending to be done on next frame.
         std::mutex m_pending_upload_mutex{};
         std::vector<std::unique_ptr<Utils::IUploadRequest>> m_pending_uploads;
+        // uploads taken out of the pending list by PrepareUploads, only touched by the frame.
+        std::vector<std::unique_ptr<Utils::IUploadRequest>> m_frame_uploads;
 
         // uploads that have been completed this frame, but need to have their resources freed.
         std::vector<std::unique_ptr<Utils::IUploadRequest>> m_completed_uploads;
@@ -263,6 +438,14 @@ namespace Renderer
         // materials (pipelines)
         Material_GLTF_PBR m_gltf_pbr_material;
 
+        // compute passes
+        MeshletCullingPass m_meshlet_culling;
+        OcclusionCullingPass m_occlusion_culling;
+        UpscalePass m_upscale;
+        BackgroundPass m_background;
+        bool m_async_background = true; // draw backgrounds on the compute queue if there is one
+        bool m_bicubic_upscale = true; // otherwise the main viewport is blitted to the swapchain
+
         // interfaces
         MaterialEngineInterface m_material_interface;
 
@@ -272,7 +455,7 @@ namespace Renderer
 
         // we allocate a VkDescriptorSet for every image through imgui so that the image can be drawn in
         // imgui.
-        std::unordered_map<VkImage, VkDescriptorSet> m_debug_image_map;
+        Utils::DebugTextureCache m_debug_textures;
 
         // Resource storages. We manage the lifetime of all resources in the engine.
         ResourceStorage<AllocatedImage> m_image_storage;
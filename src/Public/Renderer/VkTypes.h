@@ -3,6 +3,7 @@
 #include "Renderer/ResourceStorage.h"
 
 #include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <vk_mem_alloc.h>
 #include <vulkan/vk_enum_string_helper.h>
@@ -39,6 +40,8 @@ namespace Renderer
         VmaAllocation allocation;
         VkExtent3D image_extent;
         VkFormat image_format;
+        uint32_t mip_levels = 1;
+        VkImageUsageFlags image_usage = 0; // the defragmentation recreates moved images with it
     };
 
     struct AllocatedBuffer
@@ -46,6 +49,8 @@ namespace Renderer
         VkBuffer buffer;
         VmaAllocation allocation;
         VmaAllocationInfo allocation_info;
+        VkDeviceSize size = 0; // the defragmentation recreates moved buffers with these
+        VkBufferUsageFlags usage = 0;
     };
 
     struct Vertex
@@ -57,6 +62,48 @@ namespace Renderer
         glm::vec4 colour;
     };
 
+    // Layout of the vertices inside a mesh's vertex buffer. Selected per mesh when it is uploaded and decoded
+    // in the vertex shader (see data/shader/vertex_formats.glsl). Values need to match the shader.
+    enum class VertexFormat : uint32_t
+    {
+        Standard = 0,         // Vertex, 48 bytes.
+        Compact = 1,          // CompactVertex, 24 bytes.
+        CompactQuantised = 2, // QuantisedVertex, 20 bytes.
+    };
+
+    // full precision position, octahedral snorm16x2 normal, half2 uv and unorm8x4 colour.
+    struct CompactVertex
+    {
+        glm::vec3 position;
+        uint32_t normal;
+        uint32_t uv;
+        uint32_t colour;
+    };
+
+    // same as CompactVertex but the position is unorm16x3 relative to the bounds of the mesh.
+    struct QuantisedVertex
+    {
+        uint16_t position[3];
+        uint16_t padding;
+        uint32_t normal;
+        uint32_t uv;
+        uint32_t colour;
+    };
+
+    static_assert(sizeof(Vertex) == 48, "Vertex layout needs to match the shader");
+    static_assert(sizeof(CompactVertex) == 24, "CompactVertex layout needs to match the shader");
+    static_assert(sizeof(QuantisedVertex) == 20, "QuantisedVertex layout needs to match the shader");
+
+    // Object space axis aligned bounds of a mesh.
+    struct MeshBounds
+    {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+
+        glm::vec3 Centre() const { return (min + max) * 0.5f; }
+        glm::vec3 Extent() const { return max - min; }
+    };
+
     // template specialisations for resource storages
     void DestroyImage(VulkanEngine& engine, const AllocatedImage& image);
     void DestroyBuffer(VulkanEngine& engine, const AllocatedBuffer& buffer);
@@ -80,11 +127,47 @@ namespace Renderer
     using ImageHandle = ReferenceCountedHandle<AllocatedImage>;
     using BufferHandle = ReferenceCountedHandle<AllocatedBuffer>;
 
+    // Small cluster of triangles of a surface, stored as a contiguous range of the mesh index buffer so it
+    // can be culled on its own. Layout needs to match data/shader/meshlet_cull.comp.
+    struct GPUMeshlet
+    {
+        glm::vec4 bounding_sphere;  // object space centre in xyz, radius in w
+        glm::vec4 cone_axis_cutoff; // object space normal cone axis in xyz, cutoff in w. 1 disables culling
+        uint32_t first_index;
+        uint32_t index_count;
+        uint32_t padding[2];
+    };
+
+    static_assert(sizeof(GPUMeshlet) == 48, "GPUMeshlet layout needs to match the shader");
+
+    // bytes of a geometry pool buffer sub-allocated to a mesh.
+    struct GeometryRange
+    {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
     struct GPUMeshBuffers
     {
         BufferHandle index_buffer;
         BufferHandle vertex_buffer;
-        VkDeviceAddress vertex_buffer_address;
+        VkDeviceAddress index_buffer_address; // of the first index of the mesh
+        VkDeviceAddress vertex_buffer_address; // of the first vertex of the mesh
+        VertexFormat vertex_format = VertexFormat::Standard;
+
+        // meshes in the geometry pool share its buffers and own these ranges of them. Empty for meshes with
+        // buffers of their own, which start at 0.
+        GeometryRange vertex_range{};
+        GeometryRange index_range{};
+        uint32_t first_index = 0; // the index range in indices, added to the first index of every draw
+
+        // bounds of the vertex positions. Quantised formats store positions relative to these.
+        MeshBounds bounds{};
+
+        // optional, meshlets of all surfaces. Only present if the mesh was imported with meshlets.
+        BufferHandle meshlet_buffer;
+        VkDeviceAddress meshlet_buffer_address = 0;
+        uint32_t meshlet_count = 0;
     };
 
     struct GPUDrawPushConstants
@@ -92,6 +175,9 @@ namespace Renderer
         glm::mat4 world_matrix;
         VkDeviceAddress vertex_buffer_address;
         float opacity;
+        VertexFormat vertex_format;
+        glm::vec4 position_offset; // xyz is added to dequantised positions
+        glm::vec4 position_scale;  // xyz is multiplied with dequantised positions
     };
 
     struct GPUSceneData
@@ -102,5 +188,6 @@ namespace Renderer
         glm::vec4 ambient_colour = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
         glm::vec4 light_direction = glm::vec4(0.34f, 0.33f, 0.33f, 0.0f);
         glm::vec4 light_colour = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        glm::uvec4 virtual_texturing = glm::uvec4(0); // page table and feedback addresses of VirtualTexturing
     };
 } // namespace Renderer
\ No newline at end of file